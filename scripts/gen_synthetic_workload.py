@@ -0,0 +1,157 @@
+#!/usr/bin/env python
+# Generates a synthetic BEER workflow and the matching data size file for
+# benchmarking the scheduler with --simulate, e.g.:
+#   gen_synthetic_workload.py chain 50 chain.rap chain_sizes 1
+#   musketeer --simulate --run_daemon=false --beer_query=chain.rap \
+#     --dry_run_data_size_file=chain_sizes
+import sys
+import random
+
+SHAPES = ['chain', 'wide_join', 'nested_loop']
+MIN_OPS = 10
+MAX_OPS = 200
+
+if len(sys.argv) < 5:
+    print("usage: gen_synthetic_workload.py " + "|".join(SHAPES) +
+          " num_operators rap_file_out data_size_file_out [seed]")
+    sys.exit(1)
+
+shape = sys.argv[1]
+num_ops = int(sys.argv[2])
+if shape not in SHAPES or num_ops < MIN_OPS or num_ops > MAX_OPS:
+    print("shape must be one of " + ", ".join(SHAPES) + " and the number "
+          "of operators between " + str(MIN_OPS) + " and " + str(MAX_OPS))
+    sys.exit(1)
+if len(sys.argv) > 5:
+    random.seed(int(sys.argv[5]))
+
+creates = []
+ops = []
+# Relation name -> size in KB.
+sizes = {}
+next_rel = [0]
+
+
+def new_name(prefix):
+    next_rel[0] += 1
+    return prefix + str(next_rel[0])
+
+
+def create_input(size_kb):
+    name = new_name('in')
+    creates.append('CREATE RELATION ' + name +
+                   ' WITH COLUMNS (INTEGER, INTEGER) WITH OWNERS (1)')
+    sizes[name] = size_kb
+    return name
+
+
+def random_input():
+    # Log-uniform between 10MB and 100GB.
+    return create_input(int(10 ** random.uniform(4, 8)))
+
+
+def add_op(code, output, size_kb):
+    ops.append(code)
+    sizes[output] = max(1, int(size_kb))
+    return output
+
+
+def unary_op(rel, output=None):
+    output = output or new_name('r')
+    kind = random.choice(['select', 'project', 'sum', 'agg'])
+    if kind == 'select':
+        return add_op('SELECT [' + rel + '_0, ' + rel + '_1] FROM (' + rel +
+                      ') WHERE [(' + rel + '_1 < ' +
+                      str(random.randint(1, 1000)) + ')] AS ' + output,
+                      output, sizes[rel] * random.uniform(0.1, 0.9))
+    if kind == 'project':
+        return add_op('PROJECT [' + rel + '_1, ' + rel + '_0] FROM (' + rel +
+                      ') AS ' + output, output, sizes[rel])
+    if kind == 'sum':
+        return add_op('SUM [' + rel + '_1, 1] FROM (' + rel + ') AS ' +
+                      output, output, sizes[rel])
+    return add_op('AGG [' + rel + '_1, +] FROM (' + rel + ') GROUP BY [' +
+                  rel + '_0] AS ' + output, output,
+                  sizes[rel] * random.uniform(0.01, 0.5))
+
+
+# A join followed by a projection back to two columns. Uses two operators.
+def join_op(left, right, output=None):
+    joined = new_name('j')
+    add_op('(' + left + ') JOIN (' + right + ') ON ' + left + '_0 AND ' +
+           right + '_0 AS ' + joined, joined,
+           (sizes[left] + sizes[right]) * random.uniform(0.2, 2.0))
+    output = output or new_name('r')
+    return add_op('PROJECT [' + joined + '_0, ' + joined + '_2] FROM (' +
+                  joined + ') AS ' + output, output, sizes[joined] * 0.7)
+
+
+def chain(rel, remaining, output=None):
+    while remaining > 0:
+        if remaining >= 2 and random.random() < 0.3:
+            rel = join_op(rel, random_input(),
+                          output if remaining == 2 else None)
+            remaining -= 2
+        else:
+            rel = unary_op(rel, output if remaining == 1 else None)
+            remaining -= 1
+    return rel
+
+
+def wide_join(remaining):
+    # Every join uses two operators; the rest are filters on the inputs.
+    num_joins = remaining // 2
+    rels = [random_input() for i in range(num_joins + 1)]
+    if remaining % 2 == 1:
+        rels[0] = unary_op(rels[0])
+    while len(rels) > 1:
+        left = rels.pop(random.randrange(len(rels)))
+        right = rels.pop(random.randrange(len(rels)))
+        rels.append(join_op(left, right))
+    return rels[0]
+
+
+def while_loop(counter, num_iterations, body):
+    creates.append('CREATE RELATION ' + counter +
+                   ' WITH COLUMNS (INTEGER) WITH OWNERS (1)')
+    sizes[counter] = 1
+    body = [op.replace('\n', '\n  ') for op in body]
+    ops.append('WHILE [(' + counter + '_0 < ' + str(num_iterations) +
+               ')] DO (\n  ' + ',\n  '.join(body) + ',\n  SUM [' + counter +
+               '_0,1] FROM (' + counter + ') AS ' + counter + ')')
+
+
+def nested_loop(remaining):
+    state = random_input()
+    # The outer loop, the inner loop, their counters and the reset of the
+    # inner counter use five operators.
+    inner_ops = (remaining - 5) // 2
+    outer_ops = remaining - 5 - inner_ops
+    saved_ops = list(ops)
+    del ops[:]
+    chain(state, inner_ops, state)
+    inner_body = list(ops)
+    # Restart the inner loop's count on every outer iteration.
+    ops[:] = ['MUL [inner_iter_0, 0] FROM (inner_iter) AS inner_iter']
+    while_loop('inner_iter', random.randint(2, 5), inner_body)
+    chain(state, outer_ops, state)
+    outer_body = list(ops)
+    ops[:] = saved_ops
+    while_loop('outer_iter', random.randint(2, 5), outer_body)
+    return state
+
+
+if shape == 'chain':
+    chain(random_input(), num_ops)
+elif shape == 'wide_join':
+    wide_join(num_ops)
+else:
+    nested_loop(num_ops)
+
+rap_file_out = open(sys.argv[3], 'w')
+rap_file_out.write(',\n'.join(creates + ops) + '\n')
+rap_file_out.close()
+size_file_out = open(sys.argv[4], 'w')
+for rel in sorted(sizes):
+    size_file_out.write(rel + ' ' + str(sizes[rel]) + '\n')
+size_file_out.close()
@@ -0,0 +1,262 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "base/columnar_format.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace musketeer {
+
+  static const char COLUMNAR_MAGIC[] = { '\x89', 'M', 'C', 'B' };
+
+  static bool ReadU32(const char** data, const char* end, uint32_t* value) {
+    if (end - *data < 4) {
+      return false;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(*data);
+    *value = (static_cast<uint32_t>(bytes[0]) << 24) |
+      (static_cast<uint32_t>(bytes[1]) << 16) |
+      (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+    *data += 4;
+    return true;
+  }
+
+  static bool ReadU64(const char** data, const char* end, uint64_t* value) {
+    uint32_t high;
+    uint32_t low;
+    if (!ReadU32(data, end, &high) || !ReadU32(data, end, &low)) {
+      return false;
+    }
+    *value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+  }
+
+  static bool ReadVarint(const char** data, const char* end, uint64_t* value) {
+    *value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+      if (*data == end) {
+        return false;
+      }
+      unsigned char byte = static_cast<unsigned char>(*(*data)++);
+      *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool ReadString(const char** data, const char* end, string* value) {
+    uint64_t length;
+    if (!ReadVarint(data, end, &length) ||
+        length > static_cast<uint64_t>(end - *data)) {
+      return false;
+    }
+    value->assign(*data, length);
+    *data += length;
+    return true;
+  }
+
+  static int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+  }
+
+  static string FormatInteger(int64_t value) {
+    ostringstream out;
+    out << value;
+    return out.str();
+  }
+
+  // Prints mantissa with scale digits after the point.
+  static string FormatDecimal(int64_t mantissa, uint32_t scale) {
+    uint64_t magnitude = mantissa < 0 ? ~static_cast<uint64_t>(mantissa) + 1 :
+      static_cast<uint64_t>(mantissa);
+    ostringstream out;
+    out << magnitude;
+    string digits = out.str();
+    if (digits.length() <= scale) {
+      digits.insert(0, scale + 1 - digits.length(), '0');
+    }
+    if (scale > 0) {
+      digits.insert(digits.length() - scale, ".");
+    }
+    return mantissa < 0 ? "-" + digits : digits;
+  }
+
+  bool RelationReader::NextRow(string* row) {
+    while (next_row_ == block_rows_.size()) {
+      if (!ReadBlock()) {
+        return false;
+      }
+    }
+    row->swap(block_rows_[next_row_++]);
+    return true;
+  }
+
+  bool RelationReader::ReadBlock() {
+    block_rows_.clear();
+    next_row_ = 0;
+    int first = getc(in_);
+    if (first == EOF) {
+      return false;
+    }
+    if (static_cast<char>(first) != COLUMNAR_MAGIC[0]) {
+      // A line of text.
+      string line;
+      for (int c = first; c != EOF && c != '\n'; c = getc(in_)) {
+        line += static_cast<char>(c);
+      }
+      block_rows_.push_back(line);
+      return true;
+    }
+    char header[15];
+    if (fread(header, 1, sizeof(header), in_) != sizeof(header) ||
+        header[0] != COLUMNAR_MAGIC[1] || header[1] != COLUMNAR_MAGIC[2] ||
+        header[2] != COLUMNAR_MAGIC[3]) {
+      LOG(ERROR) << "Malformed columnar block header";
+      failed_ = true;
+      return false;
+    }
+    const char* data = header + 3;
+    uint32_t num_rows;
+    uint32_t num_cols;
+    uint32_t body_bytes;
+    ReadU32(&data, header + sizeof(header), &num_rows);
+    ReadU32(&data, header + sizeof(header), &num_cols);
+    ReadU32(&data, header + sizeof(header), &body_bytes);
+    vector<char> body(body_bytes);
+    if (body_bytes > 0 && fread(&body[0], 1, body_bytes, in_) != body_bytes) {
+      LOG(ERROR) << "Truncated columnar block";
+      failed_ = true;
+      return false;
+    }
+    const char* body_data = body.empty() ? NULL : &body[0];
+    const char* body_end = body_data + body_bytes;
+    block_rows_.resize(num_rows);
+    for (uint32_t col = 0; col < num_cols; ++col) {
+      vector<string> values;
+      if (!DecodeChunk(&body_data, body_end, num_rows, &values)) {
+        LOG(ERROR) << "Malformed columnar chunk";
+        block_rows_.clear();
+        failed_ = true;
+        return false;
+      }
+      for (uint32_t row = 0; row < num_rows; ++row) {
+        if (col > 0) {
+          block_rows_[row] += ' ';
+        }
+        block_rows_[row] += values[row];
+      }
+    }
+    return true;
+  }
+
+  bool RelationReader::DecodeChunk(const char** data, const char* end,
+                                   uint32_t num_rows, vector<string>* values) {
+    if (end - *data < 2) {
+      return false;
+    }
+    char type = *(*data)++;
+    char encoding = *(*data)++;
+    // Skip the min and max of the chunk.
+    if (type == 'i' || type == 'd') {
+      if (end - *data < 16) {
+        return false;
+      }
+      *data += 16;
+    } else {
+      string bound;
+      if (!ReadString(data, end, &bound) || !ReadString(data, end, &bound)) {
+        return false;
+      }
+    }
+    uint32_t data_bytes;
+    if (!ReadU32(data, end, &data_bytes) ||
+        data_bytes > static_cast<uint64_t>(end - *data)) {
+      return false;
+    }
+    const char* chunk = *data;
+    const char* chunk_end = chunk + data_bytes;
+    *data = chunk_end;
+    uint64_t previous = 0;
+    if (type == 's' && encoding == 'k') {
+      uint64_t dict_size;
+      if (!ReadVarint(&chunk, chunk_end, &dict_size)) {
+        return false;
+      }
+      vector<string> dict;
+      for (uint64_t i = 0; i < dict_size; ++i) {
+        string entry;
+        if (!ReadString(&chunk, chunk_end, &entry)) {
+          return false;
+        }
+        dict.push_back(entry);
+      }
+      for (uint32_t row = 0; row < num_rows; ++row) {
+        uint64_t index;
+        if (!ReadVarint(&chunk, chunk_end, &index) || index >= dict.size()) {
+          return false;
+        }
+        values->push_back(dict[index]);
+      }
+      return true;
+    }
+    for (uint32_t row = 0; row < num_rows; ++row) {
+      uint64_t value;
+      if (type == 's' && encoding == 'p') {
+        string entry;
+        if (!ReadString(&chunk, chunk_end, &entry)) {
+          return false;
+        }
+        values->push_back(entry);
+        continue;
+      }
+      uint32_t scale = 0;
+      if (type == 'd') {
+        if (chunk == chunk_end) {
+          return false;
+        }
+        scale = static_cast<unsigned char>(*chunk++);
+      } else if (type != 'i') {
+        return false;
+      }
+      if (encoding == 'p') {
+        if (!ReadU64(&chunk, chunk_end, &value)) {
+          return false;
+        }
+      } else if (encoding == 'z') {
+        if (!ReadVarint(&chunk, chunk_end, &value)) {
+          return false;
+        }
+        value = previous + static_cast<uint64_t>(UnZigZag(value));
+      } else {
+        return false;
+      }
+      previous = value;
+      if (type == 'i') {
+        values->push_back(FormatInteger(static_cast<int64_t>(value)));
+      } else {
+        values->push_back(FormatDecimal(static_cast<int64_t>(value), scale));
+      }
+    }
+    return true;
+  }
+
+} // namespace musketeer
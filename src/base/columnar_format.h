@@ -0,0 +1,89 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+// Relations exchanged between jobs can be stored in a columnar format instead
+// of space-separated text. The jobs of the engines that support it read and
+// write the format (see metis_templates/columnar.h and
+// hadoop_templates/Columnar.java); Musketeer decodes it for the other engines.
+//
+// A file is a sequence of blocks, so the part files of a relation can be
+// concatenated. All integers are big-endian and varints are unsigned LEB128.
+//
+//   block := magic num_rows:u32 num_cols:u32 body_bytes:u32 chunk{num_cols}
+//   chunk := type:u8 encoding:u8 min max data_bytes:u32 data
+//
+// The magic is 0x89 'M' 'C' 'B', which can not start a line of text. A chunk
+// holds the values of one column of the block's rows:
+//   - type 'i': 64-bit integers. min and max are 8 bytes each. Encoding 'p'
+//     stores every value in 8 bytes, 'z' stores the zigzag varints of the
+//     differences between consecutive values.
+//   - type 'd': decimals, i.e. a 64-bit mantissa and the number of digits
+//     after the point. min and max are doubles of 8 bytes each. Encoding 'p'
+//     stores a u8 scale and an 8 byte mantissa per value, 'z' a u8 scale and
+//     the zigzag varint of the difference to the previous mantissa.
+//   - type 's': strings. min and max, in byte order, are a varint length and
+//     the bytes. Encoding 'p' stores every value that way, 'k' stores a
+//     dictionary (a varint count and the strings) and the varint index of
+//     every value.
+// A row is a line of text split at every space. Writers infer the type of a
+// column in each block: a column is typed 'i' or 'd' only if every value
+// prints back as the same text, so the text of a relation is preserved. A
+// row with a different number of columns starts a new block. The per-block
+// min and max let readers skip blocks that a selection can not match.
+
+#ifndef MUSKETEER_COLUMNAR_FORMAT_H
+#define MUSKETEER_COLUMNAR_FORMAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/common.h"
+
+namespace musketeer {
+
+class RelationReader {
+ public:
+  // Reads the concatenated part files of a relation, in text or in the
+  // columnar format, from in. The caller owns in.
+  explicit RelationReader(FILE* in) : in_(in), next_row_(0), failed_(false) {
+  }
+
+  // Sets row to the next row as a line of space-separated values. Returns
+  // false at the end of the input or if a block is malformed.
+  bool NextRow(string* row);
+  // True if reading stopped at a malformed block.
+  bool failed() const {
+    return failed_;
+  }
+
+ private:
+  bool ReadBlock();
+  bool DecodeChunk(const char** data, const char* end, uint32_t num_rows,
+                   vector<string>* values);
+
+  FILE* in_;
+  vector<string> block_rows_;
+  vector<string>::size_type next_row_;
+  bool failed_;
+};
+
+} // namespace musketeer
+#endif
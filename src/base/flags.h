@@ -35,6 +35,15 @@ DECLARE_string(hdfs_input_dir);
 
 // Scheduler flags.
 DECLARE_bool(operator_merge);
+DECLARE_uint64(broadcast_join_max_kb);
+DECLARE_uint64(skew_join_sample_rows);
+DECLARE_double(skew_join_min_fraction);
+DECLARE_int32(skew_join_splits);
+DECLARE_uint64(map_aggregation_max_groups);
+DECLARE_uint64(reduce_task_input_kb);
+DECLARE_bool(columnar_intermediates);
+DECLARE_uint64(columnar_block_rows);
+DECLARE_bool(columnar_compression);
 DECLARE_bool(dry_run);
 DECLARE_double(time_to_cost);
 DECLARE_string(dry_run_data_size_file);
@@ -43,6 +52,17 @@ DECLARE_uint64(max_scheduler_cost);
 DECLARE_bool(best_runtime);
 DECLARE_bool(use_heuristic);
 DECLARE_bool(use_dynamic_scheduler);
+DECLARE_bool(whole_loop_offload);
+DECLARE_uint64(job_timeout);
+DECLARE_bool(speculative_replanning);
+DECLARE_double(speculation_slowdown);
+DECLARE_string(trace_file);
+DECLARE_bool(simulate);
+DECLARE_string(job_run_trace_file);
+DECLARE_int32(simulation_engine_slots);
+DECLARE_double(simulation_background_load);
+DECLARE_double(simulation_noise);
+DECLARE_uint64(simulation_seed);
 
 // HDFS flags.
 DECLARE_string(hdfs_master);
@@ -54,11 +74,17 @@ DECLARE_string(viz_root_dir);
 // GraphChi flags.
 DECLARE_string(graphchi_dir);
 DECLARE_string(graphchi_templates_dir);
+DECLARE_bool(graphchi_cache_shards);
+DECLARE_int32(graphchi_ingest_threads);
+DECLARE_bool(graphchi_selective_scheduling);
+DECLARE_double(graphchi_convergence_threshold);
+DECLARE_int32(graphchi_max_iterations);
 
 // Hadoop flags.
 DECLARE_string(hadoop_templates_dir);
 DECLARE_string(hadoop_job_tracker_host);
 DECLARE_int32(hadoop_job_tracker_port);
+DECLARE_int32(hadoop_reduce_slots);
 
 // Metis flags.
 DECLARE_string(metis_dir);
@@ -69,6 +95,10 @@ DECLARE_bool(metis_strace_binaries);
 DECLARE_bool(metis_heapprofile);
 DECLARE_bool(metis_cpuprofile);
 DECLARE_string(metis_glog_v);
+DECLARE_bool(metis_use_worker);
+DECLARE_int32(metis_num_workers);
+DECLARE_uint64(metis_reduce_task_input_kb);
+DECLARE_int32(metis_max_reduce_tasks);
 
 // Naiad flag.s
 DECLARE_string(naiad_dir);
@@ -81,14 +111,17 @@ DECLARE_string(naiad_hosts_file);
 DECLARE_string(powergraph_dir);
 DECLARE_string(powergraph_templates_dir);
 DECLARE_int32(powergraph_num_workers);
+DECLARE_bool(powergraph_cache_partitions);
 
 // Spark flags.
 DECLARE_string(spark_dir);
 DECLARE_string(spark_master);
 DECLARE_string(spark_templates_dir);
+DECLARE_int32(spark_max_partitions);
 DECLARE_string(spark_version);
 DECLARE_string(scala_version);
 DECLARE_string(scala_major_version);
+DECLARE_int32(monitor_poll_interval_ms);
 DECLARE_string(spark_web_ui_host);
 DECLARE_int32(spark_web_ui_port);
 
@@ -104,5 +137,6 @@ DECLARE_bool(wildcherry_use_hdfs);
 
 // Universal MPC flags.
 DECLARE_string(data_owner_id);
+DECLARE_bool(mpc_parallel_local_subplans);
 
 #endif
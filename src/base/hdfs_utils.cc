@@ -18,33 +18,96 @@
 
 #include "base/hdfs_utils.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include "base/columnar_format.h"
 #include "base/common.h"
 #include "base/flags.h"
 
 namespace musketeer {
 
+  // Returns the first row of a relation. Only the beginning of the first
+  // non-empty part file is streamed; the relation is not copied locally.
   string GetHdfsRelValue(const string& relation) {
-    string value = "";
-    string cmd = "hadoop fs -get " + FLAGS_hdfs_input_dir + relation + " " +
-      FLAGS_hdfs_input_dir;
-    std::system(cmd.c_str());
-    // Assumption about the file name.
-    string file_name = FLAGS_hdfs_input_dir + relation + "/part-r-00000";
-    ifstream rel_file(file_name.c_str());
-    // Just read the first column.
-    if (rel_file.is_open() && rel_file.good()) {
-      getline(rel_file, value);
+    vector<string> rows = GetHdfsRelRows(relation, 1);
+    return rows.empty() ? "" : rows[0];
+  }
+
+  // Returns up to max_rows rows from the beginning of a relation, which can
+  // be stored as text or in the columnar format.
+  vector<string> GetHdfsRelRows(const string& relation, uint64_t max_rows) {
+    string cmd = "hadoop fs -cat " + FLAGS_hdfs_input_dir + relation +
+      "/part-* 2> /dev/null";
+    vector<string> rows;
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) {
+      return rows;
     }
-    cmd = "rm -r " + FLAGS_hdfs_input_dir + relation;
-    std::system(cmd.c_str());
-    return value;
+    RelationReader reader(pipe);
+    string row;
+    while (rows.size() < max_rows && reader.NextRow(&row)) {
+      rows.push_back(row);
+    }
+    pclose(pipe);
+    return rows;
   }
 
+  // Rewrites a relation stored in the columnar format as text, for the
+  // engines that do not read the format.
+  bool ConvertHdfsRelToText(const string& relation) {
+    if (FLAGS_dry_run) {
+      return true;
+    }
+    string rel_dir = FLAGS_hdfs_input_dir + relation;
+    string text_file = FLAGS_tmp_data_dir + relation + "_text";
+    FILE* pipe = popen(("hadoop fs -cat " + rel_dir +
+                        "/part-* 2> /dev/null").c_str(), "r");
+    FILE* out = fopen(text_file.c_str(), "w");
+    if (!pipe || !out) {
+      LOG(ERROR) << "Could not convert " << relation << " to text";
+      if (pipe) {
+        pclose(pipe);
+      }
+      if (out) {
+        fclose(out);
+      }
+      return false;
+    }
+    RelationReader reader(pipe);
+    string row;
+    while (reader.NextRow(&row)) {
+      fprintf(out, "%s\n", row.c_str());
+    }
+    bool decoded = !reader.failed() && pclose(pipe) == 0;
+    bool written = !ferror(out) && fclose(out) == 0;
+    if (!decoded || !written) {
+      LOG(ERROR) << "Could not convert " << relation << " to text";
+      remove(text_file.c_str());
+      return false;
+    }
+    // The text is uploaded next to the relation and only replaces it once it
+    // is complete. If the final rename fails the relation is moved back.
+    string tmp_dir = rel_dir + "_text_tmp";
+    string old_dir = rel_dir + "_columnar_old";
+    string cmd = "hadoop fs -rm -r -f " + tmp_dir + " " + old_dir +
+      " > /dev/null 2>&1; hadoop fs -mkdir -p " + tmp_dir +
+      " && hadoop fs -put " + text_file + " " + tmp_dir + "/part-r-00000" +
+      " && hadoop fs -mv " + rel_dir + " " + old_dir +
+      " && { hadoop fs -mv " + tmp_dir + " " + rel_dir + " || { hadoop fs -mv " +
+      old_dir + " " + rel_dir + "; false; }; }";
+    bool replaced = std::system(cmd.c_str()) == 0;
+    remove(text_file.c_str());
+    string cleanup_cmd = "hadoop fs -rm -r -f " + tmp_dir +
+      (replaced ? " " + old_dir : "") + " > /dev/null 2>&1";
+    std::system(cleanup_cmd.c_str());
+    return replaced;
+  }
 
   void removeHdfsDir(const string& path) {
     if (!FLAGS_dry_run) {
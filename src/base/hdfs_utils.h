@@ -22,12 +22,15 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "base/common.h"
 
 namespace musketeer {
 
   string GetHdfsRelValue(const string& path);
+  vector<string> GetHdfsRelRows(const string& relation, uint64_t max_rows);
+  bool ConvertHdfsRelToText(const string& relation);
   void renameHdfsDir(const string& src, const string& dst);
   void removeHdfsDir(const string& path);
   uint64_t GetRelationSize(string hdfs_location);
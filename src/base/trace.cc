@@ -0,0 +1,174 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "base/trace.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/flags.h"
+
+// Bounds the memory used by the trace of a long running daemon.
+#define TRACE_MAX_EVENTS 1000000
+
+namespace musketeer {
+
+  static boost::mutex trace_mutex;
+  static vector<string> trace_events;
+  static map<boost::thread::id, uint32_t> trace_thread_ids;
+
+  // Spans are owned by their scope, not by the thread.
+  static void KeepSpan(TraceSpan* span) {
+  }
+
+  static boost::thread_specific_ptr<TraceSpan> current_span(KeepSpan);
+
+  static uint64_t NowUs() {
+    timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec * 1000000ULL + now.tv_usec;
+  }
+
+  static string QuoteJSON(const string& value) {
+    string quoted = "\"";
+    for (string::const_iterator it = value.begin(); it != value.end(); ++it) {
+      if (*it == '"' || *it == '\\') {
+        quoted += '\\';
+        quoted += *it;
+      } else if (static_cast<unsigned char>(*it) < 0x20) {
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), "\\u%04x", *it);
+        quoted += escaped;
+      } else {
+        quoted += *it;
+      }
+    }
+    return quoted + "\"";
+  }
+
+  static string NumberJSON(double value) {
+    char number[32];
+    snprintf(number, sizeof(number), "%.6g", value);
+    return number;
+  }
+
+  TraceSpan::TraceSpan(const string& category, const string& name)
+    : enabled_(!FLAGS_trace_file.empty()), category_(category), name_(name),
+      start_us_(0), parent_(NULL) {
+    if (enabled_) {
+      start_us_ = NowUs();
+      parent_ = current_span.get();
+      current_span.reset(this);
+    }
+  }
+
+  TraceSpan::~TraceSpan() {
+    if (!enabled_) {
+      return;
+    }
+    uint64_t end_us = NowUs();
+    current_span.reset(parent_);
+    string event = "{\"name\":" + QuoteJSON(name_) + ",\"cat\":" +
+      QuoteJSON(category_) + ",\"ph\":\"X\",\"ts\":" +
+      boost::lexical_cast<string>(start_us_) + ",\"dur\":" +
+      boost::lexical_cast<string>(end_us - start_us_) + ",\"pid\":1,\"tid\":";
+    string args = "";
+    for (vector<pair<string, string> >::iterator it = args_.begin();
+         it != args_.end(); ++it) {
+      args += (args.empty() ? "" : ",") + QuoteJSON(it->first) + ":" +
+        it->second;
+    }
+    for (vector<pair<string, double> >::iterator it = numeric_args_.begin();
+         it != numeric_args_.end(); ++it) {
+      args += (args.empty() ? "" : ",") + QuoteJSON(it->first) + ":" +
+        NumberJSON(it->second);
+    }
+    boost::lock_guard<boost::mutex> lock(trace_mutex);
+    if (trace_events.size() == TRACE_MAX_EVENTS) {
+      LOG(WARNING) << "Trace is full. Dropping further spans";
+    }
+    if (trace_events.size() >= TRACE_MAX_EVENTS) {
+      return;
+    }
+    // Chrome expects small integer thread ids.
+    map<boost::thread::id, uint32_t>::iterator tid =
+      trace_thread_ids.insert(make_pair(boost::this_thread::get_id(),
+                                        trace_thread_ids.size() + 1)).first;
+    trace_events.push_back(event + boost::lexical_cast<string>(tid->second) +
+                           ",\"args\":{" + args + "}}");
+  }
+
+  void TraceSpan::AddArg(const string& key, const string& value) {
+    if (enabled_) {
+      args_.push_back(make_pair(key, QuoteJSON(value)));
+    }
+  }
+
+  void TraceSpan::AddArg(const string& key, double value) {
+    if (enabled_) {
+      args_.push_back(make_pair(key, NumberJSON(value)));
+    }
+  }
+
+  void TraceSpan::AddToArg(const string& key, double value) {
+    if (!enabled_) {
+      return;
+    }
+    for (vector<pair<string, double> >::iterator it = numeric_args_.begin();
+         it != numeric_args_.end(); ++it) {
+      if (it->first == key) {
+        it->second += value;
+        return;
+      }
+    }
+    numeric_args_.push_back(make_pair(key, value));
+  }
+
+  TraceSpan* TraceSpan::Current() {
+    return current_span.get();
+  }
+
+  void WriteTrace(const string& path) {
+    boost::lock_guard<boost::mutex> lock(trace_mutex);
+    ofstream trace_file(path.c_str());
+    if (!trace_file.good()) {
+      LOG(ERROR) << "Could not write trace to " << path;
+      return;
+    }
+    trace_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (vector<string>::size_type index = 0; index < trace_events.size();
+         ++index) {
+      trace_file << (index == 0 ? "\n" : ",\n") << trace_events[index];
+    }
+    trace_file << "\n]}\n";
+    LOG(INFO) << "Wrote " << trace_events.size() << " trace events to "
+              << path;
+  }
+
+} // namespace musketeer
@@ -0,0 +1,62 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_TRACE_H
+#define MUSKETEER_TRACE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/common.h"
+
+namespace musketeer {
+
+// A timed section of planning or execution. The span is recorded when it is
+// destroyed. Spans opened by the same thread nest. Nothing is recorded unless
+// --trace_file is set.
+class TraceSpan {
+ public:
+  TraceSpan(const string& category, const string& name);
+  ~TraceSpan();
+  void AddArg(const string& key, const string& value);
+  void AddArg(const string& key, double value);
+  // Adds value to a numeric argument, e.g. a cost that is computed in parts.
+  void AddToArg(const string& key, double value);
+  // The innermost open span of the calling thread, or NULL.
+  static TraceSpan* Current();
+
+ private:
+  bool enabled_;
+  string category_;
+  string name_;
+  uint64_t start_us_;
+  // Arguments as JSON values.
+  vector<pair<string, string> > args_;
+  vector<pair<string, double> > numeric_args_;
+  TraceSpan* parent_;
+};
+
+// Writes the recorded spans to path in the Chrome trace-event format. The
+// file can be opened in chrome://tracing or converted into a flame graph.
+void WriteTrace(const string& path);
+
+} // namespace musketeer
+#endif
@@ -417,11 +417,20 @@ namespace musketeer {
       to_visit.pop();
       op_nodes parents = node->get_parents();
       for (op_nodes::iterator it = parents.begin(); it != parents.end(); ++it) {
-        if (visited.insert(
-                (*it)->get_operator()->get_output_relation()->get_name()).second) {
-          if ((*it)->get_operator()->get_type() == WHILE_OP) {
+        if ((*it)->get_operator()->get_type() == WHILE_OP) {
+          // The WHILE is also the parent of the operators that follow the
+          // loop. Only its loop children lead into the body.
+          op_nodes loop_children = (*it)->get_loop_children();
+          if (find(loop_children.begin(), loop_children.end(), node) !=
+              loop_children.end() &&
+              visited.find((*it)->get_operator()->get_output_relation()->get_name()) ==
+              visited.end()) {
             return *it;
           }
+          continue;
+        }
+        if (visited.insert(
+                (*it)->get_operator()->get_output_relation()->get_name()).second) {
           to_visit.push(*it);
         }
       }
@@ -429,6 +438,118 @@ namespace musketeer {
     return shared_ptr<OperatorNode>();
   }
 
+  // Returns the name of the relation an operator writes, without the _tmp
+  // suffix of operators that overwrite their input.
+  string GetOverwrittenRelName(OperatorInterface* op) {
+    string output_rel = op->get_output_relation()->get_name();
+    if (op->get_rename()) {
+      output_rel = output_rel.substr(0, output_rel.length() - 4);
+    }
+    return output_rel;
+  }
+
+  // Returns true if the WHILE condition is of the form counter < constant and
+  // the loop body increments the counter. The engines run such loops for
+  // constant iterations. Any other condition is evaluated on the data
+  // computed by the loop.
+  bool IsCountedLoop(shared_ptr<OperatorNode> while_node) {
+    ConditionTree* tree =
+      dynamic_cast<WhileOperator*>(while_node->get_operator())->get_condition_tree();
+    if (!tree->isBinary() || tree->get_cond_operator()->toString() != "<" ||
+        !tree->get_left()->isColumn() || !tree->get_right()->isValue()) {
+      return false;
+    }
+    string counter_rel = tree->get_left()->get_column()->get_relation();
+    op_nodes children = while_node->get_loop_children();
+    for (op_nodes::iterator it = children.begin(); it != children.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      string output_rel = GetOverwrittenRelName(op);
+      if (op->get_type() == SUM_OP && output_rel == counter_rel &&
+          op->get_relations().size() == 1 &&
+          op->get_relations()[0]->get_name() == counter_rel) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Marks the relations that a WHILE body reads but never writes as
+  // immutable. Every Relation object that refers to them within the body is
+  // marked. Returns the names of the marked relations.
+  set<string> MarkLoopInvariantRelations(shared_ptr<OperatorNode> while_node) {
+    set<string> out_rel_names;
+    vector<Relation*> input_rels;
+    node_set visited;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    op_nodes loop_children = while_node->get_loop_children();
+    for (op_nodes::iterator it = loop_children.begin();
+         it != loop_children.end(); ++it) {
+      to_visit.push(*it);
+      visited.insert(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> cur_node = to_visit.front();
+      to_visit.pop();
+      OperatorInterface* op = cur_node->get_operator();
+      out_rel_names.insert(GetOverwrittenRelName(op));
+      vector<Relation*> rels = op->get_relations();
+      input_rels.insert(input_rels.end(), rels.begin(), rels.end());
+      op_nodes children = cur_node->get_children();
+      if (op->get_type() == WHILE_OP) {
+        // Nested loops write their body relations as well.
+        op_nodes nested = cur_node->get_loop_children();
+        children.insert(children.end(), nested.begin(), nested.end());
+      }
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+    }
+    set<string> invariant_rels;
+    for (vector<Relation*>::iterator it = input_rels.begin();
+         it != input_rels.end(); ++it) {
+      if (out_rel_names.find((*it)->get_name()) == out_rel_names.end()) {
+        (*it)->set_immutable(true);
+        if (invariant_rels.insert((*it)->get_name()).second) {
+          LOG(INFO) << "Relation " << (*it)->get_name() << " is immutable";
+        }
+      }
+    }
+    return invariant_rels;
+  }
+
+  set<string> MarkLoopInvariantRelations(const op_nodes& dag) {
+    set<string> invariant_rels;
+    node_set visited;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    for (op_nodes::const_iterator it = dag.begin(); it != dag.end(); ++it) {
+      if (visited.insert(*it).second) {
+        to_visit.push(*it);
+      }
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> cur_node = to_visit.front();
+      to_visit.pop();
+      op_nodes children = cur_node->get_children();
+      if (cur_node->get_operator()->get_type() == WHILE_OP) {
+        set<string> loop_rels = MarkLoopInvariantRelations(cur_node);
+        invariant_rels.insert(loop_rels.begin(), loop_rels.end());
+        op_nodes loop_children = cur_node->get_loop_children();
+        children.insert(children.end(), loop_children.begin(),
+                        loop_children.end());
+      }
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+    }
+    return invariant_rels;
+  }
+
   vector<Relation*>* DetermineInputs(const op_nodes& dag, set<string>* inputs,
                                      set<string>* visited) {
     vector<Relation*> *input_rels_out = new vector<Relation*>;
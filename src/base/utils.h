@@ -60,6 +60,10 @@ namespace musketeer {
   string FmwToString(uint8_t fmw);
   string FrameworkToString(FmwType fmw);
   shared_ptr<OperatorNode> IsInWhileBody(const node_list& nodes);
+  string GetOverwrittenRelName(OperatorInterface* op);
+  bool IsCountedLoop(shared_ptr<OperatorNode> while_node);
+  set<string> MarkLoopInvariantRelations(shared_ptr<OperatorNode> while_node);
+  set<string> MarkLoopInvariantRelations(const op_nodes& dag);
   void TopologicalOrder(const op_nodes& dag, op_nodes* order);
   
   void PrintNodesVector(const string& message, const op_nodes& nodes);
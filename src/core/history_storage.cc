@@ -18,13 +18,66 @@
 
 #include "core/history_storage.h"
 
+#include <fstream>
 #include <utility>
 #include <vector>
 
+#include "base/flags.h"
+#include "base/job_run.pb.h"
+
 namespace musketeer {
 namespace core {
 
+  // Appends the run to --job_run_trace_file so that the simulator can
+  // replay it.
+  static void RecordRun(JobRun* job_run) {
+    musketeer::JobRunTrace trace;
+    musketeer::JobRun* run = trace.add_runs();
+    run->set_framework(job_run->get_framework());
+    run->set_job_name(job_run->get_name());
+    run->set_make_span_ms(job_run->get_make_span_ms());
+    const JobMetrics& metrics = job_run->get_metrics();
+    musketeer::JobMetrics* run_metrics = run->mutable_metrics();
+    run_metrics->set_pull_ms(metrics.pull_ms);
+    run_metrics->set_load_ms(metrics.load_ms);
+    run_metrics->set_compile_ms(metrics.compile_ms);
+    run_metrics->set_map_ms(metrics.map_ms);
+    run_metrics->set_shuffle_ms(metrics.shuffle_ms);
+    run_metrics->set_reduce_ms(metrics.reduce_ms);
+    run_metrics->set_run_ms(metrics.run_ms);
+    run_metrics->set_push_ms(metrics.push_ms);
+    run_metrics->set_bytes_in(metrics.bytes_in);
+    run_metrics->set_bytes_out(metrics.bytes_out);
+    run_metrics->set_rows_in(metrics.rows_in);
+    run_metrics->set_rows_out(metrics.rows_out);
+    run_metrics->set_peak_rss_kb(metrics.peak_rss_kb);
+    vector<pair<string, uint64_t> > input_rels = job_run->get_input_rels_size();
+    for (vector<pair<string, uint64_t> >::iterator it = input_rels.begin();
+         it != input_rels.end(); ++it) {
+      musketeer::RelationSize* rel = run->add_input_rels();
+      rel->set_relation(it->first);
+      rel->set_size_kb(it->second);
+    }
+    vector<pair<string, uint64_t> > output_rels =
+      job_run->get_output_rels_size();
+    for (vector<pair<string, uint64_t> >::iterator it = output_rels.begin();
+         it != output_rels.end(); ++it) {
+      musketeer::RelationSize* rel = run->add_output_rels();
+      rel->set_relation(it->first);
+      rel->set_size_kb(it->second);
+    }
+    ofstream trace_file(FLAGS_job_run_trace_file.c_str(),
+                        ios::out | ios::binary | ios::app);
+    if (!trace.SerializeToOstream(&trace_file)) {
+      LOG(ERROR) << "Could not record run of " << job_run->get_name()
+                 << " in " << FLAGS_job_run_trace_file;
+    }
+  }
+
   void HistoryStorage::AddRun(JobRun* job_run) {
+    if (!FLAGS_job_run_trace_file.empty() && !FLAGS_simulate) {
+      RecordRun(job_run);
+    }
     pair<string, string> key =
       make_pair(job_run->get_name(), job_run->get_framework());
     if (job_history.find(key) != job_history.end()) {
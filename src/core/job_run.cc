@@ -18,11 +18,37 @@
 
 #include "core/job_run.h"
 
+#include <map>
 #include <utility>
 
 namespace musketeer {
 namespace core {
 
+  static uint64_t GetMetric(const map<string, uint64_t>& job_output,
+                            const string& name) {
+    map<string, uint64_t>::const_iterator it =
+      job_output.find("METRIC " + name);
+    return it == job_output.end() ? 0 : it->second;
+  }
+
+  JobMetrics ParseJobMetrics(const map<string, uint64_t>& job_output) {
+    JobMetrics metrics;
+    metrics.pull_ms = GetMetric(job_output, "PULL MS");
+    metrics.load_ms = GetMetric(job_output, "LOAD MS");
+    metrics.compile_ms = GetMetric(job_output, "COMPILE MS");
+    metrics.map_ms = GetMetric(job_output, "MAP MS");
+    metrics.shuffle_ms = GetMetric(job_output, "SHUFFLE MS");
+    metrics.reduce_ms = GetMetric(job_output, "REDUCE MS");
+    metrics.run_ms = GetMetric(job_output, "RUN MS");
+    metrics.push_ms = GetMetric(job_output, "PUSH MS");
+    metrics.bytes_in = GetMetric(job_output, "BYTES IN");
+    metrics.bytes_out = GetMetric(job_output, "BYTES OUT");
+    metrics.rows_in = GetMetric(job_output, "ROWS IN");
+    metrics.rows_out = GetMetric(job_output, "ROWS OUT");
+    metrics.peak_rss_kb = GetMetric(job_output, "PEAK RSS KB");
+    return metrics;
+  }
+
   string JobRun::get_name() {
     return job_name;
   }
@@ -31,8 +57,8 @@ namespace core {
     return framework;
   }
 
-  uint64_t JobRun::get_make_span() {
-    return make_span;
+  uint64_t JobRun::get_make_span_ms() {
+    return make_span_ms;
   }
 
   vector<pair<string, uint64_t> > JobRun::get_input_rels_size() {
@@ -43,5 +69,9 @@ namespace core {
     return output_rels_size;
   }
 
+  const JobMetrics& JobRun::get_metrics() {
+    return metrics;
+  }
+
 } // namespace core
 } // namespace musketeer
@@ -21,6 +21,7 @@
 
 #include <stdint.h>
 
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -30,26 +31,58 @@
 namespace musketeer {
 namespace core {
 
+// What a job reported about its run. Times are in milliseconds. Values
+// that the job's engine does not report are 0.
+struct JobMetrics {
+  JobMetrics() : pull_ms(0), load_ms(0), compile_ms(0), map_ms(0),
+    shuffle_ms(0), reduce_ms(0), run_ms(0), push_ms(0), bytes_in(0),
+    bytes_out(0), rows_in(0), rows_out(0), peak_rss_kb(0) {
+  }
+  uint64_t pull_ms;
+  uint64_t load_ms;
+  uint64_t compile_ms;
+  uint64_t map_ms;
+  uint64_t shuffle_ms;
+  uint64_t reduce_ms;
+  // Processing time of engines that do not split it into map, shuffle and
+  // reduce.
+  uint64_t run_ms;
+  uint64_t push_ms;
+  uint64_t bytes_in;
+  uint64_t bytes_out;
+  uint64_t rows_in;
+  uint64_t rows_out;
+  uint64_t peak_rss_kb;
+};
+
+// Collects the "METRIC <NAME>: <value>" lines a job printed, e.g.
+// "METRIC LOAD MS: 1200", keyed by "METRIC <NAME>".
+JobMetrics ParseJobMetrics(const map<string, uint64_t>& job_output);
+
 class JobRun {
  public:
-  JobRun(string job_name_, string framework_, uint64_t make_span_,
+  JobRun(string job_name_, string framework_, uint64_t make_span_ms_,
          vector<pair<string, uint64_t> > input_rels_size_,
-         vector<pair<string, uint64_t> > output_rels_size_):
-  job_name(job_name_), framework(framework_), make_span(make_span_),
-    input_rels_size(input_rels_size_), output_rels_size(output_rels_size_) {
+         vector<pair<string, uint64_t> > output_rels_size_,
+         const JobMetrics& metrics_ = JobMetrics()):
+  job_name(job_name_), framework(framework_), make_span_ms(make_span_ms_),
+    input_rels_size(input_rels_size_), output_rels_size(output_rels_size_),
+    metrics(metrics_) {
   }
   string get_name();
   string get_framework();
-  uint64_t get_make_span();
+  uint64_t get_make_span_ms();
   vector<pair<string, uint64_t> > get_input_rels_size();
   vector<pair<string, uint64_t> > get_output_rels_size();
+  const JobMetrics& get_metrics();
 
  private:
   string job_name;
   string framework;
-  uint64_t make_span;
+  uint64_t make_span_ms;
   vector<pair<string, uint64_t> > input_rels_size;
   vector<pair<string, uint64_t> > output_rels_size;
+  JobMetrics metrics;
 };
 
 } // namespace core
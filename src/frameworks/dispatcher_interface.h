@@ -19,9 +19,12 @@
 #ifndef MUSKETEER_DISPATCHER_INTERFACE_H
 #define MUSKETEER_DISPATCHER_INTERFACE_H
 
+#include <map>
 #include <string>
 
 #include "base/common.h"
+#include "base/flags.h"
+#include "frameworks/job_handle.h"
 
 namespace musketeer {
 
@@ -30,7 +33,50 @@ class DispatcherInterface {
   DispatcherInterface() {
   }
 
-  virtual void Execute(string job_path, string job_options) {
+  // Starts the job and returns without waiting for it. The caller owns the
+  // returned handle.
+  virtual JobHandle* ExecuteAsync(string job_path, string job_options) {
+    string cmd = GetCommand(job_path, job_options);
+    LOG(INFO) << "Running: " << cmd;
+    return JobHandle::StartProcess(job_path, cmd);
+  }
+
+  // Runs the job to completion and returns its exit status. Jobs that run
+  // for longer than --job_timeout seconds are cancelled. If job_output is
+  // given it is set to the values the job reported.
+  virtual int Execute(string job_path, string job_options,
+                      map<string, uint64_t>* job_output = NULL) {
+    LOG(INFO) << "Run started for: " << job_path;
+    JobHandle* job = ExecuteAsync(job_path, job_options);
+    if (FLAGS_job_timeout > 0 && !job->WaitFor(FLAGS_job_timeout)) {
+      LOG(ERROR) << "Job " << job_path << " timed out after "
+                 << FLAGS_job_timeout << "s";
+      job->Cancel();
+    }
+    int exit_status = job->Wait();
+    if (exit_status != 0) {
+      LOG(ERROR) << "Job " << job_path << " exited with status "
+                 << exit_status;
+    }
+    LOG(INFO) << "Run ended for: " << job_path;
+    if (job_output != NULL) {
+      *job_output = job->GetProgress();
+    }
+    delete job;
+    return exit_status;
+  }
+
+ protected:
+  // The shell command that runs the job.
+  virtual string GetCommand(const string& job_path,
+                            const string& job_options) = 0;
+
+  // Runs cmd in a subshell that reports its duration as the phase's metric,
+  // e.g. "METRIC PULL MS: 1200". The subshell exits with cmd's status.
+  static string TimePhase(const string& cmd, const string& phase) {
+    return "(START_MS=`date +%s%3N` ; " + cmd + " ; STATUS=$? ; " +
+      "echo \"METRIC " + phase + " MS: $((`date +%s%3N` - START_MS))\" ; " +
+      "exit $STATUS)";
   }
 };
 
@@ -0,0 +1,190 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "frameworks/engine_worker.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+// Time a worker has to start up and announce itself.
+#define WORKER_START_TIMEOUT_MS 30000
+#define WORKER_POLL_MS 100
+
+namespace musketeer {
+namespace framework {
+
+  EngineWorker::EngineWorker(const string& start_cmd,
+                             const string& fifo_prefix)
+    : start_cmd_(start_cmd), request_fifo_(fifo_prefix + ".in"),
+      response_fifo_(fifo_prefix + ".out"), requests_(NULL),
+      responses_(NULL) {
+  }
+
+  EngineWorker::~EngineWorker() {
+    Stop();
+  }
+
+  bool EngineWorker::Start() {
+    // A worker that dies while we write a request must not kill Musketeer.
+    signal(SIGPIPE, SIG_IGN);
+    unlink(request_fifo_.c_str());
+    unlink(response_fifo_.c_str());
+    if (mkfifo(request_fifo_.c_str(), 0600) != 0 ||
+        mkfifo(response_fifo_.c_str(), 0600) != 0) {
+      PLOG(ERROR) << "Could not create worker pipes " << request_fifo_;
+      return false;
+    }
+    // Open our end of the responses first so that the worker does not block
+    // when it opens the other end.
+    int response_fd = open(response_fifo_.c_str(),
+                           O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (response_fd < 0) {
+      PLOG(ERROR) << "Could not open " << response_fifo_;
+      return false;
+    }
+    string cmd = start_cmd_ + " " + request_fifo_ + " " + response_fifo_ +
+      " >> " + request_fifo_ + ".log 2>&1 &";
+    LOG(INFO) << "Starting worker: " << cmd;
+    system(cmd.c_str());
+    int request_fd = -1;
+    for (int waited = 0; waited < WORKER_START_TIMEOUT_MS;
+         waited += WORKER_POLL_MS) {
+      // Only succeeds once the worker has opened the pipe for reading.
+      request_fd = open(request_fifo_.c_str(),
+                        O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+      if (request_fd >= 0) {
+        break;
+      }
+      usleep(WORKER_POLL_MS * 1000);
+    }
+    pollfd ready = {response_fd, POLLIN, 0};
+    if (request_fd < 0 || poll(&ready, 1, WORKER_START_TIMEOUT_MS) <= 0 ||
+        !(ready.revents & POLLIN)) {
+      LOG(ERROR) << "Worker did not start: " << start_cmd_;
+      if (request_fd >= 0) {
+        close(request_fd);
+      }
+      close(response_fd);
+      return false;
+    }
+    fcntl(request_fd, F_SETFL, fcntl(request_fd, F_GETFL) & ~O_NONBLOCK);
+    fcntl(response_fd, F_SETFL, fcntl(response_fd, F_GETFL) & ~O_NONBLOCK);
+    requests_ = fdopen(request_fd, "w");
+    responses_ = fdopen(response_fd, "r");
+    char line[64];
+    if (fgets(line, sizeof(line), responses_) == NULL ||
+        strncmp(line, "ready", 5) != 0) {
+      LOG(ERROR) << "Worker did not start: " << start_cmd_;
+      Stop();
+      return false;
+    }
+    return true;
+  }
+
+  void EngineWorker::Stop() {
+    // The worker exits when it sees the end of the request pipe.
+    if (requests_ != NULL) {
+      fclose(requests_);
+      requests_ = NULL;
+    }
+    if (responses_ != NULL) {
+      fclose(responses_);
+      responses_ = NULL;
+    }
+    unlink(request_fifo_.c_str());
+    unlink(response_fifo_.c_str());
+  }
+
+  bool EngineWorker::Execute(const string& request, int* status,
+                             vector<string>* metrics) {
+    if (requests_ == NULL && !Start()) {
+      return false;
+    }
+    if (fprintf(requests_, "%s\n", request.c_str()) < 0 ||
+        fflush(requests_) != 0) {
+      LOG(ERROR) << "Worker failed while running: " << request;
+      Stop();
+      return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), responses_) != NULL) {
+      if (strncmp(line, "METRIC ", 7) != 0) {
+        *status = atoi(line);
+        return true;
+      }
+      metrics->push_back(line);
+    }
+    // The worker took the request and died while running it. Running the job
+    // again elsewhere could repeat its side effects, so it counts as failed.
+    LOG(ERROR) << "Worker failed while running: " << request;
+    Stop();
+    *status = -1;
+    return true;
+  }
+
+  EngineWorkerPool::EngineWorkerPool(const string& start_cmd,
+                                     const string& fifo_prefix,
+                                     uint32_t num_workers) {
+    for (uint32_t index = 0; index < num_workers; ++index) {
+      EngineWorker* worker = new EngineWorker(
+          start_cmd, fifo_prefix + "_" + boost::lexical_cast<string>(index));
+      workers_.push_back(worker);
+      idle_workers_.push_back(worker);
+    }
+  }
+
+  EngineWorkerPool::~EngineWorkerPool() {
+    for (vector<EngineWorker*>::iterator it = workers_.begin();
+         it != workers_.end(); ++it) {
+      delete *it;
+    }
+  }
+
+  bool EngineWorkerPool::Execute(const string& request, int* status,
+                                 vector<string>* metrics) {
+    EngineWorker* worker;
+    {
+      boost::unique_lock<boost::mutex> lock(pool_mutex_);
+      while (idle_workers_.empty()) {
+        idle_cond_.wait(lock);
+      }
+      worker = idle_workers_.back();
+      idle_workers_.pop_back();
+    }
+    bool executed = worker->Execute(request, status, metrics);
+    {
+      boost::lock_guard<boost::mutex> lock(pool_mutex_);
+      idle_workers_.push_back(worker);
+    }
+    idle_cond_.notify_one();
+    return executed;
+  }
+
+} // namespace framework
+} // namespace musketeer
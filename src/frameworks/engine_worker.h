@@ -0,0 +1,78 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_ENGINE_WORKER_H
+#define MUSKETEER_ENGINE_WORKER_H
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/common.h"
+
+namespace musketeer {
+namespace framework {
+
+// A resident worker process that runs jobs sent to it over a pair of named
+// pipes. A request is a single line holding the job and its options. The
+// worker answers every request with the "METRIC" lines the job printed,
+// followed by the job's exit status on a line of its own.
+class EngineWorker {
+ public:
+  EngineWorker(const string& start_cmd, const string& fifo_prefix);
+  ~EngineWorker();
+  // Returns false if the request could not be handed to the worker, i.e. the
+  // job did not start. Otherwise sets status to the job's exit status, or to
+  // -1 if the worker died while running the job. A failed worker is
+  // restarted on the next request.
+  bool Execute(const string& request, int* status, vector<string>* metrics);
+
+ private:
+  bool Start();
+  void Stop();
+
+  string start_cmd_;
+  string request_fifo_;
+  string response_fifo_;
+  FILE* requests_;
+  FILE* responses_;
+};
+
+// A fixed number of workers of the same engine. Requests block until a
+// worker is idle.
+class EngineWorkerPool {
+ public:
+  EngineWorkerPool(const string& start_cmd, const string& fifo_prefix,
+                   uint32_t num_workers);
+  ~EngineWorkerPool();
+  bool Execute(const string& request, int* status, vector<string>* metrics);
+
+ private:
+  vector<EngineWorker*> workers_;
+  vector<EngineWorker*> idle_workers_;
+  boost::mutex pool_mutex_;
+  boost::condition_variable idle_cond_;
+};
+
+} // namespace framework
+} // namespace musketeer
+#endif
@@ -29,14 +29,19 @@
 #include <vector>
 
 #include "base/common.h"
+#include "base/trace.h"
 #include "base/utils.h"
 #include "frameworks/dispatcher_interface.h"
 #include "monitoring/monitor_interface.h"
 #include "translation/translator_interface.h"
 
+// Bounds the penalty of scheduling on a saturated engine.
+#define MIN_FREE_SLOT_SHARE 0.1
+
 namespace musketeer {
 namespace framework {
 
+using monitor::EngineStatus;
 using monitor::MonitorInterface;
 
 typedef map<string, pair<uint64_t, uint64_t> > relation_size;
@@ -48,8 +53,22 @@ class FrameworkInterface {
   virtual uint32_t ScoreDAG(const node_list& dag,
                             const relation_size& rel_size) = 0;
   virtual string Translate(const op_nodes& dag, const string& relation) = 0;
-  virtual void Dispatch(const string& binary, const string& relation) = 0;
+  // Runs the job to completion and returns its exit status, which is 0 in
+  // dry runs. If job_output is given it is set to the values the job
+  // reported, e.g. its "METRIC" lines.
+  virtual int Dispatch(const string& binary, const string& relation,
+                       map<string, uint64_t>* job_output = NULL) = 0;
+  // Starts the job without waiting for it. The caller owns the handle.
+  virtual JobHandle* DispatchAsync(const string& binary,
+                                   const string& relation) {
+    return dispatcher_->ExecuteAsync(binary, relation);
+  }
   virtual FmwType GetType() = 0;
+  // True if the engine's jobs read and write relations in the columnar
+  // format (see base/columnar_format.h).
+  virtual bool SupportsColumnar() {
+    return false;
+  }
 
  protected:
   MonitorInterface* monitor_;
@@ -67,6 +86,28 @@ class FrameworkInterface {
   virtual bool CanMerge(const op_nodes& dag, const node_set& to_schedule,
                         int32_t num_ops_to_merge) = 0;
 
+  // Returns cost and adds it to the component's total in the open trace
+  // span, e.g. the span of the ScoreDAG call that computes the cost.
+  double TraceCost(const string& component, double cost) {
+    TraceSpan* span = TraceSpan::Current();
+    if (span != NULL) {
+      span->AddToArg(component, cost);
+    }
+    return cost;
+  }
+
+  // Extra run time, as a fraction of the job's run time, that a job incurs
+  // on an engine whose monitor reports load. The job only gets the free
+  // share of the slots and runs after the queued jobs.
+  double ScoreMonitoredLoad() {
+    EngineStatus status;
+    if (monitor_ == NULL || !monitor_->PollStatus(&status)) {
+      return 0.0;
+    }
+    double free_share = max(1.0 - status.utilization, MIN_FREE_SLOT_SHARE);
+    return (1.0 + status.queued_jobs) / free_share - 1.0;
+  }
+
   uint64_t GetDataSize(
       const vector<Relation*>& rels, const relation_size& rel_size) {
     uint64_t data_size = 0;
@@ -0,0 +1,432 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_GRAPH_FRAMEWORK_INTERFACE_H
+#define MUSKETEER_GRAPH_FRAMEWORK_INTERFACE_H
+
+#include "frameworks/framework_interface.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/common.h"
+#include "ir/agg_operator.h"
+#include "ir/condition_tree.h"
+#include "ir/count_operator.h"
+#include "ir/join_operator.h"
+#include "ir/max_operator.h"
+#include "ir/min_operator.h"
+#include "ir/project_operator.h"
+#include "ir/select_operator.h"
+#include "ir/while_operator.h"
+
+namespace musketeer {
+namespace framework {
+
+using musketeer::ir::AggOperator;
+using musketeer::ir::ConditionTree;
+using musketeer::ir::CountOperator;
+using musketeer::ir::JoinOperator;
+using musketeer::ir::MaxOperator;
+using musketeer::ir::MinOperator;
+using musketeer::ir::ProjectOperator;
+using musketeer::ir::SelectOperator;
+using musketeer::ir::WhileOperator;
+
+// Common base for the vertex-centric frameworks. It detects WHILE bodies that
+// can be expressed as gather-apply-scatter programs:
+//   (edges) JOIN (vertices) ON src AND id,
+//   per-edge operators (arithmetic, PROJECT, SELECT, UNION with vertices),
+//   SUM/COUNT/MIN/MAX GROUP BY dst,
+//   per-vertex operators (arithmetic, PROJECT, SELECT),
+// plus the operator that increments the iteration counter. The operators of
+// the body must not have WHERE clauses.
+class GraphFrameworkInterface : public FrameworkInterface {
+ protected:
+  // Returns true if the framework can store a value on each edge (e.g. a
+  // weight). Otherwise, the edges may only carry an out-degree computed by a
+  // COUNT just before the loop.
+  virtual bool SupportsEdgeValues() = 0;
+  // Returns true if the framework can run a loop whose condition depends on
+  // the data until no vertex changes. Otherwise, the loop must compare the
+  // iteration counter with a constant.
+  virtual bool SupportsConvergence() = 0;
+
+  pair<bool, shared_ptr<OperatorNode> > CanMergePreWhile(
+      shared_ptr<OperatorNode> cur_node, set<string>* visited,
+      const node_set& to_schedule, int32_t* num_ops_to_schedule) {
+    visited->insert(cur_node->get_operator()->get_output_relation()->get_name());
+    // Decrease number of operators to be visited.
+    (*num_ops_to_schedule)--;
+    op_nodes children = cur_node->get_children();
+    CountOperator* count_op =
+      dynamic_cast<CountOperator*>(cur_node->get_operator());
+    int32_t cnt_index = count_op->get_column()->get_index();
+    vector<Column*> group_bys = count_op->get_group_bys();
+    // If we count on source and group by on destination then the COUNT may be
+    // pushed to the while loop.
+    if (cnt_index != 1 || group_bys.size() != 1 ||
+        group_bys[0]->get_index() != 0 || children.size() != 1 ||
+        children[0]->get_operator()->get_type() != JOIN_OP) {
+      return make_pair(false, cur_node);
+    }
+    if (to_schedule.find(children[0]) == to_schedule.end()) {
+      // The JOIN operator is not part of the graph.
+      return make_pair(false, cur_node);
+    }
+    JoinOperator* join_op =
+      dynamic_cast<JoinOperator*>(children[0]->get_operator());
+    if (join_op->get_col_left()->get_index() != 0 ||
+        join_op->get_col_right()->get_index() != 0) {
+      return make_pair(false, cur_node);
+    }
+    visited->insert(join_op->get_output_relation()->get_name());
+    // Decrease number of operators to be visited.
+    (*num_ops_to_schedule)--;
+    children = children[0]->get_children();
+    if (children.size() != 1 ||
+        children[0]->get_operator()->get_type() != WHILE_OP) {
+      return make_pair(false, cur_node);
+    }
+    return make_pair(true, children[0]);
+  }
+
+  // Check if the block before the group by operator respects the BSP pattern.
+  // cur_node is the WHILE node. On success, dst_index is set to the column
+  // that holds the destination vertex id in the input of the group by.
+  pair<bool, shared_ptr<OperatorNode> > CanMergePreGroup(
+      shared_ptr<OperatorNode> cur_node, set<string>* visited,
+      const node_set& to_schedule, int32_t* num_ops_to_schedule,
+      bool has_count, int32_t* dst_index) {
+    shared_ptr<OperatorNode> join_node = GetEdgesJoin(cur_node);
+    if (join_node == NULL) {
+      return make_pair(false, cur_node);
+    }
+    cur_node = join_node;
+    if (to_schedule.find(cur_node) == to_schedule.end()) {
+      // The node is not part of the subDAG to be scheduled.
+      return make_pair(false, cur_node);
+    }
+    JoinOperator* join_op =
+      dynamic_cast<JoinOperator*>(cur_node->get_operator());
+    vector<Relation*> join_relations = join_op->get_relations();
+    // For the moment we're working with the assumption that the left column
+    // is the one storing information about the edges.
+    // TODO(ionel): FIX!
+    vector<Column*> edges_columns = join_relations[0]->get_columns();
+    vector<Column*> vertices_columns = join_relations[1]->get_columns();
+    if (edges_columns.size() < 2 || vertices_columns.size() < 2) {
+      return make_pair(false, cur_node);
+    }
+    if (edges_columns.size() > 2 && !has_count && !SupportsEdgeValues()) {
+      return make_pair(false, cur_node);
+    }
+    if (join_op->get_col_left()->get_index() != 0 ||
+        join_op->get_col_right()->get_index() != 0) {
+      // The JOIN is not on source vertex id and vertex id.
+      return make_pair(false, cur_node);
+    }
+    string vertices_name = join_relations[1]->get_name();
+    visited->insert(join_op->get_output_relation()->get_name());
+    // Decrease number of operators to be visited.
+    (*num_ops_to_schedule)--;
+    // The destination vertex is the second column of the edges.
+    *dst_index = 1;
+    op_nodes children = cur_node->get_children();
+    for (; ; cur_node = children[0], children = children[0]->get_children()) {
+      // We don't support intermediate operators with more than one downstream
+      // operator.
+      if (children.size() != 1) {
+        return make_pair(false, cur_node);
+      }
+      if (to_schedule.find(cur_node) == to_schedule.end()) {
+        // Parts of the loop body are missing.
+        return make_pair(false, cur_node);
+      }
+      if (cur_node != join_node) {
+        visited->insert(
+            cur_node->get_operator()->get_output_relation()->get_name());
+        // Decrease number of operators to be visited.
+        (*num_ops_to_schedule)--;
+      }
+      OperatorInterface* child_op = children[0]->get_operator();
+      if (child_op->hasGroupby()) {
+        break;
+      }
+      if (!IsPerEdgeOperator(child_op, vertices_name)) {
+        return make_pair(false, children[0]);
+      }
+      // The translators fold the old vertex values into the gather of the
+      // group by that follows the UNION.
+      if (child_op->get_type() == UNION_OP &&
+          (children[0]->get_children().size() != 1 ||
+           !children[0]->get_children()[0]->get_operator()->hasGroupby())) {
+        return make_pair(false, children[0]);
+      }
+      *dst_index = TrackColumn(child_op, *dst_index);
+      if (*dst_index < 0) {
+        // The destination vertex id is dropped before the group by.
+        return make_pair(false, children[0]);
+      }
+    }
+    return make_pair(true, children[0]);
+  }
+
+  // Check if the operators post the group by operators respect the required
+  // BSP structure. cur_node is the node with the group by.
+  pair<bool, shared_ptr<OperatorNode> > CanMergePostGroup(
+      shared_ptr<OperatorNode> cur_node, set<string>* visited,
+      const node_set& to_schedule, int32_t* num_ops_to_schedule) {
+    op_nodes children = cur_node->get_children();
+    for (; children.size() > 0;
+         cur_node = children[0], children = children[0]->get_children()) {
+      // We don't support intermediate operators with more than one downstream
+      // operator.
+      if (children.size() > 1) {
+        return make_pair(false, cur_node);
+      }
+      if (to_schedule.find(children[0]) == to_schedule.end()) {
+        // Parts of the loop body are missing.
+        return make_pair(false, cur_node);
+      }
+      if (!IsPerVertexOperator(children[0]->get_operator())) {
+        return make_pair(false, children[0]);
+      }
+      visited->insert(
+          children[0]->get_operator()->get_output_relation()->get_name());
+      // Decrease number of operators to be visited.
+      (*num_ops_to_schedule)--;
+    }
+    return make_pair(true, cur_node);
+  }
+
+  bool CanMerge(const op_nodes& dag, const node_set& to_schedule,
+                int32_t num_ops_to_schedule) {
+    set<string> visited;
+    // The dag can only start with a WHILE or a COUNT.
+    if (dag.size() != 1) {
+      return false;
+    }
+    shared_ptr<OperatorNode> cur_node = dag[0];
+    if (cur_node->get_operator()->get_type() != COUNT_OP &&
+        cur_node->get_operator()->get_type() != WHILE_OP) {
+      return false;
+    }
+    bool has_count = false;
+    if (cur_node->get_operator()->get_type() == COUNT_OP) {
+      pair<bool, shared_ptr<OperatorNode> > merge_pair =
+        CanMergePreWhile(cur_node, &visited, to_schedule, &num_ops_to_schedule);
+      if (!merge_pair.first) {
+        return false;
+      }
+      cur_node = merge_pair.second;
+      has_count = true;
+    }
+    // Check if the while loop respects the graph algorithm structure.
+    if (to_schedule.find(cur_node) == to_schedule.end()) {
+      // The WHILE operator is not part of the subDAG.
+      return false;
+    }
+    ConditionTree* cond_tree =
+      dynamic_cast<WhileOperator*>(cur_node->get_operator())->get_condition_tree();
+    if (!(cond_tree->isBinary() && cond_tree->get_right()->isValue()) &&
+        !SupportsConvergence()) {
+      return false;
+    }
+    visited.insert(cur_node->get_operator()->get_output_relation()->get_name());
+    // Decrease number of operators to be visited.
+    num_ops_to_schedule--;
+    shared_ptr<OperatorNode> iter_node = GetIterationNode(cur_node);
+    if (iter_node == NULL || to_schedule.find(iter_node) == to_schedule.end()) {
+      return false;
+    }
+    visited.insert(iter_node->get_operator()->get_output_relation()->get_name());
+    num_ops_to_schedule--;
+    // Check pre group by respects structure.
+    int32_t dst_index = -1;
+    pair<bool, shared_ptr<OperatorNode> > pre_group_merge =
+      CanMergePreGroup(cur_node, &visited, to_schedule, &num_ops_to_schedule,
+                       has_count, &dst_index);
+    if (!pre_group_merge.first) {
+      return false;
+    }
+    cur_node = pre_group_merge.second;
+    if (to_schedule.find(cur_node) == to_schedule.end()) {
+      // The GroupBy operator is not part of the subDAG to be scheduled.
+      return false;
+    }
+    if (!IsGatherReducer(cur_node->get_operator(), dst_index)) {
+      VLOG(2) << "Group by cannot be mapped to a gather";
+      return false;
+    }
+    visited.insert(cur_node->get_operator()->get_output_relation()->get_name());
+    // Decrease number of operators to be visited.
+    num_ops_to_schedule--;
+    // Check post group by respects structure.
+    pair<bool, shared_ptr<OperatorNode> > post_group_merge =
+      CanMergePostGroup(cur_node, &visited, to_schedule, &num_ops_to_schedule);
+    if (!post_group_merge.first) {
+      return false;
+    }
+    if (num_ops_to_schedule > 0) {
+      // We haven't visited all the operators.
+      return false;
+    } else if (num_ops_to_schedule < 0) {
+      LOG(ERROR) << "Merged an operator twice";
+      return false;
+    } else {
+      return true;
+    }
+  }
+
+  // The WHILE body must have two inputs: the edges-vertices JOIN and the
+  // operator incrementing the iteration counter. They can be in any order.
+  shared_ptr<OperatorNode> GetEdgesJoin(shared_ptr<OperatorNode> while_node) {
+    op_nodes children = while_node->get_loop_children();
+    if (children.size() != 2) {
+      return shared_ptr<OperatorNode>();
+    }
+    for (op_nodes::iterator it = children.begin(); it != children.end();
+         ++it) {
+      if ((*it)->get_operator()->get_type() == JOIN_OP) {
+        return *it;
+      }
+    }
+    return shared_ptr<OperatorNode>();
+  }
+
+  shared_ptr<OperatorNode> GetIterationNode(
+      shared_ptr<OperatorNode> while_node) {
+    op_nodes children = while_node->get_loop_children();
+    if (children.size() != 2) {
+      return shared_ptr<OperatorNode>();
+    }
+    for (op_nodes::iterator it = children.begin(); it != children.end();
+         ++it) {
+      OperatorType type = (*it)->get_operator()->get_type();
+      if ((type == SUM_OP || type == SUB_OP) &&
+          (*it)->get_children().empty()) {
+        return *it;
+      }
+    }
+    return shared_ptr<OperatorNode>();
+  }
+
+  // Returns true if op only applies to the rows that match its WHERE
+  // clause. The graph translators do not generate code for conditions.
+  bool HasCondition(OperatorInterface* op) {
+    ConditionTree* tree = op->get_condition_tree();
+    return tree != NULL &&
+      !(tree->isValue() && tree->get_value()->get_value() == "true");
+  }
+
+  // Operators that can be computed on an edge using only the edge and the
+  // value of its source vertex. A UNION is only allowed with the vertices
+  // relation, i.e. to include the old vertex value in the group by.
+  bool IsPerEdgeOperator(OperatorInterface* op, const string& vertices_name) {
+    if (HasCondition(op)) {
+      return false;
+    }
+    switch (op->get_type()) {
+    case DIV_OP:
+    case MUL_OP:
+    case SUB_OP:
+    case SUM_OP:
+    case PROJECT_OP:
+    case SELECT_OP:
+      return true;
+    case UNION_OP: {
+      vector<Relation*> rels = op->get_relations();
+      return rels.size() == 2 && rels[1]->get_name() == vertices_name;
+    }
+    default:
+      return false;
+    }
+  }
+
+  bool IsPerVertexOperator(OperatorInterface* op) {
+    if (HasCondition(op)) {
+      return false;
+    }
+    switch (op->get_type()) {
+    case DIV_OP:
+    case MUL_OP:
+    case SUB_OP:
+    case SUM_OP:
+    case PROJECT_OP:
+    case SELECT_OP:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Returns the index of column index of the input of op in the output of op
+  // or -1 if op drops the column.
+  int32_t TrackColumn(OperatorInterface* op, int32_t index) {
+    vector<Column*> columns;
+    if (op->get_type() == PROJECT_OP) {
+      columns = dynamic_cast<ProjectOperator*>(op)->get_columns();
+    } else if (op->get_type() == SELECT_OP) {
+      columns = dynamic_cast<SelectOperator*>(op)->get_columns();
+    } else {
+      // The other per-edge operators keep the columns of their input.
+      return index;
+    }
+    for (uint32_t col_index = 0; col_index < columns.size(); ++col_index) {
+      if (columns[col_index]->get_index() == index) {
+        return col_index;
+      }
+    }
+    return -1;
+  }
+
+  // The group by must be on the destination vertex and its reducer must be
+  // commutative and associative so that it can run as a gather.
+  bool IsGatherReducer(OperatorInterface* op, int32_t dst_index) {
+    vector<Column*> group_bys;
+    switch (op->get_type()) {
+    case AGG_OP: {
+      AggOperator* agg_op = dynamic_cast<AggOperator*>(op);
+      if (agg_op->get_operator() != "+" || agg_op->get_columns().size() != 1) {
+        return false;
+      }
+      group_bys = agg_op->get_group_bys();
+      break;
+    }
+    case COUNT_OP:
+      group_bys = dynamic_cast<CountOperator*>(op)->get_group_bys();
+      break;
+    case MAX_OP:
+      group_bys = dynamic_cast<MaxOperator*>(op)->get_group_bys();
+      break;
+    case MIN_OP:
+      group_bys = dynamic_cast<MinOperator*>(op)->get_group_bys();
+      break;
+    default:
+      return false;
+    }
+    return group_bys.size() == 1 && group_bys[0]->get_index() == dst_index;
+  }
+};
+
+} // namespace framework
+} // namespace musketeer
+#endif
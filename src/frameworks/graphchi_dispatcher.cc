@@ -31,25 +31,21 @@ namespace framework {
   GraphChiDispatcher::GraphChiDispatcher() {
   }
 
-  void GraphChiDispatcher::Execute(string job_path, string job_options) {
+  string GraphChiDispatcher::GetCommand(const string& job_path,
+                                        const string& job_options) {
     // GraphChi doesn't have dynamic job options.
-    LOG(INFO) << "graphChi run started for: " << job_path;
     string path = job_path.substr(0, job_path.rfind("/"));
     string copy_bin =  path + "/DataTransformer_bin";
     string source_env = path + "/env.sh";
-    LOG(INFO) << "graphChi copy input started for: " << job_path;
-    string copy_input_cmd = source_env + " ; " + copy_bin + " copy_input";
-    system(copy_input_cmd.c_str());
-    LOG(INFO) << "graphChi copy input ended for: " << job_path;
+    string copy_input_cmd = TimePhase(
+        source_env + " ; " + copy_bin + " copy_input", "PULL");
     string cmd = source_env + " ; export GRAPHCHI_ROOT=\"" +
       FLAGS_graphchi_dir + "\" ; " + job_path +
       " filetype edgelist membudget_mb 10000 execthreads 6";
-    system(cmd.c_str());
-    LOG(INFO) << "graphChi copy output started for: " << job_path;
-    string copy_output_cmd = source_env + " ; " + copy_bin + " copy_output";
-    system(copy_output_cmd.c_str());
-    LOG(INFO) << "graphChi copy output ended for: " << job_path;
-    LOG(INFO) << "graphChi run ended for: " << job_path;
+    string copy_output_cmd = TimePhase(
+        source_env + " ; " + copy_bin + " copy_output", "PUSH");
+    // The output is only copied back if the job succeeded.
+    return copy_input_cmd + " ; (" + cmd + ") && " + copy_output_cmd;
   }
 
 } // namespace framework
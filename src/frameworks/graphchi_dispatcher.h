@@ -31,7 +31,9 @@ namespace framework {
 class GraphChiDispatcher : public DispatcherInterface {
  public:
   GraphChiDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
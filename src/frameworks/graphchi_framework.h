@@ -19,7 +19,7 @@
 #ifndef MUSKETEER_GRAPHCHI_FRAMEWORK_H
 #define MUSKETEER_GRAPHCHI_FRAMEWORK_H
 
-#include "frameworks/framework_interface.h"
+#include "frameworks/graph_framework_interface.h"
 
 #include <set>
 #include <string>
@@ -33,11 +33,12 @@
 namespace musketeer {
 namespace framework {
 
-class GraphChiFramework: public FrameworkInterface {
+class GraphChiFramework: public GraphFrameworkInterface {
  public:
   GraphChiFramework();
   string Translate(const op_nodes& dag, const string& relation);
-  void Dispatch(const string& binary, const string& relation);
+  int Dispatch(const string& binary, const string& relation,
+               map<string, uint64_t>* job_output = NULL);
   FmwType GetType();
   uint32_t ScoreDAG(const node_list& nodes, const relation_size& rel_size);
   double ScoreOperator(shared_ptr<OperatorNode> op_node,
@@ -49,17 +50,8 @@ class GraphChiFramework: public FrameworkInterface {
   double ScoreRuntime(uint64_t data_size_kb, const node_list& nodes,
                       const relation_size& rel_size);
   double ScorePush(uint64_t data_size_kb);
-  pair<bool, shared_ptr<OperatorNode> > CanMergePreWhile(
-      shared_ptr<OperatorNode> cur_node, set<string>* visited,
-      const node_set& to_schedule, int32_t* num_ops_to_schedule);
-  pair<bool, shared_ptr<OperatorNode> > CanMergePreGroup(
-      shared_ptr<OperatorNode> cur_node, set<string>* visited,
-      const node_set& to_schedule, int32_t* num_ops_to_schedule);
-  pair<bool, shared_ptr<OperatorNode> > CanMergePostGroup(
-      shared_ptr<OperatorNode> cur_node, set<string>* visited,
-      const node_set& to_schedule, int32_t* num_ops_to_schedule);
-  bool CanMerge(const op_nodes& dag, const node_set& to_schedule,
-                int32_t num_ops_to_schedule);
+  bool SupportsEdgeValues();
+  bool SupportsConvergence();
 };
 
 } // namespace framework
@@ -30,13 +30,10 @@ namespace framework {
   HadoopDispatcher::HadoopDispatcher() {
   }
 
-  void HadoopDispatcher::Execute(string job_path, string job_options) {
+  string HadoopDispatcher::GetCommand(const string& job_path,
+                                      const string& job_options) {
     // XXX(malte): hack hack hack
-    string cmd = "hadoop jar " + job_path + " " + job_options;
-    LOG(INFO) << "hadoop run started for: " << job_path;
-    LOG(INFO) << "hadoop run started for: " << cmd;
-    system(cmd.c_str());
-    LOG(INFO) << "hadoop run ended for: " << job_path;
+    return "hadoop jar " + job_path + " " + job_options;
   }
 
 } // namespace framework
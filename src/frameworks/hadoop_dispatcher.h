@@ -32,7 +32,9 @@ namespace framework {
 class HadoopDispatcher : public DispatcherInterface {
  public:
   HadoopDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
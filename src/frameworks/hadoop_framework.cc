@@ -26,6 +26,8 @@
 #include <utility>
 #include <vector>
 
+#include "monitoring/status_poller.h"
+
 #define HADOOP_START_TIME 15.0
 #define NUM_HADOOP_MACHINES 100
 
@@ -34,10 +36,11 @@ namespace framework {
 
   using musketeer::translator::TranslatorHadoop;
   using musketeer::monitor::HadoopMonitor;
+  using musketeer::monitor::StatusPoller;
 
   HadoopFramework::HadoopFramework(): FrameworkInterface() {
     dispatcher_ = new HadoopDispatcher();
-    monitor_ = new HadoopMonitor();
+    monitor_ = new StatusPoller("Hadoop", new HadoopMonitor());
   }
 
   string HadoopFramework::Translate(const op_nodes& dag,
@@ -47,17 +50,23 @@ namespace framework {
     return translator_hadoop.GenerateCode();
   }
 
-  void HadoopFramework::Dispatch(const string& binary_file,
-                                 const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int HadoopFramework::Dispatch(const string& binary_file,
+                                const string& relation,
+                                map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   FmwType HadoopFramework::GetType() {
     return FMW_HADOOP;
   }
 
+  bool HadoopFramework::SupportsColumnar() {
+    return true;
+  }
+
   uint32_t HadoopFramework::ScoreDAG(const node_list& nodes,
                                      const relation_size& rel_size) {
     node_set to_schedule;
@@ -88,21 +97,29 @@ namespace framework {
           input_nodes[0]->get_operator()->get_condition_tree()->getNumIterations();
         uint64_t input_data_size_kb = GetInputSizeOfWhile(input_nodes[0], rel_size);
         uint64_t output_data_size_kb = GetOutputSizeOfWhile(input_nodes[0], rel_size);
-        double cost_per_iteration = ScorePull(input_data_size_kb) +
-          ScoreLoad(input_data_size_kb) + ScorePush(output_data_size_kb);
+        double cost_per_iteration =
+          TraceCost("pull", ScorePull(input_data_size_kb)) +
+          TraceCost("load", ScoreLoad(input_data_size_kb)) +
+          TraceCost("push", ScorePush(output_data_size_kb));
         return num_iterations * cost_per_iteration;
       }
+      double time_job = HADOOP_START_TIME +
+        TraceCost("compile", ScoreCompile()) +
+        TraceCost("load", ScoreLoad(input_data_size)) +
+        TraceCost("runtime", ScoreRuntime(input_data_size, nodes, rel_size)) +
+        TraceCost("push", ScorePush(output_data_size));
+      shared_ptr<OperatorNode> while_op = IsInWhileBody(nodes);
+      if (while_op) {
+        // Hadoop cannot iterate, so the job is launched once per iteration.
+        time_job *=
+          while_op->get_operator()->get_condition_tree()->getNumIterations();
+      }
+      time_job *= 1.0 + TraceCost("cluster_state", ScoreClusterState());
       if (FLAGS_best_runtime) {
-        return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                   HADOOP_START_TIME + ScoreCompile() + ScoreLoad(input_data_size) +
-                   ScoreRuntime(input_data_size, nodes, rel_size) +
-                   ScorePush(output_data_size));
+        return min(static_cast<double>(FLAGS_max_scheduler_cost), time_job);
       } else {
         return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                   (HADOOP_START_TIME + ScoreCompile() + ScoreLoad(input_data_size) +
-                    ScoreRuntime(input_data_size, nodes, rel_size) +
-                    ScorePush(output_data_size)) *
-                   NUM_HADOOP_MACHINES);
+                   time_job * NUM_HADOOP_MACHINES);
       }
     } else {
       VLOG(2) << "Cannot merge in " << FrameworkToString(GetType());
@@ -209,6 +226,22 @@ namespace framework {
       expected_output_size = it->second.second;
     }
     double time = expected_output_size / NUM_HADOOP_MACHINES / 7.0 / 1024.0;
+    // A broadcast join runs in the map: every machine loads the small input
+    // and scans its share of the other one, at the map-only rate.
+    int32_t broadcast_input =
+      dynamic_cast<ir::JoinOperator*>(op)->broadcastInput(rel_size);
+    if (broadcast_input >= 0) {
+      uint64_t broadcast_size =
+        broadcast_input == 0 ? left_data_size : right_data_size;
+      uint64_t stream_size =
+        broadcast_input == 0 ? right_data_size : left_data_size;
+      double broadcast_time =
+        (stream_size / NUM_HADOOP_MACHINES + broadcast_size +
+         expected_output_size / NUM_HADOOP_MACHINES) / 30.0 / 1024.0;
+      VLOG(2) << "Join " << output_rel_name << " takes " << time
+              << "s shuffled and " << broadcast_time << "s broadcast";
+      time = broadcast_time;
+    }
     return time * FLAGS_time_to_cost;
   }
 
@@ -239,9 +272,9 @@ namespace framework {
   }
 
   double HadoopFramework::ScoreClusterState() {
-    // CurrentUtilizaion returns a value tha represents the max between
-    // the percentage of map slots and the percentage of reduce slots occupied.
-    return monitor_->CurrentUtilization();
+    // The monitor reports the max between the percentage of map slots and
+    // the percentage of reduce slots occupied.
+    return ScoreMonitoredLoad();
   }
 
   // The compile time in Hadoop takes around 5s.
@@ -35,8 +35,10 @@ class HadoopFramework: public FrameworkInterface {
  public:
   HadoopFramework();
   string Translate(const op_nodes& dag, const string& relation);
-  void Dispatch(const string& binary, const string& relation);
+  int Dispatch(const string& binary, const string& relation,
+               map<string, uint64_t>* job_output = NULL);
   FmwType GetType();
+  bool SupportsColumnar();
   uint32_t ScoreDAG(const node_list& nodes, const relation_size& rel_size);
   double ScoreMapOnly(OperatorInterface* op, const relation_size& rel_size);
   double ScoreMapRedGroup(OperatorInterface* op, const relation_size& rel_size);
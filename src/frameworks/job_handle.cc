@@ -0,0 +1,282 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "frameworks/job_handle.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Time a cancelled job has to exit before it is killed.
+#define CANCEL_GRACE_PERIOD_S 10
+
+// Lines that Hadoop and YARN clients print when they submit a job. The id
+// of the job follows the prefix.
+static const char* CLUSTER_JOB_PREFIXES[] = {
+  "Running job: ",
+  "Submitted application ",
+};
+
+namespace musketeer {
+
+  JobHandle::JobHandle(const string& name)
+    : name_(name), pid_(-1), done_(false), cancelled_(false),
+      exit_status_(-1), runner_(NULL) {
+  }
+
+  JobHandle::~JobHandle() {
+    if (!IsDone()) {
+      Cancel();
+    }
+    if (runner_ != NULL) {
+      runner_->join();
+      delete runner_;
+    }
+  }
+
+  JobHandle* JobHandle::StartProcess(const string& name, const string& cmd) {
+    JobHandle* job = new JobHandle(name);
+    int output[2];
+    // Jobs started concurrently by other threads must not inherit our end of
+    // the pipe, or reading the output would wait for them to exit. dup2
+    // clears the flag on the job's stdout and stderr.
+    if (pipe2(output, O_CLOEXEC) != 0) {
+      LOG(ERROR) << "Could not create the output pipe of " << name;
+      job->Finish(127);
+      return job;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      // Put the job in its own process group so that cancelling it also
+      // stops the processes it starts.
+      setpgid(0, 0);
+      dup2(output[1], STDOUT_FILENO);
+      dup2(output[1], STDERR_FILENO);
+      close(output[0]);
+      close(output[1]);
+      execl("/bin/sh", "sh", "-c", cmd.c_str(), static_cast<char*>(NULL));
+      _exit(127);
+    }
+    close(output[1]);
+    if (pid < 0) {
+      LOG(ERROR) << "Could not start " << name;
+      close(output[0]);
+      job->Finish(127);
+      return job;
+    }
+    setpgid(pid, pid);
+    job->pid_ = pid;
+    job->runner_ = new boost::thread(
+        boost::bind(&JobHandle::ReadOutput, job, output[0]));
+    return job;
+  }
+
+  JobHandle* JobHandle::StartFunction(
+      const string& name, const boost::function<int(JobHandle*)>& fn) {
+    JobHandle* job = new JobHandle(name);
+    job->runner_ =
+      new boost::thread(boost::bind(&JobHandle::RunFunction, job, fn));
+    return job;
+  }
+
+  void JobHandle::RunFunction(boost::function<int(JobHandle*)> fn) {
+    Finish(fn(this));
+  }
+
+  void JobHandle::ReadOutput(int output_fd) {
+    FILE* output = fdopen(output_fd, "r");
+    char* line = NULL;
+    size_t line_len = 0;
+    while (getline(&line, &line_len, output) != -1) {
+      cout << line;
+      ReportOutput(line);
+    }
+    free(line);
+    fclose(output);
+    int status = 0;
+    rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    while (wait4(pid_, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    // Includes the processes the job waited for.
+    SetProgress("METRIC PEAK RSS KB", usage.ru_maxrss);
+    if (WIFEXITED(status)) {
+      Finish(WEXITSTATUS(status));
+    } else if (WIFSIGNALED(status)) {
+      Finish(128 + WTERMSIG(status));
+    } else {
+      Finish(127);
+    }
+  }
+
+  void JobHandle::ReportOutput(const char* line) {
+    for (size_t i = 0;
+         i < sizeof(CLUSTER_JOB_PREFIXES) / sizeof(CLUSTER_JOB_PREFIXES[0]);
+         ++i) {
+      const char* id = strstr(line, CLUSTER_JOB_PREFIXES[i]);
+      if (id != NULL) {
+        id += strlen(CLUSTER_JOB_PREFIXES[i]);
+        size_t id_len = strspn(id, "abcdefghijklmnopqrstuvwxyz"
+                               "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+        if (id_len > 0) {
+          boost::lock_guard<boost::mutex> lock(job_mutex_);
+          cluster_jobs_.push_back(string(id, id_len));
+        }
+        return;
+      }
+    }
+    // Jobs report values as lines such as "METRIC RUN MS: 12".
+    const char* colon = strchr(line, ':');
+    if (colon == NULL || colon == line) {
+      return;
+    }
+    for (const char* c = line; c < colon; ++c) {
+      if ((*c < 'A' || *c > 'Z') && *c != ' ') {
+        return;
+      }
+    }
+    char* value_end;
+    uint64_t value = strtoull(colon + 1, &value_end, 10);
+    if (value_end != colon + 1) {
+      SetProgress(string(line, colon), value);
+    }
+  }
+
+  void JobHandle::SetProgress(const string& key, uint64_t value) {
+    boost::lock_guard<boost::mutex> lock(job_mutex_);
+    map<string, uint64_t>::iterator it = progress_.find(key);
+    if (it == progress_.end()) {
+      progress_[key] = value;
+    } else {
+      it->second = max(it->second, value);
+    }
+  }
+
+  void JobHandle::Finish(int exit_status) {
+    {
+      boost::lock_guard<boost::mutex> lock(job_mutex_);
+      exit_status_ = exit_status;
+      done_ = true;
+    }
+    done_cond_.notify_all();
+  }
+
+  int JobHandle::Wait() {
+    boost::unique_lock<boost::mutex> lock(job_mutex_);
+    while (!done_) {
+      done_cond_.wait(lock);
+    }
+    return exit_status_;
+  }
+
+  bool JobHandle::WaitFor(uint64_t timeout_s) {
+    boost::unique_lock<boost::mutex> lock(job_mutex_);
+    boost::system_time deadline =
+      boost::get_system_time() + boost::posix_time::seconds(timeout_s);
+    while (!done_) {
+      if (!done_cond_.timed_wait(lock, deadline)) {
+        break;
+      }
+    }
+    return done_;
+  }
+
+  bool JobHandle::Cancel() {
+    if (pid_ < 0) {
+      LOG(ERROR) << "Job " << name_ << " cannot be cancelled";
+      return false;
+    }
+    {
+      boost::lock_guard<boost::mutex> lock(job_mutex_);
+      if (done_) {
+        return true;
+      }
+      cancelled_ = true;
+    }
+    LOG(INFO) << "Cancelling job " << name_;
+    kill(-pid_, SIGTERM);
+    if (!WaitFor(CANCEL_GRACE_PERIOD_S)) {
+      kill(-pid_, SIGKILL);
+    }
+    KillClusterJobs();
+    return true;
+  }
+
+  void JobHandle::KillClusterJobs() {
+    vector<string> cluster_jobs;
+    {
+      boost::lock_guard<boost::mutex> lock(job_mutex_);
+      cluster_jobs = cluster_jobs_;
+    }
+    for (vector<string>::iterator it = cluster_jobs.begin();
+         it != cluster_jobs.end(); ++it) {
+      string cmd;
+      if (it->compare(0, strlen("application_"), "application_") == 0) {
+        cmd = "yarn application -kill " + *it;
+      } else if (it->compare(0, strlen("job_"), "job_") == 0) {
+        cmd = "hadoop job -kill " + *it;
+      } else {
+        continue;
+      }
+      LOG(INFO) << "Killing cluster job " << *it << " of " << name_;
+      if (std::system(cmd.c_str()) != 0) {
+        LOG(ERROR) << "Could not kill cluster job " << *it << " of " << name_;
+      }
+    }
+  }
+
+  bool JobHandle::IsDone() {
+    boost::lock_guard<boost::mutex> lock(job_mutex_);
+    return done_;
+  }
+
+  bool JobHandle::IsCancelled() {
+    boost::lock_guard<boost::mutex> lock(job_mutex_);
+    return cancelled_;
+  }
+
+  int JobHandle::get_exit_status() {
+    boost::lock_guard<boost::mutex> lock(job_mutex_);
+    return exit_status_;
+  }
+
+  const string& JobHandle::get_name() {
+    return name_;
+  }
+
+  map<string, uint64_t> JobHandle::GetProgress() {
+    boost::lock_guard<boost::mutex> lock(job_mutex_);
+    return progress_;
+  }
+
+} // namespace musketeer
@@ -0,0 +1,95 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_JOB_HANDLE_H
+#define MUSKETEER_JOB_HANDLE_H
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/common.h"
+
+namespace musketeer {
+
+// A job started by a dispatcher. The handle reports the job's progress and
+// exit status, and can cancel the job or wait for it with a timeout.
+class JobHandle {
+ public:
+  // Runs cmd through the shell in a process group of its own. The job's
+  // output is forwarded to our stdout and scanned for progress lines.
+  static JobHandle* StartProcess(const string& name, const string& cmd);
+  // Runs fn in a thread. fn is given the job's handle so that it can report
+  // the job's output. Such jobs cannot be cancelled.
+  static JobHandle* StartFunction(const string& name,
+                                  const boost::function<int(JobHandle*)>& fn);
+  ~JobHandle();
+
+  // Blocks until the job ends and returns its exit status.
+  int Wait();
+  // Returns true if the job ended within timeout_s seconds.
+  bool WaitFor(uint64_t timeout_s);
+  // Terminates the job's process group and kills the Hadoop or YARN jobs it
+  // submitted, which would otherwise keep running on the cluster. Returns
+  // false if the job cannot be cancelled.
+  bool Cancel();
+  bool IsDone();
+  bool IsCancelled();
+  // Exit status of the job, or a negative value while it is running. Jobs
+  // killed by a signal report 128 plus the signal number.
+  int get_exit_status();
+  const string& get_name();
+  // The values the job has printed so far as "UPPER CASE KEY: number"
+  // lines, e.g. "METRIC LOAD MS" -> 1200. A key printed several times, e.g.
+  // once by every process of a distributed job, keeps its largest value.
+  // Jobs run as processes also report "METRIC PEAK RSS KB" when they end.
+  map<string, uint64_t> GetProgress();
+  // Scans a line of the job's output for a progress value.
+  void ReportOutput(const char* line);
+  void SetProgress(const string& key, uint64_t value);
+
+ private:
+  explicit JobHandle(const string& name);
+  void ReadOutput(int output_fd);
+  void RunFunction(boost::function<int(JobHandle*)> fn);
+  void Finish(int exit_status);
+  void KillClusterJobs();
+
+  string name_;
+  pid_t pid_;
+  bool done_;
+  bool cancelled_;
+  int exit_status_;
+  map<string, uint64_t> progress_;
+  // Ids of the jobs submitted to a Hadoop or YARN cluster, as printed by
+  // their clients.
+  vector<string> cluster_jobs_;
+  boost::thread* runner_;
+  boost::mutex job_mutex_;
+  boost::condition_variable done_cond_;
+};
+
+} // namespace musketeer
+#endif
@@ -18,7 +18,12 @@
 
 #include "frameworks/metis_dispatcher.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <map>
 #include <string>
+#include <vector>
 #include <stdlib.h>
 
 #include "base/common.h"
@@ -27,29 +32,112 @@
 namespace musketeer {
 namespace framework {
 
-  MetisDispatcher::MetisDispatcher() {
+  MetisDispatcher::MetisDispatcher()
+    : workers_(NULL), worker_unavailable_(false) {
+  }
+
+  string MetisDispatcher::GetEnvironment() {
+    string env;
+    if (atoi(FLAGS_metis_glog_v.c_str()) >= 0) {
+      env += "GLOG_v=";
+      env += FLAGS_metis_glog_v;
+      env += " GLOG_logtostderr=1 ";
+    }
+    return env;
   }
 
-  void MetisDispatcher::Execute(string job_path, string job_options) {
+  // Runs the job's shared library in a resident worker. This avoids starting
+  // a new process, and with it the JVM used by libhdfs, for every job.
+  bool MetisDispatcher::ExecuteInWorker(const string& job_path,
+                                        const string& job_options,
+                                        int* status,
+                                        vector<string>* metrics) {
+    {
+      boost::lock_guard<boost::mutex> lock(workers_mutex_);
+      if (worker_unavailable_) {
+        return false;
+      }
+      if (workers_ == NULL) {
+        string worker_dir = FLAGS_generated_code_dir + "/metis_worker/";
+        string build_cmd = "mkdir -p " + worker_dir + " && cp " +
+          FLAGS_metis_templates_dir + "/metis_worker.cc " +
+          FLAGS_metis_templates_dir + "/Makefile_worker " + worker_dir +
+          " && make -C " + worker_dir + " -f Makefile_worker METIS_ROOT=" +
+          FLAGS_metis_dir + " USE_HDFS=" + (FLAGS_metis_use_hdfs ? "1" : "0");
+        LOG(INFO) << "Building Metis worker: " << build_cmd;
+        if (system(build_cmd.c_str()) != 0) {
+          LOG(ERROR) << "Could not build the Metis worker. Running jobs in "
+                     << "their own processes";
+          worker_unavailable_ = true;
+          return false;
+        }
+        workers_ = new EngineWorkerPool(
+            GetEnvironment() + worker_dir + "metis_worker",
+            worker_dir + "worker", FLAGS_metis_num_workers);
+      }
+    }
+    string job_lib = job_path.substr(0, job_path.rfind("_bin")) + "_lib.so";
+    LOG(INFO) << "metis run started in worker for: " << job_path;
+    return workers_->Execute(job_lib + " " + job_options, status, metrics);
+  }
+
+  int MetisDispatcher::RunJob(const string& job_path,
+                              const string& job_options, JobHandle* job) {
+    int status = 0;
+    vector<string> metrics;
+    // Only fall back to a process of its own if the job never started in a
+    // worker; a job that failed in the worker is not run again.
+    if (ExecuteInWorker(job_path, job_options, &status, &metrics)) {
+      for (vector<string>::iterator it = metrics.begin(); it != metrics.end();
+           ++it) {
+        job->ReportOutput(it->c_str());
+      }
+      return status;
+    }
+    JobHandle* process =
+      DispatcherInterface::ExecuteAsync(job_path, job_options);
+    status = process->Wait();
+    map<string, uint64_t> progress = process->GetProgress();
+    for (map<string, uint64_t>::iterator it = progress.begin();
+         it != progress.end(); ++it) {
+      job->SetProgress(it->first, it->second);
+    }
+    delete process;
+    return status;
+  }
+
+  JobHandle* MetisDispatcher::ExecuteAsync(string job_path,
+                                           string job_options) {
+    // Debugging and profiling wrap the job's own process. Jobs in a worker
+    // cannot be cancelled, so --job_timeout and speculative jobs also need a
+    // process per job.
+    if (!FLAGS_metis_use_worker || FLAGS_job_timeout > 0 ||
+        FLAGS_speculative_replanning ||
+        FLAGS_metis_debug_binaries ||
+        FLAGS_metis_strace_binaries || FLAGS_metis_heapprofile ||
+        FLAGS_metis_cpuprofile) {
+      return DispatcherInterface::ExecuteAsync(job_path, job_options);
+    }
+    return JobHandle::StartFunction(
+        job_path,
+        boost::bind(&MetisDispatcher::RunJob, this, job_path, job_options,
+                    _1));
+  }
+
+  string MetisDispatcher::GetCommand(const string& job_path,
+                                     const string& job_options) {
     string cmd;
     if (FLAGS_metis_heapprofile)
       cmd += "HEAP_PROFILE=/tmp/heapprofile ";
     if (FLAGS_metis_cpuprofile)
       cmd += "CPU_PROFILE=/tmp/cpuprofile ";
-    if (atoi(FLAGS_metis_glog_v.c_str()) >= 0) {
-      cmd += "GLOG_v=";
-      cmd += FLAGS_metis_glog_v;
-      cmd += " GLOG_logtostderr=1 ";
-    }
+    cmd += GetEnvironment();
     if (FLAGS_metis_debug_binaries)
       cmd += "gdb --args ";
     if (FLAGS_metis_strace_binaries)
       cmd += "strace ";
     cmd += (job_path + " " + job_options);
-    LOG(INFO) << "Metis command: " << cmd;
-    LOG(INFO) << "metis run started for: " << job_path;
-    system(cmd.c_str());
-    LOG(INFO) << "metis run ended for: " << job_path;
+    return cmd;
   }
 
 } // namespace framework
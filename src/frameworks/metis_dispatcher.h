@@ -21,9 +21,13 @@
 
 #include "frameworks/dispatcher_interface.h"
 
+#include <boost/thread/mutex.hpp>
+
 #include <string>
+#include <vector>
 
 #include "base/common.h"
+#include "frameworks/engine_worker.h"
 
 namespace musketeer {
 namespace framework {
@@ -31,7 +35,21 @@ namespace framework {
 class MetisDispatcher : public DispatcherInterface {
  public:
   MetisDispatcher();
-  void Execute(string job_path, string job_options);
+  JobHandle* ExecuteAsync(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
+
+ private:
+  string GetEnvironment();
+  bool ExecuteInWorker(const string& job_path, const string& job_options,
+                       int* status, vector<string>* metrics);
+  int RunJob(const string& job_path, const string& job_options,
+             JobHandle* job);
+
+  EngineWorkerPool* workers_;
+  bool worker_unavailable_;
+  boost::mutex workers_mutex_;
 };
 
 } // namespace framework
@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <limits>
 #include <map>
+#include <queue>
 #include <set>
 #include <string>
 #include <utility>
@@ -43,17 +44,23 @@ namespace framework {
     return binary_file;
   }
 
-  void MetisFramework::Dispatch(const string& binary_file,
-                                const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int MetisFramework::Dispatch(const string& binary_file,
+                               const string& relation,
+                               map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   FmwType MetisFramework::GetType() {
     return FMW_METIS;
   }
 
+  bool MetisFramework::SupportsColumnar() {
+    return true;
+  }
+
   double MetisFramework::ScoreMapOnly(OperatorInterface* op,
                                       const relation_size& rel_size) {
     string input_rel = op->get_relations()[0]->get_name();
@@ -147,6 +154,16 @@ namespace framework {
     if (op->get_type() == BLACK_BOX_OP || op->get_type() == UDF_OP) {
       return FLAGS_max_scheduler_cost;
     }
+    if (op->get_type() == AGG_OP) {
+      // The generated aggregation reduces all columns as one C type.
+      vector<Column*> cols = dynamic_cast<AggOperator*>(op)->get_columns();
+      for (vector<Column*>::iterator it = cols.begin(); it != cols.end();
+           ++it) {
+        if ((*it)->get_type() != cols[0]->get_type()) {
+          return FLAGS_max_scheduler_cost;
+        }
+      }
+    }
     if (op->mapOnly()) {
       return ScoreMapOnly(op, rel_size);
     }
@@ -222,13 +239,26 @@ namespace framework {
     node_set to_schedule;
     op_nodes input_nodes;
     int32_t num_ops_to_schedule = 0;
-    // At the moment we only support one input DAGs in Metis.
-    input_nodes.push_back(nodes.front());
     for (node_list::const_iterator it = nodes.begin(); it != nodes.end();
          ++it) {
       to_schedule.insert(*it);
       num_ops_to_schedule++;
     }
+    // Operators that read the job's input and share its scan.
+    for (node_list::const_iterator it = nodes.begin(); it != nodes.end();
+         ++it) {
+      op_nodes parents = (*it)->get_parents();
+      bool is_input = true;
+      for (op_nodes::iterator p_it = parents.begin(); p_it != parents.end();
+           ++p_it) {
+        if (to_schedule.find(*p_it) != to_schedule.end()) {
+          is_input = false;
+        }
+      }
+      if (is_input) {
+        input_nodes.push_back(*it);
+      }
+    }
     if (CanMerge(input_nodes, to_schedule, num_ops_to_schedule)) {
       VLOG(2) << "Can merge in " << FrameworkToString(GetType());
       set<string> input_names;
@@ -238,38 +268,43 @@ namespace framework {
         GetDataSize(DetermineFinalOutputs(input_nodes, nodes), rel_size);
       // TODO(ionel): FIX! ScorePush(output_data_size);
       return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                 ScoreCompile() + ScorePull(input_data_size) +
-                 ScoreLoad(input_data_size) +
-                 ScoreRuntime(input_data_size, nodes, rel_size) +
-                 ScorePush(output_data_size));
+                 TraceCost("compile", ScoreCompile()) +
+                 TraceCost("pull", ScorePull(input_data_size)) +
+                 TraceCost("load", ScoreLoad(input_data_size)) +
+                 TraceCost("runtime",
+                           ScoreRuntime(input_data_size, nodes, rel_size)) +
+                 TraceCost("push", ScorePush(output_data_size)));
     } else {
       VLOG(2) << "Cannot merge in " << FrameworkToString(GetType());
       return numeric_limits<uint32_t>::max();
     }
   }
 
+  // The operators may fan out and several of them may read the job's input.
+  // Every operator must have at most one parent in the job and every pipeline
+  // at most one operator that needs a reduce.
   bool MetisFramework::CanMerge(const op_nodes& dag,
                                 const node_set& to_schedule,
                                 int32_t num_ops_to_schedule) {
-    set<string> visited;
-    // Can't merge DAGs that have more than 1 operator as input.
-    if (dag.size() != 1) {
-      return false;
-    }
-    bool got_reduce = false;
-    shared_ptr<OperatorNode> cur_node = dag[0];
-    op_nodes children = cur_node->get_children();
-    for (; ; children = cur_node->get_children()) {
-      // UDFs are currently non-mergeable.
-      // WHILE is not mergeable in our current implementation.
-      if (to_schedule.find(cur_node) == to_schedule.end()) {
+    set<shared_ptr<OperatorNode> > visited;
+    // Nodes to visit and whether their pipeline already has a reduce.
+    queue<pair<shared_ptr<OperatorNode>, bool> > to_visit;
+    for (op_nodes::const_iterator it = dag.begin(); it != dag.end(); ++it) {
+      if (to_schedule.find(*it) == to_schedule.end()) {
         // The node is not part of the subDAG to be scheduled.
         return false;
       }
-      visited.insert(
-          cur_node->get_operator()->get_output_relation()->get_name());
+      visited.insert(*it);
+      to_visit.push(make_pair(*it, false));
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> cur_node = to_visit.front().first;
+      bool got_reduce = to_visit.front().second;
+      to_visit.pop();
       // Decrease number of operators to be visited.
       num_ops_to_schedule--;
+      // UDFs are currently non-mergeable.
+      // WHILE is not mergeable in our current implementation.
       if (cur_node->get_operator()->get_type() == BLACK_BOX_OP ||
           cur_node->get_operator()->get_type() == UDF_OP ||
           cur_node->get_operator()->get_type() == WHILE_OP) {
@@ -283,18 +318,22 @@ namespace framework {
           got_reduce = true;
         }
       }
+      op_nodes children = cur_node->get_children();
       uint16_t num_children_to_schedule = 0;
       for (op_nodes::iterator c_it = children.begin(); c_it != children.end();
            ++c_it) {
         if (to_schedule.find(*c_it) != to_schedule.end()) {
-          cur_node = *c_it;
+          if (!visited.insert(*c_it).second) {
+            // We can't merge operators that have two parents in the job.
+            return false;
+          }
+          to_visit.push(make_pair(*c_it, got_reduce));
           num_children_to_schedule++;
         }
       }
-      if (num_children_to_schedule == 0) {
-        break;
-      } else if (num_children_to_schedule > 1) {
-        // We can't merge nodes that have more than one children.
+      if (num_children_to_schedule > 0 &&
+          num_children_to_schedule != children.size()) {
+        // Only the outputs of the last operators in the job are written.
         return false;
       }
     }
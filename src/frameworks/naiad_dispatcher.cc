@@ -31,15 +31,12 @@ namespace musketeer {
   NaiadDispatcher::NaiadDispatcher() {
   }
 
-  void NaiadDispatcher::Execute(string job_path, string job_options) {
-    LOG(INFO) << "naiad run started for: " << job_path;
-    LOG(INFO) << "naiad copy input started for: " << job_path;
+  string NaiadDispatcher::GetCommand(const string& job_path,
+                                     const string& job_options) {
     string copy_input_cmd = "parallel-ssh -h " + FLAGS_naiad_hosts_file +
-      " -t 10000 -p 100 -i 'START_TIME=`date +%s` ; sh " +
-      FLAGS_generated_code_dir + "Musketeer/hdfs_get.sh ; END_TIME=`date +%s` ; " +
-      "PULL_TIME=`expr $END_TIME - $START_TIME` ; echo \"PULLING DATA: \"$PULL_TIME'";
-    system(copy_input_cmd.c_str());
-    LOG(INFO) << "naiad copy input ended for: " << job_path;
+      " -t 10000 -p 100 -i 'START_TIME=`date +%s%3N` ; sh " +
+      FLAGS_generated_code_dir + "Musketeer/hdfs_get.sh ; END_TIME=`date +%s%3N` ; " +
+      "PULL_TIME=`expr $END_TIME - $START_TIME` ; echo \"METRIC PULL MS: \"$PULL_TIME'";
     string run_cmd = "parallel-ssh -h " + FLAGS_naiad_hosts_file +
       " -t 10000 -p 100 -i 'PROCID=`" + FLAGS_generated_code_dir +
       "Musketeer/get_proc_id.sh` ; cd " + FLAGS_generated_code_dir + " ; mono-sgen " +
@@ -47,12 +44,10 @@ namespace musketeer {
       boost::lexical_cast<string>(FLAGS_naiad_num_workers) + " -t " +
       boost::lexical_cast<string>(FLAGS_naiad_num_threads) + " -h @" +
       FLAGS_naiad_hosts_file +
-      " --inlineserializer ; START_TIME=`date +%s` ; sh Musketeer/hdfs_put.sh ; " +
-      "END_TIME=`date +%s` ; PUSH_TIME=`expr $END_TIME - $START_TIME` ; " +
-      "echo \"PUSHING DATA: \"$PUSH_TIME'";
-    LOG(INFO) << "Running: " << run_cmd;
-    system(run_cmd.c_str());
-    LOG(INFO) << "naiad run ended for: " << job_path;
+      " --inlineserializer ; START_TIME=`date +%s%3N` ; sh Musketeer/hdfs_put.sh ; " +
+      "END_TIME=`date +%s%3N` ; PUSH_TIME=`expr $END_TIME - $START_TIME` ; " +
+      "echo \"METRIC PUSH MS: \"$PUSH_TIME'";
+    return copy_input_cmd + " ; " + run_cmd;
   }
 
 } // namespace musketeer
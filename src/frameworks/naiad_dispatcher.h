@@ -30,7 +30,9 @@ namespace musketeer {
 class NaiadDispatcher : public DispatcherInterface {
  public:
   NaiadDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace musketeer
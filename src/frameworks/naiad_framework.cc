@@ -44,11 +44,13 @@ namespace framework {
     return translator_naiad.GenerateCode();
   }
 
-  void NaiadFramework::Dispatch(const string& binary_file,
-                                const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int NaiadFramework::Dispatch(const string& binary_file,
+                               const string& relation,
+                               map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   uint32_t NaiadFramework::ScoreDAG(const node_list& nodes,
@@ -70,8 +72,9 @@ namespace framework {
           *DetermineInputs(input_nodes, &input_names), rel_size);
       uint64_t output_data_size =
         GetDataSize(DetermineFinalOutputs(input_nodes, nodes), rel_size);
-      double time_compile_read_write = ScoreCompile() +
-        ScoreLoad(input_data_size) + ScorePush(output_data_size);
+      double time_compile_read_write = TraceCost("compile", ScoreCompile()) +
+        TraceCost("load", ScoreLoad(input_data_size)) +
+        TraceCost("push", ScorePush(output_data_size));
       shared_ptr<OperatorNode> while_op = IsInWhileBody(nodes);
       if (while_op) {
         time_compile_read_write *=
@@ -80,11 +83,13 @@ namespace framework {
       if (FLAGS_best_runtime) {
         return min(static_cast<double>(FLAGS_max_scheduler_cost),
                    time_compile_read_write +
-                   ScoreRuntime(input_data_size, nodes, rel_size));
+                   TraceCost("runtime",
+                             ScoreRuntime(input_data_size, nodes, rel_size)));
       } else {
         return min(static_cast<double>(FLAGS_max_scheduler_cost),
                    (time_compile_read_write +
-                    ScoreRuntime(input_data_size, nodes, rel_size)) *
+                    TraceCost("runtime",
+                              ScoreRuntime(input_data_size, nodes, rel_size))) *
                    FLAGS_naiad_num_workers);
       }
     } else {
@@ -100,6 +105,11 @@ namespace framework {
     for (node_set::const_iterator it = to_schedule.begin();
          it != to_schedule.end(); ++it) {
       if ((*it)->get_operator()->get_type() == WHILE_OP) {
+        // The generated code unrolls the loop while it builds the dataflow,
+        // so only loops with a fixed number of iterations can run in Naiad.
+        if (!IsCountedLoop(*it)) {
+          return false;
+        }
         if (to_schedule.size() == 1) {
           // We can schedule the WHILE op by itself.
           return true;
@@ -34,7 +34,8 @@ class NaiadFramework: public FrameworkInterface {
  public:
   NaiadFramework();
   string Translate(const op_nodes& dag, const string& relation);
-  void Dispatch(const string& binary, const string& relation);
+  int Dispatch(const string& binary, const string& relation,
+               map<string, uint64_t>* job_output = NULL);
   FmwType GetType();
   uint32_t ScoreDAG(const node_list& nodes, const relation_size& rel_size);
   bool CanMerge(const op_nodes& dag, const node_set& to_schedule,
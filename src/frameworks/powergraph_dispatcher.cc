@@ -30,11 +30,9 @@ namespace framework {
   PowerGraphDispatcher::PowerGraphDispatcher() {
   }
 
-  void PowerGraphDispatcher::Execute(string job_path, string job_options) {
-    string cmd = "cd ~/ ; " + job_path + " " + job_options;
-    LOG(INFO) << "powerGraph run started for: " << job_path;
-    system(cmd.c_str());
-    LOG(INFO) << "powerGraph run ended for: " << job_path;
+  string PowerGraphDispatcher::GetCommand(const string& job_path,
+                                          const string& job_options) {
+    return "cd ~/ ; " + job_path + " " + job_options;
   }
 
 } // namespace framework
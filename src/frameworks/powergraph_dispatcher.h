@@ -29,7 +29,9 @@ namespace framework {
 class PowerGraphDispatcher : public DispatcherInterface {
  public:
   PowerGraphDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
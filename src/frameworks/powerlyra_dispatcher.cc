@@ -24,11 +24,9 @@ namespace framework {
   PowerLyraDispatcher::PowerLyraDispatcher() {
   }
 
-  void PowerLyraDispatcher::Execute(string job_path, string job_options) {
-    string cmd = "cd ~/ ; " + job_path + " " + job_options;
-    LOG(INFO) << "PowerLyra run started for: " << job_path;
-    system(cmd.c_str());
-    LOG(INFO) << "PowerLyra run ended for: " << job_path;
+  string PowerLyraDispatcher::GetCommand(const string& job_path,
+                                         const string& job_options) {
+    return "cd ~/ ; " + job_path + " " + job_options;
   }
 
 } // namespace framework
@@ -27,7 +27,9 @@ namespace framework {
 class PowerLyraDispatcher : public DispatcherInterface {
  public:
   PowerLyraDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
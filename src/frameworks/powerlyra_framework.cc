@@ -35,11 +35,13 @@ namespace framework {
     return "";
   }
 
-  void PowerLyraFramework::Dispatch(const string& binary_file,
-                                    const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int PowerLyraFramework::Dispatch(const string& binary_file,
+                                   const string& relation,
+                                   map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   FmwType PowerLyraFramework::GetType() {
@@ -30,15 +30,13 @@ namespace framework {
   SparkDispatcher::SparkDispatcher() {
   }
 
-  void SparkDispatcher::Execute(string job_path, string job_options) {
+  string SparkDispatcher::GetCommand(const string& job_path,
+                                     const string& job_options) {
     string sbt = FLAGS_spark_dir + "sbt/sbt ";
     // change directory to be in the correct project directory then do sbt run
     string dir = FLAGS_generated_code_dir + "/" + job_options + "_code";
-    string cmd = "export SPARK_MEM=8g ; cd " + dir + "&& " + sbt  + "run" +
+    return "export SPARK_MEM=8g ; cd " + dir + "&& " + sbt  + "run" +
       " " + job_options;
-    LOG(INFO) << "spark run started for: " << job_path;
-    system(cmd.c_str());
-    LOG(INFO) << "spark run ended for: " << job_path;
   }
 
 } // namespace framework
@@ -33,7 +33,9 @@ namespace framework {
 class SparkDispatcher : public DispatcherInterface {
  public:
   SparkDispatcher();
-  void Execute(string output_path, string job_path);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
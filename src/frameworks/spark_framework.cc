@@ -26,6 +26,8 @@
 #include <utility>
 #include <vector>
 
+#include "monitoring/status_poller.h"
+
 #define SPARK_START_TIME 3.0
 #define NUM_SPARK_MACHINES 100
 
@@ -34,10 +36,11 @@ namespace framework {
 
   using musketeer::translator::TranslatorSpark;
   using musketeer::monitor::SparkMonitor;
+  using musketeer::monitor::StatusPoller;
 
   SparkFramework::SparkFramework(): FrameworkInterface() {
     dispatcher_ = new SparkDispatcher();
-    monitor_ = new SparkMonitor();
+    monitor_ = new StatusPoller("Spark", new SparkMonitor());
   }
 
   string SparkFramework::Translate(const op_nodes& dag,
@@ -47,11 +50,13 @@ namespace framework {
     return translator_spark.GenerateCode();
   }
 
-  void SparkFramework::Dispatch(const string& binary_file,
-                                const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int SparkFramework::Dispatch(const string& binary_file,
+                               const string& relation,
+                               map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   FmwType SparkFramework::GetType() {
@@ -93,6 +98,20 @@ namespace framework {
     uint64_t right_size = it->second.second;
     double time = SumNoOverflow(left_size, right_size) /
       NUM_SPARK_MACHINES / 35.0 / 1024.0;
+    // A broadcast join sends the small input to every machine and scans the
+    // other one in place.
+    int32_t broadcast_input =
+      dynamic_cast<ir::JoinOperator*>(op)->broadcastInput(rel_size);
+    if (broadcast_input >= 0) {
+      uint64_t broadcast_size = broadcast_input == 0 ? left_size : right_size;
+      uint64_t stream_size = broadcast_input == 0 ? right_size : left_size;
+      double broadcast_time =
+        (stream_size / NUM_SPARK_MACHINES / 80.0 + broadcast_size / 35.0) /
+        1024.0;
+      VLOG(2) << "Join " << op->get_output_relation()->get_name() << " takes "
+              << time << "s shuffled and " << broadcast_time << "s broadcast";
+      time = broadcast_time;
+    }
     return time * FLAGS_time_to_cost;
   }
 
@@ -286,10 +305,8 @@ namespace framework {
     }
   }
 
-  // In our current setup Spark always uses the entire cluster.
-  // TODO(ionel): Fix!
   double SparkFramework::ScoreClusterState() {
-    return monitor_->CurrentUtilization();
+    return ScoreMonitoredLoad();
   }
 
   uint32_t SparkFramework::ScoreDAG(const node_list& nodes,
@@ -311,22 +328,23 @@ namespace framework {
           *DetermineInputs(input_nodes, &input_names), rel_size);
       uint64_t output_data_size =
         GetDataSize(DetermineFinalOutputs(input_nodes, nodes), rel_size);
-      double time_compile_read_write = ScoreCompile() +
-        ScoreLoad(input_data_size) + ScorePush(output_data_size);
+      double time_compile_read_write = TraceCost("compile", ScoreCompile()) +
+        TraceCost("load", ScoreLoad(input_data_size)) +
+        TraceCost("push", ScorePush(output_data_size));
       shared_ptr<OperatorNode> while_op = IsInWhileBody(nodes);
       if (while_op) {
         time_compile_read_write *=
           while_op->get_operator()->get_condition_tree()->getNumIterations();
       }
+      double time_job = (time_compile_read_write +
+                         TraceCost("runtime", ScoreRuntime(input_data_size,
+                                                           nodes, rel_size))) *
+        (1.0 + TraceCost("cluster_state", ScoreClusterState()));
       if (FLAGS_best_runtime) {
-        return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                   time_compile_read_write +
-                   ScoreRuntime(input_data_size, nodes, rel_size));
+        return min(static_cast<double>(FLAGS_max_scheduler_cost), time_job);
       } else {
         return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                   (time_compile_read_write +
-                    ScoreRuntime(input_data_size, nodes, rel_size)) *
-                   NUM_SPARK_MACHINES);
+                   time_job * NUM_SPARK_MACHINES);
       }
     } else {
       VLOG(2) << "Cannot merge in " << FrameworkToString(GetType());
@@ -30,12 +30,10 @@ namespace framework {
   ViffDispatcher::ViffDispatcher() {
   }
 
-  void ViffDispatcher::Execute(string job_path, string job_options) {
+  string ViffDispatcher::GetCommand(const string& job_path,
+                                    const string& job_options) {
     // XXX(malte): hack hack hack
-    string cmd = "python " + job_path + " --no-ssl " + job_options;
-    LOG(INFO) << "viff run started for: " << job_path;
-    system(cmd.c_str());
-    LOG(INFO) << "viff run ended for: " << job_path;
+    return "python " + job_path + " --no-ssl " + job_options;
   }
 
 } // namespace framework
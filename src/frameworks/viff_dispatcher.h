@@ -31,7 +31,9 @@ namespace framework {
 class ViffDispatcher : public DispatcherInterface {
  public:
   ViffDispatcher();
-  void Execute(string job_path, string job_options);
+
+ protected:
+  string GetCommand(const string& job_path, const string& job_options);
 };
 
 } // namespace framework
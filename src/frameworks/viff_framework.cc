@@ -47,11 +47,13 @@ namespace framework {
     return translator_viff.GenerateCode();
   }
 
-  void ViffFramework::Dispatch(const string& binary_file,
-                               const string& relation) {
-    if (!FLAGS_dry_run) {
-      dispatcher_->Execute(binary_file, relation);
+  int ViffFramework::Dispatch(const string& binary_file,
+                              const string& relation,
+                              map<string, uint64_t>* job_output) {
+    if (FLAGS_dry_run) {
+      return 0;
     }
+    return dispatcher_->Execute(binary_file, relation, job_output);
   }
 
   FmwType ViffFramework::GetType() {
@@ -81,7 +83,8 @@ namespace framework {
           *DetermineInputs(input_nodes, &input_names), rel_size);
       
       return min(static_cast<double>(FLAGS_max_scheduler_cost),
-                 ScoreRuntime(input_data_size, nodes, rel_size));
+                 TraceCost("runtime",
+                           ScoreRuntime(input_data_size, nodes, rel_size)));
       
     } else {
       LOG(INFO) << "Cannot merge in " << FrameworkToString(GetType());
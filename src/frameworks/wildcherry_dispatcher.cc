@@ -30,14 +30,9 @@ namespace framework {
   WildCherryDispatcher::WildCherryDispatcher() {
   }
 
-  void WildCherryDispatcher::Execute(string job_path, string job_options) {
-      LOG(INFO) << "Wildcherry execute " << job_path;
-      string cmd = "time bash ";
-      cmd += job_path;
-      LOG(INFO) << "Wildcherry command: " << cmd;
-      LOG(INFO) << "Wildcherry run started for: " << job_path;
-      system(cmd.c_str());
-      LOG(INFO) << "Wildcherry run ended for: " << job_path;
+  string WildCherryDispatcher::GetCommand(const string& job_path,
+                                          const string& job_options) {
+      return "time bash " + job_path;
   }
 
 } // namespace framework
@@ -31,7 +31,8 @@ class WildCherryFramework: public FrameworkInterface {
  public:
   WildCherryFramework();
   string Translate(const op_nodes& dag, const string& relation);
-  void Dispatch(const string& binary, const string& relation);
+  int Dispatch(const string& binary, const string& relation,
+               map<string, uint64_t>* job_output = NULL);
   FmwType GetType();
   uint32_t ScoreDAG(const node_list& nodes, const relation_size& rel_size);
   double ScoreOperator(shared_ptr<OperatorNode> op_node,
@@ -58,6 +58,10 @@ namespace musketeer {
        barrier_loop_children.size() == 0);
   }
 
+  bool OperatorNode::HasConsumers() {
+    return children.size() > 0 || loop_children.size() > 0;
+  }
+
   void OperatorNode::set_barrier(bool has_barrier_) {
     has_barrier = has_barrier_;
   }
@@ -68,6 +68,9 @@ class OperatorNode {
   void set_barrier(bool has_barrier_);
   bool HasBarrier();
   bool IsLeaf();
+  // True if other operators of the workflow read the node's output, including
+  // the ones outside the job that is being scheduled.
+  bool HasConsumers();
 
  private:
   OperatorInterface* node_operator;
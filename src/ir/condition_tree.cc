@@ -325,5 +325,41 @@ namespace ir {
     }
   }
 
+  void ConditionTree::getColumnIndices(set<int32_t>* indices) {
+    if (isValue()) {
+      return;
+    }
+    if (isColumn()) {
+      indices->insert(column->get_index());
+      return;
+    }
+    left->getColumnIndices(indices);
+    if (isBinary()) {
+      right->getColumnIndices(indices);
+    }
+  }
+
+  ConditionTree* ConditionTree::copyWithColumns(
+      const map<int32_t, Column*>& columns) {
+    if (isValue()) {
+      return new ConditionTree(new Value(value->get_value(),
+                                         value->get_type()));
+    }
+    if (isColumn()) {
+      map<int32_t, Column*>::const_iterator col_it =
+        columns.find(column->get_index());
+      if (col_it == columns.end()) {
+        return new ConditionTree(column->clone());
+      }
+      return new ConditionTree(col_it->second->clone());
+    }
+    ConditionTree* right_copy = NULL;
+    if (isBinary()) {
+      right_copy = right->copyWithColumns(columns);
+    }
+    return new ConditionTree(new CondOperator(cond_operator->toString()),
+                             left->copyWithColumns(columns), right_copy);
+  }
+
 } // namespace ir
 } // namespace musketeer
@@ -19,6 +19,7 @@
 #ifndef MUSKETEER_CONDITION_TREE_H
 #define MUSKETEER_CONDITION_TREE_H
 
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -135,6 +136,10 @@ class ConditionTree {
   bool checkConditionArithmetic();
   int getNumIterations();
   void getRelNames(set<string>* rel_names);
+  void getColumnIndices(set<int32_t>* indices);
+  // Returns a deep copy of the tree in which every column whose index is in
+  // columns is replaced by a copy of the column it maps to.
+  ConditionTree* copyWithColumns(const map<int32_t, Column*>& columns);
 
   // Returns a string that will be plugged in the template for filtering out
   // rows. If the type of the node is EMPTY_NODE then the operator doesn't
@@ -19,8 +19,13 @@
 #include "ir/join_operator.h"
 #include "ir/join_operator_mpc.h"
 
+#include <boost/algorithm/string.hpp>
+#include <math.h>
+
+#include <algorithm>
 #include <limits>
 #include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -87,8 +92,12 @@ namespace ir {
   }
 
   OperatorInterface* JoinOperator::clone() {
-    return new JoinOperator(get_input_dir(), get_relations(), left_cols_,
-                            right_cols_, get_output_relation());
+    JoinOperator* join_op =
+      new JoinOperator(get_input_dir(), get_relations(), left_cols_,
+                       right_cols_, get_output_relation());
+    join_op->set_broadcast_input(broadcast_input_);
+    join_op->set_skewed_keys(skewed_input_, skewed_keys_);
+    return join_op;
   }
 
   OperatorInterface* JoinOperator::toMPC() {
@@ -96,5 +105,132 @@ namespace ir {
                                right_cols_, get_output_relation());
   }
 
+  int32_t JoinOperator::broadcastInput(
+      const map<string, pair<uint64_t, uint64_t> >& rel_size) {
+    vector<Relation*> rels = get_relations();
+    map<string, pair<uint64_t, uint64_t> >::const_iterator left_it =
+      rel_size.find(rels[0]->get_name());
+    map<string, pair<uint64_t, uint64_t> >::const_iterator right_it =
+      rel_size.find(rels[1]->get_name());
+    if (left_it == rel_size.end() || right_it == rel_size.end()) {
+      return -1;
+    }
+    // Broadcast the smaller input if it fits.
+    int32_t input = left_it->second.second < right_it->second.second ? 0 : 1;
+    uint64_t input_size = min(left_it->second.second,
+                              right_it->second.second);
+    if (FLAGS_broadcast_join_max_kb == 0 ||
+        input_size > FLAGS_broadcast_join_max_kb) {
+      return -1;
+    }
+    return input;
+  }
+
+  int32_t JoinOperator::get_broadcast_input() {
+    return broadcast_input_;
+  }
+
+  void JoinOperator::set_broadcast_input(int32_t broadcast_input) {
+    broadcast_input_ = broadcast_input;
+  }
+
+  int32_t JoinOperator::skewedInput(
+      const map<string, pair<uint64_t, uint64_t> >& rel_size) {
+    vector<Relation*> rels = get_relations();
+    map<string, pair<uint64_t, uint64_t> >::const_iterator left_it =
+      rel_size.find(rels[0]->get_name());
+    map<string, pair<uint64_t, uint64_t> >::const_iterator right_it =
+      rel_size.find(rels[1]->get_name());
+    if (left_it == rel_size.end() || right_it == rel_size.end()) {
+      return -1;
+    }
+    return left_it->second.second < right_it->second.second ? 1 : 0;
+  }
+
+  vector<string> JoinOperator::heavyKeys(int32_t input,
+                                         const vector<string>& rows) {
+    vector<string> heavy_keys;
+    if (FLAGS_skew_join_min_fraction <= 0 || FLAGS_skew_join_min_fraction > 1) {
+      return heavy_keys;
+    }
+    // The key columns stay in the order the join declares them, which is
+    // the order the map tasks build their keys in.
+    vector<int32_t> indices;
+    vector<Column*> cols = input == 0 ? left_cols_ : right_cols_;
+    for (vector<Column*>::iterator it = cols.begin(); it != cols.end(); ++it) {
+      indices.push_back((*it)->get_index());
+    }
+    vector<string> keys;
+    for (vector<string>::const_iterator it = rows.begin(); it != rows.end();
+         ++it) {
+      vector<string> values;
+      boost::split(values, *it, boost::is_any_of(" "));
+      string key;
+      vector<int32_t>::iterator index_it = indices.begin();
+      for (; index_it != indices.end() &&
+             *index_it < static_cast<int32_t>(values.size());
+           ++index_it) {
+        key += (key.empty() ? "" : " ") + values[*index_it];
+      }
+      // Skip rows that lack a key column.
+      if (index_it == indices.end()) {
+        keys.push_back(key);
+      }
+    }
+    // Misra-Gries summary: with k counters every key that occurs in more
+    // than 1/k of the rows is left with a counter.
+    uint32_t num_counters =
+      static_cast<uint32_t>(ceil(1.0 / FLAGS_skew_join_min_fraction));
+    map<string, uint64_t> counters;
+    for (vector<string>::iterator it = keys.begin(); it != keys.end(); ++it) {
+      map<string, uint64_t>::iterator counter_it = counters.find(*it);
+      if (counter_it != counters.end()) {
+        ++counter_it->second;
+      } else if (counters.size() < num_counters) {
+        counters[*it] = 1;
+      } else {
+        for (counter_it = counters.begin(); counter_it != counters.end();) {
+          if (--counter_it->second == 0) {
+            counters.erase(counter_it++);
+          } else {
+            ++counter_it;
+          }
+        }
+      }
+    }
+    // The counters underestimate, so count the candidates exactly.
+    for (map<string, uint64_t>::iterator it = counters.begin();
+         it != counters.end(); ++it) {
+      it->second = 0;
+    }
+    for (vector<string>::iterator it = keys.begin(); it != keys.end(); ++it) {
+      map<string, uint64_t>::iterator counter_it = counters.find(*it);
+      if (counter_it != counters.end()) {
+        ++counter_it->second;
+      }
+    }
+    for (map<string, uint64_t>::iterator it = counters.begin();
+         it != counters.end(); ++it) {
+      if (it->second >= FLAGS_skew_join_min_fraction * keys.size()) {
+        heavy_keys.push_back(it->first);
+      }
+    }
+    return heavy_keys;
+  }
+
+  int32_t JoinOperator::get_skewed_input() {
+    return skewed_input_;
+  }
+
+  vector<string> JoinOperator::get_skewed_keys() {
+    return skewed_keys_;
+  }
+
+  void JoinOperator::set_skewed_keys(int32_t skewed_input,
+                                     const vector<string>& keys) {
+    skewed_input_ = skewed_input;
+    skewed_keys_ = keys;
+  }
+
 } // namespace ir
 } // namespace musketeer
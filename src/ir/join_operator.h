@@ -41,7 +41,8 @@ class JoinOperator: public OperatorInterface {
                vector<Column*> left_cols, vector<Column*> right_cols,
                Relation* output_relation):
     OperatorInterface(input_dir, relations, output_relation),
-      left_cols_(left_cols), right_cols_(right_cols) {
+      left_cols_(left_cols), right_cols_(right_cols), broadcast_input_(-1),
+      skewed_input_(-1) {
   }
 
   ~JoinOperator() {
@@ -58,10 +59,33 @@ class JoinOperator: public OperatorInterface {
       map<string, pair<uint64_t, uint64_t> >* rel_size);
   OperatorInterface* clone();
   OperatorInterface* toMPC();
+  // Returns the input that is small enough to be loaded into a hash table in
+  // every task, or -1 if both inputs have to be shuffled.
+  int32_t broadcastInput(
+      const map<string, pair<uint64_t, uint64_t> >& rel_size);
+  // The input the translators load into every task; -1 (the default) for a
+  // repartition join.
+  int32_t get_broadcast_input();
+  void set_broadcast_input(int32_t broadcast_input);
+  // Returns the larger input, whose heavy keys are spread over several reduce
+  // tasks, or -1 if the input sizes are unknown.
+  int32_t skewedInput(const map<string, pair<uint64_t, uint64_t> >& rel_size);
+  // Returns the join keys of at least FLAGS_skew_join_min_fraction of the
+  // sampled rows of an input. A key holds the values of the key columns in
+  // the order the join lists them, separated by spaces.
+  vector<string> heavyKeys(int32_t input, const vector<string>& rows);
+  // The input whose rows with a skewed key are spread over the reduce tasks;
+  // the other input's rows with such a key are sent to all of them.
+  int32_t get_skewed_input();
+  vector<string> get_skewed_keys();
+  void set_skewed_keys(int32_t skewed_input, const vector<string>& keys);
 
  protected:
   vector<Column*> left_cols_;
   vector<Column*> right_cols_;
+  int32_t broadcast_input_;
+  int32_t skewed_input_;
+  vector<string> skewed_keys_;
 };
 
 } // namespace ir
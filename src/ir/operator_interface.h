@@ -42,7 +42,8 @@ class OperatorInterface {
                     const vector<Relation*>& relations_,
                     Relation* output_relation_):
     has_groupby(false), input_dir(input_dir_), relations(relations_),
-    output_relation(output_relation_), rename(false), condition_tree(NULL) {
+    output_relation(output_relation_), rename(false), condition_tree(NULL),
+    input_size_kb(0), columnar_output(false) {
   }
 
   OperatorInterface(const string& input_dir_,
@@ -51,7 +52,8 @@ class OperatorInterface {
                     ConditionTree* condition_tree_):
     has_groupby(false), input_dir(input_dir_), relations(relations_),
     output_relation(output_relation_), rename(false),
-    condition_tree(condition_tree_) {
+    condition_tree(condition_tree_), input_size_kb(0),
+    columnar_output(false) {
   }
 
 
@@ -238,6 +240,26 @@ class OperatorInterface {
     return has_groupby;
   }
 
+  // Estimated size of all the operator's inputs, or 0 if it is unknown. The
+  // translators use it to size the shuffle of the job.
+  uint64_t get_input_size_kb() {
+    return input_size_kb;
+  }
+
+  void set_input_size_kb(uint64_t input_size_kb_) {
+    input_size_kb = input_size_kb_;
+  }
+
+  // True if the output relation is read by later jobs and is written in the
+  // columnar format (see base/columnar_format.h) instead of as text.
+  bool get_columnar_output() {
+    return columnar_output;
+  }
+
+  void set_columnar_output(bool columnar_output_) {
+    columnar_output = columnar_output_;
+  }
+
   virtual bool isMPC() {
     return false;
   }
@@ -279,6 +301,8 @@ class OperatorInterface {
   Relation* output_relation;
   bool rename;
   ConditionTree* condition_tree;
+  uint64_t input_size_kb;
+  bool columnar_output;
 };
 
 } // namespace ir
@@ -18,148 +18,99 @@
 
 #include "monitoring/hadoop_monitor.h"
 
-#include <curl/curl.h>
 #include <jansson.h>
+#include <stdio.h>
 
 #include <algorithm>
+#include <string>
 
 #include "base/common.h"
 #include "base/flags.h"
+#include "monitoring/http_utils.h"
 
 namespace musketeer {
 namespace monitor {
 
-#define BUFFER_SIZE  (256 * 1024)
 #define URL_FORMAT   "http://%s:%u/metrics?format=json"
 #define URL_SIZE     256
 
 HadoopMonitor::HadoopMonitor() :
   jobtracker_hostname_(FLAGS_hadoop_job_tracker_host),
-  jobtracker_port_(FLAGS_hadoop_job_tracker_port) {
+  jobtracker_port_(FLAGS_hadoop_job_tracker_port),
+  http_handle_(CreateHTTPHandle()) {
 }
 
-static size_t write_response(void *ptr, size_t size, size_t nmemb,
-                             void *stream) {
-  struct curl_write_result *result = (struct curl_write_result *)stream;
-
-  if (result->pos + size * nmemb >= BUFFER_SIZE - 1) {
-    LOG(ERROR) << "buffer too small";
-    return 0;
+HadoopMonitor::~HadoopMonitor() {
+  if (http_handle_ != NULL) {
+    curl_easy_cleanup(http_handle_);
   }
-
-  memcpy(result->data + result->pos, ptr, size * nmemb);
-  result->pos += size * nmemb;
-
-  return size * nmemb;
 }
 
-string HadoopMonitor::HTTPLoad(const string& url) {
-  CURL *curl;
-  CURLcode status;
-  char *data;
-  int32_t code;
-
-  curl = curl_easy_init();
-  data = reinterpret_cast<char*>(malloc(BUFFER_SIZE));
-  if (!curl || !data) {
-    return NULL;
-  }
-
-  curl_write_result wr;
-  wr.data = data;
-  wr.pos = 0;
-
-  curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_response);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &wr);
-
-  status = curl_easy_perform(curl);
-  if (status != 0) {
-    LOG(ERROR) << "CURL error: unable to request data from " << url;
-    LOG(ERROR) << curl_easy_strerror(status);
-    return NULL;
-  }
-
-  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
-  if (code != 200) {
-    LOG(ERROR) << "HTTP error: server responded with code " << code;
-    return NULL;
+// Returns the fraction of slots in use, or 0 if there are no slots.
+static double SlotUtilization(json_t* stats, const char* slots_key,
+                              const char* occupied_key) {
+  uint64_t slots = json_integer_value(json_object_get(stats, slots_key));
+  if (slots == 0) {
+    return 0.0;
   }
-
-  // XXX(malte): This is a bit ugly, as it copies the string
-  data[wr.pos] = '\0';
-  string result(data, wr.pos);
-
-  curl_easy_cleanup(curl);
-  curl_global_cleanup();
-
-  return result;
+  uint64_t occupied = json_integer_value(json_object_get(stats, occupied_key));
+  return static_cast<double>(occupied) / slots;
 }
 
-
-double HadoopMonitor::ParseJSONStatusString(const string& json_str) {
-  double utilization = 0;
-  json_t *root;
+bool HadoopMonitor::ParseJSONStatusString(const string& json_str,
+                                          EngineStatus* status) {
   json_error_t error;
-  root = json_loads(json_str.c_str(), 0, &error);
-  LOG(INFO) << json_str;
-
+  json_t* root = json_loads(json_str.c_str(), 0, &error);
   if (!root) {
     LOG(ERROR) << "Failed to parse Hadoop status info: on line " << error.line
                << ": " << error.text;
+    return false;
   }
-
-  CHECK(json_is_object(root));
   json_t* mapred = json_object_get(root, "mapred");
-  CHECK(json_is_object(mapred));
   json_t* jobtracker = json_object_get(mapred, "jobtracker");
-  CHECK(json_is_array(jobtracker));
-  json_t* jobtracker2 = json_array_get(jobtracker, 0);  // single-element array
-  CHECK(json_is_array(jobtracker2));
-  for (uint32_t i = 0; i < json_array_size(jobtracker2); i += 2) {
+  // single-element array
+  json_t* jobtracker2 = json_array_get(jobtracker, 0);
+  if (!json_is_array(jobtracker2)) {
+    LOG(ERROR) << "Hadoop status is missing the job tracker metrics";
+    json_decref(root);
+    return false;
+  }
+  status->utilization = 0.0;
+  status->queued_jobs = 0;
+  for (uint32_t i = 0; i + 1 < json_array_size(jobtracker2); i += 2) {
     // Job tracker hostname
-    json_t* jt_meta = json_array_get(jobtracker2, i);
-    CHECK(json_is_object(jt_meta));
-    json_t* jt_hostname = json_object_get(jt_meta, "hostName");
-    CHECK(json_is_string(jt_hostname));
-    string jt_hostname_str = json_string_value(jt_hostname);
+    json_t* jt_hostname =
+      json_object_get(json_array_get(jobtracker2, i), "hostName");
+    string jt_hostname_str =
+      json_is_string(jt_hostname) ? json_string_value(jt_hostname) : "";
     // Stats
-    json_t* jt_stats = json_array_get(jobtracker2, i+1);
-    CHECK(json_is_object(jt_stats));
-    uint64_t total_reduce_slots = json_integer_value(
-        json_object_get(jt_stats, "reduce_slots"));
-    uint64_t total_map_slots = json_integer_value(
-        json_object_get(jt_stats, "map_slots"));
-    uint64_t occup_reduce_slots = json_integer_value(
-        json_object_get(jt_stats, "occupied_reduce_slots"));
-    uint64_t occup_map_slots = json_integer_value(
-        json_object_get(jt_stats, "occupied_map_slots"));
-    utilization =
-        max(1.0 - (static_cast<double>(total_reduce_slots - occup_reduce_slots)
-                   / static_cast<double>(total_reduce_slots)),
-            1.0 - (static_cast<double>(total_map_slots - occup_map_slots)
-                   / static_cast<double>(total_map_slots)));
-    LOG(INFO) << "Hadoop job tracker on " << jt_hostname_str << "'s utilization"
-              << " is " << utilization;
+    json_t* jt_stats = json_array_get(jobtracker2, i + 1);
+    if (!json_is_object(jt_stats)) {
+      continue;
+    }
+    double utilization =
+      max(SlotUtilization(jt_stats, "map_slots", "occupied_map_slots"),
+          SlotUtilization(jt_stats, "reduce_slots", "occupied_reduce_slots"));
+    status->utilization = max(status->utilization, utilization);
+    status->queued_jobs +=
+      json_integer_value(json_object_get(jt_stats, "jobs_preparing"));
+    VLOG(1) << "Hadoop job tracker on " << jt_hostname_str << "'s utilization"
+            << " is " << utilization;
   }
-
   // release resources
   json_decref(root);
-  return utilization;
+  return true;
 }
 
-double HadoopMonitor::PollStatusInformationFromHadoop(string* json_str) {
+bool HadoopMonitor::PollStatus(EngineStatus* status) {
   char url[URL_SIZE];
-
   snprintf(url, URL_SIZE, URL_FORMAT, jobtracker_hostname_.c_str(),
-          jobtracker_port_);
-
-  *json_str = HTTPLoad(url);
-
-  if (json_str->empty())
-    LOG(ERROR) << "Failed to poll Hadoop status from " << jobtracker_hostname_;
-
-  return ParseJSONStatusString(*json_str);
+           jobtracker_port_);
+  string json_str;
+  if (!HTTPGet(http_handle_, url, &json_str)) {
+    return false;
+  }
+  return ParseJSONStatusString(json_str, status);
 }
 
 } // namespace monitor
@@ -21,6 +21,8 @@
 
 #include "monitoring/monitor_interface.h"
 
+#include <curl/curl.h>
+
 #include <string>
 #include <vector>
 
@@ -29,28 +31,18 @@
 namespace musketeer {
 namespace monitor {
 
-static size_t write_response(void *ptr, size_t size, size_t nmemb,
-                             void *stream);
-
 class HadoopMonitor : public MonitorInterface {
  public:
   HadoopMonitor();
-  double CurrentUtilization() {
-    string json_status = "";
-    return PollStatusInformationFromHadoop(&json_status);
-  }
-  double PollStatusInformationFromHadoop(string* str);
+  ~HadoopMonitor();
+  bool PollStatus(EngineStatus* status);
+
  private:
-  static string HTTPLoad(const string& url);
-  double ParseJSONStatusString(const string& json_str);
+  bool ParseJSONStatusString(const string& json_str, EngineStatus* status);
 
   string jobtracker_hostname_;
   uint32_t jobtracker_port_;
-};
-
-struct curl_write_result {
-  char* data;
-  int64_t pos;
+  CURL* http_handle_;
 };
 
 } // namespace monitor
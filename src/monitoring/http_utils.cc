@@ -0,0 +1,82 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "monitoring/http_utils.h"
+
+#include <boost/thread/once.hpp>
+
+#include <string>
+
+// Status endpoints are expected to answer quickly.
+#define HTTP_CONNECT_TIMEOUT_S 2
+#define HTTP_TIMEOUT_S 5
+
+namespace musketeer {
+namespace monitor {
+
+  static boost::once_flag curl_init_flag = BOOST_ONCE_INIT;
+
+  static void InitCurl() {
+    curl_global_init(CURL_GLOBAL_ALL);
+  }
+
+  static size_t AppendToBody(char* data, size_t size, size_t nmemb,
+                             void* body) {
+    static_cast<string*>(body)->append(data, size * nmemb);
+    return size * nmemb;
+  }
+
+  CURL* CreateHTTPHandle() {
+    boost::call_once(curl_init_flag, InitCurl);
+    CURL* handle = curl_easy_init();
+    if (handle == NULL) {
+      LOG(ERROR) << "Could not create a CURL handle";
+      return NULL;
+    }
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, AppendToBody);
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, HTTP_CONNECT_TIMEOUT_S);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT, HTTP_TIMEOUT_S);
+    // Timeouts would otherwise be delivered as signals to the whole process.
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    return handle;
+  }
+
+  bool HTTPGet(CURL* handle, const string& url, string* body) {
+    if (handle == NULL) {
+      return false;
+    }
+    body->clear();
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, body);
+    CURLcode status = curl_easy_perform(handle);
+    if (status != CURLE_OK) {
+      VLOG(1) << "Could not fetch " << url << ": "
+              << curl_easy_strerror(status);
+      return false;
+    }
+    long code = 0;  // NOLINT
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+    if (code != 200) {
+      VLOG(1) << "Fetching " << url << " returned HTTP code " << code;
+      return false;
+    }
+    return true;
+  }
+
+} // namespace monitor
+} // namespace musketeer
@@ -0,0 +1,39 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_MONITORING_HTTP_UTILS_H
+#define MUSKETEER_MONITORING_HTTP_UTILS_H
+
+#include <curl/curl.h>
+
+#include <string>
+
+#include "base/common.h"
+
+namespace musketeer {
+namespace monitor {
+
+  // Creates a handle for HTTPGet. libcurl is initialised on the first call.
+  CURL* CreateHTTPHandle();
+  // Fetches url into body. Reusing the handle keeps the connection to the
+  // server open between calls. Returns false if the request failed.
+  bool HTTPGet(CURL* handle, const string& url, string* body);
+
+} // namespace monitor
+} // namespace musketeer
+#endif  // MUSKETEER_MONITORING_HTTP_UTILS_H
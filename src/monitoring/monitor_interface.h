@@ -26,9 +26,19 @@
 namespace musketeer {
 namespace monitor {
 
+// The load of an engine as reported by its status endpoint.
+struct EngineStatus {
+  // Fraction of the engine's slots that are in use, between 0 and 1.
+  double utilization;
+  // Jobs waiting for the engine to admit them.
+  uint32_t queued_jobs;
+};
+
 class MonitorInterface {
  public:
-  virtual double CurrentUtilization() = 0;
+  virtual ~MonitorInterface() {}
+  // Returns false if the engine's status is not known.
+  virtual bool PollStatus(EngineStatus* status) = 0;
 };
 
 } // namespace monitor
@@ -21,11 +21,8 @@
 
 #include "monitoring/monitor_interface.h"
 
-#include <jansson.h>
-#include <stdio.h>
-#include <stdlib.h>
+#include <curl/curl.h>
 
-#include <cstring>
 #include <string>
 #include <vector>
 
@@ -34,20 +31,18 @@
 namespace musketeer {
 namespace monitor {
 
-static int writer(char* data, size_t size, size_t nmemb, string *writerData);
-
 class SparkMonitor : public MonitorInterface {
  public:
   SparkMonitor();
-  double CurrentUtilization();
+  ~SparkMonitor();
+  bool PollStatus(EngineStatus* status);
 
  private:
-  string formatJSON(const string& json);
-  int ParseJSON(const string& json, double* utilization);
-  static string HTTPLoad(const string& url);
+  bool ParseJSON(const string& json, EngineStatus* status);
 
   string master_name_;
   uint32_t master_port_;
+  CURL* http_handle_;
 };
 
 } // namespace monitor
@@ -0,0 +1,93 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "monitoring/status_poller.h"
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <algorithm>
+#include <string>
+
+#include "base/flags.h"
+
+#define SNAPSHOT_VALID (1ULL << 63)
+#define UTILIZATION_SCALE 1000000.0
+
+namespace musketeer {
+namespace monitor {
+
+  StatusPoller::StatusPoller(const string& engine, MonitorInterface* monitor)
+    : engine_(engine), monitor_(monitor), snapshot_(0), poller_(NULL) {
+    if (!FLAGS_dry_run && FLAGS_monitor_poll_interval_ms > 0) {
+      poller_ = new boost::thread(boost::bind(&StatusPoller::PollLoop, this));
+    }
+  }
+
+  StatusPoller::~StatusPoller() {
+    if (poller_ != NULL) {
+      poller_->interrupt();
+      poller_->join();
+      delete poller_;
+    }
+    delete monitor_;
+  }
+
+  bool StatusPoller::PollStatus(EngineStatus* status) {
+    uint64_t snapshot = snapshot_.load(std::memory_order_acquire);
+    if (!(snapshot & SNAPSHOT_VALID)) {
+      return false;
+    }
+    status->utilization =
+      ((snapshot & ~SNAPSHOT_VALID) >> 32) / UTILIZATION_SCALE;
+    status->queued_jobs = static_cast<uint32_t>(snapshot);
+    return true;
+  }
+
+  void StatusPoller::PollLoop() {
+    bool reachable = true;
+    try {
+      while (true) {
+        EngineStatus status;
+        if (monitor_->PollStatus(&status)) {
+          double utilization = min(max(status.utilization, 0.0), 1.0);
+          uint64_t snapshot = SNAPSHOT_VALID |
+            (static_cast<uint64_t>(utilization * UTILIZATION_SCALE) << 32) |
+            status.queued_jobs;
+          snapshot_.store(snapshot, std::memory_order_release);
+          if (!reachable) {
+            LOG(INFO) << "The status of " << engine_ << " is available again";
+            reachable = true;
+          }
+        } else {
+          snapshot_.store(0, std::memory_order_release);
+          if (reachable) {
+            LOG(WARNING) << "Could not fetch the status of " << engine_;
+            reachable = false;
+          }
+        }
+        boost::this_thread::sleep(
+            boost::posix_time::milliseconds(FLAGS_monitor_poll_interval_ms));
+      }
+    } catch (boost::thread_interrupted&) {
+      // The poller is shutting down.
+    }
+  }
+
+} // namespace monitor
+} // namespace musketeer
@@ -0,0 +1,61 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef MUSKETEER_MONITORING_STATUS_POLLER_H
+#define MUSKETEER_MONITORING_STATUS_POLLER_H
+
+#include "monitoring/monitor_interface.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <string>
+
+#include "base/common.h"
+
+namespace musketeer {
+namespace monitor {
+
+// Polls a monitor from a background thread every
+// FLAGS_monitor_poll_interval_ms and keeps the last status it returned.
+// Reading the status never blocks, so the scheduler can score frameworks
+// without waiting on the engines' status endpoints.
+class StatusPoller : public MonitorInterface {
+ public:
+  // Takes ownership of monitor.
+  StatusPoller(const string& engine, MonitorInterface* monitor);
+  ~StatusPoller();
+  // Returns the status fetched by the last poll. Returns false if the last
+  // poll failed or no poll has completed yet.
+  bool PollStatus(EngineStatus* status);
+
+ private:
+  void PollLoop();
+
+  string engine_;
+  MonitorInterface* monitor_;
+  // The last status, packed so that it can be swapped atomically. The top
+  // bit marks a valid status, the next 31 bits hold the utilization in
+  // millionths and the low 32 bits the number of queued jobs.
+  std::atomic<uint64_t> snapshot_;
+  boost::thread* poller_;
+};
+
+} // namespace monitor
+} // namespace musketeer
+#endif  // MUSKETEER_MONITORING_STATUS_POLLER_H
@@ -26,6 +26,7 @@
 
 #include "tests/mindi/test.h"
 #include "base/common.h"
+#include "base/trace.h"
 #include "base/utils.h"
 #include "core/daemon.h"
 #include "core/daemon_connection.h"
@@ -79,12 +80,69 @@ DEFINE_string(dry_run_data_size_file, "",
 DEFINE_uint64(max_scheduler_cost, 100000,
              "Maximum value the cost function can return");
 DEFINE_bool(operator_merge, true, "Activates operator merge");
+DEFINE_uint64(broadcast_join_max_kb, 65536,
+              "Largest input (in KB) of a JOIN that is loaded into every task "
+              "instead of being shuffled. 0 disables broadcast joins");
+DEFINE_uint64(skew_join_sample_rows, 100000,
+              "Number of rows of a JOIN's larger input that are sampled for "
+              "heavy join keys. 0 disables skew joins");
+DEFINE_double(skew_join_min_fraction, 0.01,
+              "Fraction of the sampled rows a join key must have to be spread "
+              "over several reduce tasks");
+DEFINE_int32(skew_join_splits, 16,
+             "Number of reduce tasks each heavy join key is spread over");
+DEFINE_uint64(map_aggregation_max_groups, 100000,
+              "Number of groups an aggregation combines in each mapper before "
+              "it emits them. 0 disables map-side aggregation");
+DEFINE_uint64(reduce_task_input_kb, 262144,
+              "Estimated input each reduce task or partition of a Hadoop or "
+              "Spark job processes");
+DEFINE_bool(columnar_intermediates, false,
+            "Write the relations that later jobs read in the columnar format "
+            "if the job's engine supports it. Musketeer converts them to text "
+            "for the other engines");
+DEFINE_uint64(columnar_block_rows, 65536,
+              "Number of rows in each block of a columnar relation");
+DEFINE_bool(columnar_compression, true,
+            "Delta-encode the numbers and dictionary-encode the strings of "
+            "columnar relations");
 DEFINE_bool(populate_history, false,
             "True if the scheduler should read the expected data size of all"
             " the operators");
 DEFINE_double(time_to_cost, 1, "Time to cost scalling factor");
 DEFINE_bool(use_heuristic, true, "Use scheduler heuristic");
 DEFINE_bool(use_dynamic_scheduler, true, "Use dynamic scheduler");
+DEFINE_bool(whole_loop_offload, true,
+            "Run an entire WHILE loop as a single job when an engine can "
+            "iterate natively");
+DEFINE_uint64(job_timeout, 0,
+              "Seconds after which a running job is cancelled. 0 disables "
+              "the timeout. Metis jobs then run in processes of their own, "
+              "not in resident workers");
+DEFINE_bool(speculative_replanning, false,
+            "Launch a job that runs far slower than estimated on the next "
+            "best framework as well and keep the first to finish");
+DEFINE_double(speculation_slowdown, 2,
+              "How many times longer than its estimate a job may run before "
+              "it is speculated on");
+DEFINE_bool(simulate, false,
+            "Simulate the jobs on modelled engines instead of running them. "
+            "Implies --dry_run");
+DEFINE_string(job_run_trace_file, "",
+              "File to which completed jobs are appended and from which "
+              "--simulate replays their run times");
+DEFINE_int32(simulation_engine_slots, 4,
+             "Number of jobs a simulated engine runs concurrently");
+DEFINE_double(simulation_background_load, 0,
+              "Share of a simulated engine's slots used by other tenants");
+DEFINE_double(simulation_noise, 0.3,
+              "Standard deviation of the log-normal error between the cost "
+              "model and the simulated run time of jobs without a recorded "
+              "run");
+DEFINE_uint64(simulation_seed, 1, "Seed of the simulation");
+DEFINE_string(trace_file, "",
+              "File to which to write a Chrome trace of planning and job "
+              "execution. Empty disables tracing");
 
 // HDFS flags.
 DEFINE_string(hdfs_master, "localhost", "HDFS namenode hostname");
@@ -94,6 +152,20 @@ DEFINE_string(hdfs_port, "8020", "HDFS namenode port");
 DEFINE_string(graphchi_dir, "", "GraphChi directiory");
 DEFINE_string(graphchi_templates_dir, "src/translation/graphchi_templates/",
               "GraphChi templates directory");
+DEFINE_bool(graphchi_cache_shards, true,
+            "Keep the GraphChi shards of an edges relation and reuse them "
+            "until the relation changes");
+DEFINE_int32(graphchi_ingest_threads, 4,
+             "Number of threads used to load GraphChi input from HDFS");
+DEFINE_bool(graphchi_selective_scheduling, true,
+            "Only update GraphChi vertices whose in-edges changed and stop "
+            "once no vertex is active");
+DEFINE_double(graphchi_convergence_threshold, 0.0,
+              "Smallest change of a GraphChi edge value that re-activates "
+              "its target vertex");
+DEFINE_int32(graphchi_max_iterations, 100,
+             "Iterations after which a GraphChi loop without an iteration "
+             "bound stops, even if it has not converged");
 
 // Hadoop flags.
 DEFINE_string(hadoop_templates_dir, "src/translation/hadoop_templates/",
@@ -101,6 +173,9 @@ DEFINE_string(hadoop_templates_dir, "src/translation/hadoop_templates/",
 DEFINE_string(hadoop_job_tracker_host, "localhost",
               "Hadoop job tracer hostname");
 DEFINE_int32(hadoop_job_tracker_port, 50030, "Hadoop job tracker port number");
+DEFINE_int32(hadoop_reduce_slots, 16,
+             "Number of reduce slots of the Hadoop cluster. Upper bound on the "
+             "reduce tasks of a job");
 
 // Metis flags.
 DEFINE_string(metis_templates_dir, "src/translation/metis_templates/",
@@ -114,6 +189,14 @@ DEFINE_bool(metis_heapprofile, false,
             "Run Metis binaries through heap profiler");
 DEFINE_bool(metis_cpuprofile, false, "Run Metis binaries through CPU profiler");
 DEFINE_string(metis_glog_v, "1", "GLOG logging level for Metis binaries");
+DEFINE_bool(metis_use_worker, true,
+            "Run Metis jobs in resident worker processes instead of starting "
+            "a process per job");
+DEFINE_int32(metis_num_workers, 1, "Number of resident Metis workers");
+DEFINE_uint64(metis_reduce_task_input_kb, 16384,
+              "Estimated input each reduce task of a Metis job processes");
+DEFINE_int32(metis_max_reduce_tasks, 256,
+             "Maximum number of reduce tasks of a Metis job");
 
 // Naiad flags.
 DEFINE_string(naiad_dir, "", "Naiad directory");
@@ -129,6 +212,9 @@ DEFINE_string(powergraph_dir, "", "PowerGraph directory");
 DEFINE_string(powergraph_templates_dir, "src/translation/powergraph_templates/",
               "PowerGraph templates directory");
 DEFINE_int32(powergraph_num_workers, 1, "Number of PowerGraph nodes");
+DEFINE_bool(powergraph_cache_partitions, true,
+            "Keep the partitioned graph on local disk and reuse it until the "
+            "edges relation changes");
 
 // PowerLyra flags.
 DEFINE_string(powerlyra_dir, "", "PowerLyra directory");
@@ -144,6 +230,12 @@ DEFINE_string(scala_version, "2.10.3", "Scala Version");
 DEFINE_string(scala_major_version, "2.10", "Scala Major Version");
 DEFINE_string(spark_templates_dir, "src/translation/spark_templates/",
               "Spark templates directory");
+DEFINE_int32(spark_max_partitions, 180,
+             "Number of cores of the Spark cluster. Upper bound on the "
+             "partitions of a shuffle");
+DEFINE_int32(monitor_poll_interval_ms, 5000,
+             "How often the engines' status endpoints are polled. 0 disables "
+             "monitoring");
 DEFINE_string(spark_web_ui_host, "localhost", "Spark Web UI Host");
 DEFINE_int32(spark_web_ui_port, 8080, "Spark Web UI Port");
 
@@ -160,6 +252,9 @@ DEFINE_bool(wildcherry_use_hdfs, false,
 
 // MPC flags
 DEFINE_string(data_owner_id, "1", "ID used to indicate data ownership");
+DEFINE_bool(mpc_parallel_local_subplans, true,
+            "Run the single-owner subplans that feed into the MPC operators "
+            "concurrently before scheduling the MPC part of the DAG");
 
 
 inline void init(int argc, char *argv[]) {
@@ -231,6 +326,9 @@ int main(int argc, char *argv[]) {
   init(argc, argv);
   FLAGS_logtostderr = true;
   FLAGS_stderrthreshold = 0;
+  if (FLAGS_simulate) {
+    FLAGS_dry_run = true;
+  }
   if (FLAGS_generated_code_dir == "") {
     FLAGS_generated_code_dir = FLAGS_root_dir;
   }
@@ -255,6 +353,11 @@ int main(int argc, char *argv[]) {
   if (FLAGS_spark_dir == "") {
     FLAGS_spark_dir = FLAGS_root_dir + "/spark-0.9.0-incubating/";
   }
+  if (FLAGS_graphchi_ingest_threads < 1) {
+    // GraphChi jobs would not read any edges without an ingest thread.
+    LOG(WARNING) << "--graphchi_ingest_threads must be at least 1; using 1";
+    FLAGS_graphchi_ingest_threads = 1;
+  }
 
   int port = atoi(FLAGS_daemon_port.c_str());
   HistoryStorage* history = new HistoryStorage();
@@ -352,6 +455,9 @@ int main(int argc, char *argv[]) {
     lexer->free(lexer);
     input->close(input);
     LOG(INFO) << "Finished scheduling job";
+    if (!FLAGS_trace_file.empty()) {
+      WriteTrace(FLAGS_trace_file);
+    }
     // We're running in no daemon mode.
     if (!FLAGS_run_daemon) {
       return 0;
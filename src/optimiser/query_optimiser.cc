@@ -19,807 +19,1518 @@
 
 #include "optimiser/query_optimiser.h"
 
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+#include "base/trace.h"
+#include "frontends/relations_type.h"
+#include "ir/join_operator.h"
+#include "ir/project_operator.h"
+#include "ir/select_operator.h"
+#include "ir/union_operator.h"
+
 namespace musketeer {
 
-  QueryOptimiser::QueryOptimiser(bool active, HistoryStorage* history):
-    history_(history), active_(active) {
+  using musketeer::ir::CondOperator;
+  using musketeer::ir::ProjectOperator;
+  using musketeer::ir::SelectOperator;
+  using musketeer::ir::UnionOperator;
+
+  QueryOptimiser::QueryOptimiser(bool active,
+                                 core::HistoryStorage* history):
+    history_(history), active_(active), num_new_relations_(0) {
     LOG(INFO) << "Starting Query Optimiser";
-    initialiseCommutativityMatrix();
-    initialiseRules(active);
   }
 
-  void QueryOptimiser::optimiseDAG(op_nodes* dag) {
-    bool changed = true;
-    LOG(INFO) << "optimiseDAG";
+  void QueryOptimiser::optimiseDAG(
+      op_nodes* dag, map<string, pair<uint64_t, uint64_t> >* rel_size) {
+    if (!active_) {
+      LOG(INFO) << "Optimisations deactivated";
+      return;
+    }
+    TraceSpan span("scheduling", "OptimiseDAG");
+    markLoopNodes(*dag);
+    int num_rewrites = 0;
     /* Keep applying rules until dag can no longer be further optimised */
-    // TODO(Tach): someone keep all intermediate DAGs
-    /* In certain cases, may add to the roots of the tree
-       need to explicitly add those nodes */
-    while (changed) {
-      changed = navigateTree(dag);
-    }
-  }
-
-  shared_ptr<OperatorNode> QueryOptimiser::copyNodes(
-      shared_ptr<OperatorNode> obj) {
-    LOG(INFO) << "copyNodes";
-    OperatorInterface* copy_op = obj->get_operator()->clone();
-    shared_ptr<OperatorNode> copy_node(new OperatorNode(copy_op));
-    copy_node->set_children(obj->get_children());
-    copy_node->set_parents(obj->get_parents());
-    copy_node->set_children_loop(obj->get_loop_children());
-    return copy_node;
-  }
-
-  /* op1 would go above op2 */
-  bool QueryOptimiser::canReorder(shared_ptr<OperatorNode> op1,
-                                  shared_ptr<OperatorNode> op2) {
-    LOG(INFO) << "canReorder";
-    return doCommute(op1, op2) || areIndependent(op1, op2) ||
-      (op2->get_children().size() == 0);
-  }
-
-  bool QueryOptimiser::doCommute(shared_ptr<OperatorNode> op_left,
-                                 shared_ptr<OperatorNode> op_right) {
-    LOG(INFO) << "doCommute";
-    OperatorType op1 = op_left->get_operator()->get_type();
-    OperatorType op2 = op_right->get_operator()->get_type();
-    return commutativity_matrix_[op1][op2];
-  }
-
-  bool QueryOptimiser::areIndependent(shared_ptr<OperatorNode> op1,
-                                      shared_ptr<OperatorNode> op2) {
-    LOG(INFO) << "areIndependent";
-    bool independent = true;
-    string output_op1 = op1->get_operator()->get_output_relation()->get_name();
-    string output_op2 = op2->get_operator()->get_output_relation()->get_name();
-    //TODO(Tach): inefficient, optimise
-    vector<Relation*> input_relations_op1 =
-      op1->get_operator()->get_relations();
-    vector<Relation*> input_relations_op2 =
-      op2->get_operator()->get_relations();
-    for (vector<Relation*>::iterator it = input_relations_op1.begin() ;
-         it != input_relations_op1.end(); ++it) {
-      string name = (*it)->get_name();
-      if (!strcmp(output_op1.c_str(), name.c_str())) {
-        return false;
+    for (; num_rewrites < kMaxPasses; ++num_rewrites) {
+      rel_size_ = *rel_size;
+      node_set visited;
+      for (op_nodes::iterator it = dag->begin(); it != dag->end(); ++it) {
+        estimateSize(*it, &visited);
+      }
+      if (!navigateTree(dag)) {
+        break;
       }
     }
-    // TODO(tach): currently can make no assumptions as to which one is parent
-    // of the other
-    for (vector<Relation*>::iterator it = input_relations_op2.begin();
-         it != input_relations_op2.end(); ++it) {
-      string name = (*it)->get_name();
-      if (!strcmp(output_op2.c_str(), name.c_str())) {
-        LOG(INFO) << "Depend on " << output_op2 << " and " << name;
+    LOG(INFO) << "Applied " << num_rewrites << " DAG rewrites";
+    span.AddArg("rewrites", static_cast<double>(num_rewrites));
+    rel_size_ = *rel_size;
+    node_set visited;
+    for (op_nodes::iterator it = dag->begin(); it != dag->end(); ++it) {
+      estimateSize(*it, &visited);
+    }
+    reorderJoins(dag);
+    pruneColumns(dag);
+  }
+
+  void QueryOptimiser::reorderJoins(op_nodes* dag) {
+    op_nodes order;
+    TopologicalOrder(*dag, &order);
+    for (op_nodes::iterator it = order.begin(); it != order.end(); ++it) {
+      if (!canReorder(*it)) {
+        continue;
+      }
+      // Start from the last JOIN of every tree of JOINs.
+      op_nodes children = (*it)->get_children();
+      if (children.size() == 1 && canReorder(children[0])) {
+        continue;
+      }
+      reorderJoin(*it, dag);
+    }
+  }
+
+  bool QueryOptimiser::canReorder(shared_ptr<OperatorNode> node) {
+    OperatorInterface* op = node->get_operator();
+    if (op->get_type() != JOIN_OP || op->isMPC() ||
+        loop_nodes_.find(node) != loop_nodes_.end() ||
+        !node->get_loop_children().empty()) {
+      return false;
+    }
+    vector<Relation*> inputs = op->get_relations();
+    return inputs[0]->get_name() != inputs[1]->get_name();
+  }
+
+  bool QueryOptimiser::reorderJoin(shared_ptr<OperatorNode> root,
+                                   op_nodes* dag) {
+    JoinGraph graph;
+    graph.output = root->get_operator()->get_output_relation();
+    op_nodes joins;
+    map<string, vector<int32_t> > layouts;
+    map<string, uint32_t> masks;
+    collectJoins(root, &graph, &joins, &layouts, &masks);
+    uint32_t num_inputs = graph.inputs.size();
+    set<string> input_names;
+    for (vector<Relation*>::iterator it = graph.inputs.begin();
+         it != graph.inputs.end(); ++it) {
+      input_names.insert((*it)->get_name());
+    }
+    if (num_inputs < 3 || num_inputs > kMaxJoinInputs ||
+        input_names.size() < num_inputs) {
+      return false;
+    }
+    JoinPlan no_plan = {0, 0, 0, numeric_limits<uint64_t>::max()};
+    graph.plans.assign(1 << num_inputs, no_plan);
+    for (uint32_t index = 0; index < num_inputs; ++index) {
+      map<string, pair<uint64_t, uint64_t> >::iterator size_it =
+        rel_size_.find(graph.inputs[index]->get_name());
+      if (size_it == rel_size_.end() ||
+          size_it->second.second == numeric_limits<uint64_t>::max()) {
         return false;
       }
+      JoinPlan input_plan = {0, 0, size_it->second.second, 0};
+      graph.plans[1 << index] = input_plan;
+      int32_t last_id = index + 1 < num_inputs ?
+        graph.first_ids[index + 1] : graph.types.size();
+      for (int32_t id = graph.first_ids[index]; id < last_id; ++id) {
+        graph.classes[id] = joinClass(&graph, id);
+        graph.class_inputs[graph.classes[id]] |= 1 << index;
+      }
     }
+    for (op_nodes::iterator it = joins.begin(); it != joins.end(); ++it) {
+      string name =
+        (*it)->get_operator()->get_output_relation()->get_name();
+      if (history_ == NULL) {
+        break;
+      }
+      vector<pair<string, uint64_t> > sizes =
+        history_->get_expected_data_size(name);
+      for (vector<pair<string, uint64_t> >::iterator size_it = sizes.begin();
+           size_it != sizes.end(); ++size_it) {
+        if (size_it->first == name) {
+          graph.observed_sizes[masks[name]] = size_it->second;
+        }
+      }
+    }
+    planJoins(&graph);
+    uint32_t all_inputs = (1 << num_inputs) - 1;
+    // Cost of the order the query was written in.
+    uint64_t written_cost = 0;
+    for (op_nodes::iterator it = joins.begin(); it != joins.end(); ++it) {
+      vector<Relation*> inputs = (*it)->get_operator()->get_relations();
+      for (vector<Relation*>::iterator rel_it = inputs.begin();
+           rel_it != inputs.end(); ++rel_it) {
+        const JoinPlan& plan = graph.plans[masks[(*rel_it)->get_name()]];
+        if (plan.cost == numeric_limits<uint64_t>::max()) {
+          return false;
+        }
+        written_cost = SumNoOverflow(written_cost, plan.size);
+      }
+    }
+    if (graph.plans[all_inputs].cost >= written_cost) {
+      LOG(INFO) << "Kept the order of the joins of "
+                << graph.output->get_name();
+      return false;
+    }
+    node_set old_joins(joins.begin(), joins.end());
+    for (op_nodes::iterator it = graph.producers.begin();
+         it != graph.producers.end(); ++it) {
+      if (*it) {
+        op_nodes children = (*it)->get_children();
+        op_nodes kept_children;
+        for (op_nodes::iterator child_it = children.begin();
+             child_it != children.end(); ++child_it) {
+          if (old_joins.find(*child_it) == old_joins.end()) {
+            kept_children.push_back(*child_it);
+          }
+        }
+        (*it)->set_children(kept_children);
+      }
+    }
+    for (op_nodes::iterator it = joins.begin(); it != joins.end(); ++it) {
+      dag->erase(remove(dag->begin(), dag->end(), *it), dag->end());
+    }
+    string input_dir = root->get_operator()->get_input_dir();
+    vector<int32_t> layout = planLayout(graph, all_inputs);
+    const vector<int32_t>& root_layout = layouts[graph.output->get_name()];
+    bool same_columns = layout.size() == root_layout.size();
+    for (vector<int32_t>::size_type pos = 0;
+         same_columns && pos < layout.size(); ++pos) {
+      same_columns =
+        graph.classes[layout[pos]] == graph.classes[root_layout[pos]];
+    }
+    Relation* join_output;
+    if (same_columns) {
+      buildJoinPlan(graph, all_inputs, input_dir, true, root, dag,
+                    &join_output);
+    } else {
+      // Restore the column order the consumers of the JOINs expect.
+      shared_ptr<OperatorNode> last_join =
+        buildJoinPlan(graph, all_inputs, input_dir, false,
+                      shared_ptr<OperatorNode>(), dag, &join_output);
+      vector<Column*> columns;
+      for (vector<int32_t>::const_iterator it = root_layout.begin();
+           it != root_layout.end(); ++it) {
+        vector<int32_t>::size_type pos = 0;
+        while (pos < layout.size() &&
+               graph.classes[layout[pos]] != graph.classes[*it]) {
+          ++pos;
+        }
+        columns.push_back(new Column(join_output->get_name(), pos,
+                                     graph.types[*it]));
+      }
+      ProjectOperator* project_op = new ProjectOperator(
+          input_dir, new ConditionTree(new Value("true", BOOLEAN_TYPE)),
+          vector<Relation*>(1, join_output->copy(join_output->get_name())),
+          columns, graph.output->copy(graph.output->get_name()));
+      root->replace_operator(project_op);
+      root->set_parents(op_nodes(1, last_join));
+      last_join->AddChild(root);
+    }
+    LOG(INFO) << "Reordered the joins of " << graph.output->get_name()
+              << ": estimated data read by them changes from "
+              << written_cost << " to " << graph.plans[all_inputs].cost;
     return true;
   }
 
-  bool QueryOptimiser::applyRules(shared_ptr<OperatorNode> child,
-                                  shared_ptr<OperatorNode> parent,
-                                  op_nodes* new_roots) {
-    bool changed = false;
-    LOG(INFO) << "applyRules";
-    // for(vector<rule_t>::iterator it = rules_.begin() ;
-    //  it!=rules_.end();
-    //  ++it) {
-    //   rule_t fn = **it ;
-    //   changed = changed && fn(child,parent);
-    // }
-    if (active_) {
-      changed = false // || filterMerge(child,parent, new_roots)
-        || filterPushUp(child, parent, new_roots);
-      //  || intersectionPushUp(child,parent, new_roots)
-      //  || differencePushUp(child,parent,new_roots) || sortPushDown(child,parent,new_roots)
-      //  || optimiseJoin(child,parent,new_roots)
-    } else {
-      LOG(INFO) << "Optimisations deactivated";
+  // Flattens the tree of JOINs that ends at node. layouts maps every
+  // relation of the tree to the ids of its columns and masks to the inputs
+  // it is computed from.
+  void QueryOptimiser::collectJoins(shared_ptr<OperatorNode> node,
+                                    JoinGraph* graph, op_nodes* joins,
+                                    map<string, vector<int32_t> >* layouts,
+                                    map<string, uint32_t>* masks) {
+    OperatorInterface* op = node->get_operator();
+    vector<Relation*> inputs = op->get_relations();
+    op_nodes parents = node->get_parents();
+    for (vector<Relation*>::iterator it = inputs.begin(); it != inputs.end();
+         ++it) {
+      string name = (*it)->get_name();
+      shared_ptr<OperatorNode> producer;
+      for (op_nodes::iterator parent_it = parents.begin();
+           parent_it != parents.end(); ++parent_it) {
+        if ((*parent_it)->get_operator()->get_output_relation()->get_name() ==
+            name) {
+          producer = *parent_it;
+        }
+      }
+      if (producer && canReorder(producer) &&
+          producer->get_children().size() == 1) {
+        collectJoins(producer, graph, joins, layouts, masks);
+        continue;
+      }
+      uint32_t index = graph->inputs.size();
+      graph->inputs.push_back(*it);
+      graph->producers.push_back(producer);
+      graph->first_ids.push_back(graph->types.size());
+      vector<int32_t>& layout = (*layouts)[name];
+      vector<Column*> columns = (*it)->get_columns();
+      for (vector<Column*>::iterator col_it = columns.begin();
+           col_it != columns.end(); ++col_it) {
+        layout.push_back(graph->types.size());
+        graph->classes.push_back(graph->types.size());
+        graph->types.push_back((*col_it)->get_type());
+      }
+      (*masks)[name] = index < 32 ? 1 << index : 0;
+    }
+    JoinOperator* join_op = dynamic_cast<JoinOperator*>(op);
+    const vector<int32_t>& left_layout = (*layouts)[inputs[0]->get_name()];
+    const vector<int32_t>& right_layout = (*layouts)[inputs[1]->get_name()];
+    vector<Column*> left_keys = join_op->get_left_cols();
+    vector<Column*> right_keys = join_op->get_right_cols();
+    set<int32_t> right_key_indices;
+    for (vector<Column*>::size_type key = 0;
+         key < left_keys.size() && key < right_keys.size(); ++key) {
+      int32_t left_index = left_keys[key]->get_index();
+      int32_t right_index = right_keys[key]->get_index();
+      if (left_index < static_cast<int32_t>(left_layout.size()) &&
+          right_index < static_cast<int32_t>(right_layout.size())) {
+        graph->classes[joinClass(graph, right_layout[right_index])] =
+          joinClass(graph, left_layout[left_index]);
+        right_key_indices.insert(right_index);
+      }
+    }
+    vector<int32_t> layout = left_layout;
+    for (vector<int32_t>::size_type index = 0; index < right_layout.size();
+         ++index) {
+      if (right_key_indices.find(index) == right_key_indices.end()) {
+        layout.push_back(right_layout[index]);
+      }
     }
-    LOG(INFO) << "Changed " << changed;
-    return changed;
+    string output = op->get_output_relation()->get_name();
+    (*layouts)[output] = layout;
+    (*masks)[output] = (*masks)[inputs[0]->get_name()] |
+      (*masks)[inputs[1]->get_name()];
+    joins->push_back(node);
   }
 
-  bool QueryOptimiser::navigateTree(op_nodes* dag) {
-    bool changed = false;
-    LOG(INFO) << "navigateTree DAG size " << dag->size();
-    for (op_nodes::iterator it = dag->begin(); it != dag->end(); ++it) {
-      shared_ptr<OperatorNode> node = *it;
-      bool opt = navigateTreeInternal(node, dag);
-      changed = changed || opt;
+  int32_t QueryOptimiser::joinClass(JoinGraph* graph, int32_t id) {
+    while (graph->classes[id] != id) {
+      graph->classes[id] = graph->classes[graph->classes[id]];
+      id = graph->classes[id];
     }
-    return changed;
+    return id;
   }
 
-  bool QueryOptimiser::navigateTreeInternal(shared_ptr<OperatorNode> node,
-                                            op_nodes* dag) {
-    op_nodes children = node->get_children();
-    int size = children.size();
-    bool changed = false;
-    if (size == 0) {
-      return false;
-    } else {
-     for (op_nodes::iterator it = children.begin(); it != children.end(); ++it) {
-       shared_ptr<OperatorNode> kid = *it;
-       bool chan = applyRules(kid, node, dag);
-       if (chan) {
-         navigateTreeInternal(node, dag);
-       } else {
-         navigateTreeInternal(kid, dag);
-       }
-       changed = changed && chan;
-     }
+  void QueryOptimiser::planJoins(JoinGraph* graph) {
+    uint32_t num_subsets = graph->plans.size();
+    for (uint32_t mask = 1; mask < num_subsets; ++mask) {
+      if ((mask & (mask - 1)) == 0) {
+        // A single input.
+        continue;
+      }
+      JoinPlan& plan = graph->plans[mask];
+      // The left side always holds the first input of the subset so that
+      // every split is only tried once.
+      uint32_t first_input = mask & (~mask + 1);
+      for (uint32_t left = (mask - 1) & mask; left > 0;
+           left = (left - 1) & mask) {
+        uint32_t right = mask ^ left;
+        if (!(left & first_input) ||
+            graph->plans[left].cost == numeric_limits<uint64_t>::max() ||
+            graph->plans[right].cost == numeric_limits<uint64_t>::max()) {
+          continue;
+        }
+        // Cross products are never planned.
+        bool joined = false;
+        for (map<int32_t, uint32_t>::iterator it =
+               graph->class_inputs.begin();
+             it != graph->class_inputs.end(); ++it) {
+          joined = joined || ((it->second & left) && (it->second & right));
+        }
+        if (!joined) {
+          continue;
+        }
+        if (plan.cost == numeric_limits<uint64_t>::max()) {
+          map<uint32_t, uint64_t>::iterator size_it =
+            graph->observed_sizes.find(mask);
+          plan.size = size_it != graph->observed_sizes.end() ?
+            size_it->second : estimateJoinSize(*graph, left, right);
+        }
+        uint64_t cost = SumNoOverflow(
+            SumNoOverflow(graph->plans[left].cost, graph->plans[right].cost),
+            SumNoOverflow(graph->plans[left].size, graph->plans[right].size));
+        if (cost < plan.cost) {
+          plan.left = left;
+          plan.right = right;
+          plan.cost = cost;
+        }
+      }
     }
-    return changed;
   }
 
-  void QueryOptimiser::deleteNode(shared_ptr<OperatorNode> child,
-                                  shared_ptr<OperatorNode> parent) {
-    LOG(INFO) << "deleteNode";
-    op_nodes::iterator it = find(parent->get_children().begin(),
-                                 parent->get_children().end(), child);
-    parent->get_children().erase(it);
-    parent->get_children().insert(parent->get_children().begin(),
-                                  child->get_children().begin(),
-                                  child->get_children().end());
-    for (op_nodes::iterator it = child->get_children().begin();
-         it != child->get_children().end(); ++it ) {
-      shared_ptr<OperatorNode> chi = *it;
-       /* Find  parent */
-      op_nodes::iterator it_par =
-        find(chi->get_parents().begin(), chi->get_parents().end(), parent);
-      *it_par = parent;
-    }
-  }
-
-  void QueryOptimiser::switchNodes(shared_ptr<OperatorNode> child,
-                                   shared_ptr<OperatorNode> parent,
-                                   op_nodes* dag) {
-    LOG(INFO) << "switchNodes";
-    op_nodes parents_of_child = child->get_parents();
-    op_nodes parents_of_parent = parent->get_parents();
-    op_nodes childs_of_child = child->get_children();
-    op_nodes childs_of_parent = parent->get_children();
-    shared_ptr<OperatorNode> dup_node;
-    OperatorInterface* op_inter_child = child->get_operator();
-    OperatorInterface* op_inter_parent = parent->get_operator();
-
-    /* Determine whether there is a need to duplicate */
-    // TODO(tach): for now: always duplicate, but possible to optimise
-    if ((op_inter_child->get_relations().size() == 1) &&
-        (op_inter_parent->get_relations().size() == 1)) {
-      LOG(INFO) << "Simple case, inverse nodes";
-      /* Do renaming here */
-      if (parent->get_parents().size() == 0) {
-        /* If Parent was a root, remove it */
-        op_nodes::iterator it = find(dag->begin(), dag->end(), parent);
-        if (it != dag->end()) {
-          dag->erase(it);
+  // Estimates the output of an equi-join as left * right / distinct keys.
+  // The number of distinct keys of a class is approximated by the size of
+  // the smallest input that has a column in it, i.e. the input is assumed
+  // to hold a key of the class.
+  uint64_t QueryOptimiser::estimateJoinSize(const JoinGraph& graph,
+                                            uint32_t left, uint32_t right) {
+    uint64_t distinct = 1;
+    for (map<int32_t, uint32_t>::const_iterator it =
+           graph.class_inputs.begin();
+         it != graph.class_inputs.end(); ++it) {
+      if (!(it->second & left) || !(it->second & right)) {
+        continue;
+      }
+      uint64_t class_distinct = numeric_limits<uint64_t>::max();
+      for (uint32_t index = 0; index < graph.inputs.size(); ++index) {
+        if (it->second & (left | right) & (1 << index)) {
+          class_distinct = min(class_distinct,
+                               max(graph.plans[1 << index].size,
+                                   static_cast<uint64_t>(1)));
         }
       }
-      swapOperators(child, parent);
-      if (child->get_parents().size() == 0) {
-        /* If Child has no parent, add it to roots */
-        dag->push_back(child);
-      }
-    } else if ((op_inter_child->get_relations().size() == 1) &&
-               (op_inter_parent->get_relations().size() == 2)) {
-      LOG(INFO) << "Requires duplication";
-      Relation* left = op_inter_parent->get_relations()[0];
-      Relation* right = op_inter_parent->get_relations()[1];
-      swapOperators(child, parent);
-
-      dup_node = copyNodes(child);
-
-      /* Dealing with operators */
-      left = op_inter_child->get_relations()[0];
-      right = op_inter_child->get_relations()[1];
-      vector<Relation*> relations_left = vector<Relation*>();
-      relations_left.push_back(left);
-      vector<Relation*> relations_right = vector<Relation*>();
-      relations_right.push_back(right);
-      child->get_operator()->set_relations(relations_left);
-      dup_node->get_operator()->set_relations(relations_right);
-
-      //TODO(HACK,HACK,HACK)
-      string left_name = left->get_name() + "reorder";
-      string right_name = right->get_name() + "reorder";
-
-      Relation* relation_left_filter = left->copy(left_name);
-      Relation* relation_right_filter = right->copy(right_name);
-
-      child->get_operator()->set_output_relation(relation_left_filter);
-      dup_node->get_operator()->set_output_relation(relation_right_filter);
-      dup_node->get_operator()->set_offset(
-          child->get_operator()->get_relations()[0]->get_columns(). size());
-
-      vector<Relation*> inputs = vector<Relation*>();
-      inputs.push_back(relation_left_filter);
-      inputs.push_back(relation_right_filter);
-      op_inter_parent->set_relations(inputs);
-
-      /* Dealing with nodes */
-      op_nodes left_children = op_nodes();
-      op_nodes right_children = op_nodes();
-      left_children.push_back(parent);
-      right_children.push_back(parent);
-      child->set_children(left_children);
-      dup_node->set_children(right_children);
-      op_nodes parents = op_nodes();
-      parents.push_back(child);
-      parents.push_back(dup_node);
-      parent->set_parents(parents);
-      updateOperator(parent->get_operator());
-      updateOperator(child->get_operator());
-      if (dup_node) updateOperator(dup_node->get_operator());
-      if (dup_node && (dup_node->get_parents().size() == 0)) {
-        LOG(INFO) << "Adding Dup Node";
-        dag->push_back(dup_node);
-      }
-     if (child->get_parents().size() == 0) {
-        replaceInVector(dag, parent, child);
+      distinct = max(distinct, class_distinct);
+    }
+    long double size = static_cast<long double>(graph.plans[left].size) *
+      graph.plans[right].size / distinct;
+    if (size >= numeric_limits<uint64_t>::max()) {
+      return numeric_limits<uint64_t>::max();
+    }
+    return static_cast<uint64_t>(size);
+  }
+
+  // Returns the ids of the columns the plan of the subset outputs.
+  vector<int32_t> QueryOptimiser::planLayout(const JoinGraph& graph,
+                                             uint32_t mask) {
+    const JoinPlan& plan = graph.plans[mask];
+    vector<int32_t> layout;
+    if (plan.left == 0) {
+      uint32_t index = 0;
+      while (!(mask & (1 << index))) {
+        ++index;
+      }
+      int32_t num_columns = graph.inputs[index]->get_columns().size();
+      for (int32_t column = 0; column < num_columns; ++column) {
+        layout.push_back(graph.first_ids[index] + column);
+      }
+      return layout;
+    }
+    layout = planLayout(graph, plan.left);
+    vector<int32_t> right_layout = planLayout(graph, plan.right);
+    vector<pair<int32_t, int32_t> > keys =
+      planKeys(graph, plan.left, plan.right);
+    set<int32_t> right_keys;
+    for (vector<pair<int32_t, int32_t> >::iterator it = keys.begin();
+         it != keys.end(); ++it) {
+      right_keys.insert(it->second);
+    }
+    for (vector<int32_t>::size_type pos = 0; pos < right_layout.size();
+         ++pos) {
+      if (right_keys.find(pos) == right_keys.end()) {
+        layout.push_back(right_layout[pos]);
+      }
+    }
+    return layout;
+  }
+
+  // Returns the positions of the columns the plans of the two subsets are
+  // joined on: one pair for every class both subsets have columns in.
+  vector<pair<int32_t, int32_t> > QueryOptimiser::planKeys(
+      const JoinGraph& graph, uint32_t left, uint32_t right) {
+    vector<int32_t> left_layout = planLayout(graph, left);
+    vector<int32_t> right_layout = planLayout(graph, right);
+    vector<pair<int32_t, int32_t> > keys;
+    for (map<int32_t, uint32_t>::const_iterator it =
+           graph.class_inputs.begin();
+         it != graph.class_inputs.end(); ++it) {
+      if (!(it->second & left) || !(it->second & right)) {
+        continue;
+      }
+      int32_t left_pos = 0;
+      while (graph.classes[left_layout[left_pos]] != it->first) {
+        ++left_pos;
+      }
+      int32_t right_pos = 0;
+      while (graph.classes[right_layout[right_pos]] != it->first) {
+        ++right_pos;
+      }
+      keys.push_back(make_pair(left_pos, right_pos));
+    }
+    return keys;
+  }
+
+  // Creates the JOINs of the subset's plan and returns the node of the
+  // last one, or the producer of the input if the subset is a single input.
+  // The last JOIN of the tree reuses node and writes the tree's output.
+  shared_ptr<OperatorNode> QueryOptimiser::buildJoinPlan(
+      const JoinGraph& graph, uint32_t mask, const string& input_dir,
+      bool last_join, shared_ptr<OperatorNode> node, op_nodes* dag,
+      Relation** output) {
+    const JoinPlan& plan = graph.plans[mask];
+    if (plan.left == 0) {
+      uint32_t index = 0;
+      while (!(mask & (1 << index))) {
+        ++index;
       }
+      *output = graph.inputs[index];
+      return graph.producers[index];
+    }
+    Relation* left_rel;
+    Relation* right_rel;
+    shared_ptr<OperatorNode> left_node =
+      buildJoinPlan(graph, plan.left, input_dir, false,
+                    shared_ptr<OperatorNode>(), dag, &left_rel);
+    shared_ptr<OperatorNode> right_node =
+      buildJoinPlan(graph, plan.right, input_dir, false,
+                    shared_ptr<OperatorNode>(), dag, &right_rel);
+    vector<int32_t> left_layout = planLayout(graph, plan.left);
+    vector<int32_t> right_layout = planLayout(graph, plan.right);
+    vector<pair<int32_t, int32_t> > keys =
+      planKeys(graph, plan.left, plan.right);
+    vector<Column*> left_cols;
+    vector<Column*> right_cols;
+    for (vector<pair<int32_t, int32_t> >::iterator it = keys.begin();
+         it != keys.end(); ++it) {
+      left_cols.push_back(new Column(left_rel->get_name(), it->first,
+                                     graph.types[left_layout[it->first]]));
+      right_cols.push_back(
+          new Column(right_rel->get_name(), it->second,
+                     graph.types[right_layout[it->second]]));
+    }
+    Relation* join_output;
+    if (last_join) {
+      join_output = graph.output->copy(graph.output->get_name());
     } else {
-      LOG(FATAL) << "Unimplemented";
+      join_output = layoutRelation(graph,
+                                   newRelationName(graph.output->get_name()),
+                                   planLayout(graph, mask),
+                                   graph.output->get_owners());
+      registerRelation(join_output);
     }
+    vector<Relation*> inputs;
+    inputs.push_back(left_rel->copy(left_rel->get_name()));
+    inputs.push_back(right_rel->copy(right_rel->get_name()));
+    JoinOperator* join_op =
+      new JoinOperator(input_dir, inputs, left_cols, right_cols, join_output);
+    op_nodes parents;
+    if (left_node) {
+      parents.push_back(left_node);
+    }
+    if (right_node) {
+      parents.push_back(right_node);
+    }
+    if (node) {
+      node->replace_operator(join_op);
+      node->set_parents(parents);
+    } else {
+      node = shared_ptr<OperatorNode>(new OperatorNode(join_op, parents));
+    }
+    for (op_nodes::iterator it = parents.begin(); it != parents.end(); ++it) {
+      (*it)->AddChild(node);
+    }
+    if (parents.empty()) {
+      dag->push_back(node);
+    }
+    *output = join_output;
+    return node;
   }
 
+  Relation* QueryOptimiser::layoutRelation(const JoinGraph& graph,
+                                           const string& name,
+                                           const vector<int32_t>& layout,
+                                           const set<Owner*>& owners) {
+    vector<Column*> columns;
+    for (vector<int32_t>::size_type pos = 0; pos < layout.size(); ++pos) {
+      columns.push_back(new Column(name, pos, graph.types[layout[pos]]));
+    }
+    return new Relation(name, columns, owners);
+  }
 
-  void QueryOptimiser::updateOperator(OperatorInterface* op) {
-    switch (op->get_type()) {
-    case AGG_OP: {
-      AggOperator* opCast = (dynamic_cast<AggOperator*>(op));
-      string relation = opCast->get_relations()[0]->get_name();
-      vector<Column*> cols = opCast->get_columns();
-      for (vector<Column*>::iterator it = cols.begin(); it != cols.end();
-           ++it) {
-        (*it)->rename(relation);
-      }
-      vector<Column*> group_bys = opCast->get_group_bys();
-      for (vector<Column*>::iterator it = group_bys.begin();
-           it != group_bys.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case COUNT_OP: {
-      CountOperator* opCast = (dynamic_cast<CountOperator*>(op));
-      string relation = opCast->get_relations()[0]->get_name();
-      opCast->get_column()->rename(relation);
-      vector<Column*> group_bys = opCast->get_group_bys();
-      for (vector<Column*>::iterator it = group_bys.begin();
-           it != group_bys.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case DIFFERENCE_OP: {
-      DifferenceOperator* opCast = dynamic_cast<DifferenceOperator*>(op);
-      break;
-    }
-    case DIV_OP: {
-      DivOperator* opCast = (dynamic_cast<DivOperator*>(op));
-      break;
-    }
-    case INTERSECTION_OP: {
-      IntersectionOperator* opCast = (dynamic_cast<IntersectionOperator*>(op));
-      break;
-    }
-    case JOIN_OP: {
-      JoinOperator* opCast = (dynamic_cast<JoinOperator*>(op));
-      string left = opCast->get_relations()[0]->get_name();
-      string right = opCast->get_relations()[1]->get_name();
-      opCast->get_col_left()->rename(left);
-      opCast->get_col_left()->rename(right);
-      break;
-    }
-    case MAX_OP: {
-      MaxOperator* opCast = (dynamic_cast<MaxOperator*>(op));
-      string relation = opCast->get_relations()[0]->get_name();
-      opCast->get_column()->rename(relation);
-      vector<Column*> group_bys = opCast->get_group_bys();
-      for (vector<Column*>::iterator it = group_bys.begin();
-           it != group_bys.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case MIN_OP: {
-      MinOperator* opCast = (dynamic_cast<MinOperator*>(op));
-      string relation = opCast->get_relations()[0]->get_name();
-      opCast->get_column()->rename(relation);
-      vector<Column*> group_bys = opCast->get_group_bys();
-      for (vector<Column*>::iterator it = group_bys.begin();
-           it != group_bys.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case MUL_OP: {
-      MulOperator* opCast = (dynamic_cast<MulOperator*>(op));
-      break;
-    }
-    case PROJECT_OP: {
-      ProjectOperator* opCast = (dynamic_cast<ProjectOperator*>(op));
-      vector<Column*> columns = opCast->get_columns();
-      string relation = opCast->get_relations()[0]->get_name();
-      for (vector<Column*>::iterator it = columns.begin();
-           it != columns.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case SELECT_OP: {
-      SelectOperator* opCast = (dynamic_cast<SelectOperator*>(op));
-      vector<Column*> columns = opCast->get_columns();
-      string relation = opCast->get_relations()[0]->get_name();
-      for (vector<Column*>::iterator it = columns.begin();
-           it != columns.end(); ++it) {
-        (*it)->rename(relation);
-      }
-      break;
-    }
-    case SORT_OP: {
-      SortOperator* opCast = (dynamic_cast<SortOperator*>(op));
-      string relation = opCast->get_relations()[0]->get_name();
-      opCast->get_column()->rename(relation);
-      break;
-    }
-    case SUB_OP: {
-      SubOperator* opCast = (dynamic_cast<SubOperator*>(op));
-      break;
-    }
-    case SUM_OP: {
-      SumOperator* opCast = (dynamic_cast<SumOperator*>(op));
-      break;
-    }
-    case UDF_OP: {
-      UdfOperator* opCast = (dynamic_cast<UdfOperator*>(op));
-      break;
-    }
-    case UNION_OP: {
-      UnionOperator* opCast = (dynamic_cast<UnionOperator*>(op));
-      break;
-    }
-    case WHILE_OP: {
-      WhileOperator* opCast = (dynamic_cast<WhileOperator*>(op));
-      break;
+  void QueryOptimiser::pruneColumns(op_nodes* dag) {
+    op_nodes order;
+    TopologicalOrder(*dag, &order);
+    map<string, Relation*> relations;
+    map<string, op_nodes> consumers;
+    map<string, int> num_producers;
+    for (op_nodes::iterator it = order.begin(); it != order.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      Relation* output_rel = op->get_output_relation();
+      relations[output_rel->get_name()] = output_rel;
+      num_producers[output_rel->get_name()]++;
+      vector<Relation*> inputs = op->get_relations();
+      for (vector<Relation*>::iterator rel_it = inputs.begin();
+           rel_it != inputs.end(); ++rel_it) {
+        relations.insert(make_pair((*rel_it)->get_name(), *rel_it));
+        op_nodes& rel_consumers = consumers[(*rel_it)->get_name()];
+        if (rel_consumers.empty() || rel_consumers.back() != *it) {
+          rel_consumers.push_back(*it);
+        }
+      }
+    }
+    // The columns of every relation that are read. Relations that are
+    // written by several operators (i.e. updated in loops) keep all of them.
+    map<string, set<int32_t> > required;
+    for (map<string, int>::iterator it = num_producers.begin();
+         it != num_producers.end(); ++it) {
+      if (it->second > 1) {
+        required[it->first] = allColumns(relations[it->first]);
+      }
     }
+    for (op_nodes::reverse_iterator it = order.rbegin(); it != order.rend();
+         ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      Relation* output_rel = op->get_output_relation();
+      // The outputs of the DAG keep all their columns.
+      if (required.find(output_rel->get_name()) == required.end()) {
+        required[output_rel->get_name()] = allColumns(output_rel);
+      }
+      const set<int32_t>& output_cols = required[output_rel->get_name()];
+      vector<Relation*> inputs = op->get_relations();
+      if (!canPrune(*it)) {
+        for (vector<Relation*>::iterator rel_it = inputs.begin();
+             rel_it != inputs.end(); ++rel_it) {
+          set<int32_t> columns = allColumns(*rel_it);
+          required[(*rel_it)->get_name()].insert(columns.begin(),
+                                                 columns.end());
+        }
+        continue;
+      }
+      if (op->get_type() == JOIN_OP) {
+        JoinOperator* join_op = dynamic_cast<JoinOperator*>(op);
+        set<int32_t>& left_required = required[inputs[0]->get_name()];
+        set<int32_t>& right_required = required[inputs[1]->get_name()];
+        vector<Column*> keys = join_op->get_left_cols();
+        for (vector<Column*>::iterator col_it = keys.begin();
+             col_it != keys.end(); ++col_it) {
+          left_required.insert((*col_it)->get_index());
+        }
+        keys = join_op->get_right_cols();
+        for (vector<Column*>::iterator col_it = keys.begin();
+             col_it != keys.end(); ++col_it) {
+          right_required.insert((*col_it)->get_index());
+        }
+        int32_t num_left_cols = inputs[0]->get_columns().size();
+        vector<int32_t> right_cols = joinRightColumns(join_op, inputs[1]);
+        for (set<int32_t>::const_iterator col_it = output_cols.begin();
+             col_it != output_cols.end(); ++col_it) {
+          if (*col_it < num_left_cols) {
+            left_required.insert(*col_it);
+          } else if (*col_it - num_left_cols <
+                     static_cast<int32_t>(right_cols.size())) {
+            right_required.insert(right_cols[*col_it - num_left_cols]);
+          }
+        }
+      } else {
+        vector<Column*> columns = selectedColumns(op);
+        set<int32_t>& input_required = required[inputs[0]->get_name()];
+        op->get_condition_tree()->getColumnIndices(&input_required);
+        for (set<int32_t>::const_iterator col_it = output_cols.begin();
+             col_it != output_cols.end(); ++col_it) {
+          if (*col_it < static_cast<int32_t>(columns.size())) {
+            input_required.insert(columns[*col_it]->get_index());
+          }
+        }
+      }
+    }
+    // The columns every relation keeps and the relations that are read
+    // through a new PROJECT.
+    map<string, vector<int32_t> > kept;
+    map<string, string> renamed;
+    for (op_nodes::iterator it = order.begin(); it != order.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      vector<Relation*> inputs = op->get_relations();
+      for (vector<Relation*>::iterator rel_it = inputs.begin();
+           rel_it != inputs.end(); ++rel_it) {
+        string name = (*rel_it)->get_name();
+        if (kept.find(name) != kept.end()) {
+          continue;
+        }
+        // The relation is an input of the DAG.
+        kept[name] = prunedColumns(*rel_it, required[name]);
+        if (kept[name].size() < (*rel_it)->get_columns().size()) {
+          renamed[name] = insertProject(*rel_it, kept[name],
+                                        shared_ptr<OperatorNode>(),
+                                        consumers[name], dag);
+        }
+      }
+      Relation* output_rel = op->get_output_relation();
+      string output = output_rel->get_name();
+      if (canPrune(*it)) {
+        kept[output] = pruneOperator(*it, required[output], kept, renamed);
+        continue;
+      }
+      vector<int32_t> columns = prunedColumns(output_rel, required[output]);
+      if (columns.size() < output_rel->get_columns().size() &&
+          loop_nodes_.find(*it) == loop_nodes_.end() && !op->isMPC() &&
+          !(*it)->get_children().empty() &&
+          (*it)->get_loop_children().empty()) {
+        kept[output] = columns;
+        renamed[output] =
+          insertProject(output_rel, columns, *it, consumers[output], dag);
+      } else {
+        kept[output] = prunedColumns(output_rel, allColumns(output_rel));
+      }
+    }
+  }
+
+  bool QueryOptimiser::canPrune(shared_ptr<OperatorNode> node) {
+    OperatorInterface* op = node->get_operator();
+    if (loop_nodes_.find(node) != loop_nodes_.end() || op->isMPC() ||
+        !node->get_loop_children().empty()) {
+      return false;
+    }
+    vector<Relation*> inputs = op->get_relations();
+    switch (op->get_type()) {
+    case JOIN_OP:
+      return inputs[0]->get_name() != inputs[1]->get_name();
+    case PROJECT_OP:
+    case SELECT_OP:
+      return op->get_condition_tree() != NULL &&
+        readsOnly(op->get_condition_tree(), inputs[0]->get_name());
     default:
-      LOG(ERROR) << "Unexpected operator type: " << op->get_type();
-    }
-  }
-
-  void QueryOptimiser::rewriteCondition(string relation,
-                                        pANTLR3_BASE_TREE condition_tree) {
-    LOG(INFO) << "rewriteCondition";
-  }
-
-  void QueryOptimiser::swapOperators(shared_ptr<OperatorNode> child,
-                                     shared_ptr<OperatorNode> parent) {
-    LOG(INFO) << "swapOperators";
-    op_nodes parents_of_child = child->get_parents();
-    op_nodes parents_of_parent = parent->get_parents();
-    op_nodes childs_of_child = child->get_children();
-    op_nodes childs_of_parent = parent->get_children();
-    /* Handling Operators */
-    OperatorInterface* op_inter_child = child->get_operator();
-    OperatorInterface* op_inter_parent = parent->get_operator();
-
-    Relation* swap = op_inter_parent->get_output_relation();
-    op_inter_parent->set_output_relation(op_inter_child->get_output_relation());
-    op_inter_child->set_output_relation(swap);
-    vector<Relation*> swaps = op_inter_child->get_relations();
-    if (op_inter_parent->get_relations().size() != op_inter_parent->get_relations().size()) {
-      LOG(ERROR) << "ERROR: Not Implemented. Logic wrong";
-      //TODO(Tach): fix
-    }
-    op_inter_child->set_relations(op_inter_parent->get_relations());
-    vector<Relation*> relations = vector<Relation*>();
-    relations.push_back(swaps.front());
-    op_inter_parent->set_relations(relations);
-
-    /* Handling Nodes */
-    for (op_nodes::iterator it = childs_of_parent.begin();
-         it != childs_of_parent.end(); ++it ) {
-      shared_ptr<OperatorNode> chi = *it;
-      if (chi != child) {
-        op_nodes::iterator it_par = find(chi->get_parents().begin(),
-                                         chi->get_parents().end(), parent);
-        *it_par = child;
-      }
-    }
-    for (op_nodes::iterator it = parents_of_parent.begin();
-         it != parents_of_parent.end(); ++it ) {
-      shared_ptr<OperatorNode> par = *it;
-      op_nodes::iterator it_par = find(par->get_children().begin(),
-                                       par->get_children().end(), parent);
-      *it_par = child;
-    }
-    for (op_nodes::iterator it = childs_of_child.begin();
-         it != childs_of_child.end(); ++it) {
-      shared_ptr<OperatorNode> chi = *it;
-      op_nodes::iterator it_chi = find(chi->get_parents().begin(),
-                                       chi->get_parents().end(), child);
-      *it_chi = parent;
-    }
-    op_nodes::iterator r = find(parents_of_child.begin(),
-                                parents_of_child.end(),
-                                parent);
-    if (r != parents_of_child.end()) {
-      parents_of_child.erase(r);
-    }
-
-    op_nodes sw = childs_of_child;
-    childs_of_child = childs_of_parent;
-    childs_of_parent = sw;
-    sw = parents_of_parent;
-    parents_of_parent = parents_of_child;
-    parents_of_parent.push_back(child);
-    parents_of_child = sw;
-    parent->set_parents(parents_of_parent);
-    child->set_parents(parents_of_child);
-    op_nodes::iterator it;
-    if (childs_of_parent.size() > 0) {
-      it = find(childs_of_parent.begin(), childs_of_parent.end(), child);
-      if (it != childs_of_parent.end()) {
-        childs_of_parent.erase(it);
-      }
-    }
-    parent->set_children(childs_of_parent);
-
-    if (childs_of_child.size() > 0)  {
-      it = find(childs_of_child.begin(),
-                childs_of_child.end(), child);
-      if (it != childs_of_child.end()) {
-        childs_of_child.erase(it);
-      }
-    }
-    childs_of_child.push_back(parent);
-    child->set_children(childs_of_child);
-
-    op_nodes nodes = child->get_parents();
-    it = nodes.begin();
-    if (nodes.size() > 0) {
-      it = find(nodes.begin(), nodes.end(), parent);
-      if (it != nodes.end()) {
-        nodes.erase(it);
-      }
-    }
-    child->set_parents(nodes);
+      return false;
+    }
   }
 
-  bool QueryOptimiser::filterMerge(shared_ptr<OperatorNode> child,
-                                   shared_ptr<OperatorNode> parent,
-                                   op_nodes* dag) {
-    LOG(INFO) << "filterMerge";
+  // Rebuilds the operator so that it reads the pruned inputs and only
+  // outputs the required columns. Returns the columns it keeps.
+  vector<int32_t> QueryOptimiser::pruneOperator(
+      shared_ptr<OperatorNode> node, const set<int32_t>& required,
+      const map<string, vector<int32_t> >& kept,
+      const map<string, string>& renamed) {
+    OperatorInterface* op = node->get_operator();
+    Relation* output_rel = op->get_output_relation();
+    vector<Relation*> inputs = op->get_relations();
     bool changed = false;
-    if ((child->get_operator()->get_type() == SELECT_OP) &&
-        (parent->get_operator()->get_type() == SELECT_OP))  {
-      vector<pANTLR3_BASE_TREE> conditions =
-        static_cast<SelectOperator*>(child->get_operator())->get_condition_tree();
-      for (vector<pANTLR3_BASE_TREE>::iterator it = conditions.begin();
-           it != conditions.end(); ++it) {
-        (static_cast<SelectOperator*> (parent->get_operator()))->addCondition(*it);
+    // Maps the columns of every input to their index after pruning.
+    vector<map<int32_t, Column*> > input_columns(inputs.size());
+    vector<Column*> pruned_columns;
+    vector<vector<int32_t> > input_kept;
+    vector<Relation*> new_inputs;
+    for (vector<Relation*>::size_type index = 0; index < inputs.size();
+         ++index) {
+      string name = inputs[index]->get_name();
+      string new_name = name;
+      map<string, string>::const_iterator rename_it = renamed.find(name);
+      if (rename_it != renamed.end()) {
+        new_name = rename_it->second;
       }
-      deleteNode(child, parent);
-      return true;
+      vector<int32_t> columns = kept.find(name)->second;
+      vector<Column*> rel_columns = inputs[index]->get_columns();
+      changed = changed || new_name != name ||
+        columns.size() < rel_columns.size();
+      for (vector<int32_t>::size_type pos = 0; pos < columns.size(); ++pos) {
+        Column* column = new Column(new_name, pos,
+                                    rel_columns[columns[pos]]->get_type());
+        pruned_columns.push_back(column);
+        input_columns[index][columns[pos]] = column;
+      }
+      input_kept.push_back(columns);
+      new_inputs.push_back(narrowRelation(inputs[index], new_name, columns));
+    }
+    vector<int32_t> output_cols;
+    OperatorInterface* pruned_op;
+    if (op->get_type() == JOIN_OP) {
+      JoinOperator* join_op = dynamic_cast<JoinOperator*>(op);
+      output_cols = input_kept[0];
+      int32_t num_left_cols = inputs[0]->get_columns().size();
+      vector<int32_t> right_cols = joinRightColumns(join_op, inputs[1]);
+      for (vector<int32_t>::size_type pos = 0; pos < right_cols.size();
+           ++pos) {
+        if (binary_search(input_kept[1].begin(), input_kept[1].end(),
+                          right_cols[pos])) {
+          output_cols.push_back(num_left_cols + pos);
+        }
+      }
+      pruned_op = new JoinOperator(
+          op->get_input_dir(), new_inputs,
+          mapColumns(join_op->get_left_cols(), input_columns[0]),
+          mapColumns(join_op->get_right_cols(), input_columns[1]),
+          narrowRelation(output_rel, output_rel->get_name(), output_cols));
     } else {
-      LOG(INFO) << "Rule Cannot be Applied";
+      output_cols = prunedColumns(output_rel, required);
+      vector<Column*> selected = selectedColumns(op);
+      vector<Column*> columns;
+      for (vector<int32_t>::iterator col_it = output_cols.begin();
+           col_it != output_cols.end(); ++col_it) {
+        columns.push_back(selected[*col_it]);
+      }
+      columns = mapColumns(columns, input_columns[0]);
+      ConditionTree* condition =
+        op->get_condition_tree()->copyWithColumns(input_columns[0]);
+      Relation* pruned_output =
+        narrowRelation(output_rel, output_rel->get_name(), output_cols);
+      if (op->get_type() == SELECT_OP) {
+        pruned_op = new SelectOperator(op->get_input_dir(), condition,
+                                       columns, new_inputs, pruned_output);
+      } else {
+        pruned_op = new ProjectOperator(op->get_input_dir(), condition,
+                                        new_inputs, columns, pruned_output);
+      }
     }
-    return false;
+    for (vector<Column*>::iterator it = pruned_columns.begin();
+         it != pruned_columns.end(); ++it) {
+      delete *it;
+    }
+    if (!changed && output_cols.size() == output_rel->get_columns().size()) {
+      delete pruned_op;
+      return output_cols;
+    }
+    LOG(INFO) << "Pruned " << output_rel->get_name() << " to "
+              << output_cols.size() << " of "
+              << output_rel->get_columns().size() << " columns";
+    registerRelation(pruned_op->get_output_relation());
+    node->replace_operator(pruned_op);
+    return output_cols;
   }
 
-  bool QueryOptimiser::filterPushUp(shared_ptr<OperatorNode> child,
-                                    shared_ptr<OperatorNode> parent,
-                                    op_nodes* dag) {
-    LOG(INFO) << "filterPushUp";
-    if ((child == NULL || parent == NULL)) {
-      return false;
+  // Adds a PROJECT that keeps the given columns of relation between the
+  // relation's producer and the operators that read it. Returns the name of
+  // the PROJECT's output.
+  string QueryOptimiser::insertProject(Relation* relation,
+                                       const vector<int32_t>& columns,
+                                       shared_ptr<OperatorNode> producer,
+                                       const op_nodes& consumers,
+                                       op_nodes* dag) {
+    string name = relation->get_name();
+    string pruned_rel = newRelationName(name);
+    vector<Column*> rel_columns = relation->get_columns();
+    vector<Column*> project_columns;
+    for (vector<int32_t>::const_iterator it = columns.begin();
+         it != columns.end(); ++it) {
+      project_columns.push_back(
+          new Column(name, *it, rel_columns[*it]->get_type()));
+    }
+    ProjectOperator* project_op = new ProjectOperator(
+        consumers.front()->get_operator()->get_input_dir(),
+        new ConditionTree(new Value("true", BOOLEAN_TYPE)),
+        vector<Relation*>(1, relation->copy(name)), project_columns,
+        narrowRelation(relation, pruned_rel, columns));
+    registerRelation(project_op->get_output_relation());
+    op_nodes parents;
+    if (producer) {
+      parents.push_back(producer);
     }
-    if ((child->get_operator()->get_type() == SELECT_OP)) {
-      if (canReorder(child, parent)) {
-        switchNodes(child, parent, dag);
-        return true;
+    shared_ptr<OperatorNode> project_node(
+        new OperatorNode(project_op, parents));
+    for (op_nodes::const_iterator it = consumers.begin();
+         it != consumers.end(); ++it) {
+      project_node->AddChild(*it);
+      op_nodes consumer_parents = (*it)->get_parents();
+      if (producer) {
+        consumer_parents.erase(remove(consumer_parents.begin(),
+                                      consumer_parents.end(), producer),
+                               consumer_parents.end());
       } else {
-        LOG(INFO) << "Cannot be reodered";
-        return false;
+        dag->erase(remove(dag->begin(), dag->end(), *it), dag->end());
+      }
+      consumer_parents.push_back(project_node);
+      (*it)->set_parents(consumer_parents);
+    }
+    if (producer) {
+      op_nodes children = producer->get_children();
+      for (op_nodes::const_iterator it = consumers.begin();
+           it != consumers.end(); ++it) {
+        children.erase(remove(children.begin(), children.end(), *it),
+                       children.end());
       }
+      children.push_back(project_node);
+      producer->set_children(children);
     } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
+      dag->push_back(project_node);
+    }
+    LOG(INFO) << "Pruned " << name << " to " << columns.size() << " of "
+              << rel_columns.size() << " columns";
+    return pruned_rel;
+  }
+
+  bool QueryOptimiser::navigateTree(op_nodes* dag) {
+    node_set visited;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    for (op_nodes::iterator it = dag->begin(); it != dag->end(); ++it) {
+      to_visit.push(*it);
+      visited.insert(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> node = to_visit.front();
+      to_visit.pop();
+      op_nodes children = node->get_children();
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        // The DAG has changed. Start again from its roots.
+        if (applyRules(*it, node, dag)) {
+          return true;
+        }
+      }
+      op_nodes loop_children = node->get_loop_children();
+      children.insert(children.end(), loop_children.begin(),
+                      loop_children.end());
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+    }
+    return false;
+  }
+
+  bool QueryOptimiser::applyRules(shared_ptr<OperatorNode> child,
+                                  shared_ptr<OperatorNode> parent,
+                                  op_nodes* dag) {
+    if (!canRewrite(child, parent)) {
+      return false;
+    }
+    return filterMerge(child, parent, dag) ||
+      filterPushUp(child, parent, dag) ||
+      unionPushDown(child, parent, dag) ||
+      optimiseProject(child, parent, dag);
+  }
+
+  bool QueryOptimiser::canRewrite(shared_ptr<OperatorNode> child,
+                                  shared_ptr<OperatorNode> parent) {
+    if (loop_nodes_.find(child) != loop_nodes_.end() ||
+        loop_nodes_.find(parent) != loop_nodes_.end()) {
       return false;
     }
+    OperatorInterface* child_op = child->get_operator();
+    OperatorInterface* parent_op = parent->get_operator();
+    if (child_op->isMPC() || parent_op->isMPC()) {
+      return false;
+    }
+    // The rules remove the parent's output. No other operator may read it.
+    return parent->get_children().size() == 1 &&
+      parent->get_loop_children().empty() &&
+      child->get_loop_children().empty() &&
+      child_op->get_relations().size() == 1;
+  }
+
+  void QueryOptimiser::markLoopNodes(const op_nodes& dag) {
+    loop_nodes_.clear();
+    node_set visited;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    for (op_nodes::const_iterator it = dag.begin(); it != dag.end(); ++it) {
+      to_visit.push(*it);
+      visited.insert(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> node = to_visit.front();
+      to_visit.pop();
+      op_nodes children = node->get_children();
+      op_nodes loop_children = node->get_loop_children();
+      children.insert(children.end(), loop_children.begin(),
+                      loop_children.end());
+      bool in_loop = node->get_operator()->get_type() == WHILE_OP ||
+        loop_nodes_.find(node) != loop_nodes_.end();
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (in_loop && loop_nodes_.insert(*it).second) {
+          // Visit the node again so that its children are marked as well.
+          visited.erase(*it);
+        }
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+      if (in_loop) {
+        loop_nodes_.insert(node);
+      }
+    }
+  }
+
+  void QueryOptimiser::estimateSize(shared_ptr<OperatorNode> node,
+                                    node_set* visited) {
+    if (!visited->insert(node).second) {
+      return;
+    }
+    op_nodes parents = node->get_parents();
+    for (op_nodes::iterator it = parents.begin(); it != parents.end(); ++it) {
+      estimateSize(*it, visited);
+    }
+    node->get_operator()->get_output_size(&rel_size_);
+    op_nodes children = node->get_children();
+    op_nodes loop_children = node->get_loop_children();
+    children.insert(children.end(), loop_children.begin(),
+                    loop_children.end());
+    for (op_nodes::iterator it = children.begin(); it != children.end();
+         ++it) {
+      estimateSize(*it, visited);
+    }
+  }
+
+  // Returns the size of the data the shuffling operators read. The map-only
+  // operators run in the same job as the operators next to them.
+  uint64_t QueryOptimiser::estimateCost(
+      const vector<OperatorInterface*>& ops,
+      map<string, pair<uint64_t, uint64_t> >* rel_size) {
+    uint64_t cost = 0;
+    for (vector<OperatorInterface*>::const_iterator it = ops.begin();
+         it != ops.end(); ++it) {
+      if (!(*it)->mapOnly()) {
+        vector<Relation*> inputs = (*it)->get_relations();
+        for (vector<Relation*>::iterator rel_it = inputs.begin();
+             rel_it != inputs.end(); ++rel_it) {
+          map<string, pair<uint64_t, uint64_t> >::iterator size_it =
+            rel_size->find((*rel_it)->get_name());
+          if (size_it == rel_size->end()) {
+            return numeric_limits<uint64_t>::max();
+          }
+          cost = SumNoOverflow(cost, size_it->second.second);
+        }
+      }
+      (*it)->get_output_size(rel_size);
+    }
+    return cost;
+  }
+
+  bool QueryOptimiser::isCheaper(const string& rule,
+                                 const vector<OperatorInterface*>& old_ops,
+                                 const vector<OperatorInterface*>& new_ops) {
+    map<string, pair<uint64_t, uint64_t> > old_rel_size = rel_size_;
+    map<string, pair<uint64_t, uint64_t> > new_rel_size = rel_size_;
+    uint64_t old_cost = estimateCost(old_ops, &old_rel_size);
+    uint64_t new_cost = estimateCost(new_ops, &new_rel_size);
+    LOG(INFO) << rule << " changes the estimated shuffled data from "
+              << old_cost << " to " << new_cost;
+    return new_cost <= old_cost;
+  }
+
+  void QueryOptimiser::deleteNode(shared_ptr<OperatorNode> child,
+                                  shared_ptr<OperatorNode> parent) {
+    op_nodes children = parent->get_children();
+    children.erase(remove(children.begin(), children.end(), child),
+                   children.end());
+    op_nodes grand_children = child->get_children();
+    for (op_nodes::iterator it = grand_children.begin();
+         it != grand_children.end(); ++it) {
+      op_nodes parents = (*it)->get_parents();
+      replace(parents.begin(), parents.end(), child, parent);
+      (*it)->set_parents(parents);
+      children.push_back(*it);
+    }
+    parent->set_children(children);
   }
 
-  bool QueryOptimiser::intersectionPushUp(shared_ptr<OperatorNode> child,
-                                          shared_ptr<OperatorNode> parent,
-                                          op_nodes* dag) {
-    LOG(INFO) << "intersectionPushUp";
-    if ((child->get_operator()->get_type() == INTERSECTION_OP)) {
-      if (canReorder(child, parent)) {
-        switchNodes(child, parent, dag);
-        return true;
+  // Adds a node running op between node and the operator that produces op's
+  // input.
+  shared_ptr<OperatorNode> QueryOptimiser::insertParent(
+      shared_ptr<OperatorNode> node, OperatorInterface* op, op_nodes* dag) {
+    string input_rel = op->get_relations()[0]->get_name();
+    op_nodes parents = node->get_parents();
+    shared_ptr<OperatorNode> producer;
+    for (op_nodes::iterator it = parents.begin(); it != parents.end(); ++it) {
+      if ((*it)->get_operator()->get_output_relation()->get_name() ==
+          input_rel) {
+        producer = *it;
       }
+    }
+    op_nodes new_parents;
+    if (producer) {
+      new_parents.push_back(producer);
+    }
+    shared_ptr<OperatorNode> new_node(new OperatorNode(op, new_parents));
+    new_node->AddChild(node);
+    if (producer) {
+      op_nodes children = producer->get_children();
+      replace(children.begin(), children.end(), node, new_node);
+      producer->set_children(children);
+      replace(parents.begin(), parents.end(), producer, new_node);
     } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
+      // The operator reads an input of the DAG.
+      parents.push_back(new_node);
+      dag->erase(remove(dag->begin(), dag->end(), node), dag->end());
+      dag->push_back(new_node);
+    }
+    node->set_parents(parents);
+    return new_node;
+  }
+
+  string QueryOptimiser::newRelationName(const string& relation) {
+    string name;
+    do {
+      name = relation + "_opt" +
+        boost::lexical_cast<string>(++num_new_relations_);
+    } while (RelationsType::relations_type.find(name) !=
+             RelationsType::relations_type.end());
+    RelationsType::relations_type[name] =
+      RelationsType::relations_type[relation];
+    return name;
+  }
+
+  void QueryOptimiser::splitConjuncts(ConditionTree* condition,
+                                      vector<ConditionTree*>* conjuncts) {
+    if (condition->isBinary() &&
+        condition->get_cond_operator()->toString() == "&&") {
+      splitConjuncts(condition->get_left(), conjuncts);
+      splitConjuncts(condition->get_right(), conjuncts);
+    } else {
+      conjuncts->push_back(condition);
+    }
+  }
+
+  ConditionTree* QueryOptimiser::mergeConjuncts(
+      const vector<ConditionTree*>& conjuncts,
+      const map<int32_t, Column*>& columns) {
+    ConditionTree* condition = NULL;
+    for (vector<ConditionTree*>::const_iterator it = conjuncts.begin();
+         it != conjuncts.end(); ++it) {
+      ConditionTree* conjunct = (*it)->copyWithColumns(columns);
+      if (condition == NULL) {
+        condition = conjunct;
+      } else {
+        condition =
+          new ConditionTree(new CondOperator("&&"), condition, conjunct);
+      }
+    }
+    return condition;
+  }
+
+  bool QueryOptimiser::isTrue(ConditionTree* condition) {
+    return condition == NULL ||
+      (condition->isValue() &&
+       condition->get_value()->get_value() == "true");
+  }
+
+  bool QueryOptimiser::readsOnly(ConditionTree* condition,
+                                 const string& relation) {
+    set<string> rel_names;
+    condition->getRelNames(&rel_names);
+    return rel_names.empty() ||
+      (rel_names.size() == 1 && *rel_names.begin() == relation);
+  }
+
+  bool QueryOptimiser::isIdentity(const vector<Column*>& columns,
+                                  Relation* input) {
+    if (columns.size() != input->get_columns().size()) {
       return false;
     }
-    return false;
+    for (vector<Column*>::size_type index = 0; index < columns.size();
+         ++index) {
+      if (columns[index]->get_index() != static_cast<int32_t>(index)) {
+        return false;
+      }
+    }
+    return true;
   }
 
-  bool QueryOptimiser::differencePushUp(shared_ptr<OperatorNode> child,
-                                        shared_ptr<OperatorNode> parent,
-                                        op_nodes* new_root) {
-    LOG(INFO) << "differencePushUp";
-    if ((child->get_operator()->get_type() == DIFFERENCE_OP)) {
-      if (canReorder(child, parent)) {
-        switchNodes(child, parent, new_root);
-        return true;
+  vector<Column*> QueryOptimiser::identityColumns(Relation* relation) {
+    vector<Column*> rel_columns = relation->get_columns();
+    vector<Column*> columns;
+    for (vector<Column*>::size_type index = 0; index < rel_columns.size();
+         ++index) {
+      columns.push_back(new Column(relation->get_name(), index,
+                                   rel_columns[index]->get_type()));
+    }
+    return columns;
+  }
+
+  map<int32_t, Column*> QueryOptimiser::indexColumns(
+      const vector<Column*>& columns) {
+    map<int32_t, Column*> mapping;
+    for (vector<Column*>::size_type index = 0; index < columns.size();
+         ++index) {
+      mapping[index] = columns[index];
+    }
+    return mapping;
+  }
+
+  vector<Column*> QueryOptimiser::mapColumns(
+      const vector<Column*>& columns, const map<int32_t, Column*>& mapping) {
+    vector<Column*> mapped;
+    for (vector<Column*>::const_iterator it = columns.begin();
+         it != columns.end(); ++it) {
+      map<int32_t, Column*>::const_iterator col_it =
+        mapping.find((*it)->get_index());
+      if (col_it == mapping.end()) {
+        mapped.push_back((*it)->clone());
+      } else {
+        mapped.push_back(col_it->second->clone());
       }
-    } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
+    }
+    return mapped;
+  }
+
+  vector<Column*> QueryOptimiser::selectedColumns(OperatorInterface* op) {
+    if (op->get_type() == PROJECT_OP) {
+      return dynamic_cast<ProjectOperator*>(op)->get_columns();
+    }
+    return dynamic_cast<SelectOperator*>(op)->get_columns();
+  }
+
+  // Returns the columns of the right input that are in the JOIN's output.
+  vector<int32_t> QueryOptimiser::joinRightColumns(JoinOperator* join_op,
+                                                   Relation* right_input) {
+    set<int32_t> keys;
+    vector<Column*> right_keys = join_op->get_right_cols();
+    for (vector<Column*>::iterator it = right_keys.begin();
+         it != right_keys.end(); ++it) {
+      keys.insert((*it)->get_index());
+    }
+    vector<int32_t> columns;
+    int32_t num_columns = right_input->get_columns().size();
+    for (int32_t index = 0; index < num_columns; ++index) {
+      if (keys.find(index) == keys.end()) {
+        columns.push_back(index);
+      }
+    }
+    return columns;
+  }
+
+  set<int32_t> QueryOptimiser::allColumns(Relation* relation) {
+    set<int32_t> columns;
+    int32_t num_columns = relation->get_columns().size();
+    for (int32_t index = 0; index < num_columns; ++index) {
+      columns.insert(index);
+    }
+    return columns;
+  }
+
+  vector<int32_t> QueryOptimiser::prunedColumns(Relation* relation,
+                                                const set<int32_t>& required) {
+    int32_t num_columns = relation->get_columns().size();
+    vector<int32_t> columns;
+    for (set<int32_t>::const_iterator it = required.begin();
+         it != required.end(); ++it) {
+      if (*it >= 0 && *it < num_columns) {
+        columns.push_back(*it);
+      }
+    }
+    // Rows must keep at least one column.
+    if (columns.empty() && num_columns > 0) {
+      columns.push_back(0);
+    }
+    return columns;
+  }
+
+  Relation* QueryOptimiser::narrowRelation(Relation* relation,
+                                           const string& name,
+                                           const vector<int32_t>& columns) {
+    vector<Column*> rel_columns = relation->get_columns();
+    vector<Column*> narrowed;
+    for (vector<int32_t>::size_type pos = 0; pos < columns.size(); ++pos) {
+      narrowed.push_back(
+          new Column(name, pos, rel_columns[columns[pos]]->get_type()));
+    }
+    return new Relation(name, narrowed, relation->get_owners());
+  }
+
+  void QueryOptimiser::registerRelation(Relation* relation) {
+    vector<uint16_t> types;
+    vector<Column*> columns = relation->get_columns();
+    for (vector<Column*>::iterator it = columns.begin(); it != columns.end();
+         ++it) {
+      types.push_back((*it)->get_type());
+    }
+    RelationsType::relations_type[relation->get_name()] = types;
+  }
+
+  vector<Relation*> QueryOptimiser::copyRelations(
+      const vector<Relation*>& relations) {
+    vector<Relation*> copies;
+    for (vector<Relation*>::const_iterator it = relations.begin();
+         it != relations.end(); ++it) {
+      copies.push_back((*it)->copy((*it)->get_name()));
+    }
+    return copies;
+  }
+
+  bool QueryOptimiser::filterMerge(shared_ptr<OperatorNode> child,
+                                   shared_ptr<OperatorNode> parent,
+                                   op_nodes* dag) {
+    OperatorInterface* child_op = child->get_operator();
+    OperatorInterface* parent_op = parent->get_operator();
+    if (child_op->get_type() != SELECT_OP ||
+        parent_op->get_type() != SELECT_OP ||
+        !readsOnly(child_op->get_condition_tree(),
+                   parent_op->get_output_relation()->get_name())) {
       return false;
     }
-    return false;
+    // The child's columns are indices into the parent's columns.
+    map<int32_t, Column*> parent_columns = indexColumns(
+        dynamic_cast<SelectOperator*>(parent_op)->get_columns());
+    ConditionTree* condition =
+      child_op->get_condition_tree()->copyWithColumns(parent_columns);
+    if (!isTrue(parent_op->get_condition_tree())) {
+      condition = new ConditionTree(
+          new CondOperator("&&"),
+          parent_op->get_condition_tree()->copyWithColumns(
+              map<int32_t, Column*>()),
+          condition);
+    }
+    Relation* output_rel = child_op->get_output_relation();
+    SelectOperator* merged = new SelectOperator(
+        parent_op->get_input_dir(), condition,
+        mapColumns(dynamic_cast<SelectOperator*>(child_op)->get_columns(),
+                   parent_columns),
+        copyRelations(parent_op->get_relations()),
+        output_rel->copy(output_rel->get_name()));
+    vector<OperatorInterface*> old_ops;
+    old_ops.push_back(parent_op);
+    old_ops.push_back(child_op);
+    if (!isCheaper("filterMerge", old_ops,
+                   vector<OperatorInterface*>(1, merged))) {
+      delete merged;
+      return false;
+    }
+    LOG(INFO) << "Merged SELECT " << parent_op->get_output_relation()->get_name()
+              << " into SELECT " << output_rel->get_name();
+    parent->replace_operator(merged);
+    deleteNode(child, parent);
+    return true;
   }
 
-  bool QueryOptimiser::optimiseJoin(shared_ptr<OperatorNode> child,
+  bool QueryOptimiser::filterPushUp(shared_ptr<OperatorNode> child,
                                     shared_ptr<OperatorNode> parent,
                                     op_nodes* dag) {
-    LOG(INFO) << "optimiseJoin";
-    bool changed = false;
-    if ((child->get_operator()->get_type() == JOIN_OP)) {
-      /* It is only worth reordering a join if there
-         is a significant asymetry in size */
-      Relation* relA = child->get_operator()->get_relations().front();
-      Relation* relB = child->get_operator()->get_relations().back();
-      // TODO(tach/ionel): Fix this. It only uses the first output of a job.
-      uint64_t sizA = history_->get_expected_data_size(relA->get_name())[0].second;
-      uint64_t sizB = history_->get_expected_data_size(relB->get_name())[0].second;
-      // TODO(tach/ionel): Check for overflow.
-      if (sizA != 0 && sizB != 0 &&
-          ((sizA > (kSizeFactor * sizB)) || (sizB > (kSizeFactor* sizA)))) {
-        if (canReorder(child, parent)) {
-          switchNodes(child, parent, dag);
-          return true;
+    OperatorInterface* child_op = child->get_operator();
+    OperatorInterface* parent_op = parent->get_operator();
+    if (child_op->get_type() != SELECT_OP ||
+        parent_op->get_type() != JOIN_OP) {
+      return false;
+    }
+    JoinOperator* join_op = dynamic_cast<JoinOperator*>(parent_op);
+    vector<Relation*> inputs = parent_op->get_relations();
+    if (inputs[0]->get_name() == inputs[1]->get_name()) {
+      return false;
+    }
+    // The output of the JOIN has all the columns of the left input followed
+    // by the columns of the right input that are not join keys.
+    vector<Column*> right_keys = join_op->get_right_cols();
+    set<int32_t> right_key_indices;
+    for (vector<Column*>::iterator it = right_keys.begin();
+         it != right_keys.end(); ++it) {
+      right_key_indices.insert((*it)->get_index());
+    }
+    int32_t num_left_cols = inputs[0]->get_columns().size();
+    int32_t num_join_cols = num_left_cols + inputs[1]->get_columns().size() -
+      right_key_indices.size();
+    string join_rel = parent_op->get_output_relation()->get_name();
+    vector<ConditionTree*> conjuncts;
+    splitConjuncts(child_op->get_condition_tree(), &conjuncts);
+    vector<ConditionTree*> side_conjuncts[2];
+    vector<ConditionTree*> rest_conjuncts;
+    for (vector<ConditionTree*>::iterator it = conjuncts.begin();
+         it != conjuncts.end(); ++it) {
+      set<int32_t> indices;
+      (*it)->getColumnIndices(&indices);
+      if (indices.empty() || !readsOnly(*it, join_rel)) {
+        rest_conjuncts.push_back(*it);
+      } else if (*indices.rbegin() < num_left_cols) {
+        side_conjuncts[0].push_back(*it);
+      } else if (*indices.begin() >= num_left_cols &&
+                 *indices.rbegin() < num_join_cols) {
+        side_conjuncts[1].push_back(*it);
+      } else {
+        rest_conjuncts.push_back(*it);
+      }
+    }
+    if (side_conjuncts[0].empty() && side_conjuncts[1].empty()) {
+      return false;
+    }
+    string input_dir = parent_op->get_input_dir();
+    vector<OperatorInterface*> new_ops;
+    SelectOperator* pushed_ops[2] = {NULL, NULL};
+    vector<Relation*> join_inputs;
+    for (int side = 0; side < 2; ++side) {
+      Relation* input = inputs[side];
+      if (side_conjuncts[side].empty()) {
+        join_inputs.push_back(input->copy(input->get_name()));
+        continue;
+      }
+      vector<Column*> columns = identityColumns(input);
+      map<int32_t, Column*> join_columns;
+      if (side == 0) {
+        join_columns = indexColumns(columns);
+      } else {
+        int32_t join_index = num_left_cols;
+        for (vector<Column*>::size_type index = 0; index < columns.size();
+             ++index) {
+          if (right_key_indices.find(index) == right_key_indices.end()) {
+            join_columns[join_index++] = columns[index];
+          }
         }
-        return false;
       }
-    } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
+      string pushed_rel = newRelationName(input->get_name());
+      pushed_ops[side] = new SelectOperator(
+          input_dir, mergeConjuncts(side_conjuncts[side], join_columns),
+          columns, vector<Relation*>(1, input->copy(input->get_name())),
+          input->copy(pushed_rel));
+      new_ops.push_back(pushed_ops[side]);
+      join_inputs.push_back(input->copy(pushed_rel));
+    }
+    vector<Column*> left_keys = mapColumns(join_op->get_left_cols(),
+                                           map<int32_t, Column*>());
+    for (vector<Column*>::iterator it = left_keys.begin();
+         it != left_keys.end(); ++it) {
+      (*it)->set_relation(join_inputs[0]->get_name());
+    }
+    right_keys = mapColumns(right_keys, map<int32_t, Column*>());
+    for (vector<Column*>::iterator it = right_keys.begin();
+         it != right_keys.end(); ++it) {
+      (*it)->set_relation(join_inputs[1]->get_name());
+    }
+    // The SELECT is only kept if it has conditions or columns left.
+    vector<Column*> select_columns =
+      dynamic_cast<SelectOperator*>(child_op)->get_columns();
+    bool keep_select = !rest_conjuncts.empty() ||
+      !isIdentity(select_columns, parent_op->get_output_relation());
+    Relation* join_output = keep_select ? parent_op->get_output_relation() :
+      child_op->get_output_relation();
+    JoinOperator* new_join_op = new JoinOperator(
+        input_dir, join_inputs, left_keys, right_keys,
+        join_output->copy(join_output->get_name()));
+    new_ops.push_back(new_join_op);
+    SelectOperator* rest_op = NULL;
+    if (keep_select) {
+      ConditionTree* condition = rest_conjuncts.empty() ?
+        new ConditionTree(new Value("true", BOOLEAN_TYPE)) :
+        mergeConjuncts(rest_conjuncts, map<int32_t, Column*>());
+      Relation* output_rel = child_op->get_output_relation();
+      rest_op = new SelectOperator(
+          input_dir, condition,
+          mapColumns(select_columns, map<int32_t, Column*>()),
+          copyRelations(child_op->get_relations()),
+          output_rel->copy(output_rel->get_name()));
+      new_ops.push_back(rest_op);
+    }
+    vector<OperatorInterface*> old_ops;
+    old_ops.push_back(parent_op);
+    old_ops.push_back(child_op);
+    if (!isCheaper("filterPushUp", old_ops, new_ops)) {
+      for (vector<OperatorInterface*>::iterator it = new_ops.begin();
+           it != new_ops.end(); ++it) {
+        delete *it;
+      }
       return false;
     }
-    return false;
+    LOG(INFO) << "Pushed SELECT " << child_op->get_output_relation()->get_name()
+              << " below JOIN " << join_rel;
+    parent->replace_operator(new_join_op);
+    for (int side = 0; side < 2; ++side) {
+      if (pushed_ops[side] != NULL) {
+        insertParent(parent, pushed_ops[side], dag);
+      }
+    }
+    if (keep_select) {
+      child->replace_operator(rest_op);
+    } else {
+      deleteNode(child, parent);
+    }
+    return true;
   }
 
   bool QueryOptimiser::unionPushDown(shared_ptr<OperatorNode> child,
                                      shared_ptr<OperatorNode> parent,
                                      op_nodes* dag) {
-    LOG(INFO) << "unionPushDown";
-    if ((parent->get_operator()->get_type() == UNION_OP)) {
-      if (canReorder(child, parent)) {
-        switchNodes(parent, child, dag);
-        return true;
-      }
-    } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
+    OperatorInterface* child_op = child->get_operator();
+    OperatorInterface* parent_op = parent->get_operator();
+    if (child_op->get_type() != SELECT_OP ||
+        parent_op->get_type() != UNION_OP ||
+        !readsOnly(child_op->get_condition_tree(),
+                   parent_op->get_output_relation()->get_name())) {
       return false;
     }
-    return false;
-  }
-
-  bool QueryOptimiser::sortPushDown(shared_ptr<OperatorNode> child,
-                                    shared_ptr<OperatorNode> parent,
-                                    op_nodes* dag) {
-    LOG(INFO) << "sortPushDown";
-    if ((parent->get_operator()->get_type() == SORT_OP)) {
-      if (canReorder(child, parent)) {
-        switchNodes(parent, child, dag);
-        return true;
+    vector<Relation*> inputs = parent_op->get_relations();
+    if (inputs.size() != 2 || inputs[0]->get_name() == inputs[1]->get_name()) {
+      return false;
+    }
+    string input_dir = parent_op->get_input_dir();
+    Relation* output_rel = child_op->get_output_relation();
+    vector<Column*> select_columns =
+      dynamic_cast<SelectOperator*>(child_op)->get_columns();
+    vector<OperatorInterface*> new_ops;
+    vector<Relation*> union_inputs;
+    for (vector<Relation*>::iterator it = inputs.begin(); it != inputs.end();
+         ++it) {
+      // Both inputs of the UNION have the columns of its output.
+      vector<Column*> input_columns = identityColumns(*it);
+      map<int32_t, Column*> columns = indexColumns(input_columns);
+      string pushed_rel = newRelationName(output_rel->get_name());
+      new_ops.push_back(new SelectOperator(
+          input_dir, child_op->get_condition_tree()->copyWithColumns(columns),
+          mapColumns(select_columns, columns),
+          vector<Relation*>(1, (*it)->copy((*it)->get_name())),
+          output_rel->copy(pushed_rel)));
+      union_inputs.push_back(output_rel->copy(pushed_rel));
+      for (vector<Column*>::iterator col_it = input_columns.begin();
+           col_it != input_columns.end(); ++col_it) {
+        delete *col_it;
+      }
+    }
+    UnionOperator* new_union_op = new UnionOperator(
+        input_dir, union_inputs, output_rel->copy(output_rel->get_name()));
+    new_ops.push_back(new_union_op);
+    vector<OperatorInterface*> old_ops;
+    old_ops.push_back(parent_op);
+    old_ops.push_back(child_op);
+    if (!isCheaper("unionPushDown", old_ops, new_ops)) {
+      for (vector<OperatorInterface*>::iterator it = new_ops.begin();
+           it != new_ops.end(); ++it) {
+        delete *it;
       }
-    } else {
-      LOG(INFO) << "Rule Cannot Be Applied";
       return false;
     }
-    return false;
+    LOG(INFO) << "Pushed UNION " << parent_op->get_output_relation()->get_name()
+              << " below SELECT " << output_rel->get_name();
+    parent->replace_operator(new_union_op);
+    insertParent(parent, new_ops[0], dag);
+    insertParent(parent, new_ops[1], dag);
+    deleteNode(child, parent);
+    return true;
   }
 
   bool QueryOptimiser::optimiseProject(shared_ptr<OperatorNode> child,
                                        shared_ptr<OperatorNode> parent,
                                        op_nodes* dag)  {
-    LOG(INFO) << "optimiseProject";
-    bool changed = false;
-    //TODO(implement)
-    return changed;
-  }
-
-  void QueryOptimiser::initialiseCommutativityMatrix() {
-    LOG(INFO) << "initialiseCommutativityMatrix";
-    for (int i = 0; i < kNumberOperators; i++) {
-      commutativity_matrix_[AGG_OP][i] = false;
-      commutativity_matrix_[i][AGG_OP] = false;
-      commutativity_matrix_[BLACK_BOX_OP][i] = false;
-      commutativity_matrix_[i][BLACK_BOX_OP] = false;
-      commutativity_matrix_[i][WHILE_OP] = false;
-      commutativity_matrix_[WHILE_OP][i] = false;
-      commutativity_matrix_[SORT_OP][i] = true;
-      commutativity_matrix_[i][SORT_OP] = true;
-      commutativity_matrix_[UDF_OP][i] = false;
-      commutativity_matrix_[i][UDF_OP] = false;
-      commutativity_matrix_[COUNT_OP][i] = false;
-      commutativity_matrix_[i][COUNT_OP] = false;
-    }
-    commutativity_matrix_[DIFFERENCE_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][DIV_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][INTERSECTION_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][JOIN_OP] = true;
-    commutativity_matrix_[DIFFERENCE_OP][MAX_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][MIN_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][MUL_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][PROJECT_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][SELECT_OP] = true;
-    commutativity_matrix_[DIFFERENCE_OP][SUB_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][SUM_OP] = false;
-    commutativity_matrix_[DIFFERENCE_OP][UNION_OP] = false;
-    commutativity_matrix_[DIV_OP][COUNT_OP] = false;
-    commutativity_matrix_[DIV_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[DIV_OP][DIV_OP] = false;
-    commutativity_matrix_[DIV_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[DIV_OP][JOIN_OP] = true;
-    commutativity_matrix_[DIV_OP][MAX_OP] = true;
-    commutativity_matrix_[DIV_OP][MIN_OP] = true;
-    commutativity_matrix_[DIV_OP][MUL_OP] = false;
-    commutativity_matrix_[DIV_OP][PROJECT_OP] = false;
-    commutativity_matrix_[DIV_OP][SELECT_OP] = false;
-    commutativity_matrix_[DIV_OP][SUB_OP] = false;
-    commutativity_matrix_[DIV_OP][SUM_OP] = false;
-    commutativity_matrix_[DIV_OP][UNION_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][COUNT_OP] = false;
-    commutativity_matrix_[INTERSECTION_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[INTERSECTION_OP][DIV_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][JOIN_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][MAX_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][MIN_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][MUL_OP] = false;
-    commutativity_matrix_[INTERSECTION_OP][PROJECT_OP] = true;
-    commutativity_matrix_[INTERSECTION_OP][SUB_OP] = false;
-    commutativity_matrix_[INTERSECTION_OP][SUM_OP] = false;
-    commutativity_matrix_[INTERSECTION_OP][UNION_OP] = false;
-    commutativity_matrix_[JOIN_OP][COUNT_OP] = false;
-    commutativity_matrix_[JOIN_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[JOIN_OP][DIV_OP] = false;
-    commutativity_matrix_[JOIN_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[JOIN_OP][JOIN_OP] = true;
-    commutativity_matrix_[JOIN_OP][MAX_OP] = false;
-    commutativity_matrix_[JOIN_OP][MIN_OP] = false;
-    commutativity_matrix_[JOIN_OP][MUL_OP] = false;
-    commutativity_matrix_[JOIN_OP][PROJECT_OP] = false;
-    commutativity_matrix_[JOIN_OP][SELECT_OP] = true;
-    commutativity_matrix_[JOIN_OP][SUB_OP] = false;
-    commutativity_matrix_[JOIN_OP][SUM_OP] = false;
-    commutativity_matrix_[JOIN_OP][UNION_OP] = false;
-    commutativity_matrix_[MAX_OP][COUNT_OP] = false;
-    commutativity_matrix_[MAX_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[MAX_OP][DIV_OP] = false;
-    commutativity_matrix_[MAX_OP][INTERSECTION_OP] = false;
-    commutativity_matrix_[MAX_OP][JOIN_OP] = false;
-    commutativity_matrix_[MAX_OP][MAX_OP] = false;
-    commutativity_matrix_[MAX_OP][MIN_OP] = false;
-    commutativity_matrix_[MAX_OP][MUL_OP] =  false;
-    commutativity_matrix_[MAX_OP][PROJECT_OP] = false;
-    commutativity_matrix_[MAX_OP][SELECT_OP] = false;
-    commutativity_matrix_[MAX_OP][SUB_OP] = false;
-    commutativity_matrix_[MAX_OP][SUM_OP] = false;
-    commutativity_matrix_[MAX_OP][UNION_OP] = false;
-    commutativity_matrix_[MIN_OP][COUNT_OP] = false;
-    commutativity_matrix_[MIN_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[MIN_OP][DIV_OP] = false;
-    commutativity_matrix_[MIN_OP][INTERSECTION_OP] = false;
-    commutativity_matrix_[MIN_OP][JOIN_OP] = false;
-    commutativity_matrix_[MIN_OP][MAX_OP] = false;
-    commutativity_matrix_[MIN_OP][MIN_OP] = false;
-    commutativity_matrix_[MIN_OP][MUL_OP] = false;
-    commutativity_matrix_[MIN_OP][PROJECT_OP] = false;
-    commutativity_matrix_[MIN_OP][SELECT_OP] = false;
-    commutativity_matrix_[MIN_OP][SUB_OP] = false;
-    commutativity_matrix_[MIN_OP][SUM_OP] = false;
-    commutativity_matrix_[MIN_OP][UNION_OP] = false;
-    commutativity_matrix_[MUL_OP][COUNT_OP] = false;
-    commutativity_matrix_[MUL_OP][DIFFERENCE_OP] = true;
-    commutativity_matrix_[MUL_OP][DIV_OP] = false;
-    commutativity_matrix_[MUL_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[MUL_OP][JOIN_OP] = true;
-    commutativity_matrix_[MUL_OP][MAX_OP] = false;
-    commutativity_matrix_[MUL_OP][MIN_OP] = false;
-    commutativity_matrix_[MUL_OP][MUL_OP] = true;
-    commutativity_matrix_[MUL_OP][PROJECT_OP] = false;
-    commutativity_matrix_[MUL_OP][SELECT_OP] = true;
-    commutativity_matrix_[MUL_OP][SUB_OP] = false;
-    commutativity_matrix_[MUL_OP][SUM_OP] = false;
-    commutativity_matrix_[MUL_OP][UNION_OP] = true;
-    commutativity_matrix_[PROJECT_OP][COUNT_OP] = false;
-    commutativity_matrix_[PROJECT_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[PROJECT_OP][DIV_OP] = false;
-    commutativity_matrix_[PROJECT_OP][INTERSECTION_OP] = false;
-    commutativity_matrix_[PROJECT_OP][JOIN_OP] = false;
-    commutativity_matrix_[PROJECT_OP][MAX_OP] = false;
-    commutativity_matrix_[PROJECT_OP][MIN_OP] = false;
-    commutativity_matrix_[PROJECT_OP][MUL_OP] = false;
-    commutativity_matrix_[PROJECT_OP][PROJECT_OP] = false;
-    commutativity_matrix_[PROJECT_OP][SELECT_OP] = false;
-    commutativity_matrix_[PROJECT_OP][SUB_OP] = false;
-    commutativity_matrix_[PROJECT_OP][SUM_OP] = false;
-    commutativity_matrix_[PROJECT_OP][UNION_OP] = false;
-    commutativity_matrix_[SELECT_OP][COUNT_OP] = true;
-    commutativity_matrix_[SELECT_OP][DIFFERENCE_OP] = true;
-    commutativity_matrix_[SELECT_OP][DIV_OP] = true;
-    commutativity_matrix_[SELECT_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[SELECT_OP][JOIN_OP] = true;
-    commutativity_matrix_[SELECT_OP][MAX_OP] = true;
-    commutativity_matrix_[SELECT_OP][MIN_OP] = true;
-    commutativity_matrix_[SELECT_OP][MUL_OP] = true;
-    commutativity_matrix_[SELECT_OP][PROJECT_OP] = false;
-    commutativity_matrix_[SELECT_OP][SELECT_OP] = true;
-    commutativity_matrix_[SELECT_OP][SUB_OP] = true;
-    commutativity_matrix_[SELECT_OP][SUM_OP] = true;
-    commutativity_matrix_[SELECT_OP][UNION_OP] = true;
-    commutativity_matrix_[SUB_OP][COUNT_OP] = false;
-    commutativity_matrix_[SUB_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[SUB_OP][DIV_OP] = false;
-    commutativity_matrix_[SUB_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[SUB_OP][JOIN_OP] = false;
-    commutativity_matrix_[SUB_OP][MAX_OP] = false;
-    commutativity_matrix_[SUB_OP][MIN_OP] = false;
-    commutativity_matrix_[SUB_OP][MUL_OP] = false;
-    commutativity_matrix_[SUB_OP][PROJECT_OP] = true;
-    commutativity_matrix_[SUB_OP][SELECT_OP] = false;
-    commutativity_matrix_[SUB_OP][SUB_OP] = true;
-    commutativity_matrix_[SUB_OP][SUM_OP] = true;
-    commutativity_matrix_[SUB_OP][UNION_OP] = true;
-    commutativity_matrix_[SUM_OP][COUNT_OP] = false;
-    commutativity_matrix_[SUM_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[SUM_OP][DIV_OP] = false;
-    commutativity_matrix_[SUM_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[SUM_OP][JOIN_OP] = false;
-    commutativity_matrix_[SUM_OP][MAX_OP] = false;
-    commutativity_matrix_[SUM_OP][MIN_OP] =  false;
-    commutativity_matrix_[SUM_OP][MUL_OP] = false;
-    commutativity_matrix_[SUM_OP][PROJECT_OP] = true;
-    commutativity_matrix_[SUM_OP][SELECT_OP] = true;
-    commutativity_matrix_[SUM_OP][SUB_OP] = true;
-    commutativity_matrix_[SUM_OP][SUM_OP] = true;
-    commutativity_matrix_[SUM_OP][UNION_OP] = true;
-    commutativity_matrix_[MUL_OP][COUNT_OP] = false;
-    commutativity_matrix_[UNION_OP][DIFFERENCE_OP] = false;
-    commutativity_matrix_[UNION_OP][DIV_OP] = true;
-    commutativity_matrix_[UNION_OP][INTERSECTION_OP] = true;
-    commutativity_matrix_[UNION_OP][JOIN_OP] = false;
-    commutativity_matrix_[UNION_OP][MAX_OP] = false;
-    commutativity_matrix_[UNION_OP][MIN_OP] = false;
-    commutativity_matrix_[UNION_OP][MUL_OP] =  false;
-    commutativity_matrix_[UNION_OP][PROJECT_OP] = true;
-    commutativity_matrix_[UNION_OP][SELECT_OP] = false;
-    commutativity_matrix_[UNION_OP][SUB_OP] = false;
-    commutativity_matrix_[UNION_OP][SUM_OP] = false;
-    commutativity_matrix_[UNION_OP][UNION_OP] = true;
-  }
-
-  void QueryOptimiser::initialiseRules(bool active) {
-    // LOG(INFO) << "initialiseRules" ;
-    // rules_ = vector<rule_t >();
-    // if (active ) {
-
-    //   rules_.push_back(&QueryOptimiser::filterMerge);
-      // rules_.push_back((rule_t)QueryOptimiser::filterPushUp);
-      // rules_.push_back((rule_t)QueryOptimiser::intersectionPushUp);
-      // rules_.push_back((rule_t)QueryOptimiser::differencePushUp);
-      // rules_.push_back((rule_t)QueryOptimiser::sortPushDown);
-      // rules_.push_back((rule_t)QueryOptimiser::optimiseJoin);
-      // rules_.push_back((rule_t)QueryOptimiser::unionPushDown);
-    // }
+    OperatorInterface* child_op = child->get_operator();
+    OperatorInterface* parent_op = parent->get_operator();
+    if ((child_op->get_type() != PROJECT_OP &&
+         child_op->get_type() != SELECT_OP) ||
+        !isTrue(child_op->get_condition_tree())) {
+      return false;
+    }
+    vector<Column*> child_columns = selectedColumns(child_op);
+    Relation* output_rel = child_op->get_output_relation();
+    OperatorType parent_type = parent_op->get_type();
+    if (isIdentity(child_columns, parent_op->get_output_relation())) {
+      // The projection keeps all the columns. The parent can write its
+      // output directly. The output of black box operators is fixed.
+      if (parent_type == BLACK_BOX_OP || parent_type == UDF_OP ||
+          parent_type == WHILE_OP) {
+        return false;
+      }
+      LOG(INFO) << "Removed projection " << output_rel->get_name();
+      parent_op->set_output_relation(output_rel->copy(output_rel->get_name()));
+      deleteNode(child, parent);
+      return true;
+    }
+    if (parent_type != PROJECT_OP && parent_type != SELECT_OP) {
+      return false;
+    }
+    vector<Column*> parent_columns = selectedColumns(parent_op);
+    // Only keep the parent's columns that the child uses.
+    vector<Column*> columns =
+      mapColumns(child_columns, indexColumns(parent_columns));
+    ConditionTree* condition = parent_op->get_condition_tree() == NULL ? NULL :
+      parent_op->get_condition_tree()->copyWithColumns(map<int32_t, Column*>());
+    OperatorInterface* folded_op;
+    if (parent_type == PROJECT_OP) {
+      folded_op = new ProjectOperator(
+          parent_op->get_input_dir(), condition,
+          copyRelations(parent_op->get_relations()), columns,
+          output_rel->copy(output_rel->get_name()));
+    } else {
+      folded_op = new SelectOperator(
+          parent_op->get_input_dir(), condition, columns,
+          copyRelations(parent_op->get_relations()),
+          output_rel->copy(output_rel->get_name()));
+    }
+    vector<OperatorInterface*> old_ops;
+    old_ops.push_back(parent_op);
+    old_ops.push_back(child_op);
+    if (!isCheaper("optimiseProject", old_ops,
+                   vector<OperatorInterface*>(1, folded_op))) {
+      delete folded_op;
+      return false;
+    }
+    LOG(INFO) << "Folded projection " << output_rel->get_name() << " into "
+              << parent_op->get_output_relation()->get_name();
+    parent->replace_operator(folded_op);
+    deleteNode(child, parent);
+    return true;
   }
 
 } // namespace musketeer
@@ -20,91 +20,183 @@
 #define MUSKETEER_QUERY_OPTIMISER_H
 
 #include <boost/shared_ptr.hpp>
-#include <stdio.h>
-#include <string.h>
+#include <stdint.h>
 
-#include <cstring>
-#include <functional>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/common.h"
 #include "base/utils.h"
 #include "core/history_storage.h"
 #include "frontends/operator_node.h"
+#include "ir/column.h"
+#include "ir/condition_tree.h"
+#include "ir/join_operator.h"
 #include "ir/operator_interface.h"
 
 namespace musketeer {
 
-const int kNumberOperators = 18;
+using ir::ConditionTree;
+using ir::JoinOperator;
 
+// Rewrites the operator DAG before it is scheduled. Every rule looks at an
+// operator (child) that reads the output of another operator (parent) and
+// is applied only if it does not increase the estimated amount of data the
+// DAG's shuffling operators read.
 class QueryOptimiser {
  public:
-  QueryOptimiser(bool active, HistoryStorage* history);
-  void optimiseDAG(op_nodes* dag);
+  QueryOptimiser(bool active, core::HistoryStorage* history);
+  // dag holds the roots of the DAG and rel_size the sizes of its inputs.
+  void optimiseDAG(op_nodes* dag,
+                   map<string, pair<uint64_t, uint64_t> >* rel_size);
 
  private:
-  bool canReorder(shared_ptr<OperatorNode> op1, shared_ptr<OperatorNode> op2);
-  bool doCommute(shared_ptr<OperatorNode> op1, shared_ptr<OperatorNode> op2);
-  bool areIndependent(shared_ptr<OperatorNode> op1,
-                      shared_ptr<OperatorNode> op2);
+  // Bounds the number of rewrites applied to a DAG.
+  static const int kMaxPasses = 100;
+  // Bounds the number of relations of a multi-way join that are reordered.
+  static const uint32_t kMaxJoinInputs = 10;
 
-  HistoryStorage* history_;
-  bool active_;
+  // The cheapest way of joining a subset of the inputs of a multi-way join.
+  // The subsets are bit masks over the inputs.
+  struct JoinPlan {
+    uint32_t left;
+    uint32_t right;
+    // Estimated output size and data read by the plan's JOINs.
+    uint64_t size;
+    uint64_t cost;
+  };
 
-  // TODO(tach): Pick better value
-  static const int kSizeFactor = 100;
+  // A tree of JOINs flattened into its inputs and the columns they are
+  // joined on. Every column of every input has an id.
+  struct JoinGraph {
+    // The output of the last JOIN.
+    Relation* output;
+    vector<Relation*> inputs;
+    // The nodes that produce the inputs, or NULL for inputs of the DAG.
+    op_nodes producers;
+    // The id of the first column of every input.
+    vector<int32_t> first_ids;
+    vector<uint16_t> types;
+    // The columns that are equal because they are joined on are in the
+    // same class. Maps every id to its class.
+    vector<int32_t> classes;
+    // Maps every class to the inputs that have columns in it.
+    map<int32_t, uint32_t> class_inputs;
+    // Output sizes the history recorded for the subsets the JOINs of the
+    // query produce.
+    map<uint32_t, uint64_t> observed_sizes;
+    // Indexed by subset; plans[mask].cost is max if there is no plan.
+    vector<JoinPlan> plans;
+  };
 
   /* Rules */
+  // Merges two consecutive SELECTs.
   bool filterMerge(shared_ptr<OperatorNode> child,
                    shared_ptr<OperatorNode> parent,
-                   op_nodes* new_roots);
+                   op_nodes* dag);
+  // Moves the conditions of a SELECT that only use the columns of one JOIN
+  // input to a new SELECT on that input.
   bool filterPushUp(shared_ptr<OperatorNode> child,
                     shared_ptr<OperatorNode> parent,
-                    op_nodes* new_roots);
-  bool intersectionPushUp(shared_ptr<OperatorNode> child,
-                          shared_ptr<OperatorNode> parent,
-                          op_nodes* new_roots);
-  bool differencePushUp(shared_ptr<OperatorNode> child,
-                        shared_ptr<OperatorNode> parent,
-                        op_nodes* new_roots);
-  bool sortPushDown(shared_ptr<OperatorNode> child,
-                    shared_ptr<OperatorNode> parent,
-                    op_nodes* new_roots);
-  /* These two make use of the history */
-  bool optimiseJoin(shared_ptr<OperatorNode> child,
-                    shared_ptr<OperatorNode> parent,
-                    op_nodes* new_roots);
+                    op_nodes* dag);
+  // Folds a PROJECT into the SELECT or PROJECT it reads from and removes
+  // projections that keep all the columns.
   bool optimiseProject(shared_ptr<OperatorNode> child,
                        shared_ptr<OperatorNode> parent,
-                       op_nodes* new_roots);
+                       op_nodes* dag);
+  // Replaces a SELECT of a UNION with a UNION of SELECTs.
   bool unionPushDown(shared_ptr<OperatorNode> child,
                      shared_ptr<OperatorNode> parent,
-                     op_nodes* new_roots);
-  bool applyRules(shared_ptr<OperatorNode> op1,
-                  shared_ptr<OperatorNode> op2,
-                  op_nodes* new_roots);
+                     op_nodes* dag);
+  // Narrows every relation to the columns the operators that read it use.
+  // PROJECTs are added after the inputs and the operators whose outputs
+  // cannot be narrowed in place.
+  void pruneColumns(op_nodes* dag);
+  bool canPrune(shared_ptr<OperatorNode> node);
+  vector<int32_t> pruneOperator(shared_ptr<OperatorNode> node,
+                                const set<int32_t>& required,
+                                const map<string, vector<int32_t> >& kept,
+                                const map<string, string>& renamed);
+  string insertProject(Relation* relation, const vector<int32_t>& columns,
+                       shared_ptr<OperatorNode> producer,
+                       const op_nodes& consumers, op_nodes* dag);
+  // Picks the cheapest order for every tree of JOINs with dynamic
+  // programming over its left-deep and bushy join orders.
+  void reorderJoins(op_nodes* dag);
+  bool canReorder(shared_ptr<OperatorNode> node);
+  bool reorderJoin(shared_ptr<OperatorNode> root, op_nodes* dag);
+  void collectJoins(shared_ptr<OperatorNode> node, JoinGraph* graph,
+                    op_nodes* joins, map<string, vector<int32_t> >* layouts,
+                    map<string, uint32_t>* masks);
+  int32_t joinClass(JoinGraph* graph, int32_t id);
+  void planJoins(JoinGraph* graph);
+  uint64_t estimateJoinSize(const JoinGraph& graph, uint32_t left,
+                            uint32_t right);
+  vector<int32_t> planLayout(const JoinGraph& graph, uint32_t mask);
+  vector<pair<int32_t, int32_t> > planKeys(const JoinGraph& graph,
+                                           uint32_t left, uint32_t right);
+  shared_ptr<OperatorNode> buildJoinPlan(const JoinGraph& graph,
+                                         uint32_t mask,
+                                         const string& input_dir,
+                                         bool last_join,
+                                         shared_ptr<OperatorNode> node,
+                                         op_nodes* dag, Relation** output);
+  Relation* layoutRelation(const JoinGraph& graph, const string& name,
+                           const vector<int32_t>& layout,
+                           const set<Owner*>& owners);
+  bool applyRules(shared_ptr<OperatorNode> child,
+                  shared_ptr<OperatorNode> parent,
+                  op_nodes* dag);
   bool navigateTree(op_nodes* dag);
-  bool navigateTreeInternal(shared_ptr<OperatorNode > node, op_nodes* new_roots);
-  shared_ptr<OperatorNode> copyNodes(shared_ptr<OperatorNode> node);
-  void renameNodes(shared_ptr<OperatorNode> child,
-                   shared_ptr<OperatorNode> parent);
+  bool canRewrite(shared_ptr<OperatorNode> child,
+                  shared_ptr<OperatorNode> parent);
+  void markLoopNodes(const op_nodes& dag);
+  void estimateSize(shared_ptr<OperatorNode> node, node_set* visited);
+  uint64_t estimateCost(const vector<OperatorInterface*>& ops,
+                        map<string, pair<uint64_t, uint64_t> >* rel_size);
+  bool isCheaper(const string& rule,
+                 const vector<OperatorInterface*>& old_ops,
+                 const vector<OperatorInterface*>& new_ops);
   void deleteNode(shared_ptr<OperatorNode> child,
                   shared_ptr<OperatorNode> parent);
-  void switchNodes(shared_ptr<OperatorNode> child,
-                   shared_ptr<OperatorNode> parent,
-                   op_nodes* new_roots);
-  void swapOperators(shared_ptr<OperatorNode> child,
-                     shared_ptr<OperatorNode> parent);
-  void rewriteCondition(string relation, pANTLR3_BASE_TREE condition_tree);
-  void initialiseCommutativityMatrix();
-  void initialiseRules(bool active);
-  void updateOperator(OperatorInterface* op);
-  bool commutativity_matrix_[kNumberOperators][kNumberOperators];
-};
+  shared_ptr<OperatorNode> insertParent(shared_ptr<OperatorNode> node,
+                                        OperatorInterface* op,
+                                        op_nodes* dag);
+  string newRelationName(const string& name);
+  void splitConjuncts(ConditionTree* condition,
+                      vector<ConditionTree*>* conjuncts);
+  ConditionTree* mergeConjuncts(const vector<ConditionTree*>& conjuncts,
+                                const map<int32_t, Column*>& columns);
+  bool isTrue(ConditionTree* condition);
+  bool readsOnly(ConditionTree* condition, const string& relation);
+  bool isIdentity(const vector<Column*>& columns, Relation* input);
+  vector<Column*> identityColumns(Relation* relation);
+  map<int32_t, Column*> indexColumns(const vector<Column*>& columns);
+  vector<Column*> mapColumns(const vector<Column*>& columns,
+                             const map<int32_t, Column*>& mapping);
+  vector<Relation*> copyRelations(const vector<Relation*>& relations);
+  vector<Column*> selectedColumns(OperatorInterface* op);
+  vector<int32_t> joinRightColumns(JoinOperator* join_op,
+                                   Relation* right_input);
+  set<int32_t> allColumns(Relation* relation);
+  vector<int32_t> prunedColumns(Relation* relation,
+                                const set<int32_t>& required);
+  Relation* narrowRelation(Relation* relation, const string& name,
+                           const vector<int32_t>& columns);
+  void registerRelation(Relation* relation);
 
-typedef bool (QueryOptimiser::*rule_t)(shared_ptr<OperatorNode>,
-                                       shared_ptr<OperatorNode>);
+  core::HistoryStorage* history_;
+  bool active_;
+  // Nodes that are part of or follow a WHILE loop. They are not rewritten
+  // because the loop updates their relations in place.
+  node_set loop_nodes_;
+  // Size estimates of the relations of the DAG that is being rewritten.
+  map<string, pair<uint64_t, uint64_t> > rel_size_;
+  uint32_t num_new_relations_;
+};
 
 } // namespace musketeer
 #endif
@@ -77,6 +77,10 @@ namespace scheduling {
     FrameworkInterface* fmw = fmws.find(FLAGS_force_framework)->second;
     LOG(INFO) << "Begin Schedule DAG";
     string binary_file = fmw->Translate(dag, output_relation);
+    if (binary_file.empty()) {
+      LOG(ERROR) << "Could not generate the code of " << output_relation;
+      return;
+    }
     LOG(INFO) << "-------> *** ";
     LOG(INFO) << "End Schedule DAG";
     fmw->Dispatch(binary_file, output_relation);
@@ -18,6 +18,12 @@
 
 #include "scheduling/scheduler_dynamic.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+#include <sys/time.h>
+
+#include <algorithm>
 #include <bitset>
 #include <limits>
 #include <map>
@@ -28,14 +34,40 @@
 
 #include "base/common.h"
 #include "base/hdfs_utils.h"
+#include "base/trace.h"
 #include "ir/while_operator.h"
 
+// Appended to the outputs of speculatively launched jobs.
+#define SPECULATIVE_SUFFIX "_spec"
+
 namespace musketeer {
 namespace scheduling {
 
+  using musketeer::core::JobMetrics;
   using musketeer::core::JobRun;
+  using musketeer::core::ParseJobMetrics;
+  using musketeer::ir::JoinOperator;
   using musketeer::ir::WhileOperator;
 
+  static uint64_t ElapsedMs(const timeval& start, const timeval& end) {
+    return (end.tv_sec - start.tv_sec) * 1000 +
+      (end.tv_usec - start.tv_usec) / 1000;
+  }
+
+  // Lists the operators of a sub-DAG for a trace, e.g. "JOIN(r1) AGG(r2)".
+  template <typename NodeContainer>
+  static string DescribeNodes(const NodeContainer& nodes) {
+    string description = "";
+    for (typename NodeContainer::const_iterator it = nodes.begin();
+         it != nodes.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      description += (description.empty() ? "" : " ") +
+        string(op->get_type_string()) + "(" +
+        op->get_output_relation()->get_name() + ")";
+    }
+    return description;
+  }
+
   // Construct subDAG for a while operator node.
   void SchedulerDynamic::ConstructSubDAGWhile(
       shared_ptr<OperatorNode> cur_node, const node_set& nodes, node_set* visited,
@@ -201,14 +233,15 @@ namespace scheduling {
 
   op_nodes::size_type SchedulerDynamic::DynamicScheduleWhileBody(
       const op_nodes& nodes, const op_nodes& order, uint64_t* num_op_executed) {
-    WhileOperator* while_op =
-      dynamic_cast<WhileOperator*>(nodes[0]->get_operator());
     // TODO(ionel): FIX! We increase iter in the scheduler code.
     op_nodes::size_type while_boundary =
       DetermineWhileBoundary(nodes[0], order, 0);
+    // Let the translators of the per-iteration jobs know which inputs are
+    // not updated by the loop.
+    MarkLoopInvariantRelations(nodes[0]);
     int iter = 0;
     bool first_iteration = true;
-    while (while_op->get_condition_tree()->checkCondition(iter)) {
+    while (CheckLoopCondition(nodes[0], iter)) {
       op_nodes order_body(order.begin() + 1,
                           order.begin() + while_boundary + 1);
       while (order_body.size() > 0) {
@@ -236,11 +269,13 @@ namespace scheduling {
   }
 
   void SchedulerDynamic::DynamicScheduleDAG(const op_nodes& dag) {
+    TraceSpan span("scheduling", "DynamicScheduleDAG");
     DetermineInputsSize(dag);
     LOG(INFO) << "DynamicSchedule DAG";
     op_nodes order = op_nodes();
-    //    optimiser_->optimiseDAG(dag);
-    TopologicalOrder(dag, &order);
+    op_nodes optimised_dag = dag;
+    optimiser_.optimiseDAG(&optimised_dag, rel_size_);
+    TopologicalOrder(optimised_dag, &order);
     PrintNodesVector("Node order after optimisation: ", order);
     if (FLAGS_populate_history) {
       vector<string> rel_names;
@@ -254,6 +289,25 @@ namespace scheduling {
     }
 
     uint64_t num_op_executed = 0;
+    if (FLAGS_mpc_parallel_local_subplans) {
+      map<string, op_nodes> local_subplans = DetermineLocalSubplans(order);
+      if (local_subplans.size() > 0) {
+        num_op_executed += ScheduleLocalSubplans(local_subplans);
+        // The remaining operators start at the MPC frontier.
+        node_set local_nodes;
+        for (map<string, op_nodes>::iterator it = local_subplans.begin();
+             it != local_subplans.end(); ++it) {
+          local_nodes.insert(it->second.begin(), it->second.end());
+        }
+        op_nodes remaining_order;
+        for (op_nodes::iterator it = order.begin(); it != order.end(); ++it) {
+          if (local_nodes.find(*it) == local_nodes.end()) {
+            remaining_order.push_back(*it);
+          }
+        }
+        order = remaining_order;
+      }
+    }
     while (order.size() > 0) {
       RefreshOutputSize(order);
       bindings_lt l_bindings = BindOperators(order);
@@ -261,6 +315,11 @@ namespace scheduling {
       pair<op_nodes, FmwType> bind = bindings[0];
       // LOG(INFO) << "Running job " << index << " on framework " <<
       //   CheckForceFmwFlag(bind.second);
+      if (FLAGS_whole_loop_offload &&
+          bind.first[0]->get_operator()->get_type() == WHILE_OP &&
+          bind.first.size() == 1) {
+        BindWholeLoop(order, &bind);
+      }
       uint64_t num_op_scheduled = 0;
       // Check if we're trying to schedyle WHILE OPERATOR individually.
       if (bind.first[0]->get_operator()->get_type() == WHILE_OP &&
@@ -292,6 +351,9 @@ namespace scheduling {
       // Remove the operators that have already been executed.
       order.erase(order.begin(), order.begin() + num_op_scheduled);
     }
+    if (FLAGS_simulate) {
+      scheduler_simulator_.PrintReport();
+    }
   }
 
   void SchedulerDynamic::DispatchWithHistory(
@@ -300,25 +362,408 @@ namespace scheduling {
     LOG(INFO) << "Dispatching relation " << relation << " in framework "
               << fmw_name;
     FrameworkInterface* fmw = fmws.find(fmw_name)->second;
+    TraceSpan span("execution", "Job " + relation);
+    span.AddArg("framework", fmw_name);
+    span.AddArg("dag", DescribeNodes(bind.first));
+    if (FLAGS_simulate) {
+      uint64_t run_time_ms = SimulateJob(bind.first, relation, fmw_name, fmw);
+      PopulateHistory(nodes, relation, fmw_name, run_time_ms, JobMetrics());
+      return;
+    }
     timeval start_make_span;
     gettimeofday(&start_make_span, NULL);
-    string binary_file = fmw->Translate(nodes, relation);
-    fmw->Dispatch(binary_file, relation);
+    ChooseJoinStrategies(bind.first);
+    RecordInputSizes(bind.first);
+    if (!ChooseIntermediateFormats(bind.first, fmw)) {
+      LOG(ERROR) << "Not dispatching " << relation << " to " << fmw_name
+                 << " because its inputs are not readable";
+      return;
+    }
+    string binary_file;
+    {
+      TraceSpan translate_span("execution", "Translate");
+      binary_file = fmw->Translate(nodes, relation);
+    }
+    if (binary_file.empty()) {
+      LOG(ERROR) << "Not dispatching " << relation << " to " << fmw_name
+                 << " because its code could not be generated";
+      return;
+    }
+    timeval end_translate;
+    gettimeofday(&end_translate, NULL);
+    map<string, uint64_t> job_output;
+    int exit_status;
+    // A backup job that wins is measured from its own start.
+    timeval start_winner = start_make_span;
+    if (FLAGS_speculative_replanning && !FLAGS_dry_run &&
+        !FLAGS_force_framework.compare("")) {
+      fmw_name = DispatchSpeculatively(bind.first, nodes, relation, fmw,
+                                       binary_file, &job_output, &exit_status,
+                                       &start_winner);
+      span.AddArg("winner", fmw_name);
+    } else {
+      TraceSpan dispatch_span("execution", "Dispatch");
+      exit_status = fmw->Dispatch(binary_file, relation, &job_output);
+    }
     timeval end_make_span;
     gettimeofday(&end_make_span, NULL);
+    RecordIntermediateFormats(bind.first, fmws.find(fmw_name)->second);
+    if (exit_status != 0) {
+      // A failed run says nothing about how long the job takes.
+      LOG(ERROR) << "Job " << relation << " failed in " << fmw_name
+                 << " with status " << exit_status;
+      return;
+    }
+    JobMetrics metrics = ParseJobMetrics(job_output);
+    if (fmws.find(fmw_name)->second == fmw) {
+      metrics.compile_ms += ElapsedMs(start_make_span, end_translate);
+    }
     PopulateHistory(nodes, relation, fmw_name,
-                    end_make_span.tv_sec - start_make_span.tv_sec);
+                    ElapsedMs(start_winner, end_make_span), metrics);
+  }
+
+  // Runs the job and compares its progress against the estimate ScoreDAG
+  // made for it. If the job runs FLAGS_speculation_slowdown times longer
+  // than estimated, the same operators are also launched on the next best
+  // framework. The first job to succeed is kept and the other is cancelled.
+  // Returns the framework whose output was kept and sets job_output and
+  // exit_status to the values and the exit status of its job. If the backup
+  // job is kept, winner_start is set to the time it was translated.
+  string SchedulerDynamic::DispatchSpeculatively(
+      const op_nodes& bind_nodes, const op_nodes& nodes,
+      const string& relation, FrameworkInterface* fmw,
+      const string& binary_file, map<string, uint64_t>* job_output,
+      int* exit_status, timeval* winner_start) {
+    string fmw_name = FrameworkToString(fmw->GetType());
+    list<shared_ptr<OperatorNode> > score_nodes(bind_nodes.begin(),
+                                                bind_nodes.end());
+    uint32_t estimate = TraceScoreDAG(fmw_name, fmw, score_nodes);
+    bool has_mpc = false;
+    for (op_nodes::const_iterator it = bind_nodes.begin();
+         it != bind_nodes.end(); ++it) {
+      has_mpc |= (*it)->get_operator()->isMPC();
+    }
+    TraceSpan span("execution", "Dispatch");
+    JobHandle* job = fmw->DispatchAsync(binary_file, relation);
+    // MPC jobs involve the other parties and are never duplicated.
+    if (has_mpc || estimate >= FLAGS_max_scheduler_cost) {
+      *exit_status = job->Wait();
+      *job_output = job->GetProgress();
+      delete job;
+      return fmw_name;
+    }
+    // Costs are run times scaled by FLAGS_time_to_cost.
+    uint64_t deadline_s = max(1.0, FLAGS_speculation_slowdown * estimate /
+                              FLAGS_time_to_cost);
+    if (job->WaitFor(deadline_s)) {
+      *exit_status = job->get_exit_status();
+      *job_output = job->GetProgress();
+      delete job;
+      return fmw_name;
+    }
+    FrameworkInterface* backup_fmw = NULL;
+    uint32_t backup_cost = FLAGS_max_scheduler_cost;
+    // The backup job has to read the inputs as they are stored.
+    bool columnar_inputs = HasColumnarInputs(bind_nodes);
+    for (map<string, FrameworkInterface*>::const_iterator it = fmws.begin();
+         it != fmws.end(); ++it) {
+      if (it->second == fmw ||
+          (columnar_inputs && !it->second->SupportsColumnar())) {
+        continue;
+      }
+      uint32_t cost = TraceScoreDAG(it->first, it->second, score_nodes);
+      if (cost < backup_cost) {
+        backup_cost = cost;
+        backup_fmw = it->second;
+      }
+    }
+    if (backup_fmw == NULL) {
+      LOG(INFO) << "Job " << relation << " is slower than estimated, but no "
+                << "other framework can run it";
+      *exit_status = job->Wait();
+      *job_output = job->GetProgress();
+      delete job;
+      return fmw_name;
+    }
+    string backup_name = FrameworkToString(backup_fmw->GetType());
+    LOG(INFO) << "Job " << relation << " in " << fmw_name << " exceeded "
+              << deadline_s << "s. Speculating in " << backup_name;
+    // The backup job writes its outputs next to the original ones.
+    map<Relation*, string> renamed =
+      RenameOutputs(bind_nodes, SPECULATIVE_SUFFIX);
+    map<string, string> output_dirs;
+    for (map<Relation*, string>::iterator it = renamed.begin();
+         it != renamed.end(); ++it) {
+      string spec_dir = FLAGS_hdfs_input_dir + it->first->get_name() + "/";
+      if (output_dirs.insert(make_pair(FLAGS_hdfs_input_dir + it->second +
+                                       "/", spec_dir)).second) {
+        removeHdfsDir(spec_dir);
+      }
+    }
+    span.AddArg("speculated_on", backup_name);
+    span.AddArg("deadline_s", deadline_s);
+    string backup_relation = relation + SPECULATIVE_SUFFIX;
+    timeval backup_start;
+    gettimeofday(&backup_start, NULL);
+    string backup_binary;
+    {
+      TraceSpan translate_span("execution", "Translate");
+      translate_span.AddArg("framework", backup_name);
+      backup_binary = backup_fmw->Translate(nodes, backup_relation);
+    }
+    for (map<Relation*, string>::iterator it = renamed.begin();
+         it != renamed.end(); ++it) {
+      it->first->set_name(it->second);
+    }
+    if (backup_binary.empty()) {
+      LOG(ERROR) << "Could not generate the code of " << relation << " for "
+                 << backup_name << ". Waiting for " << fmw_name;
+      *exit_status = job->Wait();
+      *job_output = job->GetProgress();
+      delete job;
+      return fmw_name;
+    }
+    JobHandle* backup_job =
+      backup_fmw->DispatchAsync(backup_binary, backup_relation);
+    // Wait for the first job to succeed, or for both to end.
+    JobHandle* winner = NULL;
+    while (winner == NULL) {
+      if (job->IsDone() &&
+          (job->get_exit_status() == 0 || backup_job->IsDone())) {
+        winner = job;
+      } else if (backup_job->IsDone() &&
+                 (backup_job->get_exit_status() == 0 || job->IsDone())) {
+        winner = backup_job;
+      } else if (!job->IsDone()) {
+        job->WaitFor(1);
+      } else {
+        backup_job->WaitFor(1);
+      }
+    }
+    JobHandle* loser = winner == job ? backup_job : job;
+    // Cancelling also kills the loser's cluster jobs, so that they cannot
+    // write into the output directories after they are replaced below.
+    if (!loser->Cancel()) {
+      loser->Wait();
+    }
+    for (map<string, string>::iterator it = output_dirs.begin();
+         it != output_dirs.end(); ++it) {
+      if (winner == backup_job) {
+        removeHdfsDir(it->first);
+        renameHdfsDir(it->second, it->first);
+      } else {
+        removeHdfsDir(it->second);
+      }
+    }
+    if (winner == backup_job) {
+      LOG(INFO) << "Speculative job " << backup_relation << " in "
+                << backup_name << " finished first";
+      fmw_name = backup_name;
+      *winner_start = backup_start;
+    }
+    *exit_status = winner->get_exit_status();
+    *job_output = winner->GetProgress();
+    delete job;
+    delete backup_job;
+    return fmw_name;
+  }
+
+  // Appends suffix to the outputs of nodes and to the inputs of nodes that
+  // read them. Returns the original names of the renamed relations.
+  map<Relation*, string> SchedulerDynamic::RenameOutputs(
+      const op_nodes& nodes, const string& suffix) {
+    map<Relation*, string> renamed;
+    set<string> output_names;
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      output_names.insert(
+          (*it)->get_operator()->get_output_relation()->get_name());
+    }
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      vector<Relation*> rels = op->get_relations();
+      rels.push_back(op->get_output_relation());
+      for (vector<Relation*>::iterator rel_it = rels.begin();
+           rel_it != rels.end(); ++rel_it) {
+        string name = (*rel_it)->get_name();
+        if (output_names.find(name) != output_names.end() &&
+            renamed.insert(make_pair(*rel_it, name)).second) {
+          (*rel_it)->set_name(name + suffix);
+        }
+      }
+    }
+    return renamed;
+  }
+
+  // Groups the operators that are local to a single data owner by owner.
+  // An operator is local if its output relation is not shared, it is not
+  // an MPC operator and all its parents are local to the same owner. These
+  // subplans only feed into the MPC frontier and can run independently.
+  map<string, op_nodes> SchedulerDynamic::DetermineLocalSubplans(
+      const op_nodes& order) {
+    map<string, op_nodes> local_subplans;
+    bool has_shared_rel = false;
+    for (op_nodes::const_iterator it = order.begin(); it != order.end(); ++it) {
+      if ((*it)->get_operator()->get_output_relation()->isShared()) {
+        has_shared_rel = true;
+        break;
+      }
+    }
+    if (!has_shared_rel) {
+      // Not a multi-party DAG.
+      return local_subplans;
+    }
+    map<shared_ptr<OperatorNode>, string> node_owner;
+    for (op_nodes::const_iterator it = order.begin(); it != order.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      Relation* output_rel = op->get_output_relation();
+      if (output_rel->isShared() || op->isMPC() ||
+          op->get_type() == WHILE_OP) {
+        continue;
+      }
+      string owner = output_rel->get_owner_string();
+      bool is_local = true;
+      op_nodes parents = (*it)->get_parents();
+      for (op_nodes::iterator p_it = parents.begin(); p_it != parents.end();
+           ++p_it) {
+        map<shared_ptr<OperatorNode>, string>::iterator owner_it =
+          node_owner.find(*p_it);
+        if (owner_it == node_owner.end() || owner_it->second.compare(owner)) {
+          is_local = false;
+          break;
+        }
+      }
+      if (is_local) {
+        node_owner[*it] = owner;
+        local_subplans[owner].push_back(*it);
+      }
+    }
+    return local_subplans;
+  }
+
+  // Runs the local subplans of the different owners concurrently. Returns once
+  // all of them have completed, i.e. once all the inputs of the MPC frontier
+  // are ready.
+  uint64_t SchedulerDynamic::ScheduleLocalSubplans(
+      const map<string, op_nodes>& local_subplans) {
+    uint64_t num_op_scheduled = 0;
+    boost::thread_group subplan_threads;
+    for (map<string, op_nodes>::const_iterator it = local_subplans.begin();
+         it != local_subplans.end(); ++it) {
+      LOG(INFO) << "Local subplan of " << it->first << " has "
+                << it->second.size() << " operators";
+      num_op_scheduled += it->second.size();
+      subplan_threads.create_thread(
+          boost::bind(&SchedulerDynamic::RunLocalSubplan, this, it->first,
+                      boost::cref(it->second)));
+    }
+    subplan_threads.join_all();
+    LOG(INFO) << "Finished " << local_subplans.size() << " local subplans";
+    return num_op_scheduled;
+  }
+
+  // Runs the jobs of a local subplan in order. Like DynamicScheduleDAG, it
+  // binds the remaining operators to cleartext frameworks before every job
+  // because a binding may only cover a prefix of them. Binding, code
+  // generation and the history bookkeeping are serialized; only the job
+  // execution overlaps with the other subplans.
+  void SchedulerDynamic::RunLocalSubplan(const string& owner,
+                                         const op_nodes& subplan) {
+    op_nodes order = subplan;
+    while (order.size() > 0) {
+      pair<op_nodes, FmwType> bind;
+      FrameworkInterface* fmw;
+      string fmw_name;
+      string relation;
+      string binary_file;
+      op_nodes nodes;
+      timeval start_make_span;
+      timeval end_translate;
+      TraceSpan span("execution", "Job");
+      span.AddArg("owner", owner);
+      {
+        boost::lock_guard<boost::mutex> lock(schedule_mutex_);
+        RefreshOutputSize(order);
+        bindings_lt l_bindings = BindOperators(order);
+        bind = l_bindings.front();
+        gettimeofday(&start_make_span, NULL);
+        relation = SwapRel(bind.first);
+        nodes = ConstructSubDAG(bind.first);
+        fmw_name = CheckForceFmwFlag(bind.second);
+        LOG(INFO) << "Dispatching relation " << relation << " of " << owner
+                  << " in framework " << fmw_name;
+        span.AddArg("relation", relation);
+        span.AddArg("framework", fmw_name);
+        span.AddArg("dag", DescribeNodes(bind.first));
+        fmw = fmws.find(fmw_name)->second;
+        if (FLAGS_simulate) {
+          uint64_t run_time_ms =
+            SimulateJob(bind.first, relation, fmw_name, fmw);
+          PopulateHistory(nodes, relation, fmw_name, run_time_ms,
+                          JobMetrics());
+          ReplaceWithTmp(bind.first);
+          ClearBarriers(bind.first);
+          order.erase(order.begin(), order.begin() + bind.first.size());
+          continue;
+        }
+        ChooseJoinStrategies(bind.first);
+        RecordInputSizes(bind.first);
+        if (!ChooseIntermediateFormats(bind.first, fmw)) {
+          LOG(ERROR) << "Not dispatching " << relation << " of " << owner
+                     << " to " << fmw_name
+                     << " because its inputs are not readable";
+          ReplaceWithTmp(bind.first);
+          ClearBarriers(bind.first);
+          order.erase(order.begin(), order.begin() + bind.first.size());
+          continue;
+        }
+        TraceSpan translate_span("execution", "Translate");
+        binary_file = fmw->Translate(nodes, relation);
+        gettimeofday(&end_translate, NULL);
+        if (binary_file.empty()) {
+          LOG(ERROR) << "Not dispatching " << relation << " of " << owner
+                     << " to " << fmw_name
+                     << " because its code could not be generated";
+          ReplaceWithTmp(bind.first);
+          ClearBarriers(bind.first);
+          order.erase(order.begin(), order.begin() + bind.first.size());
+          continue;
+        }
+      }
+      map<string, uint64_t> job_output;
+      int exit_status;
+      {
+        TraceSpan dispatch_span("execution", "Dispatch");
+        exit_status = fmw->Dispatch(binary_file, relation, &job_output);
+      }
+      timeval end_make_span;
+      gettimeofday(&end_make_span, NULL);
+      JobMetrics metrics = ParseJobMetrics(job_output);
+      metrics.compile_ms += ElapsedMs(start_make_span, end_translate);
+      {
+        boost::lock_guard<boost::mutex> lock(schedule_mutex_);
+        RecordIntermediateFormats(bind.first, fmw);
+        if (exit_status != 0) {
+          LOG(ERROR) << "Job " << relation << " of " << owner << " failed in "
+                     << fmw_name << " with status " << exit_status;
+        } else {
+          PopulateHistory(nodes, relation, fmw_name,
+                          ElapsedMs(start_make_span, end_make_span), metrics);
+        }
+        ReplaceWithTmp(bind.first);
+        ClearBarriers(bind.first);
+      }
+      // Remove the operators that have already been executed.
+      order.erase(order.begin(), order.begin() + bind.first.size());
+    }
   }
 
   bindings_vt::size_type SchedulerDynamic::ScheduleWhileBody(
       const op_nodes& nodes, const bindings_vt& bindings, bindings_vt::size_type index) {
-    WhileOperator* while_op =
-      dynamic_cast<WhileOperator*>(nodes[0]->get_operator());
     bindings_vt::size_type while_boundary =
       DetermineWhileBoundary(nodes[0], bindings, index);
     // TODO(ionel): FIX! We increase iter in the scheduler code.
     int iter = 0;
-    while (while_op->get_condition_tree()->checkCondition(iter)) {
+    while (CheckLoopCondition(nodes[0], iter)) {
       // NOTE: it only goes to < while_boundary because at the
       // while_boundary we have the iter sum operator.
       for (bindings_vt::size_type while_index = index + 1;
@@ -335,6 +780,55 @@ namespace scheduling {
     return while_boundary;
   }
 
+  // Replaces a binding of a lone WHILE operator with a binding of the entire
+  // loop if an engine can iterate natively. This saves the job launch,
+  // compilation and HDFS materialisation of every iteration but the first.
+  bool SchedulerDynamic::BindWholeLoop(const op_nodes& order,
+                                       pair<op_nodes, FmwType>* bind) {
+    op_nodes::size_type while_boundary =
+      DetermineWhileBoundary(order[0], order, 0);
+    op_nodes loop_nodes(order.begin(), order.begin() + while_boundary + 1);
+    list<shared_ptr<OperatorNode> > merge_nodes(loop_nodes.begin(),
+                                                loop_nodes.end());
+    uint32_t min_cost = FLAGS_max_scheduler_cost;
+    bool found = false;
+    for (map<string, FrameworkInterface*>::const_iterator it = fmws.begin();
+         it != fmws.end(); ++it) {
+      if (!FLAGS_force_framework.compare("") ||
+          !it->first.compare(FLAGS_force_framework)) {
+        uint32_t cost_dag = TraceScoreDAG(it->first, it->second, merge_nodes);
+        if (cost_dag < min_cost) {
+          min_cost = cost_dag;
+          bind->second = it->second->GetType();
+          found = true;
+        }
+      }
+    }
+    if (found) {
+      bind->first = loop_nodes;
+      LOG(INFO) << "Offloading entire loop of " << loop_nodes.size()
+                << " operators to " << CheckForceFmwFlag(bind->second)
+                << " with cost " << min_cost;
+    }
+    return found;
+  }
+
+  // Counted loops are driven by the scheduler's own counter. Other conditions
+  // depend on the relations computed by the previous iteration; checking them
+  // reads the first row of each of these relations from HDFS with
+  // hadoop fs -cat, once per iteration.
+  bool SchedulerDynamic::CheckLoopCondition(shared_ptr<OperatorNode> while_node,
+                                            int iter) {
+    WhileOperator* while_op =
+      dynamic_cast<WhileOperator*>(while_node->get_operator());
+    if (IsCountedLoop(while_node)) {
+      return while_op->get_condition_tree()->checkCondition(iter);
+    }
+    bool holds = while_op->get_condition_tree()->checkCondition();
+    LOG(INFO) << "Loop condition after " << iter << " iterations: " << holds;
+    return holds;
+  }
+
   void SchedulerDynamic::RefreshOutputSize(const op_nodes& nodes) {
     for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
       // Trigger output size update.
@@ -345,7 +839,126 @@ namespace scheduling {
     }
   }
 
+  void SchedulerDynamic::ChooseJoinStrategies(const op_nodes& nodes) {
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      if ((*it)->get_operator()->get_type() != JOIN_OP) {
+        continue;
+      }
+      JoinOperator* join_op =
+        dynamic_cast<JoinOperator*>((*it)->get_operator());
+      int32_t broadcast_input = join_op->broadcastInput(*rel_size_);
+      join_op->set_broadcast_input(broadcast_input);
+      if (broadcast_input >= 0) {
+        LOG(INFO) << "Broadcasting "
+                  << join_op->get_relations()[broadcast_input]->get_name()
+                  << " to join " << join_op->get_output_relation()->get_name();
+      }
+      // Look for keys that would overload a reduce task in a sample of the
+      // larger input of a repartition join.
+      int32_t skewed_input = -1;
+      vector<string> skewed_keys;
+      if (broadcast_input < 0 && FLAGS_skew_join_sample_rows > 0 &&
+          !FLAGS_dry_run) {
+        skewed_input = join_op->skewedInput(*rel_size_);
+      }
+      if (skewed_input >= 0) {
+        string skewed_rel =
+          join_op->get_relations()[skewed_input]->get_name();
+        skewed_keys = join_op->heavyKeys(
+            skewed_input,
+            GetHdfsRelRows(skewed_rel, FLAGS_skew_join_sample_rows));
+        if (!skewed_keys.empty()) {
+          LOG(INFO) << "Spreading " << skewed_keys.size() << " keys of "
+                    << skewed_rel << " to join "
+                    << join_op->get_output_relation()->get_name();
+        }
+      }
+      join_op->set_skewed_keys(skewed_input, skewed_keys);
+    }
+  }
+
+  void SchedulerDynamic::RecordInputSizes(const op_nodes& nodes) {
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      vector<Relation*> rels = op->get_relations();
+      uint64_t input_size_kb = 0;
+      for (vector<Relation*>::iterator rel_it = rels.begin();
+           rel_it != rels.end(); ++rel_it) {
+        map<string, pair<uint64_t, uint64_t> >::iterator size_it =
+          rel_size_->find((*rel_it)->get_name());
+        if (size_it == rel_size_->end()) {
+          input_size_kb = 0;
+          break;
+        }
+        input_size_kb =
+          op->SumNoOverflow(input_size_kb, size_it->second.second);
+      }
+      op->set_input_size_kb(input_size_kb);
+    }
+  }
+
+  bool SchedulerDynamic::ChooseIntermediateFormats(const op_nodes& nodes,
+                                                   FrameworkInterface* fmw) {
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      if (!fmw->SupportsColumnar()) {
+        vector<Relation*> rels = op->get_relations();
+        for (vector<Relation*>::iterator rel_it = rels.begin();
+             rel_it != rels.end(); ++rel_it) {
+          string rel_name = (*rel_it)->get_name();
+          if (columnar_rels_.find(rel_name) == columnar_rels_.end()) {
+            continue;
+          }
+          LOG(INFO) << "Converting " << rel_name << " to text for "
+                    << FrameworkToString(fmw->GetType());
+          if (!ConvertHdfsRelToText(rel_name)) {
+            LOG(ERROR) << "Could not convert " << rel_name << " to text";
+            return false;
+          }
+          columnar_rels_.erase(rel_name);
+        }
+      }
+      // Workflow outputs stay text.
+      op->set_columnar_output(FLAGS_columnar_intermediates &&
+                              fmw->SupportsColumnar() &&
+                              (*it)->IsLeaf() && (*it)->HasConsumers());
+    }
+    return true;
+  }
+
+  void SchedulerDynamic::RecordIntermediateFormats(const op_nodes& nodes,
+                                                   FrameworkInterface* fmw) {
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      OperatorInterface* op = (*it)->get_operator();
+      if (!(*it)->IsLeaf()) {
+        continue;
+      }
+      string rel_name = op->get_output_relation()->get_name();
+      if (op->get_columnar_output() && fmw->SupportsColumnar()) {
+        columnar_rels_.insert(rel_name);
+      } else {
+        columnar_rels_.erase(rel_name);
+      }
+    }
+  }
+
+  bool SchedulerDynamic::HasColumnarInputs(const op_nodes& nodes) {
+    for (op_nodes::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+      vector<Relation*> rels = (*it)->get_operator()->get_relations();
+      for (vector<Relation*>::iterator rel_it = rels.begin();
+           rel_it != rels.end(); ++rel_it) {
+        if (columnar_rels_.find((*rel_it)->get_name()) !=
+            columnar_rels_.end()) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
   bindings_lt SchedulerDynamic::BindOperators(const op_nodes& order) {
+    TraceSpan span("planning", "BindOperators");
+    span.AddArg("operators", order.size());
     bindings_lt bindings;
     timeval start_scheduler;
     gettimeofday(&start_scheduler, NULL);
@@ -354,20 +967,27 @@ namespace scheduling {
     } else {
       bindings = ComputeOptimal(order);
     }
+    span.AddArg("bindings", bindings.size());
     timeval end_scheduler;
     gettimeofday(&end_scheduler, NULL);
     double scheduler_time = (end_scheduler.tv_sec - start_scheduler.tv_sec);
     scheduler_time +=
       (end_scheduler.tv_usec - start_scheduler.tv_usec) / 1000000.0;
     cout << "SCHEDULER TIME: " << scheduler_time << endl;
+    if (FLAGS_simulate) {
+      scheduler_simulator_.AddPlanningTime(scheduler_time);
+    }
     return bindings;
   }
 
   void SchedulerDynamic::ScheduleDAG(const op_nodes& dag) {
+    TraceSpan span("scheduling", "ScheduleDAG");
     DetermineInputsSize(dag);
     LOG(INFO) << "Schedule DAG";
     op_nodes order = op_nodes();
-    TopologicalOrder(dag, &order);
+    op_nodes optimised_dag = dag;
+    optimiser_.optimiseDAG(&optimised_dag, rel_size_);
+    TopologicalOrder(optimised_dag, &order);
     PrintNodesVector("Node order: ", order);
     RefreshOutputSize(order);
     
@@ -394,6 +1014,9 @@ namespace scheduling {
       ClearBarriers(bind.first);
       rem_index++;
     }
+    if (FLAGS_simulate) {
+      scheduler_simulator_.PrintReport();
+    }
   }
 
   string SchedulerDynamic::SwapRel(const op_nodes& binding) {
@@ -468,7 +1091,7 @@ namespace scheduling {
         if (!FLAGS_force_framework.compare("") ||
             !it->first.compare(FLAGS_force_framework)) {
           uint32_t cost_dag =
-            ClampCost(it->second->ScoreDAG(merge_nodes, *rel_size_));
+            ClampCost(TraceScoreDAG(it->first, it->second, merge_nodes));
           if (cost_dag < min_cost[jobs_merged] && cost_dag < FLAGS_max_scheduler_cost) {
             min_cost[jobs_merged] = cost_dag;
             job_cost[jobs_merged] = cost_dag;
@@ -583,7 +1206,8 @@ namespace scheduling {
                it != fmws.end(); ++it) {
             if (!FLAGS_force_framework.compare("") ||
                 !it->first.compare(FLAGS_force_framework)) {
-              uint32_t cost_dag = it->second->ScoreDAG(merge_nodes, *rel_size_);
+              uint32_t cost_dag =
+                TraceScoreDAG(it->first, it->second, merge_nodes);
               // LOG(INFO) << "Cost of DAG [" << ops_used - num_merge + 1 << ", "
               //           << ops_used << "] in framework: " << it->second->GetType()
               //           << " is: " << cost_dag;
@@ -693,9 +1317,37 @@ namespace scheduling {
     return nodes.size() - 1;
   }
 
+  // Scores nodes in fmw and records the estimate and its components as a
+  // planning span.
+  uint32_t SchedulerDynamic::TraceScoreDAG(
+      const string& fmw_name, FrameworkInterface* fmw,
+      const list<shared_ptr<OperatorNode> >& nodes) {
+    TraceSpan span("planning", "ScoreDAG");
+    span.AddArg("framework", fmw_name);
+    span.AddArg("dag", DescribeNodes(nodes));
+    uint32_t cost = fmw->ScoreDAG(nodes, *rel_size_);
+    span.AddArg("cost", cost);
+    return cost;
+  }
+
+  // Runs the job on the simulated engine of its framework instead of
+  // dispatching it. Returns the simulated run time in milliseconds.
+  uint64_t SchedulerDynamic::SimulateJob(const op_nodes& bind_nodes,
+                                         const string& relation,
+                                         const string& fmw_name,
+                                         FrameworkInterface* fmw) {
+    list<shared_ptr<OperatorNode> > score_nodes(bind_nodes.begin(),
+                                                bind_nodes.end());
+    double estimate_s =
+      TraceScoreDAG(fmw_name, fmw, score_nodes) / FLAGS_time_to_cost;
+    return static_cast<uint64_t>(
+        scheduler_simulator_.SimulateJob(fmw_name, relation, estimate_s) *
+        1000.0 + 0.5);
+  }
+
   void SchedulerDynamic::PopulateHistory(
       const op_nodes& nodes, const string& relation, const string& framework,
-      uint64_t make_span) {
+      uint64_t make_span_ms, const JobMetrics& metrics) {
     vector<pair<string, uint64_t> > input_rels_size =
       DetermineInputsSize(nodes);
     vector<string> output_rels = GetDagOutputs(nodes);
@@ -724,8 +1376,16 @@ namespace scheduling {
                   << (*rel_size_)[*it].second;
       }
     }
-    history_->AddRun(new JobRun(relation, framework, make_span,
-                                input_rels_size, output_rels_size));
+    LOG(INFO) << "Metrics of " << relation << " in " << framework
+              << ": compile " << metrics.compile_ms << "ms, pull "
+              << metrics.pull_ms << "ms, load " << metrics.load_ms
+              << "ms, run " << metrics.run_ms + metrics.map_ms +
+                 metrics.shuffle_ms + metrics.reduce_ms
+              << "ms, push " << metrics.push_ms << "ms, rows "
+              << metrics.rows_in << " -> " << metrics.rows_out << ", peak RSS "
+              << metrics.peak_rss_kb << "KB";
+    history_->AddRun(new JobRun(relation, framework, make_span_ms,
+                                input_rels_size, output_rels_size, metrics));
   }
 
   bindings_vt SchedulerDynamic::ScheduleNetflix(op_nodes order,
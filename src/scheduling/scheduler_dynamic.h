@@ -22,6 +22,9 @@
 #include "scheduling/scheduler_interface.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <sys/time.h>
 
 #include <iostream>
 #include <list>
@@ -47,6 +50,7 @@
 #include "frameworks/spark_framework.h"
 #include "frameworks/wildcherry_framework.h"
 #include "frontends/operator_node.h"
+#include "optimiser/query_optimiser.h"
 #include "scheduling/scheduler_simulator.h"
 
 namespace musketeer {
@@ -65,10 +69,14 @@ class SchedulerDynamic : public SchedulerInterface {
   SchedulerDynamic(const map<string, FrameworkInterface*>& fmws,
                    HistoryStorage* history)
     : SchedulerInterface(fmws), history_(history),
-    rel_size_(new map<string, pair<uint64_t, uint64_t> >) {
+    rel_size_(new map<string, pair<uint64_t, uint64_t> >),
+    optimiser_(FLAGS_optimise_ir_dag, history) {
     if (FLAGS_dry_run && FLAGS_dry_run_data_size_file.compare("")) {
       scheduler_simulator_.ReadDataSizeFile();
     }
+    if (FLAGS_simulate && FLAGS_job_run_trace_file.compare("")) {
+      scheduler_simulator_.ReadJobRunTrace();
+    }
   }
 
   void DynamicScheduleDAG(const op_nodes& dag);
@@ -106,10 +114,28 @@ class SchedulerDynamic : public SchedulerInterface {
                                                uint64_t* num_op_executed);
   bindings_vt::size_type ScheduleWhileBody(
       const op_nodes& nodes, const bindings_vt& bindings, bindings_vt::size_type index);
+  bool CheckLoopCondition(shared_ptr<OperatorNode> while_node, int iter);
+  bool BindWholeLoop(const op_nodes& order, pair<op_nodes, FmwType>* bind);
+  map<string, op_nodes> DetermineLocalSubplans(const op_nodes& order);
+  uint64_t ScheduleLocalSubplans(const map<string, op_nodes>& local_subplans);
+  void RunLocalSubplan(const string& owner, const op_nodes& subplan);
+  uint32_t TraceScoreDAG(const string& fmw_name, FrameworkInterface* fmw,
+                         const list<shared_ptr<OperatorNode> >& nodes);
   void PopulateHistory(const op_nodes& nodes, const string& relation,
-                       const string& framework, uint64_t run_time);
+                       const string& framework, uint64_t make_span_ms,
+                       const core::JobMetrics& metrics);
+  uint64_t SimulateJob(const op_nodes& bind_nodes, const string& relation,
+                       const string& fmw_name, FrameworkInterface* fmw);
   void DispatchWithHistory(
       pair<op_nodes, FmwType> bind, const op_nodes& nodes, const string& relation);
+  string DispatchSpeculatively(const op_nodes& bind_nodes,
+                               const op_nodes& nodes, const string& relation,
+                               FrameworkInterface* fmw,
+                               const string& binary_file,
+                               map<string, uint64_t>* job_output,
+                               int* exit_status, timeval* winner_start);
+  map<Relation*, string> RenameOutputs(const op_nodes& nodes,
+                                       const string& suffix);
   bindings_vt ScheduleNetflix(op_nodes order, FmwType fmw_type);
   bindings_vt SchedulePageRank(op_nodes order, FmwType fmw_type);
   bindings_vt SchedulePageRankHad(op_nodes order);
@@ -119,11 +145,34 @@ class SchedulerDynamic : public SchedulerInterface {
   bindings_vt ScheduleTPC(op_nodes order, FmwType fmw_type);
 
   void RefreshOutputSize(const op_nodes& nodes);
+  // Decides whether the JOINs of a job broadcast an input, using the latest
+  // estimates of their input sizes, and which of their keys are skewed.
+  void ChooseJoinStrategies(const op_nodes& nodes);
+  // Records the latest estimates of the operators' input sizes so that the
+  // translators can choose the number of reduce tasks of the job.
+  void RecordInputSizes(const op_nodes& nodes);
+  // Converts the job's columnar inputs to text if fmw's jobs can not read
+  // them, and decides which of the job's outputs are written in the columnar
+  // format: the ones that later jobs read, if fmw supports the format.
+  // Returns false if an input could not be converted; the input then stays
+  // columnar and the job must not run in fmw.
+  bool ChooseIntermediateFormats(const op_nodes& nodes,
+                                 FrameworkInterface* fmw);
+  // Records the outputs that fmw's job wrote in the columnar format.
+  void RecordIntermediateFormats(const op_nodes& nodes,
+                                 FrameworkInterface* fmw);
+  bool HasColumnarInputs(const op_nodes& nodes);
   bindings_lt BindOperators(const op_nodes& order);
 
   HistoryStorage* history_;
   map<string, pair<uint64_t, uint64_t> >* rel_size_;
+  // Relations that are stored in the columnar format.
+  set<string> columnar_rels_;
   SchedulerSimulator scheduler_simulator_;
+  QueryOptimiser optimiser_;
+  // Serializes code generation and the scheduler's bookkeeping when
+  // several local subplans are dispatched concurrently.
+  boost::mutex schedule_mutex_;
 };
 
 } // namespace scheduling
@@ -18,16 +18,62 @@
 
 #include "scheduling/scheduler_simulator.h"
 
+#include <boost/random/exponential_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <utility>
 
 #include "base/common.h"
 #include "base/flags.h"
+#include "base/job_run.pb.h"
+
+// Mean run time of the jobs of other tenants.
+#define BACKGROUND_JOB_S 60.0
 
 namespace musketeer {
 namespace scheduling {
 
+  SimulatedEngine::SimulatedEngine(uint32_t num_slots, double background_load)
+    : slot_free_s_(max(num_slots, 1U), 0.0),
+      background_rate_(max(0.0, background_load) * slot_free_s_.size() /
+                       BACKGROUND_JOB_S),
+      next_background_s_(0) {
+  }
+
+  vector<double>::iterator SimulatedEngine::EarliestFreeSlot() {
+    return min_element(slot_free_s_.begin(), slot_free_s_.end());
+  }
+
+  double SimulatedEngine::Admit(double arrival_s, double run_time_s,
+                                boost::mt19937* rng) {
+    if (background_rate_ > 0) {
+      boost::variate_generator<boost::mt19937&,
+                               boost::exponential_distribution<> >
+        inter_arrival(*rng, boost::exponential_distribution<>(
+            background_rate_));
+      boost::variate_generator<boost::mt19937&,
+                               boost::exponential_distribution<> >
+        background_run_time(*rng, boost::exponential_distribution<>(
+            1.0 / BACKGROUND_JOB_S));
+      // Jobs are served in arrival order.
+      while (next_background_s_ <= arrival_s) {
+        vector<double>::iterator slot = EarliestFreeSlot();
+        *slot = max(*slot, next_background_s_) + background_run_time();
+        next_background_s_ += inter_arrival();
+      }
+    }
+    vector<double>::iterator slot = EarliestFreeSlot();
+    double start_s = max(*slot, arrival_s);
+    *slot = start_s + run_time_s;
+    return start_s;
+  }
+
   map<string, pair<uint64_t, uint64_t> >* SchedulerSimulator::GetAllRelSize() {
     return all_rel_size_;
   }
@@ -52,5 +98,99 @@ namespace scheduling {
     (*current_rel_size_)[rel_name] = (*all_rel_size_)[rel_name];
   }
 
+  void SchedulerSimulator::ReadJobRunTrace() {
+    ifstream in_file(FLAGS_job_run_trace_file.c_str(), ios::in | ios::binary);
+    musketeer::JobRunTrace trace;
+    if (!in_file.good() || !trace.ParseFromIstream(&in_file)) {
+      LOG(ERROR) << "Could not read job runs from "
+                 << FLAGS_job_run_trace_file;
+      return;
+    }
+    for (int index = 0; index < trace.runs_size(); ++index) {
+      const musketeer::JobRun& run = trace.runs(index);
+      pair<double, uint32_t>& runs =
+        recorded_runs_[make_pair(run.job_name(), run.framework())];
+      runs.first += run.make_span_ms() / 1000.0;
+      runs.second++;
+      // Outputs keep the size they had when the job was recorded.
+      for (int rel = 0; rel < run.output_rels_size(); ++rel) {
+        uint64_t size_kb = run.output_rels(rel).size_kb();
+        if (all_rel_size_->find(run.output_rels(rel).relation()) ==
+            all_rel_size_->end()) {
+          (*all_rel_size_)[run.output_rels(rel).relation()] =
+            make_pair(size_kb, size_kb);
+        }
+      }
+    }
+    LOG(INFO) << "Replaying " << trace.runs_size() << " recorded job runs";
+  }
+
+  double SchedulerSimulator::RecordedRunTime(const string& framework,
+                                             const string& job_name) {
+    map<pair<string, string>, pair<double, uint32_t> >::iterator it =
+      recorded_runs_.find(make_pair(job_name, framework));
+    if (it == recorded_runs_.end()) {
+      return -1.0;
+    }
+    return it->second.first / it->second.second;
+  }
+
+  double SchedulerSimulator::SimulateJob(const string& framework,
+                                         const string& job_name,
+                                         double estimate_s) {
+    boost::lock_guard<boost::mutex> lock(simulation_mutex_);
+    double run_time_s = RecordedRunTime(framework, job_name);
+    if (run_time_s < 0) {
+      // Jobs that have never run deviate randomly from the cost model.
+      boost::variate_generator<boost::mt19937&,
+                               boost::normal_distribution<> >
+        log_error(rng_, boost::normal_distribution<>(
+            0.0, max(FLAGS_simulation_noise, 0.0)));
+      run_time_s = estimate_s * exp(log_error());
+    }
+    map<string, SimulatedEngine*>::iterator engine = engines_.find(framework);
+    if (engine == engines_.end()) {
+      engine = engines_.insert(make_pair(framework, new SimulatedEngine(
+          FLAGS_simulation_engine_slots,
+          FLAGS_simulation_background_load))).first;
+    }
+    double start_s = engine->second->Admit(now_s_, run_time_s, &rng_);
+    double queued_s = start_s - now_s_;
+    queued_s_ += queued_s;
+    now_s_ = start_s + run_time_s;
+    num_jobs_++;
+    if (run_time_s > 0) {
+      estimate_error_ += fabs(estimate_s - run_time_s) / run_time_s;
+      estimate_bias_ += (estimate_s - run_time_s) / run_time_s;
+      num_estimated_jobs_++;
+    }
+    LOG(INFO) << "Simulated " << job_name << " in " << framework << ": "
+              << "queued " << queued_s << "s, ran " << run_time_s
+              << "s, estimated " << estimate_s << "s";
+    return run_time_s;
+  }
+
+  void SchedulerSimulator::AddPlanningTime(double planning_s) {
+    boost::lock_guard<boost::mutex> lock(simulation_mutex_);
+    planning_s_ += planning_s;
+    // The scheduler plans while no job of the workflow runs.
+    now_s_ += planning_s;
+  }
+
+  void SchedulerSimulator::PrintReport() {
+    boost::lock_guard<boost::mutex> lock(simulation_mutex_);
+    cout << "SIMULATED JOBS: " << num_jobs_ << endl;
+    cout << "SIMULATED MAKESPAN: " << now_s_ << endl;
+    cout << "SIMULATED QUEUEING TIME: " << queued_s_ << endl;
+    cout << "PLANNING TIME: " << planning_s_ << endl;
+    if (num_estimated_jobs_ > 0) {
+      // Relative to the simulated run time.
+      cout << "COST MODEL MEAN ABSOLUTE ERROR: "
+           << estimate_error_ / num_estimated_jobs_ << endl;
+      cout << "COST MODEL MEAN BIAS: "
+           << estimate_bias_ / num_estimated_jobs_ << endl;
+    }
+  }
+
 } // namespace scheduling
 } // namespace musketeer
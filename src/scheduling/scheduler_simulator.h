@@ -19,38 +19,93 @@
 #ifndef MUSKETEER_SCHEDULER_SIMULATOR_H
 #define MUSKETEER_SCHEDULER_SIMULATOR_H
 
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/thread/mutex.hpp>
 #include <stdint.h>
 
 #include <limits>
 #include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "base/common.h"
+#include "base/flags.h"
 
 namespace musketeer {
 namespace scheduling {
 
+// An engine with a fixed number of slots that is shared with other tenants.
+// Their jobs arrive as a Poisson process and keep
+// --simulation_background_load of the slots busy on average.
+class SimulatedEngine {
+ public:
+  SimulatedEngine(uint32_t num_slots, double background_load);
+  // Queues a job that arrives at arrival_s and runs for run_time_s. Returns
+  // the time at which it starts.
+  double Admit(double arrival_s, double run_time_s, boost::mt19937* rng);
+
+ private:
+  vector<double>::iterator EarliestFreeSlot();
+
+  vector<double> slot_free_s_;
+  double background_rate_;
+  double next_background_s_;
+};
+
 class SchedulerSimulator {
  public:
   SchedulerSimulator() :
     all_rel_size_(new map<string, pair<uint64_t, uint64_t> >),
-    current_rel_size_(new map<string, pair<uint64_t, uint64_t> >) {
+    current_rel_size_(new map<string, pair<uint64_t, uint64_t> >),
+    rng_(FLAGS_simulation_seed), now_s_(0), planning_s_(0), num_jobs_(0),
+    queued_s_(0), num_estimated_jobs_(0), estimate_error_(0),
+    estimate_bias_(0) {
   }
 
   ~SchedulerSimulator() {
     delete current_rel_size_;
     delete all_rel_size_;
+    for (map<string, SimulatedEngine*>::iterator it = engines_.begin();
+         it != engines_.end(); ++it) {
+      delete it->second;
+    }
   }
 
   map<string, pair<uint64_t, uint64_t> >* GetAllRelSize();
   map<string, pair<uint64_t, uint64_t> >* GetCurrentRelSize();
   void ReadDataSizeFile();
   void UpdateOutputSize(const string& rel_name);
+  // Reads the runs recorded in --job_run_trace_file.
+  void ReadJobRunTrace();
+  // Runs a job on the simulated framework and advances the simulation's
+  // clock past it. estimate_s is the cost model's estimate of the job's run
+  // time. Returns the simulated run time in seconds.
+  double SimulateJob(const string& framework, const string& job_name,
+                     double estimate_s);
+  void AddPlanningTime(double planning_s);
+  // Prints the makespan, planning time and cost model error so far.
+  void PrintReport();
 
  private:
+  double RecordedRunTime(const string& framework, const string& job_name);
+
   map<string, pair<uint64_t, uint64_t> >* all_rel_size_;
   map<string, pair<uint64_t, uint64_t> >* current_rel_size_;
+  // ((job_name, framework), (total make span, number of runs))
+  map<pair<string, string>, pair<double, uint32_t> > recorded_runs_;
+  map<string, SimulatedEngine*> engines_;
+  boost::mt19937 rng_;
+  // Jobs are simulated one after another, including jobs that the
+  // scheduler dispatches concurrently.
+  boost::mutex simulation_mutex_;
+  double now_s_;
+  double planning_s_;
+  uint64_t num_jobs_;
+  double queued_s_;
+  uint64_t num_estimated_jobs_;
+  double estimate_error_;
+  double estimate_bias_;
 };
 
 } // namespace scheduling
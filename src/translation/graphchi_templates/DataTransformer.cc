@@ -18,118 +18,314 @@
 
 #include <hdfs.h>
 #include <jni.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <sys/time.h>
+#include <vector>
+
+#include "graphchi_basic_includes.hpp"
+#include "preprocessing/sharder.hpp"
 
 //#define BUF_LEN 524288
 #define BUF_LEN 16384
 #define OUT_BUF_LEN 16384
+// Number of parsed edges a thread buffers before handing them to the sharder.
+#define EDGE_BATCH_LEN 65536
 
+using namespace graphchi;
 using namespace std;
 
-//void copy_file(hdfsFS& distfs, string path_name) {
-//    string file_name = "{{TMP_ROOT}}" + path_name + "input";
-//    string make_dir = "mkdir -p {{TMP_ROOT}}" + path_name;
-//    system(make_dir.c_str());
-//    FILE* localInFD = fopen(file_name.c_str(), "wb");
-//    if (!localInFD) {
-//        fprintf(stderr, "Could not open temporaty file!");
-//    }
-//    int num_entries = 0;
-//    hdfsFileInfo* hdfs_info = hdfsListDirectory(distfs, path_name.c_str(),
-//            &num_entries);
-//    for (int entry = 0; entry < num_entries; entry++) {
-//        if (hdfs_info[entry].mKind == kObjectKindDirectory) {
-//            continue;
-//        }
-//        hdfsFile hdfsInFD = hdfsOpenFile(distfs, hdfs_info[entry].mName, O_RDONLY,
-//                0, 0, 0);
-//        if (!hdfsInFD) {
-//            fprintf(stderr, "Failed to open input file on HDFS!");
-//        }
-//        tSize rres = 1;
-//        size_t wres = NULL;
-//        char buf[BUF_LEN];
-//        while (rres > 0) {
-//            rres = hdfsRead(distfs, hdfsInFD, &buf[0], BUF_LEN);
-//            wres = fwrite(&buf[0], sizeof(char), rres, localInFD);
-//        }
-//        hdfsCloseFile(distfs, hdfsInFD);
-//    }
-//    fclose(localInFD);
-//}
-
-void copy_file(hdfsFS& distfs, const string& path_name) {
-  string make_dir = "mkdir -p {{TMP_ROOT}}" + path_name;
-  printf("Running \"%s\" ...\n", make_dir.c_str());
-  system(make_dir.c_str());
+typedef {{VERTEX_DATA_TYPE}} VertexDataType;
+typedef {{EDGE_DATA_TYPE}} EdgeDataType;
+
+const char* kShardsBase = "{{TMP_ROOT}}{{EDGES_PATH}}input";
+const bool kCacheShards = {{CACHE_SHARDS}};
+const int kIngestThreads = {{INGEST_THREADS}};
+
+struct parsed_edge {
+  vid_t src;
+  vid_t dst;
+  EdgeDataType val;
+};
+
+void parse_value(int* val, const char* str) {
+  *val = atoi(str);
+}
 
+void parse_value(float* val, const char* str) {
+  *val = strtof(str, NULL);
+}
+
+void parse_value(double* val, const char* str) {
+  *val = strtod(str, NULL);
+}
+
+// Returns the paths of the data files stored in an HDFS relation directory.
+// The version string describes the files (name, size and modification time)
+// and changes whenever the relation is rewritten.
+vector<string> list_relation_files(hdfsFS& distfs, const string& path_name,
+                                   string* version) {
+  vector<string> files;
   int num_entries = 0;
-  hdfsFileInfo* hdfs_info = hdfsListDirectory(distfs, path_name.c_str(), &num_entries);
-  string cat_cmd = "cat ";
-  char* fname = NULL;
+  hdfsFileInfo* hdfs_info =
+    hdfsListDirectory(distfs, path_name.c_str(), &num_entries);
+  ostringstream version_stream;
   for (int entry = 0; entry < num_entries; entry++) {
     if (hdfs_info[entry].mKind == kObjectKindDirectory) {
       continue;
     }
+    files.push_back(hdfs_info[entry].mName);
+    version_stream << hdfs_info[entry].mName << " " << hdfs_info[entry].mSize
+                   << " " << hdfs_info[entry].mLastMod << "\n";
+  }
+  if (hdfs_info != NULL) {
+    hdfsFreeFileInfo(hdfs_info, num_entries);
+  }
+  if (version != NULL) {
+    *version = version_stream.str();
+  }
+  return files;
+}
 
-    unsigned i = 0;
-    for (i = 0; i < strlen(hdfs_info[entry].mName); i++) {
-      if (hdfs_info[entry].mName[i] == ':') {
-        i++;
-        break;
+// Streams an HDFS file and calls handler->line() for every line. Lines that
+// span two reads are stitched together.
+template <typename LineHandler>
+void stream_hdfs_lines(hdfsFS& distfs, const string& file_name,
+                       LineHandler* handler) {
+  hdfsFile hdfsInFD = hdfsOpenFile(distfs, file_name.c_str(), O_RDONLY, 0, 0, 0);
+  if (!hdfsInFD) {
+    fprintf(stderr, "Failed to open input file %s on HDFS!\n", file_name.c_str());
+    return;
+  }
+  char buf[BUF_LEN + 1];
+  string partial_line;
+  tSize rres;
+  while ((rres = hdfsRead(distfs, hdfsInFD, buf, BUF_LEN)) > 0) {
+    buf[rres] = '\0';
+    char* line_start = buf;
+    char* line_end;
+    while ((line_end = strchr(line_start, '\n')) != NULL) {
+      *line_end = '\0';
+      if (partial_line.empty()) {
+        handler->line(line_start);
+      } else {
+        partial_line += line_start;
+        handler->line(&partial_line[0]);
+        partial_line.clear();
       }
+      line_start = line_end + 1;
     }
+    partial_line += line_start;
+  }
+  if (!partial_line.empty()) {
+    handler->line(&partial_line[0]);
+  }
+  hdfsCloseFile(distfs, hdfsInFD);
+}
 
-    for (; i < strlen(hdfs_info[entry].mName); i++) {
-      if (hdfs_info[entry].mName[i] == ':') {
-        break;
-      }
+class EdgeLineHandler {
+ public:
+  EdgeLineHandler(sharder<EdgeDataType>* sharder_obj,
+                  pthread_mutex_t* sharder_lock):
+    sharder_obj_(sharder_obj), sharder_lock_(sharder_lock) {
+    edges_.reserve(EDGE_BATCH_LEN);
+  }
+
+  ~EdgeLineHandler() {
+    flush();
+  }
+
+  void line(char* line) {
+    char* save_ptr;
+    char* src = strtok_r(line, " \t\r", &save_ptr);
+    char* dst = strtok_r(NULL, " \t\r", &save_ptr);
+    if (src == NULL || dst == NULL || src[0] == '#' || src[0] == '%') {
+      return;
+    }
+    parsed_edge edge;
+    edge.src = static_cast<vid_t>(strtoul(src, NULL, 10));
+    edge.dst = static_cast<vid_t>(strtoul(dst, NULL, 10));
+    edge.val = EdgeDataType();
+    char* val = strtok_r(NULL, " \t\r", &save_ptr);
+    if (val != NULL) {
+      parse_value(&edge.val, val);
     }
+    edges_.push_back(edge);
+    if (edges_.size() >= EDGE_BATCH_LEN) {
+      flush();
+    }
+  }
 
-    for (; i < strlen(hdfs_info[entry].mName); i++) {
-      if (hdfs_info[entry].mName[i] == '/') {
-        i++;
-        break;
-      }
+  void flush() {
+    pthread_mutex_lock(sharder_lock_);
+    for (vector<parsed_edge>::iterator it = edges_.begin();
+         it != edges_.end(); ++it) {
+      sharder_obj_->preprocessing_add_edge(it->src, it->dst, it->val);
     }
+    pthread_mutex_unlock(sharder_lock_);
+    edges_.clear();
+  }
+
+ private:
+  sharder<EdgeDataType>* sharder_obj_;
+  pthread_mutex_t* sharder_lock_;
+  vector<parsed_edge> edges_;
+};
+
+class VertexLineHandler {
+ public:
+  void line(char* line) {
+    char* save_ptr;
+    char* id = strtok_r(line, " \t\r", &save_ptr);
+    char* val = strtok_r(NULL, " \t\r", &save_ptr);
+    if (id == NULL || val == NULL) {
+      return;
+    }
+    VertexDataType value;
+    parse_value(&value, val);
+    vertices.push_back(make_pair(static_cast<vid_t>(strtoul(id, NULL, 10)),
+                                 value));
+  }
+
+  vector<pair<vid_t, VertexDataType> > vertices;
+};
 
+struct ingest_thread_args {
+  hdfsFS* distfs;
+  const vector<string>* files;
+  int thread_id;
+  sharder<EdgeDataType>* sharder_obj;
+  pthread_mutex_t* sharder_lock;
+  VertexLineHandler* vertex_handler;
+};
+
+// Each thread streams every kIngestThreads-th file of the relation.
+void* ingest_edges_thread(void* arg) {
+  ingest_thread_args* args = reinterpret_cast<ingest_thread_args*>(arg);
+  EdgeLineHandler handler(args->sharder_obj, args->sharder_lock);
+  for (size_t index = args->thread_id; index < args->files->size();
+       index += kIngestThreads) {
+    stream_hdfs_lines(*args->distfs, (*args->files)[index], &handler);
+  }
+  return NULL;
+}
+
+void* ingest_vertices_thread(void* arg) {
+  ingest_thread_args* args = reinterpret_cast<ingest_thread_args*>(arg);
+  for (size_t index = args->thread_id; index < args->files->size();
+       index += kIngestThreads) {
+    stream_hdfs_lines(*args->distfs, (*args->files)[index],
+                      args->vertex_handler);
+  }
+  return NULL;
+}
+
+void run_ingest_threads(void* (*ingest_fn)(void*), ingest_thread_args* args) {
+  pthread_t threads[kIngestThreads];
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    args[thread_id].thread_id = thread_id;
+    pthread_create(&threads[thread_id], NULL, ingest_fn, &args[thread_id]);
+  }
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    pthread_join(threads[thread_id], NULL);
+  }
+}
 
-    fname = hdfs_info[entry].mName + i;
-    printf(" --> %s\n", fname);
-    string cmd = string("curl http://{{HDFS_ADDRESS}}:50075/streamFile/") + fname +
-      "?nnaddr={{HDFS_MASTER}}:8020 --silent -o {{TMP_ROOT}}/" + fname;
-    cat_cmd +=  "{{TMP_ROOT}}/" + string(fname) + " ";
-    printf("Running \"%s\" ...\n", cmd.c_str());
-    system(cmd.c_str());
+bool shards_up_to_date(const string& version_file, const string& version) {
+  if (!kCacheShards) {
+    return false;
+  }
+  ifstream version_stream(version_file.c_str());
+  if (!version_stream.good()) {
+    return false;
   }
+  stringstream cached_version;
+  cached_version << version_stream.rdbuf();
+  return cached_version.str() == version &&
+    find_shards<EdgeDataType>(kShardsBase, "auto") > 0;
+}
 
-  if (num_entries > 1) {
-    cat_cmd += "> {{TMP_ROOT}}/" + path_name + "input";
-    printf("Running \"%s\" ...\n", cat_cmd.c_str());
-    system(cat_cmd.c_str() );
-  } else{
-    string mv_cmd = string("mv {{TMP_ROOT}}/") + fname + " " + "{{TMP_ROOT}}/" + path_name +
-      "input";
-    printf("Running \"%s\" ... \n", mv_cmd.c_str());
-    system(mv_cmd.c_str());
+// Converts the HDFS edge list directly into GraphChi shards. The edges are
+// read and parsed by kIngestThreads threads and fed to the sharder without
+// materializing a local copy of the edge list. Shards are reused as long as
+// the edges relation has not changed.
+void ingest_edges(hdfsFS& distfs, const string& path_name) {
+  string version;
+  vector<string> files = list_relation_files(distfs, path_name, &version);
+  string version_file = string(kShardsBase) + ".version";
+  if (shards_up_to_date(version_file, version)) {
+    printf("Reusing shards for %s\n", path_name.c_str());
+    return;
+  }
+  string make_dir = "rm -rf {{TMP_ROOT}}" + path_name +
+    " ; mkdir -p {{TMP_ROOT}}" + path_name;
+  printf("Running \"%s\" ...\n", make_dir.c_str());
+  system(make_dir.c_str());
+  sharder<EdgeDataType> sharder_obj(kShardsBase);
+  sharder_obj.start_preprocessing();
+  pthread_mutex_t sharder_lock;
+  pthread_mutex_init(&sharder_lock, NULL);
+  ingest_thread_args args[kIngestThreads];
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    args[thread_id].distfs = &distfs;
+    args[thread_id].files = &files;
+    args[thread_id].sharder_obj = &sharder_obj;
+    args[thread_id].sharder_lock = &sharder_lock;
+    args[thread_id].vertex_handler = NULL;
+  }
+  run_ingest_threads(ingest_edges_thread, args);
+  pthread_mutex_destroy(&sharder_lock);
+  sharder_obj.end_preprocessing();
+  sharder_obj.execute_sharding("auto");
+  if (kCacheShards) {
+    ofstream version_stream(version_file.c_str());
+    version_stream << version;
+    version_stream.close();
   }
 }
 
-void ascii_to_binary(const char* in_filename, const char* out_filename) {
-  {{VERTEX_DATA_TYPE}} value;
-  ifstream infile(in_filename);
-  ofstream outfile(out_filename, ios::out | ios::binary);
-  while (infile >> value) {
-    outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+// Streams the vertices relation from HDFS and writes the vertex values to
+// the GraphChi vertex data file, indexed by vertex id.
+void ingest_vertices(hdfsFS& distfs, const string& path_name,
+                     const char* out_filename) {
+  vector<string> files = list_relation_files(distfs, path_name, NULL);
+  VertexLineHandler handlers[kIngestThreads];
+  ingest_thread_args args[kIngestThreads];
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    args[thread_id].distfs = &distfs;
+    args[thread_id].files = &files;
+    args[thread_id].sharder_obj = NULL;
+    args[thread_id].sharder_lock = NULL;
+    args[thread_id].vertex_handler = &handlers[thread_id];
   }
-  infile.close();
-  outfile.close();
+  run_ingest_threads(ingest_vertices_thread, args);
+  vid_t max_id = 0;
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    vector<pair<vid_t, VertexDataType> >& vertices = handlers[thread_id].vertices;
+    for (size_t index = 0; index < vertices.size(); index++) {
+      max_id = max(max_id, vertices[index].first);
+    }
+  }
+  vector<VertexDataType> values(max_id + 1, VertexDataType());
+  for (int thread_id = 0; thread_id < kIngestThreads; thread_id++) {
+    vector<pair<vid_t, VertexDataType> >& vertices = handlers[thread_id].vertices;
+    for (size_t index = 0; index < vertices.size(); index++) {
+      values[vertices[index].first] = vertices[index].second;
+    }
+  }
+  FILE* outFD = fopen(out_filename, "wb");
+  if (!outFD) {
+    fprintf(stderr, "Could not open vertex data file %s!\n", out_filename);
+    return;
+  }
+  fwrite(&values[0], sizeof(VertexDataType), values.size(), outFD);
+  fclose(outFD);
 }
 
 void copy_file_append(hdfsFS& distfs, string path_name) {
@@ -203,7 +399,7 @@ void binary_to_ascii_hadoop(hdfsFS& distfs, const char* in_filename,
     return;
   }
 
-  {{VERTEX_DATA_TYPE}} tmp_ver_val;
+  VertexDataType tmp_ver_val;
   int buflen = OUT_BUF_LEN * sizeof(tmp_ver_val);
   char buf[buflen];
   // 16 for vertex, 16 for value, 1 space, 1 EOL
@@ -238,23 +434,23 @@ int main(int argc, char *argv[]) {
   gettimeofday(&start_time, NULL);
   printf("Connecting...to %s:%i\n", "hdfs://{{HDFS_MASTER}}", {{HDFS_PORT}});
   hdfsFS distfs = hdfsConnect("{{HDFS_MASTER}}", {{HDFS_PORT}});
-  char ver_file[128];
-  sprintf(ver_file, "{{TMP_ROOT}}{{EDGES_PATH}}input.%luB.vout", sizeof({{VERTEX_DATA_TYPE}}));
+  char ver_file[512];
+  sprintf(ver_file, "%s.%luB.vout", kShardsBase, sizeof(VertexDataType));
 
   if (!strcmp(argv[1], "copy_input")) {
     printf("Copying...\n");
-    copy_file(distfs, "{{EDGES_PATH}}");
-    // cmd_append("{{EDGES_PATH}}");
-    copy_file(distfs, "{{VERTICES_PATH}}");
-    ascii_to_binary("{{TMP_ROOT}}{{VERTICES_PATH}}input", ver_file);
+    ingest_edges(distfs, "{{EDGES_PATH}}");
+    ingest_vertices(distfs, "{{VERTICES_PATH}}", ver_file);
     gettimeofday(&end_time, NULL);
     long pulling_data = end_time.tv_sec - start_time.tv_sec;
     cout << "PULLING DATA: " << pulling_data << endl;
   } else if (!strcmp(argv[1], "copy_output")) {
     binary_to_ascii_hadoop(distfs, ver_file, "{{VERTICES_PATH}}output");
-    string rm_tmp_dirs =
-      "rm -r {{TMP_ROOT}}{{VERTICES_PATH}} ; rm -r {{TMP_ROOT}}{{EDGES_PATH}}";
-    system(rm_tmp_dirs.c_str());
+    if (!kCacheShards) {
+      // The shards are kept when caching so that the next run can reuse them.
+      string rm_tmp_dirs = "rm -r {{TMP_ROOT}}{{EDGES_PATH}}";
+      system(rm_tmp_dirs.c_str());
+    }
     gettimeofday(&end_time, NULL);
     long pushing_data = end_time.tv_sec - start_time.tv_sec;
     cout << "PUSHING DATA: " << pushing_data << endl;
@@ -19,6 +19,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <sys/time.h>
 
@@ -30,6 +31,22 @@ using namespace std;
 typedef {{VERTEX_DATA_TYPE}} VertexDataType;
 typedef {{EDGE_DATA_TYPE}} EdgeDataType;
 
+// With selective scheduling a vertex only runs if one of its in-edges changed
+// in the previous iteration. The engine stops early once no vertex is active.
+// Vertices without in-edges, and vertices whose update reads their own value
+// (a UNION with the vertices), also run again while their value changes.
+// With a threshold of 0 the result is the same as without selective
+// scheduling.
+const bool kSelectiveScheduling = {{SELECTIVE_SCHEDULING}};
+const bool kReadsOwnValue = {{READS_OWN_VALUE}};
+// Changes of an edge value up to the threshold are not propagated.
+const double kConvergenceThreshold = {{CONVERGENCE_THRESHOLD}};
+
+bool value_changed(EdgeDataType old_val, EdgeDataType new_val) {
+  double delta = static_cast<double>(new_val) - static_cast<double>(old_val);
+  return delta > kConvergenceThreshold || -delta > kConvergenceThreshold;
+}
+
 struct {{CLASS_NAME}} : public GraphChiProgram<VertexDataType, EdgeDataType> {
   void before_iteration(int iteration, graphchi_context &ginfo) {
   }
@@ -50,6 +67,12 @@ struct {{CLASS_NAME}} : public GraphChiProgram<VertexDataType, EdgeDataType> {
       // On the first iteration add the values to the edges.
       for (int i = 0; i < v.num_outedges(); i++) {
         v.outedge(i)->set_data(in_edge_val);
+        if (ginfo.scheduler != NULL) {
+          ginfo.scheduler->add_task(v.outedge(i)->vertex_id());
+        }
+      }
+      if (ginfo.scheduler != NULL && v.num_inedges() == 0) {
+        ginfo.scheduler->add_task(v.id());
       }
     } else {
       VertexDataType ver_val = {{INIT_VER_VAL}};
@@ -62,8 +85,19 @@ struct {{CLASS_NAME}} : public GraphChiProgram<VertexDataType, EdgeDataType> {
       in_edge_val = ver_val;
       {{PRE_GROUP_VERTEX_VAL}}
       for (int i = 0; i < v.num_outedges(); i++) {
+        if (ginfo.scheduler != NULL) {
+          if (!value_changed(v.outedge(i)->get_data(), in_edge_val)) {
+            continue;
+          }
+          ginfo.scheduler->add_task(v.outedge(i)->vertex_id());
+        }
         v.outedge(i)->set_data(in_edge_val);
       }
+      if (ginfo.scheduler != NULL &&
+          (v.num_inedges() == 0 || kReadsOwnValue) &&
+          value_changed(v.get_data(), ver_val)) {
+        ginfo.scheduler->add_task(v.id());
+      }
       v.set_data(ver_val);
     }
   }
@@ -72,7 +106,7 @@ struct {{CLASS_NAME}} : public GraphChiProgram<VertexDataType, EdgeDataType> {
 class OutputVertexCallback : public VCallback<VertexDataType> {
  public:
   OutputVertexCallback(): VCallback<VertexDataType>(),
-                          outfile("/tmp{{EDGES_PATH}}output") {
+                          outfile("{{TMP_ROOT}}{{EDGES_PATH}}output") {
   }
 
   ~OutputVertexCallback() {
@@ -91,13 +125,13 @@ int main(int argc, const char** argv) {
   metrics met("{{CLASS_NAME}}");
   int niters = get_option_int("niters", {{N_ITERS}});
   string filetype = get_option_string("filetype", "edgelist");
-  bool scheduler = false;
+  bool scheduler = kSelectiveScheduling;
   timeval start_proc;
   gettimeofday(&start_proc, NULL);
   int num_shards = convert_if_notexists<{{EDGE_DATA_TYPE}}>(
-      "/tmp{{EDGES_PATH}}input", get_option_string("nshards", "auto"));
+      "{{TMP_ROOT}}{{EDGES_PATH}}input", get_option_string("nshards", "auto"));
   graphchi_engine<VertexDataType, EdgeDataType> engine(
-      "/tmp{{EDGES_PATH}}input", num_shards, scheduler, met);
+      "{{TMP_ROOT}}{{EDGES_PATH}}input", num_shards, scheduler, met);
   timeval end_proc;
   gettimeofday(&end_proc, NULL);
   engine.set_modifies_inedges(false);
@@ -105,12 +139,15 @@ int main(int argc, const char** argv) {
   engine.run(program, niters);
   timeval end_run;
   gettimeofday(&end_run, NULL);
-  long loading_data = end_proc.tv_sec - start_proc.tv_sec;
-  long run_time = end_run.tv_sec - end_proc.tv_sec;
-  cout << "LOADING DATA: " << loading_data << endl;
-  cout << "RUN TIME: " << run_time << endl;
+  long loading_data = (end_proc.tv_sec - start_proc.tv_sec) * 1000 +
+    (end_proc.tv_usec - start_proc.tv_usec) / 1000;
+  long run_time = (end_run.tv_sec - end_proc.tv_sec) * 1000 +
+    (end_run.tv_usec - end_proc.tv_usec) / 1000;
+  cout << "METRIC LOAD MS: " << loading_data << endl;
+  cout << "METRIC RUN MS: " << run_time << endl;
+  cout << "METRIC ROWS IN: " << engine.num_edges() << endl;
   //  OutputVertexCallback output_callback;
-  //  foreach_vertices<VertexDataType>("/tmp{{EDGES_PATH}}input", 0,
+  //  foreach_vertices<VertexDataType>("{{TMP_ROOT}}{{EDGES_PATH}}input", 0,
   //                                   engine.num_vertices(), output_callback);
   metrics_report(met);
   return 0;
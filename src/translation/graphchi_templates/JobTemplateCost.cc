@@ -21,6 +21,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <sys/time.h>
 
@@ -85,7 +86,7 @@ struct {{CLASS_NAME}} : public GraphChiProgram<VertexDataType, EdgeDataType> {
 class OutputVertexCallback : public VCallback<VertexDataType> {
 public:
   OutputVertexCallback(): VCallback<VertexDataType>(),
-                          outfile("/tmp{{EDGES_PATH}}output") {
+                          outfile("{{TMP_ROOT}}{{EDGES_PATH}}output") {
   }
 
   ~OutputVertexCallback() {
@@ -108,9 +109,9 @@ int main(int argc, const char** argv) {
   timeval start_proc;
   gettimeofday(&start_proc, NULL);
   int num_shards = convert_if_notexists<{{EDGE_DATA_TYPE}}>(
-      "/tmp{{EDGES_PATH}}input", get_option_string("nshards", "auto"));
+      "{{TMP_ROOT}}{{EDGES_PATH}}input", get_option_string("nshards", "auto"));
   graphchi_engine<VertexDataType, EdgeDataType> engine(
-      "/tmp{{EDGES_PATH}}input", num_shards, scheduler, met);
+      "{{TMP_ROOT}}{{EDGES_PATH}}input", num_shards, scheduler, met);
   timeval end_proc;
   gettimeofday(&end_proc, NULL);
   engine.set_modifies_inedges(false);
@@ -123,7 +124,7 @@ int main(int argc, const char** argv) {
   cout << "LOADING DATA: " << loading_data << endl;
   cout << "RUN TIME: " << run_time << endl;
   //  OutputVertexCallback output_callback;
-  //  foreach_vertices<VertexDataType>("/tmp{{EDGES_PATH}}input", 0,
+  //  foreach_vertices<VertexDataType>("{{TMP_ROOT}}{{EDGES_PATH}}input", 0,
   //                                   engine.num_vertices(), output_callback);
   metrics_report(met);
   return 0;
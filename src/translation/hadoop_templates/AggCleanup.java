@@ -5,3 +5,6 @@
         }
         context.write(new Text("ALL"), new Text(outputValue));
       }
+      {{#MAP_AGGREGATION}}
+      flushAggPartials(context);
+      {{/MAP_AGGREGATION}}
@@ -0,0 +1,15 @@
+      {{TYPE}} aggValues[] = new {{TYPE}}[{{NUM_AGG_COLS}}];
+      for (int i = 0; i < aggValues.length; ++i) {
+        aggValues[i] = {{TYPE}}.valueOf("{{INIT_VAL}}");
+      }
+      for (Text text : values) {
+        String[] cols = text.toString().split(" ");
+        for (int i = 0; i < aggValues.length; ++i) {
+          aggValues[i] {{OPERATOR}}= {{TYPE}}.valueOf(cols[i]);
+        }
+      }
+      String outputValue = String.valueOf(aggValues[0]);
+      for (int i = 1; i < aggValues.length; ++i) {
+        outputValue += " " + String.valueOf(aggValues[i]);
+      }
+      context.write(key, new Text(outputValue));
@@ -12,10 +12,30 @@
             }
           }
         } else {
+          {{#MAP_AGGREGATION}}
+          String groupKey = {{GROUP_BY_KEY}};
+          {{TYPE}}[] partials = aggPartials.get(groupKey);
+          if (partials == null) {
+            if (aggPartials.size() >= {{MAX_GROUPS}}) {
+              flushAggPartials(context);
+            }
+            partials = new {{TYPE}}[aggValues.length];
+            for (int i = 0; i < partials.length; i++) {
+              partials[i] = {{TYPE}}.valueOf("{{INIT_VAL}}");
+            }
+            aggPartials.put(groupKey, partials);
+          }
+          for (int i = 0; i < partials.length; i++) {
+            partials[i] = partials[i] {{OPERATOR}}
+              {{TYPE}}.valueOf({{REL_NAME}}[indexArray[i]]);
+          }
+          {{/MAP_AGGREGATION}}
+          {{#NO_MAP_AGGREGATION}}
           String outputValue = {{REL_NAME}}[indexArray[0]];
           for (int i = 1; i < aggValues.length; i++) {
             outputValue += " " + {{REL_NAME}}[indexArray[i]];
           }
           context.write(new Text({{GROUP_BY_KEY}}), new Text(outputValue));
+          {{/NO_MAP_AGGREGATION}}
         }
       }
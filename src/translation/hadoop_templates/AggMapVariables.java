@@ -1,2 +1,21 @@
     {{TYPE}} aggValues[] = new {{TYPE}}[{{NUM_AGG_COLS}}];
-    int indexArray[] = { {{INDEX_ARRAY}} };
\ No newline at end of file
+    int indexArray[] = { {{INDEX_ARRAY}} };
+{{#MAP_AGGREGATION}}
+    // Partial aggregates of the groups seen by this mapper.
+    private HashMap<String, {{TYPE}}[]> aggPartials =
+      new HashMap<String, {{TYPE}}[]>();
+
+    private void flushAggPartials(Context context)
+        throws IOException, InterruptedException {
+      for (java.util.Map.Entry<String, {{TYPE}}[]> entry :
+             aggPartials.entrySet()) {
+        {{TYPE}}[] partials = entry.getValue();
+        String outputValue = String.valueOf(partials[0]);
+        for (int i = 1; i < partials.length; i++) {
+          outputValue += " " + String.valueOf(partials[i]);
+        }
+        context.write(new Text(entry.getKey()), new Text(outputValue));
+      }
+      aggPartials.clear();
+    }
+{{/MAP_AGGREGATION}}
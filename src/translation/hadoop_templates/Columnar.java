@@ -0,0 +1,521 @@
+  // Reader and writer of the columnar format of intermediate relations. The
+  // format is described in Musketeer's base/columnar_format.h.
+  public static class Columnar {
+
+    static final byte[] MAGIC = { (byte) 0x89, 'M', 'C', 'B' };
+
+    // Returns true if the file starts with a columnar block.
+    public static boolean isColumnar(org.apache.hadoop.fs.FileSystem fs, Path path)
+        throws IOException {
+      org.apache.hadoop.fs.FSDataInputStream in = fs.open(path);
+      try {
+        byte[] magic = new byte[MAGIC.length];
+        int read = 0;
+        while (read < magic.length) {
+          int bytes = in.read(magic, read, magic.length - read);
+          if (bytes < 0) {
+            return false;
+          }
+          read += bytes;
+        }
+        return Arrays.equals(magic, MAGIC);
+      } finally {
+        in.close();
+      }
+    }
+
+    static void writeVarint(java.io.DataOutputStream out, long value)
+        throws IOException {
+      while ((value & ~0x7FL) != 0) {
+        out.writeByte((int) ((value & 0x7F) | 0x80));
+        value >>>= 7;
+      }
+      out.writeByte((int) value);
+    }
+
+    static long readVarint(java.io.DataInputStream in) throws IOException {
+      long value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        int b = in.readUnsignedByte();
+        value |= (long) (b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+          return value;
+        }
+      }
+      throw new IOException("Malformed varint in columnar block");
+    }
+
+    static void writeBytes(java.io.DataOutputStream out, byte[] value)
+        throws IOException {
+      writeVarint(out, value.length);
+      out.write(value);
+    }
+
+    static String readString(java.io.DataInputStream in) throws IOException {
+      byte[] value = new byte[(int) readVarint(in)];
+      in.readFully(value);
+      return new String(value, "UTF-8");
+    }
+
+    static int compareBytes(byte[] left, byte[] right) {
+      for (int i = 0; i < Math.min(left.length, right.length); i++) {
+        int diff = (left[i] & 0xFF) - (right[i] & 0xFF);
+        if (diff != 0) {
+          return diff;
+        }
+      }
+      return left.length - right.length;
+    }
+
+    static String formatDecimal(long mantissa, int scale) {
+      String digits = Long.toString(mantissa);
+      boolean negative = mantissa < 0;
+      if (negative) {
+        digits = digits.substring(1);
+      }
+      StringBuilder value = new StringBuilder();
+      for (int i = digits.length(); i <= scale; i++) {
+        value.append('0');
+      }
+      value.append(digits);
+      if (scale > 0) {
+        value.insert(value.length() - scale, '.');
+      }
+      return negative ? "-" + value : value.toString();
+    }
+
+    // Parses value as a decimal that prints back as the same text. Sets
+    // decimal[0] to the mantissa and decimal[1] to the scale.
+    static boolean parseDecimal(String value, long[] decimal) {
+      int point = value.indexOf('.');
+      int scale = point < 0 ? 0 : value.length() - point - 1;
+      String digits = point < 0 ? value :
+        value.substring(0, point) + value.substring(point + 1);
+      if (digits.isEmpty() || digits.length() > 19 || scale > 255) {
+        return false;
+      }
+      for (int i = 0; i < digits.length(); i++) {
+        char c = digits.charAt(i);
+        if (c != '-' && (c < '0' || c > '9')) {
+          return false;
+        }
+      }
+      try {
+        decimal[0] = Long.parseLong(digits);
+      } catch (NumberFormatException e) {
+        return false;
+      }
+      decimal[1] = scale;
+      return formatDecimal(decimal[0], scale).equals(value);
+    }
+
+    static void writeChunk(List<String> values, boolean compress,
+                           java.io.DataOutputStream out) throws IOException {
+      int numRows = values.size();
+      long[] mantissas = new long[numRows];
+      int[] scales = new int[numRows];
+      long[] decimal = new long[2];
+      boolean isDecimal = true;
+      boolean isInteger = true;
+      for (int i = 0; i < numRows && isDecimal; i++) {
+        isDecimal = parseDecimal(values.get(i), decimal);
+        mantissas[i] = decimal[0];
+        scales[i] = (int) decimal[1];
+        isInteger = isInteger && isDecimal && scales[i] == 0;
+      }
+      java.io.ByteArrayOutputStream dataBytes = new java.io.ByteArrayOutputStream();
+      java.io.DataOutputStream data = new java.io.DataOutputStream(dataBytes);
+      if (isDecimal) {
+        double minValue = 0;
+        double maxValue = 0;
+        long minInteger = 0;
+        long maxInteger = 0;
+        long previous = 0;
+        for (int i = 0; i < numRows; i++) {
+          double value = mantissas[i];
+          for (int s = 0; s < scales[i]; s++) {
+            value /= 10;
+          }
+          if (i == 0 || value < minValue) {
+            minValue = value;
+          }
+          if (i == 0 || value > maxValue) {
+            maxValue = value;
+          }
+          if (i == 0 || mantissas[i] < minInteger) {
+            minInteger = mantissas[i];
+          }
+          if (i == 0 || mantissas[i] > maxInteger) {
+            maxInteger = mantissas[i];
+          }
+          if (!isInteger) {
+            data.writeByte(scales[i]);
+          }
+          if (compress) {
+            long delta = mantissas[i] - previous;
+            writeVarint(data, (delta << 1) ^ (delta >> 63));
+          } else {
+            data.writeLong(mantissas[i]);
+          }
+          previous = mantissas[i];
+        }
+        out.writeByte(isInteger ? 'i' : 'd');
+        out.writeByte(compress ? 'z' : 'p');
+        if (isInteger) {
+          out.writeLong(minInteger);
+          out.writeLong(maxInteger);
+        } else {
+          out.writeDouble(minValue);
+          out.writeDouble(maxValue);
+        }
+      } else {
+        byte[][] bytes = new byte[numRows][];
+        LinkedHashMap<String, Integer> dict = new LinkedHashMap<String, Integer>();
+        int minIndex = 0;
+        int maxIndex = 0;
+        for (int i = 0; i < numRows; i++) {
+          bytes[i] = values.get(i).getBytes("UTF-8");
+          if (compareBytes(bytes[i], bytes[minIndex]) < 0) {
+            minIndex = i;
+          }
+          if (compareBytes(bytes[i], bytes[maxIndex]) > 0) {
+            maxIndex = i;
+          }
+          if (compress && !dict.containsKey(values.get(i))) {
+            dict.put(values.get(i), dict.size());
+          }
+        }
+        boolean useDict = compress && dict.size() * 2 <= numRows;
+        if (useDict) {
+          writeVarint(data, dict.size());
+          for (String entry : dict.keySet()) {
+            writeBytes(data, entry.getBytes("UTF-8"));
+          }
+          for (int i = 0; i < numRows; i++) {
+            writeVarint(data, dict.get(values.get(i)));
+          }
+        } else {
+          for (int i = 0; i < numRows; i++) {
+            writeBytes(data, bytes[i]);
+          }
+        }
+        out.writeByte('s');
+        out.writeByte(useDict ? 'k' : 'p');
+        writeBytes(out, bytes[minIndex]);
+        writeBytes(out, bytes[maxIndex]);
+      }
+      data.flush();
+      out.writeInt(dataBytes.size());
+      dataBytes.writeTo(out);
+    }
+
+    // Writes rows, which all have the same number of columns, as a block.
+    public static void writeBlock(List<String[]> rows, boolean compress,
+                                  java.io.DataOutputStream out) throws IOException {
+      int numCols = rows.get(0).length;
+      java.io.ByteArrayOutputStream bodyBytes = new java.io.ByteArrayOutputStream();
+      java.io.DataOutputStream body = new java.io.DataOutputStream(bodyBytes);
+      ArrayList<String> values = new ArrayList<String>(rows.size());
+      for (int col = 0; col < numCols; col++) {
+        values.clear();
+        for (String[] row : rows) {
+          values.add(row[col]);
+        }
+        writeChunk(values, compress, body);
+      }
+      body.flush();
+      out.write(MAGIC);
+      out.writeInt(rows.size());
+      out.writeInt(numCols);
+      out.writeInt(bodyBytes.size());
+      bodyBytes.writeTo(out);
+    }
+
+    static String[] readChunk(java.io.DataInputStream in, int numRows)
+        throws IOException {
+      int type = in.readUnsignedByte();
+      int encoding = in.readUnsignedByte();
+      // Skip the min and max of the chunk.
+      if (type == 'i' || type == 'd') {
+        in.readLong();
+        in.readLong();
+      } else {
+        readString(in);
+        readString(in);
+      }
+      in.readInt();
+      String[] values = new String[numRows];
+      if (type == 's') {
+        String[] dict = null;
+        if (encoding == 'k') {
+          dict = new String[(int) readVarint(in)];
+          for (int i = 0; i < dict.length; i++) {
+            dict[i] = readString(in);
+          }
+        } else if (encoding != 'p') {
+          throw new IOException("Unknown columnar encoding " + encoding);
+        }
+        for (int row = 0; row < numRows; row++) {
+          values[row] = dict != null ? dict[(int) readVarint(in)] : readString(in);
+        }
+        return values;
+      }
+      if ((type != 'i' && type != 'd') || (encoding != 'p' && encoding != 'z')) {
+        throw new IOException("Unknown columnar chunk " + type + "/" + encoding);
+      }
+      long previous = 0;
+      for (int row = 0; row < numRows; row++) {
+        int scale = type == 'd' ? in.readUnsignedByte() : 0;
+        long value;
+        if (encoding == 'z') {
+          long delta = readVarint(in);
+          value = previous + ((delta >>> 1) ^ -(delta & 1));
+        } else {
+          value = in.readLong();
+        }
+        previous = value;
+        values[row] = type == 'i' ? Long.toString(value) : formatDecimal(value, scale);
+      }
+      return values;
+    }
+
+    // Appends the rows of the next block to rows as lines of text. Returns
+    // false at the end of the input.
+    public static boolean readBlock(java.io.DataInputStream in, List<String> rows)
+        throws IOException {
+      int first = in.read();
+      if (first < 0) {
+        return false;
+      }
+      byte[] magic = new byte[MAGIC.length];
+      magic[0] = (byte) first;
+      in.readFully(magic, 1, magic.length - 1);
+      if (!Arrays.equals(magic, MAGIC)) {
+        throw new IOException("Malformed columnar block");
+      }
+      int numRows = in.readInt();
+      int numCols = in.readInt();
+      byte[] body = new byte[in.readInt()];
+      in.readFully(body);
+      java.io.DataInputStream bodyIn =
+        new java.io.DataInputStream(new java.io.ByteArrayInputStream(body));
+      String[][] columns = new String[numCols][];
+      for (int col = 0; col < numCols; col++) {
+        columns[col] = readChunk(bodyIn, numRows);
+      }
+      for (int row = 0; row < numRows; row++) {
+        StringBuilder line = new StringBuilder();
+        for (int col = 0; col < numCols; col++) {
+          if (col > 0) {
+            line.append(' ');
+          }
+          line.append(columns[col][row]);
+        }
+        rows.add(line.toString());
+      }
+      return true;
+    }
+
+  }
+
+  // Reads the rows of a part file, in text or in the columnar format.
+  public static class RowReader {
+
+    private java.io.BufferedReader textIn;
+    private java.io.DataInputStream columnarIn;
+    private ArrayList<String> rows = new ArrayList<String>();
+    private int nextRow = 0;
+
+    public RowReader(org.apache.hadoop.fs.FileSystem fs, Path path)
+        throws IOException {
+      if (Columnar.isColumnar(fs, path)) {
+        columnarIn = new java.io.DataInputStream(
+            new java.io.BufferedInputStream(fs.open(path)));
+      } else {
+        textIn = new java.io.BufferedReader(
+            new java.io.InputStreamReader(fs.open(path)));
+      }
+    }
+
+    // Returns the next row as a line of text, or null at the end of the file.
+    public String readLine() throws IOException {
+      if (textIn != null) {
+        return textIn.readLine();
+      }
+      while (nextRow == rows.size()) {
+        rows.clear();
+        nextRow = 0;
+        if (!Columnar.readBlock(columnarIn, rows)) {
+          return null;
+        }
+      }
+      return rows.get(nextRow++);
+    }
+
+    public void close() throws IOException {
+      if (textIn != null) {
+        textIn.close();
+      } else {
+        columnarIn.close();
+      }
+    }
+
+  }
+
+  // Reads text files line by line, like TextInputFormat, and columnar files
+  // row by row as lines of text. Columnar files are not split.
+  public static class ColumnarInputFormat
+    extends FileInputFormat<LongWritable, Text> {
+
+    @Override
+    protected boolean isSplitable(org.apache.hadoop.mapreduce.JobContext context,
+                                  Path file) {
+      org.apache.hadoop.io.compress.CompressionCodec codec =
+        new org.apache.hadoop.io.compress.CompressionCodecFactory(
+            context.getConfiguration()).getCodec(file);
+      if (codec != null) {
+        return codec instanceof org.apache.hadoop.io.compress.SplittableCompressionCodec;
+      }
+      try {
+        return !Columnar.isColumnar(file.getFileSystem(context.getConfiguration()),
+                                    file);
+      } catch (IOException e) {
+        return false;
+      }
+    }
+
+    @Override
+    public org.apache.hadoop.mapreduce.RecordReader<LongWritable, Text> createRecordReader(
+        org.apache.hadoop.mapreduce.InputSplit split,
+        org.apache.hadoop.mapreduce.TaskAttemptContext context) {
+      return new ColumnarRecordReader();
+    }
+
+  }
+
+  public static class ColumnarRecordReader
+    extends org.apache.hadoop.mapreduce.RecordReader<LongWritable, Text> {
+
+    private org.apache.hadoop.mapreduce.lib.input.LineRecordReader lineReader;
+    private org.apache.hadoop.fs.FSDataInputStream fileIn;
+    private java.io.DataInputStream columnarIn;
+    private long length;
+    private ArrayList<String> rows = new ArrayList<String>();
+    private int nextRow = 0;
+    private LongWritable key = new LongWritable(-1);
+    private Text value = new Text();
+
+    @Override
+    public void initialize(org.apache.hadoop.mapreduce.InputSplit split,
+                           org.apache.hadoop.mapreduce.TaskAttemptContext context)
+        throws IOException, InterruptedException {
+      FileSplit fileSplit = (FileSplit) split;
+      Path path = fileSplit.getPath();
+      org.apache.hadoop.fs.FileSystem fs = path.getFileSystem(context.getConfiguration());
+      if (fileSplit.getStart() == 0 && Columnar.isColumnar(fs, path)) {
+        length = fileSplit.getLength();
+        fileIn = fs.open(path);
+        columnarIn = new java.io.DataInputStream(
+            new java.io.BufferedInputStream(fileIn));
+      } else {
+        lineReader = new org.apache.hadoop.mapreduce.lib.input.LineRecordReader();
+        lineReader.initialize(split, context);
+      }
+    }
+
+    @Override
+    public boolean nextKeyValue() throws IOException, InterruptedException {
+      if (lineReader != null) {
+        return lineReader.nextKeyValue();
+      }
+      while (nextRow == rows.size()) {
+        rows.clear();
+        nextRow = 0;
+        if (!Columnar.readBlock(columnarIn, rows)) {
+          return false;
+        }
+      }
+      key.set(key.get() + 1);
+      value.set(rows.get(nextRow++));
+      return true;
+    }
+
+    @Override
+    public LongWritable getCurrentKey() throws IOException, InterruptedException {
+      return lineReader != null ? lineReader.getCurrentKey() : key;
+    }
+
+    @Override
+    public Text getCurrentValue() throws IOException, InterruptedException {
+      return lineReader != null ? lineReader.getCurrentValue() : value;
+    }
+
+    @Override
+    public float getProgress() throws IOException, InterruptedException {
+      if (lineReader != null) {
+        return lineReader.getProgress();
+      }
+      return length == 0 ? 1.0f : Math.min(1.0f, fileIn.getPos() / (float) length);
+    }
+
+    @Override
+    public void close() throws IOException {
+      if (lineReader != null) {
+        lineReader.close();
+      } else if (columnarIn != null) {
+        columnarIn.close();
+      }
+    }
+
+  }
+
+  // Writes the rows TextOutputFormat would write in the columnar format.
+  public static class ColumnarOutputFormat<K, V> extends FileOutputFormat<K, V> {
+
+    @Override
+    public org.apache.hadoop.mapreduce.RecordWriter<K, V> getRecordWriter(
+        org.apache.hadoop.mapreduce.TaskAttemptContext context)
+        throws IOException, InterruptedException {
+      Configuration conf = context.getConfiguration();
+      Path file = getDefaultWorkFile(context, "");
+      final java.io.DataOutputStream out = new java.io.DataOutputStream(
+          new java.io.BufferedOutputStream(file.getFileSystem(conf).create(file, false)));
+      final int blockRows = conf.getInt("musketeer.columnar.block.rows", 65536);
+      final boolean compress = conf.getBoolean("musketeer.columnar.compress", true);
+      return new org.apache.hadoop.mapreduce.RecordWriter<K, V>() {
+        private ArrayList<String[]> rows = new ArrayList<String[]>();
+
+        public void write(K key, V value) throws IOException {
+          boolean hasKey = key != null && !(key instanceof NullWritable);
+          boolean hasValue = value != null && !(value instanceof NullWritable);
+          String line;
+          if (hasKey && hasValue) {
+            line = key.toString() + "\t" + value.toString();
+          } else if (hasKey) {
+            line = key.toString();
+          } else if (hasValue) {
+            line = value.toString();
+          } else {
+            return;
+          }
+          String[] row = line.split(" ", -1);
+          if (!rows.isEmpty() &&
+              (rows.size() == blockRows || rows.get(0).length != row.length)) {
+            Columnar.writeBlock(rows, compress, out);
+            rows.clear();
+          }
+          rows.add(row);
+        }
+
+        public void close(org.apache.hadoop.mapreduce.TaskAttemptContext context)
+            throws IOException {
+          if (!rows.isEmpty()) {
+            Columnar.writeBlock(rows, compress, out);
+          }
+          out.close();
+        }
+      };
+    }
+
+  }
+
@@ -1,3 +1,6 @@
       if ({{GROUP_BY}} == -1) {
         context.write(new Text("ALL"), new Text(String.valueOf(cnt)));
       }
+      {{#MAP_AGGREGATION}}
+      flushCountPartials(context);
+      {{/MAP_AGGREGATION}}
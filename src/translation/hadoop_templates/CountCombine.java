@@ -0,0 +1,5 @@
+      int cnt = 0;
+      for (Text value : values) {
+        cnt += Integer.valueOf(value.toString());
+      }
+      context.write(key, new Text(String.valueOf(cnt)));
@@ -2,7 +2,17 @@
         if ({{GROUP_BY}} == -1) {
           cnt += 1;
         } else {
+          {{#MAP_AGGREGATION}}
+          String groupKey = {{GROUP_BY_KEY}};
+          Integer partial = countPartials.get(groupKey);
+          if (partial == null && countPartials.size() >= {{MAX_GROUPS}}) {
+            flushCountPartials(context);
+          }
+          countPartials.put(groupKey, partial == null ? 1 : partial + 1);
+          {{/MAP_AGGREGATION}}
+          {{#NO_MAP_AGGREGATION}}
           Text newKey = new Text({{GROUP_BY_KEY}});
           context.write(newKey, new Text("1"));
+          {{/NO_MAP_AGGREGATION}}
         }
       }
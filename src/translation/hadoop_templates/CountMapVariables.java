@@ -1 +1,16 @@
     int cnt = 0;
+{{#MAP_AGGREGATION}}
+    // Partial counts of the groups seen by this mapper.
+    private HashMap<String, Integer> countPartials =
+      new HashMap<String, Integer>();
+
+    private void flushCountPartials(Context context)
+        throws IOException, InterruptedException {
+      for (java.util.Map.Entry<String, Integer> entry :
+             countPartials.entrySet()) {
+        context.write(new Text(entry.getKey()),
+                      new Text(String.valueOf(entry.getValue())));
+      }
+      countPartials.clear();
+    }
+{{/MAP_AGGREGATION}}
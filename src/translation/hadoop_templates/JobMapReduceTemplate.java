@@ -1,13 +1,17 @@
+import java.io.DataInput;
+import java.io.DataOutput;
 import java.io.IOException;
 import java.util.*;
 import java.text.*;
-import org.apache.hadoop.fs.Path;
+import org.apache.hadoop.fs.*;
 import org.apache.hadoop.conf.*;
 import org.apache.hadoop.io.*;
+import org.apache.hadoop.util.LineReader;
 import org.apache.hadoop.util.Tool;
 import org.apache.hadoop.util.ToolRunner;
 import org.apache.hadoop.mapreduce.Job;
 import org.apache.hadoop.mapreduce.Mapper;
+import org.apache.hadoop.mapreduce.Partitioner;
 import org.apache.hadoop.mapreduce.Reducer;
 import org.apache.hadoop.mapreduce.lib.input.FileInputFormat;
 import org.apache.hadoop.mapreduce.lib.input.FileSplit;
@@ -17,6 +21,8 @@ import org.apache.hadoop.mapreduce.lib.partition.*;
 
 public class {{CLASS_NAME}} extends Configured implements Tool {
 
+{{CLASSES_CODE}}
+{{COLUMNAR_CODE}}
   public static class Map extends Mapper<Object, Text, {{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}> {
 
 {{MAP_VARIABLES_CODE}}
@@ -42,6 +48,17 @@ public class {{CLASS_NAME}} extends Configured implements Tool {
 
   }
 
+{{#COMBINER}}
+  public static class Combine extends Reducer<{{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}, {{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}>{
+
+    public void reduce({{MAP_KEY_TYPE}} key, Iterable<{{MAP_VALUE_TYPE}}> values, Context context)
+      throws IOException, InterruptedException {
+{{COMBINE_CODE}}
+    }
+
+  }
+
+{{/COMBINER}}
   public static class Reduce extends Reducer<{{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}, {{REDUCE_KEY_TYPE}}, {{REDUCE_VALUE_TYPE}}>{
 
     private int index;
@@ -53,6 +70,114 @@ public class {{CLASS_NAME}} extends Configured implements Tool {
 
   }
 
+{{#RANGE_PARTITIONER}}
+  // Sends every range of sort keys to its own reduce task. A key that occurs
+  // often gets a range of its own instead of overloading its neighbours'.
+  public static class RangePartition extends Partitioner<{{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}>
+    implements Configurable {
+
+    private Configuration conf;
+    private {{SORT_COL_TYPE}}[] splits;
+
+    public void setConf(Configuration conf) {
+      this.conf = conf;
+      String[] values = conf.getStrings("musketeer.range.splits", new String[0]);
+      splits = new {{SORT_COL_TYPE}}[values.length];
+      for (int i = 0; i < values.length; i++) {
+        splits[i] = {{SORT_COL_TYPE}}.valueOf(values[i]);
+      }
+    }
+
+    public Configuration getConf() {
+      return conf;
+    }
+
+    public int getPartition({{MAP_KEY_TYPE}} key, {{MAP_VALUE_TYPE}} value, int numPartitions) {
+      int index = Arrays.binarySearch(splits, {{SORT_COL_TYPE}}.valueOf(key.toString()));
+      int partition = index >= 0 ? index + 1 : -index - 1;
+      return Math.min(partition, numPartitions - 1);
+    }
+
+  }
+
+  // Picks the distinct split points of numRanges ranges from the sort keys
+  // of lines read at random offsets of the input.
+  private static String[] sampleRangeSplits(Configuration conf, String inputPath,
+                                            int numRanges) throws IOException {
+    final int numSamples = 100 * numRanges;
+    Path path = new Path(inputPath);
+    FileSystem fs = path.getFileSystem(conf);
+    ArrayList<FileStatus> files = new ArrayList<FileStatus>();
+    for (FileStatus status : fs.listStatus(path)) {
+      String name = status.getPath().getName();
+      if (!status.isDir() && status.getLen() > 0 && !name.startsWith("_") &&
+          !name.startsWith(".")) {
+        files.add(status);
+      }
+    }
+    ArrayList<{{SORT_COL_TYPE}}> samples = new ArrayList<{{SORT_COL_TYPE}}>();
+    Random random = new Random(numRanges);
+    for (FileStatus file : files) {
+      if (Columnar.isColumnar(fs, file.getPath())) {
+        // Columnar files can not be read from an arbitrary offset, so a
+        // reservoir of rows is sampled while reading the file.
+        ArrayList<String> rows = new ArrayList<String>();
+        int numRows = 0;
+        RowReader reader = new RowReader(fs, file.getPath());
+        String row;
+        while ((row = reader.readLine()) != null) {
+          if (rows.size() < numSamples / files.size() + 1) {
+            rows.add(row);
+          } else {
+            int index = random.nextInt(numRows + 1);
+            if (index < rows.size()) {
+              rows.set(index, row);
+            }
+          }
+          numRows++;
+        }
+        reader.close();
+        for (String sampled : rows) {
+          String[] cols = sampled.trim().split(" ");
+          if (cols.length > {{SORT_COL_INDEX}}) {
+            samples.add({{SORT_COL_TYPE}}.valueOf(cols[{{SORT_COL_INDEX}}]));
+          }
+        }
+        continue;
+      }
+      FSDataInputStream in = fs.open(file.getPath());
+      Text line = new Text();
+      for (int i = 0; i < numSamples / files.size() + 1; i++) {
+        long offset = (long) (random.nextDouble() * file.getLen());
+        in.seek(offset);
+        LineReader reader = new LineReader(in);
+        // Skip the rest of the line the offset falls in.
+        if (offset > 0) {
+          reader.readLine(line);
+        }
+        if (reader.readLine(line) > 0) {
+          String[] cols = line.toString().trim().split(" ");
+          if (cols.length > {{SORT_COL_INDEX}}) {
+            samples.add({{SORT_COL_TYPE}}.valueOf(cols[{{SORT_COL_INDEX}}]));
+          }
+        }
+      }
+      in.close();
+    }
+    Collections.sort(samples);
+    ArrayList<String> splits = new ArrayList<String>();
+    {{SORT_COL_TYPE}} last = null;
+    for (int i = 1; i < numRanges && !samples.isEmpty(); i++) {
+      {{SORT_COL_TYPE}} split = samples.get(i * samples.size() / numRanges);
+      if (last == null || split.compareTo(last) > 0) {
+        splits.add(split.toString());
+        last = split;
+      }
+    }
+    return splits.toArray(new String[splits.size()]);
+  }
+
+{{/RANGE_PARTITIONER}}
   public int run(String[] args) throws Exception {
     Configuration conf = new Configuration();
     Job job = new Job(conf, "{{CLASS_NAME}}");
@@ -63,12 +188,32 @@ public class {{CLASS_NAME}} extends Configured implements Tool {
     job.setOutputValueClass({{REDUCE_VALUE_TYPE}}.class);
     job.setMapperClass(Map.class);
     job.setReducerClass(Reduce.class);
-    job.setNumReduceTasks(16);
+{{#COMBINER}}
+    job.setCombinerClass(Combine.class);
+{{/COMBINER}}
+    job.setNumReduceTasks({{NUM_REDUCE_TASKS}});
+{{#RANGE_PARTITIONER}}
+    job.getConfiguration().setStrings("musketeer.range.splits",
+        sampleRangeSplits(job.getConfiguration(), "{{SAMPLE_PATH}}", {{NUM_REDUCE_TASKS}}));
+    job.setPartitionerClass(RangePartition.class);
+{{/RANGE_PARTITIONER}}
+{{#COLUMNAR_INPUT}}
+    job.setInputFormatClass(ColumnarInputFormat.class);
+{{/COLUMNAR_INPUT}}
     {{INPUT_PATHS}}
     FileOutputFormat.setOutputPath(job, new Path("{{OUTPUT_PATH}}"));
-    return (job.waitForCompletion(true) ? 0 : 1);
+{{#COLUMNAR_OUTPUT}}
+    job.getConfiguration().setInt("musketeer.columnar.block.rows", {{COLUMNAR_BLOCK_ROWS}});
+    job.getConfiguration().setBoolean("musketeer.columnar.compress", {{COLUMNAR_COMPRESS}});
+    job.setOutputFormatClass(ColumnarOutputFormat.class);
+{{/COLUMNAR_OUTPUT}}
+    boolean succeeded = job.waitForCompletion(true);
+    reportMetrics(job);
+    return (succeeded ? 0 : 1);
   }
 
+{{REPORT_METRICS_CODE}}
+
   public static void main(String[] args) throws Exception {
     int res = ToolRunner.run(new Configuration(), new {{CLASS_NAME}}(), args);
     System.exit(res);
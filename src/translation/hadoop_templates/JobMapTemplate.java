@@ -17,6 +17,7 @@ import org.apache.hadoop.mapreduce.lib.partition.*;
 
 public class {{CLASS_NAME}} extends Configured implements Tool {
 
+{{COLUMNAR_CODE}}
   public static class Map extends Mapper<Object, Text, {{MAP_KEY_TYPE}}, {{MAP_VALUE_TYPE}}> {
 
 {{MAP_VARIABLES_CODE}}
@@ -52,11 +53,23 @@ public class {{CLASS_NAME}} extends Configured implements Tool {
     job.setOutputValueClass({{MAP_VALUE_TYPE}}.class);
     job.setMapperClass(Map.class);
     job.setNumReduceTasks(0);
+{{#COLUMNAR_INPUT}}
+    job.setInputFormatClass(ColumnarInputFormat.class);
+{{/COLUMNAR_INPUT}}
     {{INPUT_PATHS}}
     FileOutputFormat.setOutputPath(job, new Path("{{OUTPUT_PATH}}"));
-    return (job.waitForCompletion(true) ? 0 : 1);
+{{#COLUMNAR_OUTPUT}}
+    job.getConfiguration().setInt("musketeer.columnar.block.rows", {{COLUMNAR_BLOCK_ROWS}});
+    job.getConfiguration().setBoolean("musketeer.columnar.compress", {{COLUMNAR_COMPRESS}});
+    job.setOutputFormatClass(ColumnarOutputFormat.class);
+{{/COLUMNAR_OUTPUT}}
+    boolean succeeded = job.waitForCompletion(true);
+    reportMetrics(job);
+    return (succeeded ? 0 : 1);
   }
 
+{{REPORT_METRICS_CODE}}
+
   public static void main(String[] args) throws Exception {
     int res = ToolRunner.run(new Configuration(), new {{CLASS_NAME}}(), args);
     System.exit(res);
@@ -0,0 +1,14 @@
+      List<String> {{BROADCAST_REL}}_matches = {{BROADCAST_REL}}_rows.get({{STREAM_KEY}});
+      if ({{BROADCAST_REL}}_matches != null) {
+        String {{STREAM_REL}}_tmp = "";
+        for (int {{STREAM_REL}}_i = 0; {{STREAM_REL}}_i < {{STREAM_REL}}.length; {{STREAM_REL}}_i++) {
+          if ({{STREAM_KEEP}}) {
+            {{STREAM_REL}}_tmp += " " + {{STREAM_REL}}[{{STREAM_REL}}_i];
+          }
+        }
+        for (String {{BROADCAST_REL}}_tmp : {{BROADCAST_REL}}_matches) {
+          String[] {{OUTPUT_REL}} = ({{JOINED_ROW}}).trim().split(" ");
+          {{NEXT_OPERATOR}}
+          {{OUTPUT_CODE}}
+        }
+      }
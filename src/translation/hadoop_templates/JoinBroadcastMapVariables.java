@@ -0,0 +1,3 @@
+    // Rows of {{BROADCAST_REL}} by the values of their join columns.
+    private HashMap<String, List<String>> {{BROADCAST_REL}}_rows =
+      new HashMap<String, List<String>>();
@@ -0,0 +1,31 @@
+      org.apache.hadoop.fs.FileSystem {{BROADCAST_REL}}_fs =
+        org.apache.hadoop.fs.FileSystem.get(context.getConfiguration());
+      for (org.apache.hadoop.fs.FileStatus {{BROADCAST_REL}}_file :
+             {{BROADCAST_REL}}_fs.listStatus(new Path("{{BROADCAST_PATH}}"))) {
+        String {{BROADCAST_REL}}_file_name = {{BROADCAST_REL}}_file.getPath().getName();
+        if ({{BROADCAST_REL}}_file.isDir() ||
+            {{BROADCAST_REL}}_file_name.startsWith("_") ||
+            {{BROADCAST_REL}}_file_name.startsWith(".")) {
+          continue;
+        }
+        RowReader {{BROADCAST_REL}}_reader =
+          new RowReader({{BROADCAST_REL}}_fs, {{BROADCAST_REL}}_file.getPath());
+        String {{BROADCAST_REL}}_line;
+        while (({{BROADCAST_REL}}_line = {{BROADCAST_REL}}_reader.readLine()) != null) {
+          String[] {{BROADCAST_REL}} = {{BROADCAST_REL}}_line.trim().split(" ");
+          String {{BROADCAST_REL}}_tmp = "";
+          for (int {{BROADCAST_REL}}_i = 0; {{BROADCAST_REL}}_i < {{BROADCAST_REL}}.length; {{BROADCAST_REL}}_i++) {
+            if ({{BROADCAST_KEEP}}) {
+              {{BROADCAST_REL}}_tmp += " " + {{BROADCAST_REL}}[{{BROADCAST_REL}}_i];
+            }
+          }
+          String {{BROADCAST_REL}}_key = {{BROADCAST_KEY}};
+          List<String> {{BROADCAST_REL}}_matches = {{BROADCAST_REL}}_rows.get({{BROADCAST_REL}}_key);
+          if ({{BROADCAST_REL}}_matches == null) {
+            {{BROADCAST_REL}}_matches = new ArrayList<String>();
+            {{BROADCAST_REL}}_rows.put({{BROADCAST_REL}}_key, {{BROADCAST_REL}}_matches);
+          }
+          {{BROADCAST_REL}}_matches.add({{BROADCAST_REL}}_tmp);
+        }
+        {{BROADCAST_REL}}_reader.close();
+      }
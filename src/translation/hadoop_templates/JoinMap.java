@@ -1,27 +1,34 @@
       if (this.is_left_rel) {
-        String {{LEFT_REL}}_tmp = "";
         String left_join_cols = "";
         for (int {{LEFT_REL}}_i = 0; {{LEFT_REL}}_i < {{LEFT_REL}}.length; {{LEFT_REL}}_i++) {
-          {{LEFT_REL}}_tmp += " " + {{LEFT_REL}}[{{LEFT_REL}}_i];
           if ({{#LEFT_INDICES}}{{CHECK_INDEX}}{{#LEFT_INDICES_separator}} || {{/LEFT_INDICES_separator}}{{/LEFT_INDICES}}) {
             left_join_cols += {{LEFT_REL}}[{{LEFT_REL}}_i] + " ";
           }
         }
-        context.write(new Text(left_join_cols),
-                      new Text("L" + {{LEFT_REL}}_tmp));
+        JoinValue {{LEFT_REL}}_row = new JoinValue(true, {{LEFT_REL}});
+        {{#SKEW_JOIN}}
+        writeJoinRow(context, left_join_cols, {{LEFT_REL}}_row, {{SPLIT_LEFT}});
+        {{/SKEW_JOIN}}
+        {{#NO_SKEW_JOIN}}
+        context.write(new Text(left_join_cols), {{LEFT_REL}}_row);
+        {{/NO_SKEW_JOIN}}
       } else {
-        String {{RIGHT_REL}}_tmp = "";
+        // The output keeps the right columns that are not join keys.
+        ArrayList<String> {{RIGHT_REL}}_cols = new ArrayList<String>();
         String right_join_cols = "";
         for (int {{RIGHT_REL}}_i = 0; {{RIGHT_REL}}_i < {{RIGHT_REL}}.length; {{RIGHT_REL}}_i++) {
           if ({{#RIGHT_INDICES}}{{CHECK_NOT_INDEX}}{{#RIGHT_INDICES_separator}} && {{/RIGHT_INDICES_separator}}{{/RIGHT_INDICES}}) {
-            {{RIGHT_REL}}_tmp += " " + {{RIGHT_REL}}[{{RIGHT_REL}}_i];
+            {{RIGHT_REL}}_cols.add({{RIGHT_REL}}[{{RIGHT_REL}}_i]);
           } else {
             right_join_cols += {{RIGHT_REL}}[{{RIGHT_REL}}_i] + " ";
           }
         }
-        if ({{RIGHT_REL}}_tmp.isEmpty()) {
-          {{RIGHT_REL}}_tmp = " ";
-        }
-        context.write(new Text(right_join_cols),
-                      new Text("R" + {{RIGHT_REL}}_tmp));
+        JoinValue {{RIGHT_REL}}_row = new JoinValue(
+            false, {{RIGHT_REL}}_cols.toArray(new String[{{RIGHT_REL}}_cols.size()]));
+        {{#SKEW_JOIN}}
+        writeJoinRow(context, right_join_cols, {{RIGHT_REL}}_row, {{SPLIT_RIGHT}});
+        {{/SKEW_JOIN}}
+        {{#NO_SKEW_JOIN}}
+        context.write(new Text(right_join_cols), {{RIGHT_REL}}_row);
+        {{/NO_SKEW_JOIN}}
       }
@@ -1 +1,23 @@
-    private boolean is_left_rel = false;
\ No newline at end of file
+    private boolean is_left_rel = false;
+{{#SKEW_JOIN}}
+    // Rows with a heavy join key are spread over {{SKEW_SPLITS}} reduce keys.
+    // The larger input's rows go to one of them, the other input's to all.
+    private static final HashSet<String> skewedKeys =
+      new HashSet<String>(Arrays.asList({{SKEWED_KEYS}}));
+    private Random skewRandom = new Random();
+
+    private void writeJoinRow(Context context, String key, JoinValue row,
+                              boolean split)
+        throws IOException, InterruptedException {
+      if (!skewedKeys.contains(key)) {
+        context.write(new Text(key), row);
+      } else if (split) {
+        context.write(new Text(key + "~" + skewRandom.nextInt({{SKEW_SPLITS}})),
+                      row);
+      } else {
+        for (int split_index = 0; split_index < {{SKEW_SPLITS}}; split_index++) {
+          context.write(new Text(key + "~" + split_index), row);
+        }
+      }
+    }
+{{/SKEW_JOIN}}
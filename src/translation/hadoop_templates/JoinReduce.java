@@ -1,3 +1,24 @@
+{{#TYPED_ROWS}}
+      List<String[]> arrayLeft = new ArrayList<String[]>();
+      List<String[]> arrayRight = new ArrayList<String[]>();
+      for (JoinValue row : values) {
+        if (row.left) {
+          arrayLeft.add(row.cols);
+        } else {
+          arrayRight.add(row.cols);
+        }
+      }
+      for (String[] left : arrayLeft) {
+        for (String[] right : arrayRight) {
+          String[] {{OUTPUT_REL}} = new String[left.length + right.length];
+          System.arraycopy(left, 0, {{OUTPUT_REL}}, 0, left.length);
+          System.arraycopy(right, 0, {{OUTPUT_REL}}, left.length, right.length);
+          {{NEXT_OPERATOR}}
+          {{OUTPUT_CODE}}
+        }
+      }
+{{/TYPED_ROWS}}
+{{#TEXT_ROWS}}
       List<String> arrayLeft = new LinkedList<String>();
       List<String> arrayRight = new LinkedList<String>();
       for (Text text : values) {
@@ -15,3 +36,4 @@
           {{OUTPUT_CODE}}
         }
       }
+{{/TEXT_ROWS}}
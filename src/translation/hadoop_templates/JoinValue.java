@@ -0,0 +1,87 @@
+  // A row of either JOIN input in the shuffle. Integer columns are written in
+  // binary, using the input schemas, and all other values as strings. Rows
+  // with more or fewer columns than their schema are shipped unchanged.
+  public static class JoinValue implements Writable {
+
+    public boolean left;
+    public String[] cols;
+
+    public JoinValue() {
+    }
+
+    public JoinValue(boolean left, String[] cols) {
+      this.left = left;
+      this.cols = cols;
+    }
+
+    // Integers that print back as the same text are written in binary, any
+    // other value as a string, so that every row keeps its text.
+    static void writeInteger(DataOutput out, String value) throws IOException {
+      int parsed = 0;
+      boolean binary;
+      try {
+        parsed = Integer.parseInt(value);
+        binary = Integer.toString(parsed).equals(value);
+      } catch (NumberFormatException e) {
+        binary = false;
+      }
+      out.writeBoolean(binary);
+      if (binary) {
+        out.writeInt(parsed);
+      } else {
+        Text.writeString(out, value);
+      }
+    }
+
+    static String readInteger(DataInput in) throws IOException {
+      return in.readBoolean() ? Integer.toString(in.readInt()) :
+        Text.readString(in);
+    }
+
+    public void write(DataOutput out) throws IOException {
+      out.writeBoolean(left);
+      WritableUtils.writeVInt(out, cols.length);
+      int col = 0;
+      if (left) {
+{{#LEFT_COLS}}
+        if (col < cols.length) {
+          {{WRITE_CODE}};
+          col++;
+        }
+{{/LEFT_COLS}}
+      } else {
+{{#RIGHT_COLS}}
+        if (col < cols.length) {
+          {{WRITE_CODE}};
+          col++;
+        }
+{{/RIGHT_COLS}}
+      }
+      for (; col < cols.length; col++) {
+        Text.writeString(out, cols[col]);
+      }
+    }
+
+    public void readFields(DataInput in) throws IOException {
+      left = in.readBoolean();
+      cols = new String[WritableUtils.readVInt(in)];
+      int col = 0;
+      if (left) {
+{{#LEFT_COLS}}
+        if (col < cols.length) {
+          cols[col++] = {{READ_CODE}};
+        }
+{{/LEFT_COLS}}
+      } else {
+{{#RIGHT_COLS}}
+        if (col < cols.length) {
+          cols[col++] = {{READ_CODE}};
+        }
+{{/RIGHT_COLS}}
+      }
+      for (; col < cols.length; col++) {
+        cols[col] = Text.readString(in);
+      }
+    }
+
+  }
@@ -2,3 +2,6 @@
         context.write(new Text("ALL"),
                       new Text(String.valueOf(maxValue) + selectedCols));
       }
+      {{#MAP_AGGREGATION}}
+      flushMaxPartials(context);
+      {{/MAP_AGGREGATION}}
@@ -0,0 +1,11 @@
+      {{MAX_VALUE}}
+      String maxRow = null;
+      for (Text text : values) {
+        String[] row = text.toString().split(" ");
+        {{COL_TYPE}} value = {{COL_TYPE}}.valueOf(row[0]);
+        if (maxRow == null || maxValue.compareTo(value) < 0) {
+          maxValue = value;
+          maxRow = text.toString();
+        }
+      }
+      context.write(key, new Text(maxRow));
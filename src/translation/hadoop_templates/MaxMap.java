@@ -6,9 +6,22 @@
             {{GEN_SELECTED_COLS}}
           }
         } else {
-          Text newKey = new Text({{GROUP_BY_KEY}});
           {{GEN_SELECTED_COLS}}
+          {{#MAP_AGGREGATION}}
+          String groupKey = {{GROUP_BY_KEY}};
+          {{COL_TYPE}} partial = maxPartials.get(groupKey);
+          if (partial == null && maxPartials.size() >= {{MAX_GROUPS}}) {
+            flushMaxPartials(context);
+          }
+          if (partial == null || partial.compareTo(col_value) < 0) {
+            maxPartials.put(groupKey, col_value);
+            maxPartialCols.put(groupKey, selectedCols);
+          }
+          {{/MAP_AGGREGATION}}
+          {{#NO_MAP_AGGREGATION}}
+          Text newKey = new Text({{GROUP_BY_KEY}});
           context.write(newKey,
                         new Text(String.valueOf(col_value) + selectedCols));
+          {{/NO_MAP_AGGREGATION}}
         }
       }
@@ -1,2 +1,23 @@
     private {{COL_TYPE}} maxValue;
-    private String selectedCols;
\ No newline at end of file
+    private String selectedCols;
+
+{{#MAP_AGGREGATION}}
+    // The max value, and the columns selected with it, of the groups seen
+    // by this mapper.
+    private HashMap<String, {{COL_TYPE}}> maxPartials =
+      new HashMap<String, {{COL_TYPE}}>();
+    private HashMap<String, String> maxPartialCols =
+      new HashMap<String, String>();
+
+    private void flushMaxPartials(Context context)
+        throws IOException, InterruptedException {
+      for (java.util.Map.Entry<String, {{COL_TYPE}}> entry :
+             maxPartials.entrySet()) {
+        context.write(new Text(entry.getKey()),
+                      new Text(String.valueOf(entry.getValue()) +
+                               maxPartialCols.get(entry.getKey())));
+      }
+      maxPartials.clear();
+      maxPartialCols.clear();
+    }
+{{/MAP_AGGREGATION}}
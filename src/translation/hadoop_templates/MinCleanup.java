@@ -2,3 +2,6 @@
         context.write(new Text("ALL"),
                       new Text(String.valueOf(minValue) + selectedCols));
       }
+      {{#MAP_AGGREGATION}}
+      flushMinPartials(context);
+      {{/MAP_AGGREGATION}}
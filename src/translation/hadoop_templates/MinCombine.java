@@ -0,0 +1,11 @@
+      {{MIN_VALUE}}
+      String minRow = null;
+      for (Text text : values) {
+        String[] row = text.toString().split(" ");
+        {{COL_TYPE}} value = {{COL_TYPE}}.valueOf(row[0]);
+        if (minRow == null || minValue.compareTo(value) > 0) {
+          minValue = value;
+          minRow = text.toString();
+        }
+      }
+      context.write(key, new Text(minRow));
@@ -1,2 +1,23 @@
     private {{COL_TYPE}} minValue;
-    private String selectedCols;
\ No newline at end of file
+    private String selectedCols;
+
+{{#MAP_AGGREGATION}}
+    // The min value, and the columns selected with it, of the groups seen
+    // by this mapper.
+    private HashMap<String, {{COL_TYPE}}> minPartials =
+      new HashMap<String, {{COL_TYPE}}>();
+    private HashMap<String, String> minPartialCols =
+      new HashMap<String, String>();
+
+    private void flushMinPartials(Context context)
+        throws IOException, InterruptedException {
+      for (java.util.Map.Entry<String, {{COL_TYPE}}> entry :
+             minPartials.entrySet()) {
+        context.write(new Text(entry.getKey()),
+                      new Text(String.valueOf(entry.getValue()) +
+                               minPartialCols.get(entry.getKey())));
+      }
+      minPartials.clear();
+      minPartialCols.clear();
+    }
+{{/MAP_AGGREGATION}}
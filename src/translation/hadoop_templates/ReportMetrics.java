@@ -0,0 +1,43 @@
+  private static long taskSpanMs(org.apache.hadoop.mapreduce.TaskReport[] reports) {
+    long start = Long.MAX_VALUE;
+    long finish = 0;
+    for (org.apache.hadoop.mapreduce.TaskReport report : reports) {
+      start = Math.min(start, report.getStartTime());
+      finish = Math.max(finish, report.getFinishTime());
+    }
+    return finish > start ? finish - start : 0;
+  }
+
+  private static long counterValue(org.apache.hadoop.mapreduce.Counters counters,
+                                   String group, String name) {
+    org.apache.hadoop.mapreduce.Counter counter = counters.findCounter(group, name);
+    return counter == null ? 0 : counter.getValue();
+  }
+
+  // Prints the job's phase timings and data volumes for Musketeer.
+  private static void reportMetrics(Job job)
+      throws IOException, InterruptedException {
+    String taskCounters = "org.apache.hadoop.mapreduce.TaskCounter";
+    String fsCounters = "org.apache.hadoop.mapreduce.FileSystemCounter";
+    org.apache.hadoop.mapreduce.Counters counters = job.getCounters();
+    if (counters == null) {
+      return;
+    }
+    System.out.println("METRIC MAP MS: " + taskSpanMs(
+        job.getTaskReports(org.apache.hadoop.mapreduce.TaskType.MAP)));
+    System.out.println("METRIC BYTES IN: " +
+                       counterValue(counters, fsCounters, "HDFS_BYTES_READ"));
+    System.out.println("METRIC BYTES OUT: " +
+                       counterValue(counters, fsCounters, "HDFS_BYTES_WRITTEN"));
+    System.out.println("METRIC ROWS IN: " +
+                       counterValue(counters, taskCounters, "MAP_INPUT_RECORDS"));
+    if (job.getNumReduceTasks() > 0) {
+      System.out.println("METRIC REDUCE MS: " + taskSpanMs(
+          job.getTaskReports(org.apache.hadoop.mapreduce.TaskType.REDUCE)));
+      System.out.println("METRIC ROWS OUT: " +
+                         counterValue(counters, taskCounters, "REDUCE_OUTPUT_RECORDS"));
+    } else {
+      System.out.println("METRIC ROWS OUT: " +
+                         counterValue(counters, taskCounters, "MAP_OUTPUT_RECORDS"));
+    }
+  }
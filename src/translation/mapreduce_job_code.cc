@@ -87,6 +87,30 @@ namespace translator {
     return reduce_code.compare("");
   }
 
+  string MapReduceJobCode::get_combine_code() {
+    return combine_code;
+  }
+
+  void MapReduceJobCode::set_combine_code(string combine_code_) {
+    combine_code = combine_code_;
+  }
+
+  bool MapReduceJobCode::HasCombineCode() {
+    return combine_code.compare("");
+  }
+
+  string MapReduceJobCode::get_classes_code() {
+    return classes_code;
+  }
+
+  void MapReduceJobCode::set_classes_code(string classes_code_) {
+    classes_code = classes_code_;
+  }
+
+  bool MapReduceJobCode::HasClassesCode() {
+    return classes_code.compare("");
+  }
+
   void MapReduceJobCode::set_map_key_type(string type) {
     map_key_type = type;
   }
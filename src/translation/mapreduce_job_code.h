@@ -65,6 +65,14 @@ class MapReduceJobCode : public JobCode {
   string get_reduce_code();
   void set_reduce_code(string reduce_code_);
   bool HasReduceCode();
+  // Code that merges the map output values of a key before the shuffle.
+  string get_combine_code();
+  void set_combine_code(string combine_code_);
+  bool HasCombineCode();
+  // Classes the map and reduce code use, e.g. the Writable of the map output.
+  string get_classes_code();
+  void set_classes_code(string classes_code_);
+  bool HasClassesCode();
   void set_map_key_type(string type);
   void set_map_value_type(string type);
   void set_reduce_key_type(string type);
@@ -84,6 +92,8 @@ class MapReduceJobCode : public JobCode {
   string map_code;
   string cleanup_code;
   string reduce_code;
+  string combine_code;
+  string classes_code;
 };
 
 } // namespace translator
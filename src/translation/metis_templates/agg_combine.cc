@@ -0,0 +1,19 @@
+      if (vals_len > 1) {
+        std::vector<{{TYPE}}> {{OUTPUT_REL}}_partials({{NUM_AGG_COLS}}, {{INIT_VAL}});
+        for (uint64_t i = 0; i < vals_len; ++i) {
+          std::vector<std::string> cols = str_split(std::string((const char*)vals_in[i]), ' ');
+          for (uint32_t j = 0; j < {{NUM_AGG_COLS}}; ++j) {
+            {{OUTPUT_REL}}_partials[j] {{OPERATOR}}= ({{TYPE}})atof(cols[j].c_str());
+          }
+        }
+        std::ostringstream partial_str;
+        partial_str.precision(17);
+        for (uint32_t j = 0; j < {{NUM_AGG_COLS}}; ++j) {
+          if (j > 0) {
+            partial_str << " ";
+          }
+          partial_str << {{OUTPUT_REL}}_partials[j];
+        }
+        vals_in[0] = (void *)(new std::string(partial_str.str()))->c_str();
+        return 1;
+      }
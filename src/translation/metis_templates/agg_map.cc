@@ -0,0 +1,14 @@
+      for (relation_t::const_iterator pair_it = rel_{{REL_NAME}}.begin();
+           pair_it != rel_{{REL_NAME}}.end(); ++pair_it) {
+        const row_t* row_it = &pair_it->first;
+        if ({{CONDITION}}) {
+          std::string* {{OUTPUT_REL}}_key = new std::string("{{KEY_TAG}}");
+{{GROUP_BY_KEY}}
+          std::string* {{OUTPUT_REL}}_val = new std::string();
+{{AGG_VALUES}}
+          VLOG(3) << "emit from map: " << *{{OUTPUT_REL}}_key;
+          map_emit((void *){{OUTPUT_REL}}_key->c_str(),
+                   (void *){{OUTPUT_REL}}_val->c_str(),
+                   {{OUTPUT_REL}}_key->length());
+        }
+      }
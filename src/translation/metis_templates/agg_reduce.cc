@@ -0,0 +1,31 @@
+      VLOG(2) << "In reduce for key " << (char*)key_in;
+      // TODO(ionel): At the moment we only support Agg on multiple columns that
+      // have the same type.
+      std::vector<{{TYPE}}> {{OUTPUT_REL}}_aggs({{NUM_AGG_COLS}}, {{INIT_VAL}});
+      for (uint64_t i = 0; i < vals_len; ++i) {
+        std::vector<std::string> cols = str_split(std::string((const char*)vals_in[i]), ' ');
+        for (uint32_t j = 0; j < {{NUM_AGG_COLS}}; ++j) {
+          {{OUTPUT_REL}}_aggs[j] {{OPERATOR}}= ({{TYPE}})atof(cols[j].c_str());
+        }
+      }
+      // The output row holds the group by columns followed by the aggregates.
+      std::vector<std::string> {{OUTPUT_REL}}_cols =
+        str_split(std::string((const char*)key_in + strlen("{{KEY_TAG}}")), ' ');
+      for (uint32_t j = 0; j < {{NUM_AGG_COLS}}; ++j) {
+        std::ostringstream agg_str;
+        agg_str << {{OUTPUT_REL}}_aggs[j];
+        {{OUTPUT_REL}}_cols.push_back(agg_str.str());
+      }
+      row_t row;
+      uint32_t row_length = 0;
+      for (std::vector<std::string>::const_iterator col_it = {{OUTPUT_REL}}_cols.begin();
+           col_it != {{OUTPUT_REL}}_cols.end();
+           ++col_it) {
+        std::string* tmp_str = new std::string(*col_it);
+        row.push_back(tmp_str->c_str());
+        row_length += tmp_str->size();
+      }
+      relation_t rel_{{OUTPUT_REL}};
+      rel_{{OUTPUT_REL}}.push_back(std::make_pair(row, row_length));
+      {{NEXT_OPERATOR}}
+      {{OUTPUT_CODE}}
@@ -0,0 +1,452 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+// Reader and writer of the columnar format of intermediate relations. The
+// format is described in Musketeer's base/columnar_format.h.
+
+#ifndef METIS_GENERATED_COLUMNAR_H
+#define METIS_GENERATED_COLUMNAR_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef COLUMNAR_BLOCK_ROWS
+#define COLUMNAR_BLOCK_ROWS 65536
+#endif
+#ifndef COLUMNAR_COMPRESS
+#define COLUMNAR_COMPRESS 1
+#endif
+
+static const char columnar_magic[] = { '\x89', 'M', 'C', 'B' };
+
+static bool is_columnar(const char* data, size_t len) {
+  return len >= sizeof(columnar_magic) &&
+    memcmp(data, columnar_magic, sizeof(columnar_magic)) == 0;
+}
+
+static void columnar_put_u32(std::string* out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+static void columnar_put_u64(std::string* out, uint64_t value) {
+  columnar_put_u32(out, static_cast<uint32_t>(value >> 32));
+  columnar_put_u32(out, static_cast<uint32_t>(value));
+}
+
+static void columnar_put_varint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+static void columnar_put_string(std::string* out, const std::string& value) {
+  columnar_put_varint(out, value.size());
+  out->append(value);
+}
+
+static void columnar_put_double(std::string* out, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  columnar_put_u64(out, bits);
+}
+
+static uint64_t columnar_zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+    static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t columnar_unzigzag(uint64_t value) {
+  return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static std::string columnar_format_integer(int64_t value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+  return buf;
+}
+
+static std::string columnar_format_decimal(int64_t mantissa, uint32_t scale) {
+  uint64_t magnitude = mantissa < 0 ? ~static_cast<uint64_t>(mantissa) + 1 :
+    static_cast<uint64_t>(mantissa);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%llu",
+           static_cast<unsigned long long>(magnitude));
+  std::string digits = buf;
+  if (digits.size() <= scale) {
+    digits.insert(0, scale + 1 - digits.size(), '0');
+  }
+  if (scale > 0) {
+    digits.insert(digits.size() - scale, ".");
+  }
+  return mantissa < 0 ? "-" + digits : digits;
+}
+
+// Parses value as a decimal that prints back as the same text.
+static bool columnar_parse_decimal(const std::string& value, int64_t* mantissa,
+                                   uint32_t* scale) {
+  std::string digits;
+  size_t point = value.find('.');
+  *scale = point == std::string::npos ? 0 : value.size() - point - 1;
+  digits = point == std::string::npos ? value :
+    value.substr(0, point) + value.substr(point + 1);
+  if (digits.empty() || digits.size() > 19 || *scale > 255 ||
+      digits.find_first_not_of("-0123456789") != std::string::npos) {
+    return false;
+  }
+  errno = 0;
+  char* end = NULL;
+  long long parsed = strtoll(digits.c_str(), &end, 10);
+  if (errno != 0 || *end != '\0') {
+    return false;
+  }
+  *mantissa = parsed;
+  return columnar_format_decimal(*mantissa, *scale) == value;
+}
+
+// Appends the chunk of one column of a block to out.
+static void columnar_encode_chunk(const std::vector<std::string>& values,
+                                  bool compress, std::string* out) {
+  std::vector<int64_t> mantissas(values.size());
+  std::vector<uint32_t> scales(values.size());
+  bool is_decimal = true;
+  bool is_integer = true;
+  for (size_t i = 0; i < values.size() && is_decimal; ++i) {
+    is_decimal = columnar_parse_decimal(values[i], &mantissas[i], &scales[i]);
+    is_integer = is_integer && is_decimal && scales[i] == 0;
+  }
+  std::string data;
+  if (is_decimal) {
+    double min_value = 0;
+    double max_value = 0;
+    int64_t min_integer = 0;
+    int64_t max_integer = 0;
+    int64_t previous = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      double value = mantissas[i];
+      for (uint32_t s = 0; s < scales[i]; ++s) {
+        value /= 10;
+      }
+      if (i == 0 || value < min_value) {
+        min_value = value;
+      }
+      if (i == 0 || value > max_value) {
+        max_value = value;
+      }
+      if (i == 0 || mantissas[i] < min_integer) {
+        min_integer = mantissas[i];
+      }
+      if (i == 0 || mantissas[i] > max_integer) {
+        max_integer = mantissas[i];
+      }
+      if (!is_integer) {
+        data.push_back(static_cast<char>(scales[i]));
+      }
+      if (compress) {
+        columnar_put_varint(&data, columnar_zigzag(static_cast<int64_t>(
+            static_cast<uint64_t>(mantissas[i]) -
+            static_cast<uint64_t>(previous))));
+      } else {
+        columnar_put_u64(&data, static_cast<uint64_t>(mantissas[i]));
+      }
+      previous = mantissas[i];
+    }
+    out->push_back(is_integer ? 'i' : 'd');
+    out->push_back(compress ? 'z' : 'p');
+    if (is_integer) {
+      columnar_put_u64(out, static_cast<uint64_t>(min_integer));
+      columnar_put_u64(out, static_cast<uint64_t>(max_integer));
+    } else {
+      columnar_put_double(out, min_value);
+      columnar_put_double(out, max_value);
+    }
+  } else {
+    std::map<std::string, uint64_t> dict;
+    std::vector<const std::string*> dict_order;
+    size_t min_index = 0;
+    size_t max_index = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (values[i] < values[min_index]) {
+        min_index = i;
+      }
+      if (values[i] > values[max_index]) {
+        max_index = i;
+      }
+      if (compress && dict.insert(std::make_pair(values[i],
+                                                 dict_order.size())).second) {
+        dict_order.push_back(&values[i]);
+      }
+    }
+    bool use_dict = compress && dict_order.size() * 2 <= values.size();
+    if (use_dict) {
+      columnar_put_varint(&data, dict_order.size());
+      for (size_t i = 0; i < dict_order.size(); ++i) {
+        columnar_put_string(&data, *dict_order[i]);
+      }
+      for (size_t i = 0; i < values.size(); ++i) {
+        columnar_put_varint(&data, dict[values[i]]);
+      }
+    } else {
+      for (size_t i = 0; i < values.size(); ++i) {
+        columnar_put_string(&data, values[i]);
+      }
+    }
+    out->push_back('s');
+    out->push_back(use_dict ? 'k' : 'p');
+    columnar_put_string(out, values[min_index]);
+    columnar_put_string(out, values[max_index]);
+  }
+  columnar_put_u32(out, data.size());
+  out->append(data);
+}
+
+static bool columnar_write_block(
+    const std::vector<std::vector<std::string> >& columns, uint32_t num_rows,
+    FILE* out) {
+  std::string body;
+  for (size_t col = 0; col < columns.size(); ++col) {
+    columnar_encode_chunk(columns[col], COLUMNAR_COMPRESS, &body);
+  }
+  std::string block(columnar_magic, sizeof(columnar_magic));
+  columnar_put_u32(&block, num_rows);
+  columnar_put_u32(&block, columns.size());
+  columnar_put_u32(&block, body.size());
+  block.append(body);
+  return fwrite(block.data(), 1, block.size(), out) == block.size();
+}
+
+// Rewrites the text rows of text_filename in the columnar format.
+static bool columnar_encode_file(const char* text_filename,
+                                 const char* columnar_filename) {
+  FILE* in = fopen(text_filename, "r");
+  FILE* out = fopen(columnar_filename, "w");
+  if (!in || !out) {
+    fprintf(stderr, "unable to convert %s to %s: %s\n", text_filename,
+            columnar_filename, strerror(errno));
+    if (in)
+      fclose(in);
+    if (out)
+      fclose(out);
+    return false;
+  }
+  bool written = true;
+  std::vector<std::vector<std::string> > columns;
+  uint32_t num_rows = 0;
+  char* line = NULL;
+  size_t line_cap = 0;
+  ssize_t line_len;
+  while ((line_len = getline(&line, &line_cap, in)) != -1) {
+    if (line_len > 0 && line[line_len - 1] == '\n') {
+      line[--line_len] = '\0';
+    }
+    std::vector<std::string> values;
+    const char* value_start = line;
+    for (const char* c = line; ; ++c) {
+      if (*c == ' ' || c == line + line_len) {
+        values.push_back(std::string(value_start, c - value_start));
+        value_start = c + 1;
+        if (c == line + line_len)
+          break;
+      }
+    }
+    if (num_rows == COLUMNAR_BLOCK_ROWS ||
+        (num_rows > 0 && values.size() != columns.size())) {
+      written = written && columnar_write_block(columns, num_rows, out);
+      num_rows = 0;
+    }
+    if (num_rows == 0) {
+      columns.assign(values.size(), std::vector<std::string>());
+    }
+    for (size_t col = 0; col < values.size(); ++col) {
+      columns[col].push_back(values[col]);
+    }
+    ++num_rows;
+  }
+  if (num_rows > 0) {
+    written = written && columnar_write_block(columns, num_rows, out);
+  }
+  free(line);
+  fclose(in);
+  return fclose(out) == 0 && written;
+}
+
+static bool columnar_get_u32(const char** data, const char* end,
+                             uint32_t* value) {
+  if (end - *data < 4)
+    return false;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(*data);
+  *value = (static_cast<uint32_t>(bytes[0]) << 24) |
+    (static_cast<uint32_t>(bytes[1]) << 16) |
+    (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+  *data += 4;
+  return true;
+}
+
+static bool columnar_get_varint(const char** data, const char* end,
+                                uint64_t* value) {
+  *value = 0;
+  for (uint32_t shift = 0; shift < 64 && *data < end; shift += 7) {
+    unsigned char byte = static_cast<unsigned char>(*(*data)++);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static bool columnar_get_string(const char** data, const char* end,
+                                std::string* value) {
+  uint64_t length;
+  if (!columnar_get_varint(data, end, &length) ||
+      length > static_cast<uint64_t>(end - *data))
+    return false;
+  value->assign(*data, length);
+  *data += length;
+  return true;
+}
+
+static bool columnar_decode_chunk(const char** data, const char* end,
+                                  uint32_t num_rows,
+                                  std::vector<std::string>* values) {
+  if (end - *data < 2)
+    return false;
+  char type = *(*data)++;
+  char encoding = *(*data)++;
+  std::string bound;
+  if (type == 'i' || type == 'd') {
+    if (end - *data < 16)
+      return false;
+    *data += 16;
+  } else if (!columnar_get_string(data, end, &bound) ||
+             !columnar_get_string(data, end, &bound)) {
+    return false;
+  }
+  uint32_t data_bytes;
+  if (!columnar_get_u32(data, end, &data_bytes) ||
+      data_bytes > static_cast<uint64_t>(end - *data))
+    return false;
+  const char* chunk = *data;
+  const char* chunk_end = chunk + data_bytes;
+  *data = chunk_end;
+  if (type == 's') {
+    std::vector<std::string> dict;
+    if (encoding == 'k') {
+      uint64_t dict_size;
+      if (!columnar_get_varint(&chunk, chunk_end, &dict_size))
+        return false;
+      dict.resize(dict_size);
+      for (uint64_t i = 0; i < dict_size; ++i) {
+        if (!columnar_get_string(&chunk, chunk_end, &dict[i]))
+          return false;
+      }
+    }
+    for (uint32_t row = 0; row < num_rows; ++row) {
+      std::string value;
+      uint64_t index;
+      if (encoding == 'k') {
+        if (!columnar_get_varint(&chunk, chunk_end, &index) ||
+            index >= dict.size())
+          return false;
+        value = dict[index];
+      } else if (!columnar_get_string(&chunk, chunk_end, &value)) {
+        return false;
+      }
+      values->push_back(value);
+    }
+    return true;
+  }
+  uint64_t previous = 0;
+  for (uint32_t row = 0; row < num_rows; ++row) {
+    uint32_t scale = 0;
+    if (type == 'd') {
+      if (chunk == chunk_end)
+        return false;
+      scale = static_cast<unsigned char>(*chunk++);
+    }
+    uint64_t value;
+    if (encoding == 'z') {
+      if (!columnar_get_varint(&chunk, chunk_end, &value))
+        return false;
+      value = previous + static_cast<uint64_t>(columnar_unzigzag(value));
+    } else {
+      uint32_t high;
+      uint32_t low;
+      if (!columnar_get_u32(&chunk, chunk_end, &high) ||
+          !columnar_get_u32(&chunk, chunk_end, &low))
+        return false;
+      value = (static_cast<uint64_t>(high) << 32) | low;
+    }
+    previous = value;
+    values->push_back(type == 'i' ?
+                      columnar_format_integer(static_cast<int64_t>(value)) :
+                      columnar_format_decimal(static_cast<int64_t>(value),
+                                              scale));
+  }
+  return true;
+}
+
+// Writes the rows of the columnar data to out as lines of text, each
+// starting with prefix.
+static bool columnar_decode(const char* data, size_t len, FILE* out,
+                            const char* prefix) {
+  const char* end = data + len;
+  while (data < end) {
+    uint32_t num_rows;
+    uint32_t num_cols;
+    uint32_t body_bytes;
+    if (!is_columnar(data, end - data)) {
+      fprintf(stderr, "malformed columnar block\n");
+      return false;
+    }
+    data += sizeof(columnar_magic);
+    if (!columnar_get_u32(&data, end, &num_rows) ||
+        !columnar_get_u32(&data, end, &num_cols) ||
+        !columnar_get_u32(&data, end, &body_bytes) ||
+        body_bytes > static_cast<uint64_t>(end - data))
+      return false;
+    const char* body_end = data + body_bytes;
+    std::vector<std::vector<std::string> > columns(num_cols);
+    for (uint32_t col = 0; col < num_cols; ++col) {
+      if (!columnar_decode_chunk(&data, body_end, num_rows, &columns[col]))
+        return false;
+    }
+    data = body_end;
+    for (uint32_t row = 0; row < num_rows; ++row) {
+      fputs(prefix, out);
+      for (uint32_t col = 0; col < num_cols; ++col) {
+        if (col > 0)
+          fputc(' ', out);
+        fputs(columns[col][row].c_str(), out);
+      }
+      fputc('\n', out);
+    }
+  }
+  return true;
+}
+
+#endif  // METIS_GENERATED_COLUMNAR_H
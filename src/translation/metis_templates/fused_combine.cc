@@ -0,0 +1,7 @@
+      // Keys start with the tag of the pipeline that emitted them.
+      int32_t key_tag = atoi((const char*)key_in);
+      {{#COMBINE_PIPELINES}}
+      if (key_tag == {{KEY_TAG}}) {
+{{COMBINE_CODE}}
+      }
+      {{/COMBINE_PIPELINES}}
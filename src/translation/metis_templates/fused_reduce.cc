@@ -0,0 +1,13 @@
+      // Keys start with the tag of the pipeline that emitted them.
+      int32_t key_tag = atoi((const char*)key_in);
+      {{#REDUCE_PIPELINES}}
+      if (key_tag == {{KEY_TAG}}) {
+{{REDUCE_CODE}}
+      } else
+      {{/REDUCE_PIPELINES}}
+      {
+        // Rows of relations that are produced by the map.
+        for (uint64_t i = 0; i < vals_len; ++i) {
+          reduce_emit(key_in, vals_in[i]);
+        }
+      }
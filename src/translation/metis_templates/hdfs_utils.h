@@ -10,6 +10,7 @@
 
 #include "jni.h"
 #include "hdfs.h"
+#include "columnar.h"
 #include "utils.h"
 
 // Metis types
@@ -31,6 +32,43 @@ bool copyFileFromHDFS(hdfsFS distfs, const char* hdfs_filename, const char* loca
   return true;
 }
 
+// Returns true if the HDFS file is stored in the columnar format.
+static bool isColumnarHDFSFile(hdfsFS distfs, const char* hdfs_filename) {
+  hdfsFile hdfsInFD = hdfsOpenFile(distfs, hdfs_filename, O_RDONLY, 0, 0, 0);
+  if (!hdfsInFD) {
+    return false;
+  }
+  char magic[sizeof(columnar_magic)];
+  tSize bytes_read = hdfsRead(distfs, hdfsInFD, magic, sizeof(magic));
+  hdfsCloseFile(distfs, hdfsInFD);
+  return bytes_read > 0 && is_columnar(magic, bytes_read);
+}
+
+// Appends the rows of a columnar HDFS file to the local file as lines of text,
+// each starting with prefix.
+static bool decodeColumnarFileFromHDFS(hdfsFS distfs, const char* hdfs_filename,
+                                       FILE* localInFD, const char* prefix) {
+  hdfsFile hdfsInFD = hdfsOpenFile(distfs, hdfs_filename, O_RDONLY, 0, 0, 0);
+  if (!hdfsInFD) {
+    LOG(FATAL) << "Failed to open input file on HDFS!";
+    return false;
+  }
+  std::string data;
+  char buf[1 << 16];
+  tSize bytes_read;
+  while ((bytes_read = hdfsRead(distfs, hdfsInFD, buf, sizeof(buf))) > 0) {
+    data.append(buf, bytes_read);
+  }
+  hdfsCloseFile(distfs, hdfsInFD);
+  VLOG(1) << "Decoding " << data.size() << " columnar bytes of "
+          << hdfs_filename;
+  if (!columnar_decode(data.data(), data.size(), localInFD, prefix)) {
+    LOG(ERROR) << "Malformed columnar file " << hdfs_filename;
+    return false;
+  }
+  return true;
+}
+
 bool copyAndMergeFilesFromHDFSNoPrefix(std::vector<std::string>& files,
                                        const char* local_merged_filename) {
   hdfsFS distfs = hdfsConnect("freestyle.private.srg.cl.cam.ac.uk", 8020);  // XXX
@@ -44,8 +82,9 @@ bool copyAndMergeFilesFromHDFSNoPrefix(std::vector<std::string>& files,
     int32_t num_entries = 0;  // libHDFS expects a signed integer
     hdfsFileInfo* hdfs_info = hdfsListDirectory(distfs, path_it->c_str(), &num_entries);
     VLOG(1) << "NEXT INPUT: " << *path_it;
-    // Fast-path in the case of having only one file
-    if (num_entries == 1) {
+    // Fast-path in the case of having only one text file
+    if (num_entries == 1 &&
+        !isColumnarHDFSFile(distfs, hdfs_info[0].mName)) {
       VLOG(1) << "Only one input, so taking fast-path via hdfsCopy!";
       return copyFileFromHDFS(distfs, hdfs_info[0].mName, local_merged_filename);
     }
@@ -54,6 +93,13 @@ bool copyAndMergeFilesFromHDFSNoPrefix(std::vector<std::string>& files,
       if (hdfs_info[entry_id].mKind == kObjectKindDirectory) {
         continue;
       }
+      if (isColumnarHDFSFile(distfs, hdfs_info[entry_id].mName)) {
+        if (!decodeColumnarFileFromHDFS(distfs, hdfs_info[entry_id].mName,
+                                        localInFD, "")) {
+          return false;
+        }
+        continue;
+      }
       hdfsFile hdfsInFD = hdfsOpenFile(distfs, hdfs_info[entry_id].mName, O_RDONLY, 0, 0, 0);
       VLOG(2) << "hdfsOpen of " << hdfs_info[entry_id].mName << ": "
               << ((hdfsInFD == NULL) ? "FAILED" : "SUCCEEDED");
@@ -130,6 +176,15 @@ bool copyAndMergeFilesFromHDFS(std::vector<std::string>& files, const char* loca
       if (hdfs_info[entry_id].mKind == kObjectKindDirectory) {
         continue;
       }
+      if (isColumnarHDFSFile(distfs, hdfs_info[entry_id].mName)) {
+        std::stringstream prefix;
+        prefix << input_id << " ";
+        if (!decodeColumnarFileFromHDFS(distfs, hdfs_info[entry_id].mName,
+                                        localInFD, prefix.str().c_str())) {
+          return false;
+        }
+        continue;
+      }
       hdfsFile hdfsInFD = hdfsOpenFile(distfs, hdfs_info[entry_id].mName, O_RDONLY, 0, 0, 0);
       VLOG(2) << "hdfsOpen of " << hdfs_info[entry_id].mName << ": "
               << ((hdfsInFD == NULL) ? "FAILED" : "SUCCEEDED");
@@ -209,31 +264,92 @@ bool copyAndMergeFilesFromHDFS(std::vector<std::string>& files, const char* loca
   return true;
 }
 
-static void output_all_hdfs(xarray<keyval_t> *wc_vals, hdfsFS distfs,
+// Returns the local file to copy to HDFS: the text file, or its columnar
+// encoding if the relation is read by later jobs.
+static std::string output_file_to_copy(const std::string& local_text_filename,
+                                       bool columnar) {
+  if (!columnar) {
+    return local_text_filename;
+  }
+  std::string local_columnar_filename = local_text_filename + ".col";
+  if (!columnar_encode_file(local_text_filename.c_str(),
+                            local_columnar_filename.c_str())) {
+    LOG(ERROR) << "failed to encode " << local_text_filename
+               << ", writing it as text";
+    return local_text_filename;
+  }
+  report_metric("COLUMNAR BYTES OUT",
+                file_size(local_columnar_filename.c_str()));
+  return local_columnar_filename;
+}
+
+static bool output_all_hdfs(xarray<keyval_t> *wc_vals, hdfsFS distfs,
                             hdfsFS localfs,
                             const char* local_out_temp_filename,
-                            const char* hdfs_out_filename) {
+                            const char* hdfs_out_filename, bool columnar) {
   FILE* localOutFD = fopen(local_out_temp_filename, "w");
   if (!localOutFD) {
-    PLOG(FATAL) << "unable to open " << local_out_temp_filename << ": ";
+    PLOG(ERROR) << "unable to open " << local_out_temp_filename << ": ";
+    return false;
   }
   output_all_local(wc_vals, localOutFD);
   fclose(localOutFD);
-  if (hdfsCopy(localfs, local_out_temp_filename, distfs, hdfs_out_filename) != 0) {
-    LOG(ERROR) << "failed to copy output from " << local_out_temp_filename
+  std::string local_filename =
+    output_file_to_copy(local_out_temp_filename, columnar);
+  if (hdfsCopy(localfs, local_filename.c_str(), distfs,
+               hdfs_out_filename) != 0) {
+    LOG(ERROR) << "failed to copy output from " << local_filename
                << " to " << hdfs_out_filename << " on HDFS!";
+    return false;
   }
+  return true;
 }
 
-bool writeResultsToHDFS(const char* output_filename, xarray<keyval_t>* results) {
-  hdfsFile hdfsOutFD = NULL;
+// The local copies of the outputs are named after local_prefix, which must
+// be unique to the job because several jobs can run at the same time.
+bool writeResultsToHDFS(const char* local_prefix, const char* output_filename,
+                        xarray<keyval_t>* results, bool columnar) {
   hdfsFS distfs = hdfsConnect("freestyle.private.srg.cl.cam.ac.uk", 8020);  // XXX
   hdfsFS localfs = hdfsConnect(NULL, 0);
-  output_all_hdfs(results, distfs, localfs, "/tmp/metis.tmp", output_filename);
+  std::string local_filename = std::string(local_prefix) + ".tmp";
+  bool copied = output_all_hdfs(results, distfs, localfs,
+                                local_filename.c_str(), output_filename,
+                                columnar);
   /* clean up HDFS state */
   hdfsDisconnect(localfs);
   hdfsDisconnect(distfs);
-  return true;
+  return copied;
+}
+
+bool writeTaggedResultsToHDFS(const char* local_prefix,
+                              const std::vector<std::string>& output_filenames,
+                              const std::vector<bool>& output_columnar,
+                              xarray<keyval_t>* results) {
+  std::vector<std::string> local_filenames;
+  for (uint32_t i = 0; i < output_filenames.size(); i++) {
+    std::stringstream local_filename;
+    local_filename << local_prefix << "_" << i << ".tmp";
+    local_filenames.push_back(local_filename.str());
+  }
+  if (!output_tagged_local(results, local_filenames))
+    return false;
+  hdfsFS distfs = hdfsConnect("freestyle.private.srg.cl.cam.ac.uk", 8020);  // XXX
+  hdfsFS localfs = hdfsConnect(NULL, 0);
+  bool copied = true;
+  for (uint32_t i = 0; i < output_filenames.size(); i++) {
+    std::string local_filename =
+      output_file_to_copy(local_filenames[i], output_columnar[i]);
+    if (hdfsCopy(localfs, local_filename.c_str(), distfs,
+                 output_filenames[i].c_str()) != 0) {
+      LOG(ERROR) << "failed to copy output from " << local_filename
+                 << " to " << output_filenames[i] << " on HDFS!";
+      copied = false;
+    }
+  }
+  /* clean up HDFS state */
+  hdfsDisconnect(localfs);
+  hdfsDisconnect(distfs);
+  return copied;
 }
 
 #endif  // METIS_GENERATED_HDFS_UTILS_H
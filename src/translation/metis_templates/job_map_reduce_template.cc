@@ -44,6 +44,7 @@
 #include "bench.hh"
 
 #include <map>
+#include <set>
 #include <vector>
 
 //#define HEAP_PROFILE
@@ -63,6 +64,11 @@
 // Shared Musketeer utility functions
 #include "utils.h"
 
+// Rows per block and light compression of the relations the job writes in the
+// columnar format.
+#define COLUMNAR_BLOCK_ROWS {{COLUMNAR_BLOCK_ROWS}}
+#define COLUMNAR_COMPRESS {{COLUMNAR_COMPRESS}}
+
 #if USE_HDFS == 1
 // HDFS access support
 #include "hdfs_utils.h"
@@ -90,6 +96,7 @@ struct {{CLASS_NAME}} : public map_reduce {
     }
     int combine_function(void *key_in, void **vals_in, size_t vals_len) {
         assert(vals_in);
+{{COMBINE_CODE}}
         return vals_len;
     }
     void *key_copy(void *src, size_t s) {
@@ -127,12 +134,14 @@ struct {{CLASS_NAME}} : public map_reduce {
     {{MAP_VARIABLES_CODE}}
 };
 
-int main(int argc, char *argv[]) {
-    // Set up glog for logging output
-    google::InitGoogleLogging(argv[0]);
-
-    if (argc < 1)
+// Runs the job. A resident Metis worker loads the job as a shared library and
+// calls this function directly, so failures return a non-zero status instead
+// of exiting.
+extern "C" int musketeer_job_main(int argc, char *argv[]) {
+    if (argc < 1) {
 	usage(argv[0]);
+	return EXIT_FAILURE;
+    }
 
     const char* in_filename = "/tmp/{{CLASS_NAME}}_{{REL_NAME}}_in";
 
@@ -140,17 +149,24 @@ int main(int argc, char *argv[]) {
     options_t opts;
     opts.num_procs = 0;
     opts.num_map_tasks = 0;
-    opts.num_reduce_tasks = 0;
+    opts.num_reduce_tasks = {{NUM_REDUCE_TASKS}};
     opts.quiet = 1;
     opts.sort_direction = 0;  // default: ascending
     opts.sort_alpha = 0;
     opts.out_filename = "{{OUTPUT_PATH}}/part-r-00000";
-    process_options(argc, argv, &opts);
+    if (!process_options(argc, argv, &opts))
+        return EXIT_FAILURE;
 
     /* build collection of input paths */
     std::vector<std::string> input_paths;
     {{INPUT_PATH}}
 
+    /* jobs that produce several relations write one file per relation */
+    std::vector<std::string> out_filenames;
+    /* relations that later jobs read are written in the columnar format */
+    std::vector<bool> out_columnar;
+    {{OUTPUT_FILES}}
+
 #if USE_HDFS == 1
     /* suck input file from HDFS */
     timeval pull_start_time, pull_end_time;
@@ -163,8 +179,7 @@ int main(int argc, char *argv[]) {
           printf("Failed to load inputs from HDFS!\n");
     }
     gettimeofday(&pull_end_time, NULL);
-    uint64_t pull_time = pull_end_time.tv_sec - pull_start_time.tv_sec;
-    printf("PULLING DATA: %u\n", pull_time);
+    report_metric("PULL MS", elapsed_ms(pull_start_time, pull_end_time));
 #endif
 
     timeval load_start_time, load_end_time;
@@ -183,8 +198,8 @@ int main(int argc, char *argv[]) {
     app.set_reduce_task(opts.num_reduce_tasks);
     /* done loading, emit stats */
     gettimeofday(&load_end_time, NULL);
-    uint64_t load_time = load_end_time.tv_sec - load_start_time.tv_sec;
-    printf("LOADING DATA: %u\n", load_time);
+    report_metric("LOAD MS", elapsed_ms(load_start_time, load_end_time));
+    report_metric("BYTES IN", file_size(in_filename));
     /* go! */
     printf("starting MapReduce execution...\n");
     timeval run_start_time, run_end_time;
@@ -203,26 +218,39 @@ int main(int argc, char *argv[]) {
 #endif
     /* MR run done */
     gettimeofday(&run_end_time, NULL);
-    uint64_t run_time = run_end_time.tv_sec - run_start_time.tv_sec;
-    printf("RUN TIME: %u\n", run_time);
+    report_metric("RUN MS", elapsed_ms(run_start_time, run_end_time));
+    report_metric("ROWS OUT", app.results_.size());
     app.print_stats();
     /* prepare output file */
     if (!opts.quiet)
 	print_top(&app.results_, 10);
+    int status = 0;
 #if USE_HDFS == 1
     timeval push_start_time, push_end_time;
     gettimeofday(&push_start_time, NULL);
-    if (!writeResultsToHDFS(opts.out_filename, &app.results_))
+    if (!out_filenames.empty()) {
+      if (!writeTaggedResultsToHDFS("/tmp/{{CLASS_NAME}}_out", out_filenames,
+                                    out_columnar, &app.results_)) {
+          printf("Failed to write results out the HDFS!");
+          status = EXIT_FAILURE;
+      }
+    } else if (!writeResultsToHDFS("/tmp/{{CLASS_NAME}}_out", opts.out_filename,
+                                   &app.results_, {{COLUMNAR_OUTPUT}})) {
         printf("Failed to write results out the HDFS!");
+        status = EXIT_FAILURE;
+    }
     gettimeofday(&push_end_time, NULL);
-    uint64_t push_time = push_end_time.tv_sec - push_start_time.tv_sec;
-    printf("PUSHING DATA: %u\n", push_time);
+    report_metric("PUSH MS", elapsed_ms(push_start_time, push_end_time));
 #else
-    FILE* localOutFD = fopen(opts.out_filename, "w");
-    if (!localOutFD) {
+    FILE* localOutFD = NULL;
+    if (!out_filenames.empty()) {
+        printf("Now writing output to %zu local files...\n", out_filenames.size());
+        if (!output_tagged_local(&app.results_, out_filenames))
+            status = EXIT_FAILURE;
+    } else if (!(localOutFD = fopen(opts.out_filename, "w"))) {
 	fprintf(stderr, "unable to open %s: %s\n", opts.out_filename,
 		strerror(errno));
-	exit(EXIT_FAILURE);
+	status = EXIT_FAILURE;
     } else {
         printf("Now writing output to local file %s...\n", opts.out_filename);
         output_all_local(&app.results_, localOutFD);
@@ -232,5 +260,11 @@ int main(int argc, char *argv[]) {
     app.free_results();
     mapreduce_appbase::deinitialize();
 
-    return 0;
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    // Set up glog for logging output
+    google::InitGoogleLogging(argv[0]);
+    return musketeer_job_main(argc, argv);
 }
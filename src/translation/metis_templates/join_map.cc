@@ -1,25 +1,38 @@
       for (relation_t::const_iterator l_it = rel_{{LEFT_REL}}.begin();
            l_it != rel_{{LEFT_REL}}.end();
            ++l_it) {
-        std::string* {{LEFT_REL}}_tmp = new std::string("L");
-        for (int {{LEFT_REL}}_i = 0; {{LEFT_REL}}_i < l_it->size(); {{LEFT_REL}}_i++) {
+        std::string* {{LEFT_REL}}_tmp = new std::string("0");
+        for (int {{LEFT_REL}}_i = 0; {{LEFT_REL}}_i < l_it->first.size(); {{LEFT_REL}}_i++) {
           *{{LEFT_REL}}_tmp += " ";
-          *{{LEFT_REL}}_tmp += l_it->at({{LEFT_REL}}_i);
+          *{{LEFT_REL}}_tmp += l_it->first.at({{LEFT_REL}}_i);
         }
         VLOG(3) << "emit from map (L): " << *{{LEFT_REL}}_tmp;
-        map_emit((void *)l_it->at({{LEFT_INDEX}}),
-                 (void *){{LEFT_REL}}_tmp->c_str(), {{LEFT_REL}}_tmp->length());
+        {{#SKEW_JOIN}}
+        emit_{{OUTPUT_REL}}_row(l_it->first.at({{LEFT_INDEX}}),
+                                {{LEFT_REL}}_tmp->c_str(), {{SPLIT_LEFT}});
+        {{/SKEW_JOIN}}
+        {{#NO_SKEW_JOIN}}
+        const char* {{LEFT_REL}}_key = tag_key("{{KEY_TAG}}", l_it->first.at({{LEFT_INDEX}}));
+        map_emit((void *){{LEFT_REL}}_key,
+                 (void *){{LEFT_REL}}_tmp->c_str(), strlen({{LEFT_REL}}_key));
+        {{/NO_SKEW_JOIN}}
       }
       for (relation_t::const_iterator l_it = rel_{{RIGHT_REL}}.begin();
            l_it != rel_{{RIGHT_REL}}.end();
            ++l_it) {
-        std::string* {{RIGHT_REL}}_tmp = new std::string("R");
-        for (int {{RIGHT_REL}}_i = 0; {{RIGHT_REL}}_i < l_it->size(); {{RIGHT_REL}}_i++) {
+        std::string* {{RIGHT_REL}}_tmp = new std::string("1");
+        for (int {{RIGHT_REL}}_i = 0; {{RIGHT_REL}}_i < l_it->first.size(); {{RIGHT_REL}}_i++) {
           *{{RIGHT_REL}}_tmp += " ";
-          *{{RIGHT_REL}}_tmp += l_it->at({{RIGHT_REL}}_i);
+          *{{RIGHT_REL}}_tmp += l_it->first.at({{RIGHT_REL}}_i);
         }
         VLOG(3) << "emit from map (R): " << *{{RIGHT_REL}}_tmp;
-        map_emit((void *)l_it->at({{RIGHT_INDEX}}),
-                 (void *){{RIGHT_REL}}_tmp->c_str(), {{RIGHT_REL}}_tmp->length());
+        {{#SKEW_JOIN}}
+        emit_{{OUTPUT_REL}}_row(l_it->first.at({{RIGHT_INDEX}}),
+                                {{RIGHT_REL}}_tmp->c_str(), {{SPLIT_RIGHT}});
+        {{/SKEW_JOIN}}
+        {{#NO_SKEW_JOIN}}
+        const char* {{RIGHT_REL}}_key = tag_key("{{KEY_TAG}}", l_it->first.at({{RIGHT_INDEX}}));
+        map_emit((void *){{RIGHT_REL}}_key,
+                 (void *){{RIGHT_REL}}_tmp->c_str(), strlen({{RIGHT_REL}}_key));
+        {{/NO_SKEW_JOIN}}
       }
-
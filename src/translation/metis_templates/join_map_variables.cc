@@ -0,0 +1,27 @@
+{{#SKEW_JOIN}}
+    // Rows with a heavy join key are spread over {{SKEW_SPLITS}} reduce keys.
+    // The larger input's rows go to one of them, the other input's to all.
+    void emit_{{OUTPUT_REL}}_row(const char* value, const char* row, bool split) {
+      static const char* skewed[] = { {{SKEWED_KEYS}} };
+      static const std::set<std::string> skewed_keys(
+          skewed, skewed + sizeof(skewed) / sizeof(skewed[0]));
+      static __thread uint32_t next_split = 0;
+      std::string key = std::string("{{KEY_TAG}}") + value;
+      if (skewed_keys.find(value) == skewed_keys.end()) {
+        map_emit((void *)key.c_str(), (void *)row, key.length());
+      } else if (split) {
+        next_split = (next_split + 1) % {{SKEW_SPLITS}};
+        std::ostringstream split_key;
+        split_key << key << "~" << next_split;
+        map_emit((void *)split_key.str().c_str(), (void *)row,
+                 split_key.str().length());
+      } else {
+        for (uint32_t split_index = 0; split_index < {{SKEW_SPLITS}}; ++split_index) {
+          std::ostringstream split_key;
+          split_key << key << "~" << split_index;
+          map_emit((void *)split_key.str().c_str(), (void *)row,
+                   split_key.str().length());
+        }
+      }
+    }
+{{/SKEW_JOIN}}
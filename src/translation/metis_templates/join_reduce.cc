@@ -13,7 +13,7 @@
       }
       VLOG(2) << "reduce for key " << (char*)key_in << " has " << arrayLeft.size()
               << " left elements and " << arrayRight.size() << " right ones.";
-      std::vector<std::pair<std::vector<const char*>, uint32_t> > {{OUTPUT_REL}};
+      relation_t rel_{{OUTPUT_REL}};
       for (std::vector<const char*>::const_iterator l_it = arrayLeft.begin();
            l_it != arrayLeft.end();
            ++l_it) {
@@ -40,7 +40,7 @@
             row.push_back(tmp_str->c_str());
             row_length += tmp_str->size();
           }
-          {{OUTPUT_REL}}.push_back(std::make_pair(row, row_length));
+          rel_{{OUTPUT_REL}}.push_back(std::make_pair(row, row_length));
         }
       }
       {{NEXT_OPERATOR}}
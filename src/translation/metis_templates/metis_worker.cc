@@ -0,0 +1,117 @@
+// Copyright (c) 2015 Ionel Gog <ionel.gog@cl.cam.ac.uk>
+
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS FOR
+ * A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+// Resident Metis worker. It is linked against the Metis runtime (and
+// libhdfs) once, reads job requests from a named pipe and runs each job by
+// dlopen()ing the job's shared library. A request line holds the path of
+// the library followed by the job's options. The "METRIC" lines the job
+// prints and its exit status are written back on the response pipe.
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include <vector>
+
+typedef int (*job_main_t)(int argc, char* argv[]);
+
+static int RunJob(char* request) {
+  std::vector<char*> args;
+  for (char* arg = strtok(request, " \n"); arg != NULL;
+       arg = strtok(NULL, " \n")) {
+    args.push_back(arg);
+  }
+  if (args.empty()) {
+    return 127;
+  }
+  void* job = dlopen(args[0], RTLD_NOW | RTLD_LOCAL);
+  if (job == NULL) {
+    LOG(ERROR) << "Could not load " << args[0] << ": " << dlerror();
+    return 127;
+  }
+  int status = 127;
+  job_main_t job_main =
+    reinterpret_cast<job_main_t>(dlsym(job, "musketeer_job_main"));
+  if (job_main != NULL) {
+    // Reset getopt so that every job parses its own options.
+    optind = 0;
+    args.push_back(NULL);
+    status = job_main(args.size() - 1, &args[0]);
+  } else {
+    LOG(ERROR) << args[0] << " is not a Musketeer job: " << dlerror();
+  }
+  // Unload the job so that a rebuilt library at the same path is reloaded.
+  dlclose(job);
+  return status;
+}
+
+// Runs the job with its output captured so that the job's metrics can be
+// sent back with its exit status. The output is then copied to our log.
+static int RunJobAndReport(char* request, FILE* responses) {
+  fflush(stdout);
+  FILE* job_output = tmpfile();
+  int saved_stdout = dup(STDOUT_FILENO);
+  if (job_output == NULL || saved_stdout < 0) {
+    return RunJob(request);
+  }
+  dup2(fileno(job_output), STDOUT_FILENO);
+  int status = RunJob(request);
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+  rewind(job_output);
+  char* line = NULL;
+  size_t line_len = 0;
+  while (getline(&line, &line_len, job_output) != -1) {
+    fputs(line, stdout);
+    if (strncmp(line, "METRIC ", 7) == 0) {
+      fputs(line, responses);
+    }
+  }
+  free(line);
+  fclose(job_output);
+  return status;
+}
+
+int main(int argc, char* argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s request_pipe response_pipe\n", argv[0]);
+    return 1;
+  }
+  FILE* requests = fopen(argv[1], "r");
+  FILE* responses = fopen(argv[2], "w");
+  if (requests == NULL || responses == NULL) {
+    PLOG(ERROR) << "Could not open the worker pipes";
+    return 1;
+  }
+  fprintf(responses, "ready\n");
+  fflush(responses);
+  char request[65536];
+  while (fgets(request, sizeof(request), requests) != NULL) {
+    int status = RunJobAndReport(request, responses);
+    fflush(stdout);
+    fprintf(responses, "%d\n", status);
+    fflush(responses);
+  }
+  return 0;
+}
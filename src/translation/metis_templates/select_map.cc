@@ -1,22 +1,20 @@
-        relation_t* {{OUTPUT_REL}} = new relation_t;
-        if (!rel_{{REL_NAME}}.empty()) {
-          for (relation_t::iterator row_it = rel_{{REL_NAME}}.begin();
-               row_it != rel_{{REL_NAME}}.end(); ++row_it) {
-            if ({{CONDITION}}) {
-              uint32_t i = 0;
-              row_t row;
-              for (row_t::const_iterator col_it = row_it->begin();
-                   col_it != row_it->end();
-                   ++i, ++col_it) {
-                if ((1 << i) & {{COLUMN_MASK}}) {
-                  row.push_back(*col_it);
-                }
+        relation_t rel_{{OUTPUT_REL}};
+        for (relation_t::const_iterator pair_it = rel_{{REL_NAME}}.begin();
+             pair_it != rel_{{REL_NAME}}.end(); ++pair_it) {
+          const row_t* row_it = &pair_it->first;
+          if ({{CONDITION}}) {
+            row_t row;
+            uint32_t row_length = 0;
+            for (uint32_t i = 0; i < row_it->size(); ++i) {
+              if ((1 << i) & {{COLUMN_MASK}}) {
+                row.push_back(row_it->at(i));
+                row_length += strlen(row_it->at(i));
               }
-              {{OUTPUT_REL}}->push_back(row);
             }
+            rel_{{OUTPUT_REL}}.push_back(std::make_pair(row, row_length));
           }
-          VLOG(2) << "{{OUTPUT_REL}} of " << {{OUTPUT_REL}}->size() << " rows after project on {{REL_NAME}}";
         }
+        VLOG(2) << "{{OUTPUT_REL}} of " << rel_{{OUTPUT_REL}}.size() << " rows after select on {{REL_NAME}}";
         {{NEXT_OPERATOR}}
         {{OUTPUT_CODE}}
 
@@ -135,13 +135,17 @@ static void print_top(xarray<keyval_t> *wc_vals, size_t ndisp) {
     }
 }
 
-static void output_all(xarray<keyval_t> *wc_vals, hdfsFS fs, hdfsFile fout) {
+// Returns false if the results could not be written.
+static bool output_all(xarray<keyval_t> *wc_vals, hdfsFS fs, hdfsFile fout) {
     char buf[100];
     for (uint32_t i = 0; i < wc_vals->size(); i++) {
       keyval_t *w = wc_vals->at(i);
       sprintf(buf, "%s\n", (char *)w->val);
-      hdfsWrite(fs, fout, buf, strlen(buf));
+      if (hdfsWrite(fs, fout, buf, strlen(buf)) < 0) {
+        return false;
+      }
     }
+    return true;
 }
 
 static void usage(char *prog) {
@@ -156,18 +160,22 @@ static void usage(char *prog) {
     printf("  -o filename : save output to a file\n");
     printf("  -c sort_col : sort by column in input\n");
     printf("  -d direction : zero for ascending (default), non-zero for descending\n");
-    exit(EXIT_FAILURE);
 }
 
-int main(int argc, char *argv[]) {
+// Runs the job. A resident Metis worker loads the job as a shared library and
+// calls this function directly, so failures return a non-zero status instead
+// of exiting.
+extern "C" int musketeer_job_main(int argc, char *argv[]) {
     int nprocs = 0, map_tasks = 0, ndisp = 5, reduce_tasks = 0;
     int quiet = 0;
     int c;
     int sort_column = 0;
     int direction = 0;  // ASC by default
     int alphanumeric = 0;
-    if (argc < 1)
+    if (argc < 1) {
       usage(argv[0]);
+      return EXIT_FAILURE;
+    }
     char* fn = "/tmp/{{CLASS_NAME}}_{{REL_NAME}}_in";
     char* outfn = "{{OUTPUT_PATH}}/part-r-00000";
     hdfsFile fout = NULL;
@@ -177,6 +185,12 @@ int main(int argc, char *argv[]) {
     hdfsFS localfs = hdfsConnect(NULL, 0);
     int res = hdfsCopy(fs, "{{INPUT_PATH}}", localfs, fn);
     printf("hdfsCopy: %d\n", res);
+    if (res != 0) {
+      fprintf(stderr, "unable to copy {{INPUT_PATH}} to %s\n", fn);
+      hdfsDisconnect(fs);
+      hdfsDisconnect(localfs);
+      return EXIT_FAILURE;
+    }
 
     while ((c = getopt(argc, argv, "p:s:l:m:r:qao:c:d:")) != -1) {
       switch (c) {
@@ -209,16 +223,19 @@ int main(int argc, char *argv[]) {
         break;
       default:
         usage(argv[0]);
-        exit(EXIT_FAILURE);
-        break;
+        hdfsDisconnect(fs);
+        hdfsDisconnect(localfs);
+        return EXIT_FAILURE;
       }
     }
     /* prepare output file */
     fout = hdfsOpenFile(fs, outfn, O_WRONLY | O_CREAT, 0, 0, 0);
     if (!fout) {
-      fprintf(stderr, "unable to open %s: %s\n", optarg,
+      fprintf(stderr, "unable to open %s: %s\n", outfn,
               strerror(errno));
-      exit(EXIT_FAILURE);
+      hdfsDisconnect(fs);
+      hdfsDisconnect(localfs);
+      return EXIT_FAILURE;
     }
     mapreduce_appbase::initialize();
     /* get input file */
@@ -235,14 +252,23 @@ int main(int argc, char *argv[]) {
     /* get the number of results to display */
     if (!quiet)
       print_top(&app.results_, ndisp);
-    if (fout) {
-      output_all(&app.results_, fs, fout);
-      hdfsCloseFile(fs, fout);
+    int status = 0;
+    if (!output_all(&app.results_, fs, fout)) {
+      fprintf(stderr, "unable to write %s\n", outfn);
+      status = EXIT_FAILURE;
+    }
+    if (hdfsCloseFile(fs, fout) != 0) {
+      fprintf(stderr, "unable to close %s\n", outfn);
+      status = EXIT_FAILURE;
     }
     app.free_results();
     mapreduce_appbase::deinitialize();
     /* Clean up HDFS state */
     hdfsDisconnect(fs);
     hdfsDisconnect(localfs);
-    return 0;
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    return musketeer_job_main(argc, argv);
 }
@@ -28,6 +28,10 @@
 #define input_id_num_cols(I) __input_ ## I ## _num_cols;
 #define input_name_num_cols(N) __ ## N ## _num_cols;
 
+// A row and the number of characters in its columns.
+typedef std::vector<const char*> row_t;
+typedef std::vector<std::pair<row_t, uint32_t> > relation_t;
+
 typedef struct {
   uint32_t num_procs;
   uint32_t num_map_tasks;
@@ -38,6 +42,22 @@ typedef struct {
   char* out_filename;
 } options_t;
 
+// Reports a metric in the "METRIC NAME: value" format Musketeer collects
+// from every job.
+static void report_metric(const char* name, uint64_t value) {
+  printf("METRIC %s: %ju\n", name, (uintmax_t)value);
+}
+
+static uint64_t elapsed_ms(const timeval& start, const timeval& end) {
+  return (end.tv_sec - start.tv_sec) * 1000 +
+    (end.tv_usec - start.tv_usec) / 1000;
+}
+
+static uint64_t file_size(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
 static void usage(char *prog) {
     printf("usage: %s [options]\n", prog);
     printf("options:\n");
@@ -48,11 +68,12 @@ static void usage(char *prog) {
     printf("  -a : alphanumeric sort\n");
     printf("  -o filename : save output to a file\n");
     printf("  -d sort_direction : zero for ascending (default), non-zero for descending\n");
-    exit(EXIT_FAILURE);
 }
 
 
-static void process_options(int argc, char* argv[], options_t* opts) {
+// Returns false if an option is invalid. Jobs run inside a resident worker,
+// so they must not exit.
+static bool process_options(int argc, char* argv[], options_t* opts) {
   int c;
   while ((c = getopt(argc, argv, "p:s:m:r:qao:c:d:")) != -1) {
     switch (c) {
@@ -79,10 +100,10 @@ static void process_options(int argc, char* argv[], options_t* opts) {
       break;
     default:
       usage(argv[0]);
-      exit(EXIT_FAILURE);
-      break;
+      return false;
     }
   }
+  return true;
 }
 
 struct split_numbers {
@@ -169,6 +190,19 @@ std::vector<const char*> cstr_split(char* s, char delim) {
 }
 
 
+// Prefixes a map output key with the tag of the fused pipeline that emits it,
+// so that pipelines sharing a job reduce their keys separately.
+static const char* tag_key(const char* tag, const char* key) {
+  if (tag[0] == '\0') {
+    return key;
+  }
+  size_t tag_len = strlen(tag);
+  char* tagged_key = safe_malloc<char>(tag_len + strlen(key) + 1);
+  strcpy(tagged_key, tag);
+  strcpy(tagged_key + tag_len, key);
+  return tagged_key;
+}
+
 static void print_top(xarray<keyval_t> *wc_vals, size_t ndisp) {
   printf("\nresults (TOP %zd from %zu keys):\n",
          ndisp, wc_vals->size());
@@ -199,4 +233,33 @@ static void output_all_local(xarray<keyval_t> *wc_vals, FILE* fout) {
   fwrite(&output_buffer[0], filled_up_to, 1, fout);
 }
 
+// Writes the rows of a job that produces several relations. Every row starts
+// with the index of its relation in out_filenames, which is stripped.
+static bool output_tagged_local(xarray<keyval_t> *wc_vals,
+                                const std::vector<std::string>& out_filenames) {
+  printf("writing out %jd rows to %zu relations\n", wc_vals->size(),
+         out_filenames.size());
+  std::vector<FILE*> fouts;
+  for (uint32_t i = 0; i < out_filenames.size(); i++) {
+    FILE* fout = fopen(out_filenames[i].c_str(), "w");
+    if (!fout) {
+      fprintf(stderr, "unable to open %s: %s\n", out_filenames[i].c_str(),
+              strerror(errno));
+      return false;
+    }
+    fouts.push_back(fout);
+  }
+  for (uint32_t i = 0; i < wc_vals->size(); i++) {
+    char* row = (char*)wc_vals->at(i)->val;
+    char* row_start = NULL;
+    uint32_t out_index = strtoul(row, &row_start, 10);
+    assert(out_index < fouts.size() && *row_start == ' ');
+    fprintf(fouts[out_index], "%s\n", row_start + 1);
+  }
+  for (uint32_t i = 0; i < fouts.size(); i++) {
+    fclose(fouts[i]);
+  }
+  return true;
+}
+
 #endif  // METIS_GENERATED_UTILS_H
@@ -29,6 +29,7 @@ namespace Musketeer {
     public string Usage {get {return "";} }
 
     public void Execute(string[] args) {
+      var stopwatch = Stopwatch.StartNew();
       using (var computation = NewComputation.FromArgs(ref args)) {
         {{VARS_DECLARATION}}
         {{INPUT_VARS}}
@@ -37,6 +38,7 @@ namespace Musketeer {
           computation.Configuration.WorkerCount;
         {{OUTPUT_CODE}}
         computation.Activate();
+        long loadMs = stopwatch.ElapsedMilliseconds;
         if (computation.Configuration.ProcessID == 0) {
           {{ON_COMPLETED_MASTER}}
         } else {
@@ -44,6 +46,9 @@ namespace Musketeer {
         }
         computation.Join();
         {{OUTPUT_CLOSE_CODE}}
+        // Every process reports its own timings. Musketeer keeps the slowest.
+        Console.WriteLine("METRIC LOAD MS: " + loadMs);
+        Console.WriteLine("METRIC RUN MS: " + (stopwatch.ElapsedMilliseconds - loadMs));
       }
     }
 
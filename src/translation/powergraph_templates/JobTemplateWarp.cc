@@ -16,9 +16,11 @@
  * permissions and limitations under the License.
  */
 
+#include <hdfs.h>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <sys/time.h>
 
 #include <graphlab.hpp>
@@ -33,6 +35,14 @@ typedef {{VERTEX_DATA_TYPE}} vertex_data_type;
 typedef {{EDGE_DATA_TYPE}} edge_data_type;
 typedef distributed_graph<vertex_data_type, edge_data_type> graph_type;
 
+#define BUF_LEN 65536
+
+// The partitioned graph is saved on the local disk of every process and is
+// reused for as long as the edges relation and the number of processes stay
+// the same. Only the vertex values are reloaded from HDFS in that case.
+const bool kCachePartitions = {{CACHE_PARTITIONS}};
+const string kCachePrefix = "{{TMP_ROOT}}{{EDGES_PATH}}partitions";
+
 bool line_edge_cost_parser(graph_type& graph, const std::string& filename,
                            const std::string& textline) {
   vertex_id_type v_src;
@@ -70,6 +80,176 @@ bool vertices_parser(graph_type& graph, const std::string& filename,
   return true;
 }
 
+// Returns a stamp that changes whenever a file of the relation is added,
+// removed or rewritten.
+string relation_version(hdfsFS& distfs, const string& path_name,
+                        size_t num_procs) {
+  int num_entries = 0;
+  hdfsFileInfo* hdfs_info =
+    hdfsListDirectory(distfs, path_name.c_str(), &num_entries);
+  stringstream version;
+  version << "procs " << num_procs << "\n";
+  for (int entry = 0; entry < num_entries; entry++) {
+    version << hdfs_info[entry].mName << " " << hdfs_info[entry].mSize
+            << " " << hdfs_info[entry].mLastMod << "\n";
+  }
+  if (hdfs_info != NULL) {
+    hdfsFreeFileInfo(hdfs_info, num_entries);
+  }
+  return version.str();
+}
+
+string cache_file_name(procid_t procid, const string& suffix) {
+  stringstream file_name;
+  file_name << kCachePrefix << procid << suffix;
+  return file_name.str();
+}
+
+bool partitions_up_to_date(procid_t procid, const string& version) {
+  if (!kCachePartitions) {
+    return false;
+  }
+  ifstream version_stream(cache_file_name(procid, ".version").c_str());
+  ifstream binary_stream(cache_file_name(procid, ".bin").c_str());
+  if (!version_stream.good() || !binary_stream.good()) {
+    return false;
+  }
+  stringstream cached_version;
+  cached_version << version_stream.rdbuf();
+  return cached_version.str() == version;
+}
+
+// The cache can only be used if every process has its partition.
+bool all_processes_agree(distributed_control& dc, bool local_value) {
+  size_t num_agree = local_value ? 1 : 0;
+  dc.all_reduce(num_agree);
+  return num_agree == dc.numprocs();
+}
+
+void save_partitions(distributed_control& dc, graph_type* graph,
+                     const string& version) {
+  string make_dir = "mkdir -p {{TMP_ROOT}}{{EDGES_PATH}}";
+  system(make_dir.c_str());
+  graph->save_binary(kCachePrefix);
+  ofstream version_stream(cache_file_name(dc.procid(), ".version").c_str());
+  version_stream << version;
+  version_stream.close();
+}
+
+graph_type* load_text_graph(distributed_control& dc,
+                            command_line_options& clopts,
+                            const string& graph_dir,
+                            const string& vertices_dir) {
+  graph_type* graph = new graph_type(dc, clopts);
+  graph->load(vertices_dir, vertices_parser);
+  if ({{HAS_EDGE_COST}}) {
+    graph->load(graph_dir, line_edge_cost_parser);
+  } else {
+    graph->load(graph_dir, line_parser);
+  }
+  graph->finalize();
+  return graph;
+}
+
+void set_vertex_value(graph_type* graph, const char* line,
+                      size_t* num_values, size_t* num_owned) {
+  vertex_id_type v_id;
+  vertex_data_type v_val;
+  std::stringstream line_stream(line);
+  line_stream >> v_id >> v_val;
+  if (line_stream.fail()) {
+    return;
+  }
+  (*num_values)++;
+  if (graph->contains_vertex(v_id)) {
+    graph_type::lvid_type lvid = graph->local_vid(v_id);
+    graph->l_vertex(lvid).data() = v_val;
+    if (graph->l_vertex(lvid).owned()) {
+      (*num_owned)++;
+    }
+  }
+}
+
+// Overwrites the values of the cached vertices with the ones stored in the
+// vertices relation. Every process reads the whole relation and updates the
+// vertices it has a replica of. Returns false if the relation contains
+// vertices that are not in the cached graph.
+bool reload_vertex_values(distributed_control& dc, hdfsFS& distfs,
+                          graph_type* graph, const string& path_name) {
+  size_t num_values = 0;
+  size_t num_owned = 0;
+  int num_entries = 0;
+  hdfsFileInfo* hdfs_info =
+    hdfsListDirectory(distfs, path_name.c_str(), &num_entries);
+  for (int entry = 0; entry < num_entries; entry++) {
+    if (hdfs_info[entry].mKind == kObjectKindDirectory) {
+      continue;
+    }
+    hdfsFile in_file =
+      hdfsOpenFile(distfs, hdfs_info[entry].mName, O_RDONLY, 0, 0, 0);
+    if (!in_file) {
+      dc.cout() << "Failed to open " << hdfs_info[entry].mName << endl;
+      continue;
+    }
+    char buf[BUF_LEN + 1];
+    string partial_line;
+    tSize read_size;
+    while ((read_size = hdfsRead(distfs, in_file, buf, BUF_LEN)) > 0) {
+      buf[read_size] = '\0';
+      char* line_start = buf;
+      char* line_end;
+      while ((line_end = strchr(line_start, '\n')) != NULL) {
+        *line_end = '\0';
+        partial_line += line_start;
+        set_vertex_value(graph, partial_line.c_str(), &num_values, &num_owned);
+        partial_line.clear();
+        line_start = line_end + 1;
+      }
+      partial_line += line_start;
+    }
+    if (!partial_line.empty()) {
+      set_vertex_value(graph, partial_line.c_str(), &num_values, &num_owned);
+    }
+    hdfsCloseFile(distfs, in_file);
+  }
+  if (hdfs_info != NULL) {
+    hdfsFreeFileInfo(hdfs_info, num_entries);
+  }
+  dc.all_reduce(num_owned);
+  return num_owned == num_values;
+}
+
+// Loads the graph from the local partition cache when it is up to date and
+// falls back to parsing and partitioning the relations otherwise.
+graph_type* load_graph(distributed_control& dc, command_line_options& clopts,
+                       const string& graph_dir, const string& vertices_dir) {
+  hdfsFS distfs = hdfsConnect("{{HDFS_HOST}}", {{HDFS_PORT}});
+  if (!distfs) {
+    dc.cout() << "Failed to connect to HDFS, not using the cache" << endl;
+    return load_text_graph(dc, clopts, graph_dir, vertices_dir);
+  }
+  string version =
+    relation_version(distfs, "{{EDGES_PATH}}", dc.numprocs());
+  graph_type* graph = NULL;
+  if (all_processes_agree(dc, partitions_up_to_date(dc.procid(), version))) {
+    graph = new graph_type(dc, clopts);
+    if (all_processes_agree(dc, graph->load_binary(kCachePrefix)) &&
+        reload_vertex_values(dc, distfs, graph, "{{VERTICES_PATH}}")) {
+      dc.cout() << "Reusing partitions from " << kCachePrefix << endl;
+      hdfsDisconnect(distfs);
+      return graph;
+    }
+    dc.cout() << "Cached partitions are stale, repartitioning" << endl;
+    delete graph;
+  }
+  graph = load_text_graph(dc, clopts, graph_dir, vertices_dir);
+  if (kCachePartitions) {
+    save_partitions(dc, graph, version);
+  }
+  hdfsDisconnect(distfs);
+  return graph;
+}
+
 void combiner(vertex_data_type& a, const vertex_data_type& b) {
   {{COMBINER}}
 }
@@ -120,14 +300,8 @@ int main(int argc, char** argv) {
     dc.cout() << "Error in parsing command line arguments." << endl;
     return EXIT_FAILURE;
   }
-  graph_type graph(dc, clopts);
-  graph.load(output_dir, vertices_parser);
-  if ({{HAS_EDGE_COST}}) {
-    graph.load(graph_dir, line_edge_cost_parser);
-  } else {
-    graph.load(graph_dir, line_parser);
-  }
-  graph.finalize();
+  graph_type* graph_ptr = load_graph(dc, clopts, graph_dir, output_dir);
+  graph_type& graph = *graph_ptr;
   timeval end_pulling;
   gettimeofday(&end_pulling, NULL);
   dc.cout() << "#vertices: " << graph.num_vertices() << endl
@@ -144,15 +318,19 @@ int main(int argc, char** argv) {
              false);   // do not save edges
   timeval end_pushing;
   gettimeofday(&end_pushing, NULL);
-  long load_time = end_pulling.tv_sec - start_pulling.tv_sec;
-  long run_time = start_pushing.tv_sec - end_pulling.tv_sec;
-  long time_pushing = end_pushing.tv_sec - start_pushing.tv_sec;
-  char hostname[256];
-  gethostname(hostname, sizeof(hostname));
-  std::cout << "LOADING DATA ON " << hostname << ": " << load_time << std::endl;
-  std::cout << "RUN TIME ON " << hostname << ": " << run_time << std::endl;
-  std::cout << "PUSHING DATA ON " << hostname << ": " << time_pushing <<
-    std::endl;
+  long load_time = (end_pulling.tv_sec - start_pulling.tv_sec) * 1000 +
+    (end_pulling.tv_usec - start_pulling.tv_usec) / 1000;
+  long run_time = (start_pushing.tv_sec - end_pulling.tv_sec) * 1000 +
+    (start_pushing.tv_usec - end_pulling.tv_usec) / 1000;
+  long time_pushing = (end_pushing.tv_sec - start_pushing.tv_sec) * 1000 +
+    (end_pushing.tv_usec - start_pushing.tv_usec) / 1000;
+  // Every process reports its own timings. Musketeer keeps the slowest.
+  std::cout << "METRIC LOAD MS: " << load_time << std::endl;
+  std::cout << "METRIC RUN MS: " << run_time << std::endl;
+  std::cout << "METRIC PUSH MS: " << time_pushing << std::endl;
+  std::cout << "METRIC ROWS IN: " << graph.num_edges() << std::endl;
+  std::cout << "METRIC ROWS OUT: " << graph.num_vertices() << std::endl;
+  delete graph_ptr;
   mpi_tools::finalize();
   return EXIT_SUCCESS;
 }
@@ -148,15 +148,18 @@ int main(int argc, char** argv) {
              false);   // do not save edges
   timeval end_pushing;
   gettimeofday(&end_pushing, NULL);
-  long load_time = end_pulling.tv_sec - start_pulling.tv_sec;
-  long run_time = start_pushing.tv_sec - end_pulling.tv_sec;
-  long time_pushing = end_pushing.tv_sec - start_pushing.tv_sec;
-  char hostname[256];
-  gethostname(hostname, sizeof(hostname));
-  std::cout << "LOADING DATA ON " << hostname << ": " << load_time << std::endl;
-  std::cout << "RUN TIME ON " << hostname << ": " << run_time << std::endl;
-  std::cout << "PUSHING DATA ON " << hostname << ": " << time_pushing <<
-    std::endl;
+  long load_time = (end_pulling.tv_sec - start_pulling.tv_sec) * 1000 +
+    (end_pulling.tv_usec - start_pulling.tv_usec) / 1000;
+  long run_time = (start_pushing.tv_sec - end_pulling.tv_sec) * 1000 +
+    (start_pushing.tv_usec - end_pulling.tv_usec) / 1000;
+  long time_pushing = (end_pushing.tv_sec - start_pushing.tv_sec) * 1000 +
+    (end_pushing.tv_usec - start_pushing.tv_usec) / 1000;
+  // Every process reports its own timings. Musketeer keeps the slowest.
+  std::cout << "METRIC LOAD MS: " << load_time << std::endl;
+  std::cout << "METRIC RUN MS: " << run_time << std::endl;
+  std::cout << "METRIC PUSH MS: " << time_pushing << std::endl;
+  std::cout << "METRIC ROWS IN: " << graph.num_edges() << std::endl;
+  std::cout << "METRIC ROWS OUT: " << graph.num_vertices() << std::endl;
   mpi_tools::finalize();
   return EXIT_SUCCESS;
 }
@@ -1,4 +1,4 @@
 val keyed_{{CLASS_NAME}}:org.apache.spark.rdd.RDD[({{GROUP_BY}}, {{INPUTREL_TYPE}})] = {{CONDITION}}.{{GROUP_BY_KEY}}
-val int_{{OUTPUT}} = keyed_{{CLASS_NAME}}.reduceByKey((e1, e2) => {{AGG}})
+val int_{{OUTPUT}} = keyed_{{CLASS_NAME}}.reduceByKey((e1, e2) => {{AGG}}, {{NUM_PARTITIONS}})
 {{OUTPUT}} = int_{{OUTPUT}}.map(({{INPUT}} => { {{NEXT_OPERATOR}} })){{TO_CACHE}}
 
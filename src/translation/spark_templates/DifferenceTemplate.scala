@@ -1,2 +1,2 @@
-{{OUTPUT}} = {{REL_NAME}}.subtract({{REL_NAME2}}){{TO_CACHE}}
+{{OUTPUT}} = {{REL_NAME}}.subtract({{REL_NAME2}}, {{NUM_PARTITIONS}}){{TO_CACHE}}
 
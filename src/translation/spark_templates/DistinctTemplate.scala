@@ -1,2 +1,2 @@
-{{OUTPUT}} = {{REL_NAME}}.distinct(){{TO_CACHE}}
+{{OUTPUT}} = {{REL_NAME}}.distinct({{NUM_PARTITIONS}}){{TO_CACHE}}
 
@@ -4,10 +4,17 @@ import java.lang.Number
 
 object {{CLASS_NAME}} {
  def main(args:Array[String]) {
-  System.setProperty("spark.default.parallelism", "180")
+  val musketeer_start_ms = System.currentTimeMillis()
+  System.setProperty("spark.default.parallelism", "{{DEFAULT_PARALLELISM}}")
   System.setProperty("spark.worker.timeout", "60000")
   System.setProperty("spark.akka.timeout", "60000")
   System.setProperty("spark.storage.blockManagerHeartBeatMs", "60000")
   System.setProperty("spark.akka.storage.retry.wait", "60000")
   System.setProperty("spark.akka.frameSize", "10000")
   val sc = new SparkContext( "{{SPARK_MASTER}}","main_spark","{{SPARK_DIR}}",Seq("{{BIN_NAME}}"));
+  // Metrics reported to Musketeer when the job ends.
+  val musketeer_load_ms = System.currentTimeMillis() - musketeer_start_ms
+  val musketeer_rows_in = sc.accumulator(0L)
+  val musketeer_bytes_in = sc.accumulator(0L)
+  val musketeer_rows_out = sc.accumulator(0L)
+  val musketeer_bytes_out = sc.accumulator(0L)
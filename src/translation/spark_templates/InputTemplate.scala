@@ -1,5 +1,7 @@
   var {{REL_NAME}}_st = sc.textFile("{{HDFS_MASTER}}{{INPUT_PATH}}")
   var {{REL_NAME}} = {{REL_NAME}}_st.map((line:String) => {
+    musketeer_rows_in += 1
+    musketeer_bytes_in += line.length + 1
     var splitted:Array[String] = line.split(" ");
     {{ARGS}}
   }){{TO_CACHE}}
@@ -1,3 +1,3 @@
-val diff = {{REL_NAME}}.subtract({{REL_NAME2}})
-{{OUTPUT}} = {{REL_NAME}}.subtract(diff){{TO_CACHE}}
+val diff = {{REL_NAME}}.subtract({{REL_NAME2}}, {{NUM_PARTITIONS}})
+{{OUTPUT}} = {{REL_NAME}}.subtract(diff, {{NUM_PARTITIONS}}){{TO_CACHE}}
 
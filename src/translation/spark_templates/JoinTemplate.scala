@@ -1,5 +1,35 @@
+{{#KEYED1}}
 val keyed_{{REL_NAME1}}_{{CLASS_NAME}}:org.apache.spark.rdd.RDD[({{JOIN_COL_TYPE}},{{INPUTREL_TYPE1}})] = {{REL_NAME1}}.{{KEYRDD1}};
+{{/KEYED1}}
+{{#CACHED_KEYED1}}
+if (keyed_{{REL_NAME1}}_{{CLASS_NAME}} == null) {
+  keyed_{{REL_NAME1}}_{{CLASS_NAME}} = {{REL_NAME1}}.{{KEYRDD1}}.partitionBy(new org.apache.spark.HashPartitioner({{NUM_PARTITIONS}})).cache();
+}
+{{/CACHED_KEYED1}}
+{{#KEYED2}}
 val keyed_{{REL_NAME2}}_2{{CLASS_NAME}}:org.apache.spark.rdd.RDD[({{JOIN_COL_TYPE}},{{INPUTREL_TYPE2}})] =  {{REL_NAME2}}.{{KEYRDD2}};
-val int_{{OUTPUT}} = keyed_{{REL_NAME1}}_{{CLASS_NAME}}.join(keyed_{{REL_NAME2}}_2{{CLASS_NAME}})
+{{/KEYED2}}
+{{#CACHED_KEYED2}}
+if (keyed_{{REL_NAME2}}_2{{CLASS_NAME}} == null) {
+  keyed_{{REL_NAME2}}_2{{CLASS_NAME}} = {{REL_NAME2}}.{{KEYRDD2}}.partitionBy(new org.apache.spark.HashPartitioner({{NUM_PARTITIONS}})).cache();
+}
+{{/CACHED_KEYED2}}
+{{#SHUFFLE_JOIN}}
+val int_{{OUTPUT}} = keyed_{{REL_NAME1}}_{{CLASS_NAME}}.join(keyed_{{REL_NAME2}}_2{{CLASS_NAME}}, {{NUM_PARTITIONS}})
+{{/SHUFFLE_JOIN}}
+{{#SKEW_JOIN}}
+val skewed_{{CLASS_NAME}} = sc.broadcast(Set[{{JOIN_COL_TYPE}}]({{SKEWED_KEYS}}))
+val salted_{{REL_NAME1}}_{{CLASS_NAME}} = keyed_{{REL_NAME1}}_{{CLASS_NAME}}.flatMap(row => if (skewed_{{CLASS_NAME}}.value.contains(row._1)) {{SALT_LEFT}} else Seq(((row._1, 0), row._2)))
+val salted_{{REL_NAME2}}_2{{CLASS_NAME}} = keyed_{{REL_NAME2}}_2{{CLASS_NAME}}.flatMap(row => if (skewed_{{CLASS_NAME}}.value.contains(row._1)) {{SALT_RIGHT}} else Seq(((row._1, 0), row._2)))
+val int_{{OUTPUT}} = salted_{{REL_NAME1}}_{{CLASS_NAME}}.join(salted_{{REL_NAME2}}_2{{CLASS_NAME}}, {{NUM_PARTITIONS}}).map(row => (row._1._1, row._2))
+{{/SKEW_JOIN}}
+{{#BROADCAST_LEFT}}
+val bc_{{REL_NAME1}}_{{CLASS_NAME}} = sc.broadcast(keyed_{{REL_NAME1}}_{{CLASS_NAME}}.collect().groupBy(_._1).map(group => (group._1, group._2.map(_._2))))
+val int_{{OUTPUT}} = keyed_{{REL_NAME2}}_2{{CLASS_NAME}}.flatMap(row => bc_{{REL_NAME1}}_{{CLASS_NAME}}.value.getOrElse(row._1, Array.empty[{{INPUTREL_TYPE1}}]).map(left => (row._1, (left, row._2))))
+{{/BROADCAST_LEFT}}
+{{#BROADCAST_RIGHT}}
+val bc_{{REL_NAME2}}_2{{CLASS_NAME}} = sc.broadcast(keyed_{{REL_NAME2}}_2{{CLASS_NAME}}.collect().groupBy(_._1).map(group => (group._1, group._2.map(_._2))))
+val int_{{OUTPUT}} = keyed_{{REL_NAME1}}_{{CLASS_NAME}}.flatMap(row => bc_{{REL_NAME2}}_2{{CLASS_NAME}}.value.getOrElse(row._1, Array.empty[{{INPUTREL_TYPE2}}]).map(right => (row._1, (row._2, right))))
+{{/BROADCAST_RIGHT}}
 {{OUTPUT}} = int_{{OUTPUT}}.map(({{INPUT}} => { {{NEXT_OPERATOR}} })){{TO_CACHE}}
 
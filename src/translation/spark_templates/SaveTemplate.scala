@@ -1,2 +1,6 @@
-val {{REL_NAME}}_string = {{REL_NAME}}.map({{STRING_MAPPING}})
+val {{REL_NAME}}_string = {{REL_NAME}}.map({{STRING_MAPPING}}).map(line => {
+  musketeer_rows_out += 1
+  musketeer_bytes_out += line.length + 1
+  line
+})
 {{REL_NAME}}_string.saveAsTextFile("{{HDFS_MASTER}}{{OUTPUT_PATH}}")
\ No newline at end of file
@@ -1,4 +1,11 @@
 
+    println("METRIC LOAD MS: " + musketeer_load_ms)
+    println("METRIC RUN MS: " +
+            (System.currentTimeMillis() - musketeer_start_ms - musketeer_load_ms))
+    println("METRIC ROWS IN: " + musketeer_rows_in.value)
+    println("METRIC BYTES IN: " + musketeer_bytes_in.value)
+    println("METRIC ROWS OUT: " + musketeer_rows_out.value)
+    println("METRIC BYTES OUT: " + musketeer_bytes_out.value)
     System.exit(0)
 }
 }
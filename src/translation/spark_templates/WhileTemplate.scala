@@ -1,3 +1,7 @@
-  {{CONDITION_VAR}}
-//  while ({{CONDITION}}) {
+{{#COUNTED_LOOP}}
   for (i <- 0 until {{NUM_ITER}}) {
+{{/COUNTED_LOOP}}
+{{#CONVERGENCE_LOOP}}
+{{CONDITION_VAR}}
+  while ({{CONDITION}}) {
+{{/CONVERGENCE_LOOP}}
@@ -42,14 +42,67 @@ class TranslatorGraphInterface : public TranslatorInterface {
   // TODO(ionel): This makes the following assumptions:
   //  1. the condition will be smt_0 < VAL
   //  2. smt_0 is initialized to 0 => we want to do VAL iterations
+  bool HasIterationBound(WhileOperator* op) {
+    ConditionTree* tree = op->get_condition_tree();
+    return tree->isBinary() && tree->get_right()->isValue();
+  }
+
   string GetNumIters(WhileOperator* op) {
     ConditionTree* tree = op->get_condition_tree();
     if (tree->isBinary() && tree->get_right()->isValue()) {
       return tree->get_right()->get_value()->get_value();
     } else {
       LOG(ERROR) << "Unsupported while loop condition";
-      return NULL;
+      return "";
+    }
+  }
+
+  // Returns the edges-vertices JOIN at the start of the WHILE body. The other
+  // input of the body is the operator incrementing the iteration counter.
+  shared_ptr<OperatorNode> GetEdgesJoin(shared_ptr<OperatorNode> while_node) {
+    op_nodes children = while_node->get_loop_children();
+    for (op_nodes::iterator it = children.begin(); it != children.end();
+         ++it) {
+      if ((*it)->get_operator()->get_type() == JOIN_OP) {
+        return *it;
+      }
+    }
+    LOG(ERROR) << "WHILE body does not start with a JOIN";
+    return shared_ptr<OperatorNode>();
+  }
+
+  // Returns the index of the column reduced by the group by operator or -1
+  // if the operator does not read a column (i.e. COUNT).
+  int32_t GetGatherColumn(OperatorInterface* op) {
+    switch (op->get_type()) {
+    case AGG_OP:
+      return dynamic_cast<AggOperator*>(op)->get_columns()[0]->get_index();
+    case MAX_OP:
+      return dynamic_cast<MaxOperator*>(op)->get_column()->get_index();
+    case MIN_OP:
+      return dynamic_cast<MinOperator*>(op)->get_column()->get_index();
+    default:
+      return -1;
+    }
+  }
+
+  // Makes the per-edge value reduced by the group by operator available in
+  // gather_var. Returns the code that copies it, if any.
+  string BindGatherValue(const string& gather_var,
+                         unordered_map<string, vector<string> >* rel_var_names,
+                         OperatorInterface* op) {
+    int32_t gather_col = GetGatherColumn(op);
+    if (gather_col < 0) {
+      return "";
+    }
+    vector<string>& input_cols =
+      (*rel_var_names)[op->get_relations()[0]->get_name()];
+    string gather_value = input_cols[gather_col];
+    input_cols[gather_col] = gather_var;
+    if (gather_value == gather_var) {
+      return "";
     }
+    return gather_var + " = " + gather_value + ";\n";
   }
 
   string GenOperatorCode(
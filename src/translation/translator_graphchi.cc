@@ -26,6 +26,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <string>
 #include <utility>
 
@@ -131,29 +132,40 @@ namespace translator {
     shared_ptr<OperatorNode> while_node = IgnoreIfCountEdgesPresent(dag);
     OperatorInterface* op = while_node->get_operator();
     string binary_file = GetBinaryPath(op);
-    string num_iters = GetNumIters(dynamic_cast<WhileOperator*>(op));
+    WhileOperator* while_op = dynamic_cast<WhileOperator*>(op);
+    string num_iters;
+    if (!HasIterationBound(while_op) && FLAGS_graphchi_selective_scheduling) {
+      // The WHILE condition is not translated. The loop runs until no vertex
+      // changes, which may never happen (e.g. sums with a threshold of 0), so
+      // the number of iterations is capped.
+      LOG(WARNING) << "Running GraphChi loop until convergence or for at most "
+                   << FLAGS_graphchi_max_iterations << " iterations";
+      num_iters = boost::lexical_cast<string>(FLAGS_graphchi_max_iterations);
+    } else {
+      num_iters = GetNumIters(while_op);
+      if (num_iters.empty()) {
+        return "";
+      }
+    }
     dict.SetValue("CLASS_NAME", class_name);
     dict.SetValue("HDFS_MASTER", "hdfs://" + FLAGS_hdfs_master);
     dict.SetValue("HDFS_PORT", FLAGS_hdfs_port);
     dict.SetValue("GRAPHCHI_DIR", FLAGS_graphchi_dir);
     dict.SetValue("N_ITERS", num_iters);
-    op_nodes children = while_node->get_loop_children();
-    if (children.size() != 2) {
-      LOG(ERROR) << "WHILE has more than 2 children nodes";
-      return NULL;
+    shared_ptr<OperatorNode> join_node = GetEdgesJoin(while_node);
+    if (join_node == NULL) {
+      LOG(ERROR) << "WHILE body does not start with an edges-vertices JOIN";
+      return "";
     }
-    // Assumes that the first operator is JOIN and the second operator is
-    // SUM (i.e. the one incrementing the iterator).
-    shared_ptr<OperatorNode> join_node = children[0];
     string pre_group_vertex =
       HandleVerticesEdgesJoin(&rel_var_names, &dict, join_node,
                               dag[0] != while_node);
 
-    children = join_node->get_children();
+    op_nodes children = join_node->get_children();
     for (; ; children = children[0]->get_children()) {
       if (children.size() != 1) {
         LOG(ERROR) << "Unsupported merge!";
-        return NULL;
+        return "";
       }
       OperatorInterface* child_op = children[0]->get_operator();
       if (child_op->hasGroupby()) {
@@ -161,20 +173,29 @@ namespace translator {
       }
       pre_group_vertex += GenOperatorCode(&rel_var_names, child_op) + "\n";
     }
+    OperatorInterface* group_op = children[0]->get_operator();
+    // The value scattered on the out edges is the one the group by reduces.
+    pre_group_vertex +=
+      BindGatherValue("in_edge_val", &rel_var_names, group_op);
     dict.SetValue("PRE_GROUP_VERTEX_VAL", pre_group_vertex);
     // Generating code for the operator with group by.
     string group_vertex_val =
-      UpdateGroupVertexValue("ver_val", &rel_var_names,
-                             children[0]->get_operator());
+      UpdateGroupVertexValue("ver_val", &rel_var_names, group_op);
     dict.SetValue("GROUP_VERTEX_VAL", group_vertex_val);
     string post_group_vertex = "";
+    bool reads_own_value = false;
     // Check if the parent is UNION
     if (children[0]->get_parents()[0]->get_operator()->get_type() == UNION_OP) {
       if (children[0]->get_operator()->get_type() == COUNT_OP) {
         dict.SetValue("INIT_VER_VAL", "1");
       } else {
         dict.SetValue("INIT_VER_VAL", "v.get_data()");
+        reads_own_value = true;
       }
+    } else if (group_op->get_type() == MIN_OP) {
+      dict.SetValue("INIT_VER_VAL", "numeric_limits<VertexDataType>::max()");
+    } else if (group_op->get_type() == MAX_OP) {
+      dict.SetValue("INIT_VER_VAL", "-numeric_limits<VertexDataType>::max()");
     } else {
       // TODO(ionel): FIX! This doesn't work if ver_val is of type string.
       dict.SetValue("INIT_VER_VAL", "0");
@@ -184,7 +205,7 @@ namespace translator {
     for (; children.size() > 0; children = children[0]->get_children()) {
       if (children.size() > 1) {
         LOG(ERROR) << "Unsupported merge!";
-        return NULL;
+        return "";
       }
       OperatorInterface* child_op = children[0]->get_operator();
       post_group_vertex += GenOperatorCode(&rel_var_names, child_op) + "\n";
@@ -192,6 +213,14 @@ namespace translator {
     dict.SetValue("POST_GROUP_VERTEX_VAL", post_group_vertex);
     dict.SetValue("TMP_ROOT", FLAGS_tmp_data_dir);
     dict.SetValue("HDFS_ADDRESS", FLAGS_hdfs_master);
+    dict.SetValue("CACHE_SHARDS", FLAGS_graphchi_cache_shards ? "true" : "false");
+    dict.SetIntValue("INGEST_THREADS", FLAGS_graphchi_ingest_threads);
+    dict.SetValue("SELECTIVE_SCHEDULING",
+                  FLAGS_graphchi_selective_scheduling ? "true" : "false");
+    dict.SetValue("READS_OWN_VALUE", reads_own_value ? "true" : "false");
+    dict.SetValue("CONVERGENCE_THRESHOLD",
+                  boost::lexical_cast<string>(
+                      FLAGS_graphchi_convergence_threshold));
     GenMakeFile(op, dict);
     string code;
     ExpandTemplate(FLAGS_graphchi_templates_dir + "JobTemplate.cc",
@@ -274,12 +303,12 @@ namespace translator {
       UnionOperator* op) {
     vector<Relation*> rels = op->get_relations();
     vector<string> input_left_names = (*rel_var_names)[rels[0]->get_name()];
-    vector<string> input_right_names = (*rel_var_names)[rels[1]->get_name()];
     string output_rel_name = op->get_output_relation()->get_name();
-    vector<string> output_col_names(input_right_names.begin(),
-                                    input_right_names.end());
+    // The right input is the vertices relation. Its values seed the gather
+    // through INIT_VER_VAL, so the UNION's rows are the per-edge ones.
+    vector<string> output_col_names(input_left_names.begin(),
+                                    input_left_names.end());
     rel_var_names->insert(pair<string, vector<string> >(output_rel_name, output_col_names));
-    // TODO(ionel): Implement.
     return "";
   }
 
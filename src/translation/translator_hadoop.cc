@@ -74,9 +74,16 @@ namespace translator {
       OperatorInterface* op = cur_node->get_operator();
       vector<Relation*> relations = op->get_relations();
       string output_relation = op->get_output_relation()->get_name();
-      for (vector<Relation*>::iterator rel_it = relations.begin();
-           rel_it != relations.end(); ++rel_it) {
+      // The map tasks load the broadcast input of a JOIN themselves.
+      int32_t broadcast_input =
+        op->get_type() == JOIN_OP ? BroadcastInput(op) : -1;
+      for (vector<Relation*>::size_type index = 0; index < relations.size();
+           ++index) {
+        vector<Relation*>::iterator rel_it = relations.begin() + index;
         string rel_name = (*rel_it)->get_name();
+        if (static_cast<int32_t>(index) == broadcast_input) {
+          continue;
+        }
         if (known_rels.insert(rel_name).second) {
           if (!output_relation.compare(rel_name)) {
             input_rels.insert(rel_name + "_input");
@@ -121,11 +128,60 @@ namespace translator {
   }
 
   bool TranslatorHadoop::HasReduce(OperatorInterface* op) {
+    if (op->get_type() == JOIN_OP) {
+      return BroadcastInput(op) < 0;
+    }
     return op->get_type() == AGG_OP || op->get_type() == COUNT_OP ||
       op->get_type() == CROSS_JOIN_OP || op->get_type() == DIFFERENCE_OP ||
-      op->get_type() == INTERSECTION_OP || op->get_type() == JOIN_OP ||
-      op->get_type() == MAX_OP || op->get_type() == MIN_OP ||
-      op->get_type() == SORT_OP;
+      op->get_type() == INTERSECTION_OP || op->get_type() == MAX_OP ||
+      op->get_type() == MIN_OP || op->get_type() == SORT_OP;
+  }
+
+  // Returns the input of the JOIN that every map task loads from HDFS, or -1
+  // if the JOIN shuffles both inputs. The JOIN can only run in the map if
+  // the operators before it in the job do, and the input must not be
+  // computed by the job itself.
+  int32_t TranslatorHadoop::BroadcastInput(OperatorInterface* op) {
+    int32_t input = dynamic_cast<JoinOperator*>(op)->get_broadcast_input();
+    if (input < 0) {
+      return -1;
+    }
+    string input_rel = op->get_relations()[input]->get_name();
+    for (shared_ptr<OperatorNode> node = dag[0];
+         node->get_operator() != op; node = node->get_children()[0]) {
+      OperatorInterface* prev_op = node->get_operator();
+      if (HasReduce(prev_op) ||
+          prev_op->get_output_relation()->get_name() == input_rel ||
+          node->get_children().empty()) {
+        return -1;
+      }
+    }
+    return input;
+  }
+
+  // Returns the code of the key a row of rel_name is joined on.
+  string TranslatorHadoop::JoinKeyCode(const string& rel_name,
+                                       const vector<Column*>& keys) {
+    string key_code = "";
+    for (vector<Column*>::const_iterator it = keys.begin(); it != keys.end();
+         ++it) {
+      key_code += rel_name + "[" +
+        boost::lexical_cast<string>((*it)->get_index()) + "] + \" \" + ";
+    }
+    return key_code + "\"\"";
+  }
+
+  // Returns the condition that holds for the columns of rel_name that are
+  // not join keys.
+  string TranslatorHadoop::JoinKeepCode(const string& rel_name,
+                                        const vector<Column*>& keys) {
+    string keep_code = "true";
+    for (vector<Column*>::const_iterator it = keys.begin(); it != keys.end();
+         ++it) {
+      keep_code += " && " + rel_name + "_i != " +
+        boost::lexical_cast<string>((*it)->get_index());
+    }
+    return keep_code;
   }
 
   void TranslatorHadoop::UpdateDAGCode(
@@ -134,11 +190,15 @@ namespace translator {
     if (add_to_reduce) {
       dag_code->set_reduce_code(code);
     } else {
+      // Keep the variables and the setup of the operators merged so far,
+      // e.g. the hash table of a broadcast JOIN.
       if (child_code->HasMapVariablesCode()) {
-        dag_code->set_map_variables_code(child_code->get_map_variables_code());
+        dag_code->set_map_variables_code(dag_code->get_map_variables_code() +
+                                         child_code->get_map_variables_code());
       }
       if (child_code->HasSetupCode()) {
-        dag_code->set_setup_code(child_code->get_setup_code());
+        dag_code->set_setup_code(dag_code->get_setup_code() +
+                                 child_code->get_setup_code());
       }
       if (child_code->HasCleanupCode()) {
         dag_code->set_cleanup_code(child_code->get_cleanup_code());
@@ -187,6 +247,21 @@ namespace translator {
     dict->SetValue("REDUCE_KEY_TYPE", dag_code->get_reduce_key_type());
     dict->SetValue("REDUCE_VALUE_TYPE", dag_code->get_reduce_value_type());
     dict->SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
+    // The columnar readers are also used by broadcast joins and sampling.
+    string columnar_code = "";
+    mutable_default_template_cache()->ClearCache();
+    ExpandTemplate(FLAGS_hadoop_templates_dir + "Columnar.java",
+                   ctemplate::DO_NOT_STRIP, dict, &columnar_code);
+    dict->SetValue("COLUMNAR_CODE", columnar_code);
+    if (FLAGS_columnar_intermediates) {
+      dict->ShowSection("COLUMNAR_INPUT");
+    }
+    if (op->get_columnar_output()) {
+      dict->ShowSection("COLUMNAR_OUTPUT");
+      dict->SetIntValue("COLUMNAR_BLOCK_ROWS", FLAGS_columnar_block_rows);
+      dict->SetValue("COLUMNAR_COMPRESS",
+                     FLAGS_columnar_compression ? "true" : "false");
+    }
   }
 
   // Map only operators: Div, Mul, Sub, Sum, Select, Project, Union
@@ -212,6 +287,8 @@ namespace translator {
     pair<string, string> input_rel_code = GetInputPathsAndRelationsCode(dag);
     HadoopJobCode* dag_code =
       dynamic_cast<HadoopJobCode*>(TranslateOperator(op));
+    // The operator whose input is shuffled to the reducers.
+    OperatorInterface* reduce_op = HasReduce(op) ? op : NULL;
     while (!op_node->IsLeaf()) {
       // If op is one of the following then we can only add the code to the
       // reduce step.
@@ -248,7 +325,10 @@ namespace translator {
         ExpandTemplate("dag", ctemplate::DO_NOT_STRIP, &dict, &code);
         UpdateDAGCode(code, child_code, add_to_reduce, dag_code);
         if (HasReduce((*it)->get_operator())) {
+          reduce_op = (*it)->get_operator();
           dag_code->set_reduce_code(child_code->get_reduce_code());
+          dag_code->set_combine_code(child_code->get_combine_code());
+          dag_code->set_classes_code(child_code->get_classes_code());
           dag_code->set_reduce_key_type(child_code->get_reduce_key_type());
           dag_code->set_reduce_value_type(child_code->get_reduce_value_type());
           dag_code->set_map_key_type(child_code->get_map_key_type());
@@ -264,11 +344,21 @@ namespace translator {
     string template_location;
     if (dag_code->HasReduceCode()) {
       dict.SetValue("REDUCE_CODE", dag_code->get_reduce_code());
+      if (dag_code->HasCombineCode()) {
+        dict.ShowSection("COMBINER");
+        dict.SetValue("COMBINE_CODE", dag_code->get_combine_code());
+      }
+      PopulateReduceTasks(reduce_op, &dict);
+      dict.SetValue("CLASSES_CODE", dag_code->get_classes_code());
       template_location = FLAGS_hadoop_templates_dir +
         "JobMapReduceTemplate.java";
     } else {
       template_location = FLAGS_hadoop_templates_dir + "JobMapTemplate.java";
     }
+    string report_metrics_code;
+    ExpandTemplate(FLAGS_hadoop_templates_dir + "ReportMetrics.java",
+                   ctemplate::DO_NOT_STRIP, &dict, &report_metrics_code);
+    dict.SetValue("REPORT_METRICS_CODE", report_metrics_code);
     string gen_code = "";
     mutable_default_template_cache()->ClearCache();
     ExpandTemplate(template_location, ctemplate::DO_NOT_STRIP, &dict, &gen_code);
@@ -295,6 +385,58 @@ namespace translator {
     return "\"\"";
   }
 
+  // Only associative aggregations can be computed in parts.
+  bool TranslatorHadoop::CanAggregateInMap(AggOperator* op) {
+    string math_op = op->get_operator();
+    return op->hasGroupby() && (!math_op.compare("+") || !math_op.compare("*"));
+  }
+
+  // Aggregates the groups in the mappers, using a bounded number of groups,
+  // and again in a combiner. The reduce then only merges partial results.
+  bool TranslatorHadoop::PopulateMapAggregation(bool can_aggregate,
+                                                TemplateDictionary* dict) {
+    if (can_aggregate && FLAGS_map_aggregation_max_groups > 0) {
+      dict->ShowSection("MAP_AGGREGATION");
+      dict->SetValue("MAX_GROUPS", boost::lexical_cast<string>(
+          FLAGS_map_aggregation_max_groups));
+      return true;
+    }
+    dict->ShowSection("NO_MAP_AGGREGATION");
+    return false;
+  }
+
+  // Gives every reduce task about FLAGS_reduce_task_input_kb of the shuffled
+  // input. A SORT also gets a range partitioner so that its output is
+  // globally ordered across the reduce tasks.
+  void TranslatorHadoop::PopulateReduceTasks(OperatorInterface* reduce_op,
+                                             TemplateDictionary* dict) {
+    uint32_t num_reduce_tasks = 0;
+    if (reduce_op != NULL) {
+      num_reduce_tasks = NumReduceTasks(reduce_op, FLAGS_reduce_task_input_kb,
+                                        FLAGS_hadoop_reduce_slots);
+    }
+    if (num_reduce_tasks == 0) {
+      num_reduce_tasks = max(FLAGS_hadoop_reduce_slots, 1);
+    }
+    if (reduce_op != NULL && reduce_op->get_type() == SORT_OP &&
+        num_reduce_tasks > 1) {
+      // The split points are sampled from the SORT's input, which only
+      // exists if the SORT is the first operator of the job.
+      if (reduce_op == dag[0]->get_operator()) {
+        SortOperator* sort_op = dynamic_cast<SortOperator*>(reduce_op);
+        dict->ShowSection("RANGE_PARTITIONER");
+        dict->SetValue("SAMPLE_PATH", sort_op->get_input_paths()[0]);
+        dict->SetIntValue("SORT_COL_INDEX", sort_op->get_column()->get_index());
+        dict->SetValue("SORT_COL_TYPE",
+                       sort_op->get_column()->translateTypeJava());
+      } else {
+        num_reduce_tasks = 1;
+      }
+    }
+    LOG(INFO) << "Using " << num_reduce_tasks << " reduce tasks";
+    dict->SetIntValue("NUM_REDUCE_TASKS", num_reduce_tasks);
+  }
+
   HadoopJobCode* TranslatorHadoop::Translate(AggOperator* op) {
     string input_path = op->get_input_paths()[0];
     TemplateDictionary dict("agg");
@@ -330,10 +472,13 @@ namespace translator {
     dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
     dict.SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
     dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
+    bool map_aggregation =
+      PopulateMapAggregation(CanAggregateInMap(op), &dict);
     string op_map_variables;
     string op_map;
     string op_cleanup;
     string op_reduce;
+    string op_combine;
     ExpandTemplate(FLAGS_hadoop_templates_dir + "AggMapVariables.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_hadoop_templates_dir + "AggMap.java",
@@ -349,6 +494,11 @@ namespace translator {
     job_code->set_map_value_type("Text");
     job_code->set_reduce_key_type("NullWritable");
     job_code->set_reduce_value_type("Text");
+    if (map_aggregation) {
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "AggCombine.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_combine);
+      job_code->set_combine_code(op_combine);
+    }
     return job_code;
   }
 
@@ -367,10 +517,13 @@ namespace translator {
     dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
     dict.SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
     dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
+    bool map_aggregation =
+      PopulateMapAggregation(op->hasGroupby(), &dict);
     string op_map_variables;
     string op_map;
     string op_cleanup;
     string op_reduce;
+    string op_combine;
     ExpandTemplate(FLAGS_hadoop_templates_dir + "CountMapVariables.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_hadoop_templates_dir + "CountMap.java",
@@ -386,6 +539,11 @@ namespace translator {
     job_code->set_map_value_type("Text");
     job_code->set_reduce_key_type("NullWritable");
     job_code->set_reduce_value_type("Text");
+    if (map_aggregation) {
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "CountCombine.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_combine);
+      job_code->set_combine_code(op_combine);
+    }
     return job_code;
   }
 
@@ -591,6 +749,65 @@ namespace translator {
     string op_setup;
     string op_map;
     string op_reduce;
+    int32_t broadcast_input = BroadcastInput(op);
+    if (broadcast_input >= 0) {
+      // Map-side hash join: every map task loads the small input into a hash
+      // table and streams the other input through it.
+      int32_t stream_input = 1 - broadcast_input;
+      string rel_names[] = {left_rel_name, right_rel_name};
+      vector<Column*> keys[] = {left_cols, right_cols};
+      string broadcast_rel = rel_names[broadcast_input];
+      string stream_rel = rel_names[stream_input];
+      dict.SetValue("BROADCAST_REL", broadcast_rel);
+      dict.SetValue("BROADCAST_PATH", input_paths[broadcast_input]);
+      dict.SetValue("BROADCAST_KEY",
+                    JoinKeyCode(broadcast_rel, keys[broadcast_input]));
+      dict.SetValue("STREAM_REL", stream_rel);
+      dict.SetValue("STREAM_KEY", JoinKeyCode(stream_rel, keys[stream_input]));
+      // The output holds all the left columns and the right columns that
+      // are not join keys.
+      if (broadcast_input == 0) {
+        dict.SetValue("BROADCAST_KEEP", "true");
+        dict.SetValue("STREAM_KEEP", JoinKeepCode(stream_rel, right_cols));
+        dict.SetValue("JOINED_ROW",
+                      broadcast_rel + "_tmp + " + stream_rel + "_tmp");
+      } else {
+        dict.SetValue("BROADCAST_KEEP",
+                      JoinKeepCode(broadcast_rel, right_cols));
+        dict.SetValue("STREAM_KEEP", "true");
+        dict.SetValue("JOINED_ROW",
+                      stream_rel + "_tmp + " + broadcast_rel + "_tmp");
+      }
+      ExpandTemplate(FLAGS_hadoop_templates_dir +
+                     "JoinBroadcastMapVariables.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinBroadcastSetup.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_setup);
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinBroadcastMap.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_map);
+      HadoopJobCode* job_code =
+        new HadoopJobCode(op, op_map_variables, op_setup, op_map, "", "");
+      job_code->set_map_key_type("NullWritable");
+      job_code->set_map_value_type("Text");
+      return job_code;
+    }
+    vector<string> skewed_keys = op->get_skewed_keys();
+    if (!skewed_keys.empty() && !single_input) {
+      // The map output keys end with a space.
+      string keys_code = "";
+      for (vector<string>::iterator it = skewed_keys.begin();
+           it != skewed_keys.end(); ++it) {
+        keys_code += (keys_code.empty() ? "" : ", ") + QuoteString(*it + " ");
+      }
+      dict.ShowSection("SKEW_JOIN");
+      dict.SetValue("SKEWED_KEYS", keys_code);
+      dict.SetIntValue("SKEW_SPLITS", max(FLAGS_skew_join_splits, 1));
+      dict.SetValue("SPLIT_LEFT", op->get_skewed_input() == 0 ? "true" : "false");
+      dict.SetValue("SPLIT_RIGHT",
+                    op->get_skewed_input() == 1 ? "true" : "false");
+    } else {
+      dict.ShowSection("NO_SKEW_JOIN");
+    }
     ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinMapVariables.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinSetup.java",
@@ -602,17 +819,61 @@ namespace translator {
       ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinMap.java",
                      ctemplate::DO_NOT_STRIP, &dict, &op_map);
     }
+    // The rows of both inputs are shuffled as typed JoinValues.
+    string classes_code = "";
+    if (!single_input) {
+      vector<Column*> left_value_cols = op->get_relations()[0]->get_columns();
+      vector<Column*> right_value_cols;
+      vector<Column*> right_all_cols = op->get_relations()[1]->get_columns();
+      for (vector<Column*>::iterator it = right_all_cols.begin();
+           it != right_all_cols.end(); ++it) {
+        bool is_key = false;
+        for (vector<Column*>::iterator key_it = right_cols.begin();
+             key_it != right_cols.end(); ++key_it) {
+          is_key = is_key || (*key_it)->get_index() == (*it)->get_index();
+        }
+        if (!is_key) {
+          right_value_cols.push_back(*it);
+        }
+      }
+      dict.ShowSection("TYPED_ROWS");
+      PopulateWritableColumns(left_value_cols, "LEFT_COLS", &dict);
+      PopulateWritableColumns(right_value_cols, "RIGHT_COLS", &dict);
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinValue.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &classes_code);
+    } else {
+      dict.ShowSection("TEXT_ROWS");
+    }
     ExpandTemplate(FLAGS_hadoop_templates_dir + "JoinReduce.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_reduce);
     HadoopJobCode* job_code =
       new HadoopJobCode(op, op_map_variables, op_setup, op_map, "", op_reduce);
+    job_code->set_classes_code(classes_code);
     job_code->set_map_key_type("Text");
-    job_code->set_map_value_type("Text");
+    job_code->set_map_value_type(single_input ? "Text" : "JoinValue");
     job_code->set_reduce_key_type("NullWritable");
     job_code->set_reduce_value_type("Text");
     return job_code;
   }
 
+  // Adds the code that writes and reads every column of a row. Integers are
+  // written in binary. Doubles and booleans are written as strings because
+  // parsing them would change their text, e.g. "3" would be read as "3.0".
+  void TranslatorHadoop::PopulateWritableColumns(const vector<Column*>& cols,
+                                                 const string& section,
+                                                 TemplateDictionary* dict) {
+    for (vector<Column*>::size_type index = 0; index < cols.size(); ++index) {
+      TemplateDictionary* col_dict = dict->AddSectionDictionary(section);
+      if (cols[index]->get_type() == INTEGER_TYPE) {
+        col_dict->SetValue("WRITE_CODE", "writeInteger(out, cols[col])");
+        col_dict->SetValue("READ_CODE", "readInteger(in)");
+      } else {
+        col_dict->SetValue("WRITE_CODE", "Text.writeString(out, cols[col])");
+        col_dict->SetValue("READ_CODE", "Text.readString(in)");
+      }
+    }
+  }
+
   HadoopJobCode* TranslatorHadoop::Translate(MaxOperator* op) {
     // TODO(ionel): Handle multiple input paths. Handle multiple relations.
     string input_path = op->get_input_paths()[0];
@@ -652,10 +913,13 @@ namespace translator {
     dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
     dict.SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
     dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
+    bool map_aggregation =
+      PopulateMapAggregation(op->hasGroupby(), &dict);
     string op_map_variables;
     string op_map;
     string op_cleanup;
     string op_reduce;
+    string op_combine;
     ExpandTemplate(FLAGS_hadoop_templates_dir + "MaxMapVariables.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_hadoop_templates_dir + "MaxMap.java",
@@ -671,6 +935,11 @@ namespace translator {
     job_code->set_map_value_type("Text");
     job_code->set_reduce_key_type("NullWritable");
     job_code->set_reduce_value_type("Text");
+    if (map_aggregation) {
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "MaxCombine.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_combine);
+      job_code->set_combine_code(op_combine);
+    }
     return job_code;
   }
 
@@ -713,10 +982,13 @@ namespace translator {
     dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
     dict.SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
     dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
+    bool map_aggregation =
+      PopulateMapAggregation(op->hasGroupby(), &dict);
     string op_map_variables;
     string op_map;
     string op_cleanup;
     string op_reduce;
+    string op_combine;
     ExpandTemplate(FLAGS_hadoop_templates_dir + "MinMapVariables.java",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_hadoop_templates_dir + "MinMap.java",
@@ -732,6 +1004,11 @@ namespace translator {
     job_code->set_map_value_type("Text");
     job_code->set_reduce_key_type("NullWritable");
     job_code->set_reduce_value_type("Text");
+    if (map_aggregation) {
+      ExpandTemplate(FLAGS_hadoop_templates_dir + "MinCombine.java",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_combine);
+      job_code->set_combine_code(op_combine);
+    }
     return job_code;
   }
 
@@ -64,11 +64,21 @@ class TranslatorHadoop : public TranslatorInterface {
   HadoopJobCode* Translate(UdfOperator* op);
   HadoopJobCode* Translate(UnionOperator* op);
   string GenerateGroupByKey(const vector<Column*>& group_bys);
+  bool CanAggregateInMap(AggOperator* op);
+  bool PopulateMapAggregation(bool can_aggregate, TemplateDictionary* dict);
+  void PopulateWritableColumns(const vector<Column*>& cols,
+                               const string& section,
+                               TemplateDictionary* dict);
+  void PopulateReduceTasks(OperatorInterface* reduce_op,
+                           TemplateDictionary* dict);
   string GetBinaryPath(OperatorInterface* op);
   string GetSourcePath(OperatorInterface* op);
   string GenAndCompile(OperatorInterface* op, const string& op_code);
   pair<string, string> GetInputPathsAndRelationsCode(const op_nodes& dag);
   bool HasReduce(OperatorInterface* op);
+  int32_t BroadcastInput(OperatorInterface* op);
+  string JoinKeyCode(const string& rel_name, const vector<Column*>& keys);
+  string JoinKeepCode(const string& rel_name, const vector<Column*>& keys);
   void UpdateDAGCode(const string& code, HadoopJobCode* child_code,
                      bool add_to_reduce, HadoopJobCode* dag_code);
   void PopulateEndDAG(OperatorInterface* op, HadoopJobCode* dag_code,
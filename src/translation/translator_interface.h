@@ -22,6 +22,8 @@
 #include <ctemplate/template.h>
 #include <stdint.h>
 
+#include <queue>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -299,6 +301,60 @@ class TranslatorInterface {
     return op->get_relations()[index]->get_name();
   }
 
+  // Number of reduce tasks, or shuffle partitions, that each get about
+  // task_input_kb of op's estimated input. Returns 0 if the size is unknown.
+  uint32_t NumReduceTasks(OperatorInterface* op, uint64_t task_input_kb,
+                          int32_t max_tasks) {
+    uint64_t input_size_kb = op->get_input_size_kb();
+    if (input_size_kb == 0 || task_input_kb == 0 || max_tasks <= 0) {
+      return 0;
+    }
+    uint64_t num_tasks = input_size_kb / task_input_kb +
+      (input_size_kb % task_input_kb > 0 ? 1 : 0);
+    return static_cast<uint32_t>(
+        min(num_tasks, static_cast<uint64_t>(max_tasks)));
+  }
+
+  // Returns value as a string literal of the C++, Java and Scala code.
+  string QuoteString(const string& value) {
+    string quoted = "\"";
+    for (string::const_iterator it = value.begin(); it != value.end(); ++it) {
+      if (*it == '"' || *it == '\\') {
+        quoted += '\\';
+      }
+      quoted += *it;
+    }
+    return quoted + "\"";
+  }
+
+  // Returns the node of op in the DAG that is being translated.
+  shared_ptr<OperatorNode> FindNode(OperatorInterface* op) {
+    set<shared_ptr<OperatorNode> > visited;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    for (op_nodes::iterator it = dag.begin(); it != dag.end(); ++it) {
+      to_visit.push(*it);
+      visited.insert(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> node = to_visit.front();
+      to_visit.pop();
+      if (node->get_operator() == op) {
+        return node;
+      }
+      op_nodes children = node->get_children();
+      op_nodes loop_children = node->get_loop_children();
+      children.insert(children.end(), loop_children.begin(),
+                      loop_children.end());
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+    }
+    return shared_ptr<OperatorNode>();
+  }
+
   vector<shared_ptr<OperatorNode> > dag;
   string class_name;
 };
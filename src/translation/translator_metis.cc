@@ -22,6 +22,7 @@
 #include <ctemplate/template.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
@@ -64,9 +65,10 @@ namespace translator {
   // the group by columns or to do partial aggregation when no groupby clause is
   // present.
   string TranslatorMetis::GenerateCode() {
-    // XXX(ionel): At the moment we only support a DAG in which each node has
-    // only one child.
     LOG(INFO) << "Metis code generation starting";
+    if (!IsChain(dag)) {
+      return GenerateFusedCode();
+    }
     // If false the code should be added to the map function, otherwise to the
     // reduce.
     bool add_to_reduce = false;
@@ -119,6 +121,12 @@ namespace translator {
         string code = "";
         ExpandTemplate("dag", ctemplate::DO_NOT_STRIP, &dict, &code);
         UpdateDAGCode(code, child_code, add_to_reduce, dag_code);
+        if (HasReduce((*it)->get_operator())) {
+          dag_code->set_reduce_code(child_code->get_reduce_code());
+          dag_code->set_combine_code(child_code->get_combine_code());
+          dag_code->set_reduce_key_type(child_code->get_reduce_key_type());
+          dag_code->set_reduce_value_type(child_code->get_reduce_value_type());
+        }
         // Set op to the next one to be processed by the while loop.
         op_node = *it;
         op = op_node->get_operator();
@@ -129,6 +137,7 @@ namespace translator {
     string template_location;
     if (dag_code->HasReduceCode()) {
       dict.SetValue("REDUCE_CODE", dag_code->get_reduce_code());
+      dict.SetValue("COMBINE_CODE", dag_code->get_combine_code());
       template_location = FLAGS_metis_templates_dir +
         "job_map_reduce_template.cc";
     } else {
@@ -143,6 +152,225 @@ namespace translator {
     return GenAndCompile(op, gen_code);
   }
 
+  // Fuses DAGs that fan out, or that have several operators reading the job's
+  // input, into a single Metis job. All pipelines share one scan of the input.
+  // Pipelines that need a reduce tag their map output keys so that the reduce
+  // can tell them apart, and every output row is tagged with the index of the
+  // relation it belongs to.
+  string TranslatorMetis::GenerateFusedCode() {
+    use_mergable_operators_ = true;
+    vector<OperatorInterface*> outputs;
+    OperatorInterface* job_op = NULL;
+    queue<shared_ptr<OperatorNode> > to_visit;
+    set<shared_ptr<OperatorNode> > visited;
+    for (op_nodes::iterator it = dag.begin(); it != dag.end(); ++it) {
+      to_visit.push(*it);
+      visited.insert(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> cur_node = to_visit.front();
+      to_visit.pop();
+      OperatorInterface* op = cur_node->get_operator();
+      if (job_op == NULL ||
+          !op->get_output_relation()->get_name().compare(class_name)) {
+        job_op = op;
+      }
+      if (cur_node->IsLeaf()) {
+        outputs.push_back(op);
+        continue;
+      }
+      op_nodes children = cur_node->get_children();
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (!visited.insert(*it).second) {
+          LOG(ERROR) << "Can not merge operator with two parent operators";
+          return "";
+        }
+        to_visit.push(*it);
+      }
+    }
+    // Reduce pipelines are tagged after the outputs so that the rows of the
+    // relations produced by the map can pass through the reduce.
+    uint32_t next_key_tag = outputs.size();
+    MetisJobCode* dag_code = new MetisJobCode(job_op, "", "", "", "", "");
+    TemplateDictionary pipelines_dict("pipelines");
+    string map_code = "";
+    for (op_nodes::iterator it = dag.begin(); it != dag.end(); ++it) {
+      string pipeline_code;
+      if (!FuseNode(*it, false, outputs, &next_key_tag, dag_code,
+                    &pipelines_dict, &pipeline_code)) {
+        return "";
+      }
+      map_code += pipeline_code;
+    }
+    dag_code->set_map_code(map_code);
+    dag_code->set_map_key_type("char*");
+    dag_code->set_map_value_type("char*");
+    dag_code->set_reduce_key_type("void*");
+    dag_code->set_reduce_value_type("char*");
+    TemplateDictionary dict("op");
+    string template_location;
+    mutable_default_template_cache()->ClearCache();
+    if (next_key_tag > outputs.size()) {
+      string reduce_code = "";
+      ExpandTemplate(FLAGS_metis_templates_dir + "fused_reduce.cc",
+                     ctemplate::DO_NOT_STRIP, &pipelines_dict, &reduce_code);
+      dag_code->set_reduce_code(reduce_code);
+      dict.SetValue("REDUCE_CODE", reduce_code);
+      string combine_code = "";
+      ExpandTemplate(FLAGS_metis_templates_dir + "fused_combine.cc",
+                     ctemplate::DO_NOT_STRIP, &pipelines_dict, &combine_code);
+      dict.SetValue("COMBINE_CODE", combine_code);
+      template_location = FLAGS_metis_templates_dir +
+        "job_map_reduce_template.cc";
+    } else {
+      template_location =
+        FLAGS_metis_templates_dir + "job_map_only_template.cc";
+    }
+    string output_files = "";
+    for (vector<OperatorInterface*>::iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+      LOG(INFO) << "Job output: " << (*it)->get_output_relation()->get_name();
+      output_files += "out_filenames.push_back(\"" +
+        (*it)->get_output_path() + "/part-r-00000\");\n";
+      output_files += string("out_columnar.push_back(") +
+        ((*it)->get_columnar_output() ? "true" : "false") + ");\n";
+    }
+    dict.SetValue("OUTPUT_FILES", output_files);
+    PopulateJobValues(dag_code, &dict);
+    dict.SetValue("OUTPUT_PATH", job_op->get_output_path());
+    dict.SetValue("OUTPUT_REL", job_op->get_output_relation()->get_name());
+    dict.SetValue("COLUMNAR_OUTPUT",
+                  job_op->get_columnar_output() ? "true" : "false");
+    string gen_code = "";
+    ExpandTemplate(template_location, ctemplate::DO_NOT_STRIP, &dict,
+                   &gen_code);
+    LOG(INFO) << "Job name: " << job_op->get_output_relation()->get_name();
+    return GenAndCompile(job_op, gen_code);
+  }
+
+  // Generates the code of node and of the operators that consume its output.
+  // Operators that follow a reduce are added to the reduce.
+  bool TranslatorMetis::FuseNode(shared_ptr<OperatorNode> node, bool in_reduce,
+                                 const vector<OperatorInterface*>& outputs,
+                                 uint32_t* next_key_tag,
+                                 MetisJobCode* dag_code,
+                                 TemplateDictionary* pipelines_dict,
+                                 string* code) {
+    OperatorInterface* op = node->get_operator();
+    LOG(INFO) << "Merging node: " << op->get_output_relation()->get_name();
+    bool has_reduce = HasReduce(op);
+    if (has_reduce && in_reduce) {
+      LOG(ERROR) << "Can not merge two operators with reduce function";
+      return false;
+    }
+    uint32_t key_tag = *next_key_tag;
+    if (has_reduce) {
+      key_tag_ = boost::lexical_cast<string>(key_tag) + " ";
+      ++*next_key_tag;
+    }
+    MetisJobCode* op_code =
+      dynamic_cast<MetisJobCode*>(TranslateOperator(op));
+    key_tag_ = "";
+    if (op_code->HasMapVariablesCode()) {
+      dag_code->set_map_variables_code(dag_code->get_map_variables_code() +
+                                       op_code->get_map_variables_code());
+    }
+    if (op_code->HasSetupCode()) {
+      dag_code->set_setup_code(dag_code->get_setup_code() +
+                               op_code->get_setup_code());
+    }
+    if (op_code->HasCleanupCode()) {
+      dag_code->set_cleanup_code(dag_code->get_cleanup_code() +
+                                 op_code->get_cleanup_code());
+    }
+    string next_operator = "";
+    op_nodes children = node->get_children();
+    for (op_nodes::iterator it = children.begin(); it != children.end();
+         ++it) {
+      string child_code;
+      if (!FuseNode(*it, in_reduce || has_reduce, outputs, next_key_tag,
+                    dag_code, pipelines_dict, &child_code)) {
+        return false;
+      }
+      next_operator += child_code;
+    }
+    string output_code = "";
+    if (node->IsLeaf()) {
+      TemplateDictionary output_dict("output");
+      output_dict.SetValue("OUTPUT_REL",
+                           op->get_output_relation()->get_name());
+      output_dict.SetValue("OUTPUT_TAG", boost::lexical_cast<string>(
+          find(outputs.begin(), outputs.end(), op) - outputs.begin()) + " ");
+      string output_template = in_reduce || has_reduce ?
+        "reduce_output_code.cc" : "map_output_code.cc";
+      ExpandTemplate(FLAGS_metis_templates_dir + output_template,
+                     ctemplate::DO_NOT_STRIP, &output_dict, &output_code);
+    }
+    // Every operator gets its own scope because sibling operators declare
+    // the same variables.
+    if (has_reduce) {
+      TemplateDictionary* pipeline_dict =
+        pipelines_dict->AddSectionDictionary("REDUCE_PIPELINES");
+      pipeline_dict->SetIntValue("KEY_TAG", key_tag);
+      pipeline_dict->SetValue("REDUCE_CODE",
+                              ExpandOperatorCode(op_code->get_reduce_code(),
+                                                 next_operator, output_code));
+      if (op_code->HasCombineCode()) {
+        TemplateDictionary* combine_dict =
+          pipelines_dict->AddSectionDictionary("COMBINE_PIPELINES");
+        combine_dict->SetIntValue("KEY_TAG", key_tag);
+        combine_dict->SetValue("COMBINE_CODE", op_code->get_combine_code());
+      }
+      *code = "{\n" + op_code->get_map_code() + "}\n";
+    } else {
+      *code = "{\n" + ExpandOperatorCode(op_code->get_map_code(),
+                                         next_operator, output_code) + "}\n";
+    }
+    return true;
+  }
+
+  bool TranslatorMetis::IsChain(const op_nodes& dag) {
+    if (dag.size() != 1) {
+      return false;
+    }
+    for (shared_ptr<OperatorNode> cur_node = dag[0]; !cur_node->IsLeaf();
+         cur_node = cur_node->get_children()[0]) {
+      if (cur_node->get_children().size() > 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  string TranslatorMetis::ExpandOperatorCode(const string& op_code,
+                                             const string& next_operator,
+                                             const string& output_code) {
+    TemplateDictionary dict("operator");
+    dict.SetValue("NEXT_OPERATOR", next_operator);
+    dict.SetValue("OUTPUT_CODE", output_code);
+    mutable_default_template_cache()->ClearCache();
+    StringToTemplateCache("dag", op_code, ctemplate::DO_NOT_STRIP);
+    string code = "";
+    ExpandTemplate("dag", ctemplate::DO_NOT_STRIP, &dict, &code);
+    return code;
+  }
+
+  // Generates the code that appends the columns of a row to a string.
+  string TranslatorMetis::AppendColumnsCode(const string& var,
+                                            const vector<Column*>& columns) {
+    string code = "";
+    for (vector<Column*>::const_iterator it = columns.begin();
+         it != columns.end(); ++it) {
+      if (it != columns.begin()) {
+        code += "          " + var + "->append(\" \");\n";
+      }
+      code += "          " + var + "->append(row_it->at(" +
+        boost::lexical_cast<string>((*it)->get_index()) + "));\n";
+    }
+    return code;
+  }
+
   void TranslatorMetis::GenerateMakefile(OperatorInterface* op,
                                          const string& rel_name,
                                          const string& make_file_name) {
@@ -213,6 +441,15 @@ namespace translator {
     string dag_reduce_code = "";
     ExpandTemplate("dag", ctemplate::DO_NOT_STRIP, dict, &dag_reduce_code);
     dag_code->set_reduce_code(dag_reduce_code);
+    PopulateJobValues(dag_code, dict);
+    dict->SetValue("OUTPUT_PATH", op->get_output_path());
+    dict->SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
+    dict->SetValue("COLUMNAR_OUTPUT",
+                   op->get_columnar_output() ? "true" : "false");
+  }
+
+  void TranslatorMetis::PopulateJobValues(MetisJobCode* dag_code,
+                                          TemplateDictionary* dict) {
     // Extract input relations
     vector<Relation*> input_rels;
     vector<string> input_paths;
@@ -235,16 +472,46 @@ namespace translator {
     dict->SetValue("CLASS_NAME", class_name);
     dict->SetValue("MAP_VARIABLES_CODE", dag_code->get_map_variables_code());
     dict->SetValue("SETUP_CODE", dag_code->get_setup_code());
-    dict->SetValue("MAP_CODE", dag_map_code);
+    dict->SetValue("MAP_CODE", dag_code->get_map_code());
     dict->SetValue("CLEANUP_CODE", dag_code->get_cleanup_code());
     dict->SetValue("INPUT_PATH", input_rel_code.first);
     dict->SetValue("INPUT_CODE", input_rel_code.second);
-    dict->SetValue("OUTPUT_PATH", op->get_output_path());
     dict->SetValue("MAP_KEY_TYPE", dag_code->get_map_key_type());
     dict->SetValue("MAP_VALUE_TYPE", dag_code->get_map_value_type());
     dict->SetValue("REDUCE_KEY_TYPE", dag_code->get_reduce_key_type());
     dict->SetValue("REDUCE_VALUE_TYPE", dag_code->get_reduce_value_type());
-    dict->SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
+    // 0 lets Metis choose the number of reduce tasks.
+    dict->SetIntValue("NUM_REDUCE_TASKS", JobReduceTasks());
+    dict->SetIntValue("COLUMNAR_BLOCK_ROWS", FLAGS_columnar_block_rows);
+    dict->SetIntValue("COLUMNAR_COMPRESS", FLAGS_columnar_compression ? 1 : 0);
+  }
+
+  // Sizes the reduce phase for the largest input that the job shuffles.
+  uint32_t TranslatorMetis::JobReduceTasks() {
+    uint32_t num_reduce_tasks = 0;
+    set<shared_ptr<OperatorNode> > visited(dag.begin(), dag.end());
+    queue<shared_ptr<OperatorNode> > to_visit;
+    for (op_nodes::iterator it = dag.begin(); it != dag.end(); ++it) {
+      to_visit.push(*it);
+    }
+    while (!to_visit.empty()) {
+      shared_ptr<OperatorNode> node = to_visit.front();
+      to_visit.pop();
+      if (HasReduce(node->get_operator())) {
+        num_reduce_tasks = max(num_reduce_tasks,
+                               NumReduceTasks(node->get_operator(),
+                                              FLAGS_metis_reduce_task_input_kb,
+                                              FLAGS_metis_max_reduce_tasks));
+      }
+      op_nodes children = node->get_children();
+      for (op_nodes::iterator it = children.begin(); it != children.end();
+           ++it) {
+        if (visited.insert(*it).second) {
+          to_visit.push(*it);
+        }
+      }
+    }
+    return num_reduce_tasks;
   }
 
   // TODO(ionel): There is a bug here. If an operator that uses same input and
@@ -338,7 +605,9 @@ namespace translator {
     // Populate compilation directory with utility headers
     string copy_cmd =
       "cp " + FLAGS_metis_templates_dir + "/utils.h " + path + "; ";
-    copy_cmd += "cp " + FLAGS_metis_templates_dir + "/hdfs_utils.h " + path;
+    copy_cmd += "cp " + FLAGS_metis_templates_dir + "/hdfs_utils.h " + path +
+      "; ";
+    copy_cmd += "cp " + FLAGS_metis_templates_dir + "/columnar.h " + path;
     std::system(copy_cmd.c_str());
   }
 
@@ -362,9 +631,64 @@ namespace translator {
   }
 
   MetisJobCode* TranslatorMetis::Translate(AggOperator* op) {
-    LOG(ERROR) << "AggOperator [" << op << "] can't be translated: "
-               << "unimplemented!";
-    return new MetisJobCode(op, "");
+    TemplateDictionary dict("agg");
+    PopulateCommonValues(op, &dict);
+    string output_rel = op->get_output_relation()->get_name();
+    dict.SetValue("REL_NAME", AvoidNameClash(op, 0));
+    dict.SetValue("CONDITION", op->get_condition_tree()->toString("metis"));
+    dict.SetValue("KEY_TAG", key_tag_);
+    if (op->hasGroupby()) {
+      dict.SetValue("GROUP_BY_KEY", AppendColumnsCode(output_rel + "_key",
+                                                      op->get_group_bys()));
+    }
+    dict.SetValue("AGG_VALUES",
+                  AppendColumnsCode(output_rel + "_val", op->get_columns()));
+    dict.SetIntValue("NUM_AGG_COLS", op->get_columns().size());
+    string math_op = op->get_operator();
+    if (math_op.compare("+") && math_op.compare("-")) {
+      dict.SetValue("INIT_VAL", "1");
+    } else {
+      dict.SetValue("INIT_VAL", "0");
+    }
+    dict.SetValue("OPERATOR", math_op);
+    // All the columns are reduced as the same C type. MetisFramework does not
+    // choose Metis for aggregations of columns with different types.
+    vector<Column*> agg_cols = op->get_columns();
+    for (vector<Column*>::iterator it = agg_cols.begin(); it != agg_cols.end();
+         ++it) {
+      if ((*it)->get_type() != agg_cols[0]->get_type()) {
+        LOG(ERROR) << "AggOperator [" << op << "] can't be translated: "
+                   << "columns of different types";
+        return new MetisJobCode(op, "");
+      }
+    }
+    dict.SetValue("TYPE", agg_cols[0]->translateTypeC());
+    dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
+    dict.SetValue("OUTPUT_REL", output_rel);
+    dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
+    string op_map;
+    string op_reduce;
+    // Agg reads the rows extracted by the input code.
+    use_mergable_operators_ = true;
+    ExpandTemplate(FLAGS_metis_templates_dir + "agg_map.cc",
+                   ctemplate::DO_NOT_STRIP, &dict, &op_map);
+    ExpandTemplate(FLAGS_metis_templates_dir + "agg_reduce.cc",
+                   ctemplate::DO_NOT_STRIP, &dict, &op_reduce);
+    MetisJobCode* job_code = new MetisJobCode(op, "", "", op_map, "",
+                                              op_reduce);
+    // Associative aggregations are merged while the map emits them.
+    if (FLAGS_map_aggregation_max_groups > 0 &&
+        (!math_op.compare("+") || !math_op.compare("*"))) {
+      string op_combine;
+      ExpandTemplate(FLAGS_metis_templates_dir + "agg_combine.cc",
+                     ctemplate::DO_NOT_STRIP, &dict, &op_combine);
+      job_code->set_combine_code(op_combine);
+    }
+    job_code->set_map_key_type("char*");
+    job_code->set_map_value_type("char*");
+    job_code->set_reduce_key_type("void*");
+    job_code->set_reduce_value_type("char*");
+    return job_code;
   }
 
   MetisJobCode* TranslatorMetis::Translate(CountOperator* op) {
@@ -423,6 +747,7 @@ namespace translator {
     dict.SetValue("LEFT_PATH", input_paths[0]);
     dict.SetValue("RIGHT_PATH", input_paths[1]);
     dict.SetValue("OUTPUT_PATH", op->get_output_path());
+    dict.SetValue("KEY_TAG", key_tag_);
     dict.SetValue("OUTPUT_CODE", "{{OUTPUT_CODE}}");
     dict.SetValue("OUTPUT_REL", op->get_output_relation()->get_name());
     dict.SetValue("NEXT_OPERATOR", "{{NEXT_OPERATOR}}");
@@ -430,6 +755,24 @@ namespace translator {
     string op_setup;
     string op_map;
     string op_reduce;
+    // Metis joins on the first key column only.
+    vector<string> skewed_keys = op->get_skewed_keys();
+    if (use_mergable_operators_ && !skewed_keys.empty() &&
+        op->get_left_cols().size() == 1) {
+      string keys_code = "";
+      for (vector<string>::iterator it = skewed_keys.begin();
+           it != skewed_keys.end(); ++it) {
+        keys_code += (keys_code.empty() ? "" : ", ") + QuoteString(*it);
+      }
+      dict.ShowSection("SKEW_JOIN");
+      dict.SetValue("SKEWED_KEYS", keys_code);
+      dict.SetIntValue("SKEW_SPLITS", max(FLAGS_skew_join_splits, 1));
+      dict.SetValue("SPLIT_LEFT", op->get_skewed_input() == 0 ? "true" : "false");
+      dict.SetValue("SPLIT_RIGHT",
+                    op->get_skewed_input() == 1 ? "true" : "false");
+    } else {
+      dict.ShowSection("NO_SKEW_JOIN");
+    }
     ExpandTemplate(FLAGS_metis_templates_dir + "join_map_variables.cc",
                    ctemplate::DO_NOT_STRIP, &dict, &op_map_variables);
     ExpandTemplate(FLAGS_metis_templates_dir + "join_setup.cc",
@@ -661,6 +1004,10 @@ namespace translator {
     timeval start_time, end_time;
     gettimeofday(&start_time, NULL);
     string compile_cmd = "make -C " + path;
+    if (FLAGS_metis_use_worker) {
+      // Also build the shared library that the resident worker runs.
+      compile_cmd += " all lib";
+    }
     std::system(compile_cmd.c_str());
     gettimeofday(&end_time, NULL);
     uint64_t compile_time = end_time.tv_sec - start_time.tv_sec;
@@ -42,6 +42,15 @@ class TranslatorMetis : public TranslatorInterface {
   string GenerateCode();
 
  private:
+  string GenerateFusedCode();
+  bool FuseNode(shared_ptr<OperatorNode> node, bool in_reduce,
+                const vector<OperatorInterface*>& outputs,
+                uint32_t* next_key_tag, MetisJobCode* dag_code,
+                TemplateDictionary* pipelines_dict, string* code);
+  bool IsChain(const op_nodes& dag);
+  string ExpandOperatorCode(const string& op_code, const string& next_operator,
+                            const string& output_code);
+  string AppendColumnsCode(const string& var, const vector<Column*>& columns);
   void GenerateMakefile(OperatorInterface* op, const string& rel_name,
                         const string& make_file_name);
   MetisJobCode* Translate(AggOperator* op);
@@ -77,9 +86,14 @@ class TranslatorMetis : public TranslatorInterface {
   void PopulateCommonValues(OperatorInterface* op, TemplateDictionary* dict);
   void PopulateEndDAG(OperatorInterface* op, MetisJobCode* dag_code,
                       TemplateDictionary* dict);
+  void PopulateJobValues(MetisJobCode* dag_code, TemplateDictionary* dict);
+  uint32_t JobReduceTasks();
   void PrepareCodeDirectory(OperatorInterface* op);
 
   bool use_mergable_operators_;
+  // Prefix of the map output keys of the operator being translated. Set when
+  // several reduce pipelines are fused into a job.
+  string key_tag_;
 };
 
 } // namespace translator
@@ -247,8 +247,6 @@ namespace translator {
                                            set<string>* processed,
                                            map<string, Relation*>* name_rel) {
     // TODO(ionel): Add support for nested WHILEs
-    set<string> input_rel_names;
-    set<string> out_rel_names;
     set<shared_ptr<OperatorNode> > visited;
     queue<shared_ptr<OperatorNode> > to_visit;
     op_nodes children = node->get_loop_children();
@@ -263,11 +261,9 @@ namespace translator {
       processed->insert(op->get_output_relation()->get_name());
       (*name_rel)[op->get_output_relation()->get_name()] =
         op->get_output_relation();
-      out_rel_names.insert(op->get_output_relation()->get_name());
       vector<Relation*> input_rels = op->get_relations();
       for (vector<Relation*>::iterator it = input_rels.begin();
            it != input_rels.end(); ++it) {
-        input_rel_names.insert((*it)->get_name());
         (*name_rel)[(*it)->get_name()] = *it;
       }
       if (!cur_node->IsLeaf()) {
@@ -280,14 +276,7 @@ namespace translator {
         }
       }
     }
-    for (set<string>::iterator it = input_rel_names.begin();
-         it != input_rel_names.end(); ++it) {
-      if (out_rel_names.find(*it) == out_rel_names.end()) {
-        // Relation is not written/overwitten in the while loop.
-        LOG(INFO) << "Relation " << *it << " is immutable";
-        (*name_rel)[*it]->set_immutable(true);
-      }
-    }
+    MarkLoopInvariantRelations(node);
   }
 
   void TranslatorNaiad::TranslateDAG(string* code, string* fun_code,
@@ -76,7 +76,8 @@ namespace translator {
     if (edges_columns.size() > 2) {
       edges_names.push_back("e_cost");
       if (!has_count) {
-        map_code += "  edge_data_type& e_cost = edge.data();\n";
+        // Copy the cost so that per-edge operators do not modify the graph.
+        map_code += "  edge_data_type e_cost = edge.data();\n";
         dict->SetValue("HAS_EDGE_COST", "true");
       } else {
         map_code += "  edge_data_type e_cost = (edge_data_type)ver_src.num_out_edges();\n";
@@ -140,24 +141,32 @@ namespace translator {
     OperatorInterface* op = while_node->get_operator();
     string binary_file = GetBinaryPath(op);
     string num_iters = GetNumIters(dynamic_cast<WhileOperator*>(op));
+    if (num_iters.empty()) {
+      // PowerGraph jobs run for a fixed number of iterations.
+      return "";
+    }
     dict.SetValue("CLASS_NAME", class_name);
     dict.SetValue("HDFS_MASTER", "hdfs://" + FLAGS_hdfs_master + ":" + FLAGS_hdfs_port);
     dict.SetValue("POWERGRAPH_DIR", FLAGS_powergraph_dir);
     dict.SetValue("N_ITERS", num_iters);
-    op_nodes children = while_node->get_loop_children();
-    if (children.size() != 2) {
-      LOG(ERROR) << "WHILE has more than 2 children nodes";
-      return NULL;
+    dict.SetValue("HDFS_HOST", FLAGS_hdfs_master);
+    dict.SetValue("HDFS_PORT", FLAGS_hdfs_port);
+    dict.SetValue("TMP_ROOT", FLAGS_tmp_data_dir);
+    dict.SetValue("CACHE_PARTITIONS",
+                  FLAGS_powergraph_cache_partitions ? "true" : "false");
+    shared_ptr<OperatorNode> join_node = GetEdgesJoin(while_node);
+    if (join_node == NULL) {
+      LOG(ERROR) << "WHILE body does not start with an edges-vertices JOIN";
+      return "";
     }
-    shared_ptr<OperatorNode> join_node = children[0];
     string map_code = HandleVerticesEdgesJoin(&rel_var_names, &dict, join_node,
                                               dag[0] != while_node);
     // Generate code for the pre groupby operators.
-    children = join_node->get_children();
+    op_nodes children = join_node->get_children();
     for (; children.size() > 0; children = children[0]->get_children()) {
       if (children.size() != 1) {
         LOG(ERROR) << "Unsupported merge!";
-        return NULL;
+        return "";
       }
       OperatorInterface* child_op = children[0]->get_operator();
       if (child_op->hasGroupby()) {
@@ -165,10 +174,16 @@ namespace translator {
       }
       map_code += GenOperatorCode(&rel_var_names, child_op) + "\n";
     }
+    OperatorInterface* group_op = children[0]->get_operator();
+    // The map function returns ver_val, so it must hold the reduced value.
+    map_code += BindGatherValue("ver_val", &rel_var_names, group_op);
+    if (group_op->get_type() == COUNT_OP) {
+      map_code += "  ver_val = 1;\n";
+    }
     dict.SetValue("MAP_CODE", map_code);
     // Generate code for the operator with groupby.
     string combiner = UpdateGroupVertexValue("vertex_val", &rel_var_names,
-                                             children[0]->get_operator());
+                                             group_op);
     dict.SetValue("COMBINER", combiner);
     dict.SetValue("EDGES", "IN_EDGES");
     string map_vertices = "";
@@ -180,7 +195,7 @@ namespace translator {
     for (; children.size() > 0; children = children[0]->get_children()) {
       if (children.size() > 1) {
         LOG(ERROR) << "Unsupported merge!";
-        return NULL;
+        return "";
       }
       OperatorInterface* child_op = children[0]->get_operator();
       map_vertices += GenOperatorCode(&rel_var_names, child_op) + "\n";
@@ -470,12 +485,12 @@ namespace translator {
       UnionOperator* op) {
     vector<Relation*> rels = op->get_relations();
     vector<string> input_left_names = (*rel_var_names)[rels[0]->get_name()];
-    vector<string> input_right_names = (*rel_var_names)[rels[1]->get_name()];
     string output_rel_name = op->get_output_relation()->get_name();
-    vector<string> output_col_names(input_right_names.begin(),
-                                    input_right_names.end());
+    // The right input is the vertices relation. GenPreGroupUnion combines its
+    // values with the gathered one, so the UNION's rows are the per-edge ones.
+    vector<string> output_col_names(input_left_names.begin(),
+                                    input_left_names.end());
     rel_var_names->insert(pair<string, vector<string> >(output_rel_name, output_col_names));
-    // TODO(ionel): Implement.
     return "";
   }
 
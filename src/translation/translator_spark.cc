@@ -254,11 +254,14 @@ namespace translator {
     set<string> inputs = set<string>();
     DetermineInputsSpark(dag, &inputs, &nodelist);
     PrintStringSet("Inputs are ", inputs);
-    string header = TranslateHeader(class_name, bin_name, inputs, nodelist, output_dir);
+    loop_invariant_rels = MarkLoopInvariantRelations(dag);
     string ops;
     set<shared_ptr<OperatorNode> > leafs = set<shared_ptr<OperatorNode> >();
     set<string> proc = inputs;
     TranslateDAG(&ops, dag, &leafs, &proc);
+    // The header is generated last because it declares the keyed RDDs that
+    // the operators cache across loop iterations.
+    string header = TranslateHeader(class_name, bin_name, inputs, nodelist, output_dir);
     LOG(INFO) << "Size of leaves " << leafs.size();
     string code = header + ops + TranslateTail(leafs, output_path);
     return Compile(code, code_dir);
@@ -383,11 +386,13 @@ namespace translator {
             TranslateDAG(code, node->get_loop_children(), leaves, processed);
             // TODO(ionel): Rel names should keep track of names already defined.
             // (e.g. when we have a while loop within a while loop.
-            set<string> rel_names = set<string>();
-            dynamic_cast<WhileOperator*>(
-                node->get_operator())->get_condition_tree()->getRelNames(&rel_names);
-            string update = GenUpdateConditionInput(rel_names);
-            *code += update;
+            if (!IsCountedLoop(node)) {
+              set<string> rel_names = set<string>();
+              dynamic_cast<WhileOperator*>(
+                  node->get_operator())->get_condition_tree()->getRelNames(&rel_names);
+              string update = GenUpdateConditionInput(rel_names);
+              *code += update;
+            }
             *code += "\n}\n";
           }
           TranslateDAG(code, node->get_children(), leaves, processed);
@@ -519,6 +524,7 @@ namespace translator {
     dict.SetValue("SPARK_DIR", FLAGS_spark_dir);
     dict.SetValue("HDFS_MASTER", "hdfs://" + FLAGS_hdfs_master + ":" + FLAGS_hdfs_port);
     dict.SetValue("BIN_NAME", bin_name);
+    dict.SetIntValue("DEFAULT_PARALLELISM", FLAGS_spark_max_partitions);
     ExpandTemplate(FLAGS_spark_templates_dir + "HeaderTemplate.scala",
                    ctemplate::DO_NOT_STRIP, &dict, &header);
     string inputs_st = header;
@@ -531,6 +537,13 @@ namespace translator {
       if (to_cache[input]) {
         //          dict.SetValue("TO_CACHE", ".cache()");
       }
+      if (loop_invariant_rels.find(input) != loop_invariant_rels.end()) {
+        // Keep inputs that a loop does not update in memory so that the
+        // iterations do not re-read them from HDFS.
+        dict.SetValue("TO_CACHE", ".cache()");
+      } else {
+        dict.SetValue("TO_CACHE", "");
+      }
       string save = "";
       ExpandTemplate(FLAGS_spark_templates_dir + "InputTemplate.scala",
                      ctemplate::DO_NOT_STRIP, &dict, &save);
@@ -549,7 +562,7 @@ namespace translator {
         }
       }
     }
-    return inputs_st;
+    return inputs_st + cached_keyed_rdds;
   }
 
   vector<Relation*>* TranslatorSpark::DetermineInputsSpark(const op_nodes& dag,
@@ -974,6 +987,42 @@ namespace translator {
     dict.SetValue("REL_NAME2", input_rel2->get_name());
     dict.SetValue("INPUTREL_TYPE1", inputrel_type1);
     dict.SetValue("INPUTREL_TYPE2", inputrel_type2);
+    // Loop-invariant sides are keyed and partitioned once and then reused by
+    // every iteration, so only the loop-carried side is shuffled.
+    string out_class = op->get_output_relation()->get_name();
+    string join_col_type = col_left->translateTypeScala();
+    if (input_rel1->isImmutable()) {
+      dict.ShowSection("CACHED_KEYED1");
+      cached_keyed_rdds += DeclareKeyedRDD(
+          "keyed_" + input_rel1->get_name() + "_" + out_class,
+          join_col_type, inputrel_type1);
+    } else {
+      dict.ShowSection("KEYED1");
+    }
+    if (input_rel2->isImmutable()) {
+      dict.ShowSection("CACHED_KEYED2");
+      cached_keyed_rdds += DeclareKeyedRDD(
+          "keyed_" + input_rel2->get_name() + "_2" + out_class,
+          join_col_type, inputrel_type2);
+    } else {
+      dict.ShowSection("KEYED2");
+    }
+    // A small input is collected and broadcast to every partition of the
+    // other input instead of shuffling both.
+    switch (op->get_broadcast_input()) {
+    case 0:
+      dict.ShowSection("BROADCAST_LEFT");
+      break;
+    case 1:
+      dict.ShowSection("BROADCAST_RIGHT");
+      break;
+    default:
+      if (PopulateSkewJoin(op, &dict)) {
+        dict.ShowSection("SKEW_JOIN");
+      } else {
+        dict.ShowSection("SHUFFLE_JOIN");
+      }
+    }
     string code;
     ExpandTemplate(FLAGS_spark_templates_dir + "JoinTemplate.scala",
                    ctemplate::DO_NOT_STRIP, &dict, &code);
@@ -984,6 +1033,62 @@ namespace translator {
     return job_code;
   }
 
+  // Heavy keys are salted: the larger input's rows with such a key get one of
+  // FLAGS_skew_join_splits salts and the other input's rows get all of them.
+  bool TranslatorSpark::PopulateSkewJoin(JoinOperator* op,
+                                         TemplateDictionary* dict) {
+    // The Spark join only uses the first key column.
+    vector<string> skewed_keys = op->get_skewed_keys();
+    if (skewed_keys.empty() || op->get_left_cols().size() != 1) {
+      return false;
+    }
+    uint16_t key_type = op->get_col_left()->get_type();
+    string keys_code = "";
+    for (vector<string>::iterator it = skewed_keys.begin();
+         it != skewed_keys.end(); ++it) {
+      string key_code = *it;
+      if (key_type == STRING_TYPE) {
+        key_code = QuoteString(*it);
+      } else if (key_type == INTEGER_TYPE || key_type == DOUBLE_TYPE) {
+        // Keys that do not parse as numbers cannot match any row.
+        char* end;
+        if (key_type == INTEGER_TYPE) {
+          strtol(it->c_str(), &end, 10);
+        } else {
+          strtod(it->c_str(), &end);
+        }
+        if (it->empty() || *end != '\0') {
+          continue;
+        }
+      } else {
+        return false;
+      }
+      keys_code += (keys_code.empty() ? "" : ", ") + key_code;
+    }
+    if (keys_code.empty()) {
+      return false;
+    }
+    string splits =
+      boost::lexical_cast<string>(max(FLAGS_skew_join_splits, 1));
+    string split_code = "Seq(((row._1, scala.util.Random.nextInt(" + splits +
+      ")), row._2))";
+    string replicate_code = "(0 until " + splits +
+      ").map(split => ((row._1, split), row._2))";
+    dict->SetValue("SKEWED_KEYS", keys_code);
+    dict->SetValue("SALT_LEFT",
+                   op->get_skewed_input() == 0 ? split_code : replicate_code);
+    dict->SetValue("SALT_RIGHT",
+                   op->get_skewed_input() == 1 ? split_code : replicate_code);
+    return true;
+  }
+
+  string TranslatorSpark::DeclareKeyedRDD(const string& name,
+                                          const string& key_type,
+                                          const string& value_type) {
+    string type = "org.apache.spark.rdd.RDD[(" + key_type + "," + value_type + ")]";
+    return " var " + name + ":" + type + " = null.asInstanceOf[" + type + "];\n";
+  }
+
   SparkJobCode* TranslatorSpark::Translate(MinOperator* op) {
     TemplateDictionary dict("min");
     Relation* input_rel = op->get_relations()[0];
@@ -1190,6 +1295,26 @@ namespace translator {
     return conds_vars;
   }
 
+  string TranslatorSpark::GenLoopCondition(ConditionTree* tree) {
+    if (tree->isValue()) {
+      return tree->get_value()->get_value();
+    }
+    if (tree->isColumn()) {
+      Column* column = tree->get_column();
+      string cond_var = column->get_relation() + "_cond";
+      if (relations[column->get_relation()]->get_columns().size() > 1) {
+        cond_var += "._" + boost::lexical_cast<string>(column->get_index() + 1);
+      }
+      return cond_var;
+    }
+    string cond_operator = tree->get_cond_operator()->toString();
+    if (tree->isUnary()) {
+      return "(" + cond_operator + GenLoopCondition(tree->get_left()) + ")";
+    }
+    return "(" + GenLoopCondition(tree->get_left()) + " " + cond_operator +
+      " " + GenLoopCondition(tree->get_right()) + ")";
+  }
+
   string TranslatorSpark::GenUpdateConditionInput(const set<string>& cond_names) {
     string conds = "";
     for (set<string>::const_iterator it = cond_names.begin();
@@ -1200,17 +1325,23 @@ namespace translator {
   }
 
   SparkJobCode* TranslatorSpark::Translate(WhileOperator* op) {
-    // TODO(ionel): Extend condition support.
     TemplateDictionary dict("while");
     PopulateCommonValues(op, &dict);
-    string condition = op->get_condition_tree()->toString("spark");
-    set<string> rel_names = set<string>();
-    op->get_condition_tree()->getRelNames(&rel_names);
-    string inputs = GenConditionInput(rel_names);
-    dict.SetValue("CONDITION_VAR", inputs);
-    dict.SetValue("CONDITION", condition);
-    dict.SetValue("NUM_ITER",
-                  op->get_condition_tree()->get_right()->get_value()->get_value());
+    shared_ptr<OperatorNode> while_node = FindNode(op);
+    if (!while_node || !IsCountedLoop(while_node)) {
+      // The condition depends on the data computed in the loop. It is
+      // evaluated in the driver on the first row of each relation it uses.
+      set<string> rel_names = set<string>();
+      op->get_condition_tree()->getRelNames(&rel_names);
+      dict.ShowSection("CONVERGENCE_LOOP");
+      dict.SetValue("CONDITION_VAR", GenConditionInput(rel_names));
+      dict.SetValue("CONDITION", GenLoopCondition(op->get_condition_tree()));
+    } else {
+      // IsCountedLoop only accepts counter < constant.
+      dict.ShowSection("COUNTED_LOOP");
+      dict.SetValue("NUM_ITER",
+                    op->get_condition_tree()->get_right()->get_value()->get_value());
+    }
     string code;
     ExpandTemplate(FLAGS_spark_templates_dir + "WhileTemplate.scala", ctemplate::DO_NOT_STRIP,
                    &dict, &code);
@@ -1335,9 +1466,26 @@ namespace translator {
     dict->SetValue("SPARK_MASTER", FLAGS_spark_master);
     dict->SetValue("SPARK_DIR", FLAGS_spark_dir);
     dict->SetValue("BIN_NAME", binary_file);
+    // Shuffles get a partition for about every FLAGS_reduce_task_input_kb of
+    // the operator's input. A SORT's partitions are key ranges that Spark
+    // samples from the input. If the input size is unknown, a SORT keeps its
+    // single partition.
+    uint32_t num_partitions = NumReduceTasks(op, FLAGS_reduce_task_input_kb,
+                                             FLAGS_spark_max_partitions);
+    if (num_partitions > 0) {
+      dict->SetIntValue("NUM_PARTITIONS", num_partitions);
+    } else if (op->get_type() == SORT_OP) {
+      dict->SetIntValue("NUM_PARTITIONS", 1);
+    } else {
+      dict->SetValue("NUM_PARTITIONS", "sc.defaultParallelism");
+    }
     if (to_cache[op->get_output_relation()->get_name()]) {
       //        dict->SetValue("TO_CACHE", ".cache()");
     }
+    if (loop_invariant_rels.find(op->get_output_relation()->get_name()) !=
+        loop_invariant_rels.end()) {
+      dict->SetValue("TO_CACHE", ".cache()");
+    }
   }
 
   string TranslatorSpark::Compile(const string& code, const string& code_dir) {
@@ -109,6 +109,7 @@ class TranslatorSpark : public TranslatorInterface {
                          string input_rel_name,
                          TemplateDictionary* dict);
   string GenConditionInput(const set<string>& cond_names);
+  string GenLoopCondition(ConditionTree* tree);
   string GenUpdateConditionInput(const set<string>& cond_names);
   bool CanSchedule(OperatorInterface* op, set<string>* processed);
   string GenTypedRDD(Relation* relation);
@@ -149,9 +150,16 @@ class TranslatorSpark : public TranslatorInterface {
   string GenerateAggShuffle(const string& op, const vector<Column*>& agg_cols,
                             uint32_t num_input_cols);
   bool MustGenerateCode(shared_ptr<OperatorNode> node);
+  bool PopulateSkewJoin(JoinOperator* op, TemplateDictionary* dict);
+  string DeclareKeyedRDD(const string& name, const string& key_type,
+                         const string& value_type);
 
   /* State used to determine when to cache */
   map<string, bool> to_cache;
+  /* Relations that no loop in the DAG updates */
+  set<string> loop_invariant_rels;
+  /* Declarations of the keyed RDDs reused across loop iterations */
+  string cached_keyed_rdds;
   SparkJobCode* cur_job_code;
 };
 
@@ -0,0 +1,17 @@
+#!/bin/bash
+# Checks that the SSSP loop of sssp.rap is detected as a gather-apply-scatter
+# loop, i.e. that PowerGraph can run it as a vertex program. GraphChi cannot
+# store the edge weights, so it is not expected to merge the loop.
+# $1 = musketeer binary (default: ../build/musketeer)
+MUSKETEER=${1:-../build/musketeer}
+SIZES=$(mktemp)
+trap "rm -f $SIZES" EXIT
+printf "edges 1048576\ndist 65536\niter 1\n" > $SIZES
+if $MUSKETEER --run_daemon=false --dry_run --beer_query=sssp.rap \
+    --dry_run_data_size_file=$SIZES --v=2 2>&1 |
+    grep -q "Can merge in powergraph"; then
+  echo "PASS: sssp.rap is a GAS loop"
+else
+  echo "FAIL: sssp.rap is not detected as a GAS loop"
+  exit 1
+fi